@@ -0,0 +1,394 @@
+/**
+ * @file bench/bench.c
+ * @author Vladsanin777
+ * @brief Microbenchmarks of udp_lib, result is JSON on stdout.
+ *
+ * Every case is repeated with doubling count of operations until it runs
+ * at least @ref MIN_TIME_BENCH, best of @ref ROUNDS_BENCH rounds is printed
+ * as ns/op, ops/s and bytes/s (if case moves bytes). Run by `make bench`,
+ * arguments are substrings of names of cases to run, without arguments all
+ * cases run. Case of send on loopback needs CAP_NET_RAW, without it case
+ * is printed with `"skipped": true`.
+ */
+
+#include "udp_lib/udp.h"
+#include "udp_lib/udp_private.h"
+#include "udp_lib/sender.h"
+#include "udp_lib/hex.h"
+#include "udp_lib/clock_private.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <time.h>
+
+/** Min nanoseconds of one round. */
+#define MIN_TIME_BENCH 200000000ULL
+
+/** Rounds of every case, best is printed. */
+#define ROUNDS_BENCH 3
+
+/** Max size of data in cases. */
+#define MAX_SIZE_BENCH 1472
+
+/**
+ * @brief Struct is state shared by cases.
+ * @note This struct is private. Not used outside bench/bench.c
+ */
+struct state_bench {
+    udp_pack_t m_pack; /**< Ready package. */
+    udp_sender_t m_sender; /**< Sender on loopback or NULL. */
+    uint16_t m_size; /**< Size data of current case. */
+    uint8_t m_data[MAX_SIZE_BENCH]; /**< Data for cases. */
+    char m_hex[MAX_SIZE_BENCH * 2]; /**< Data for cases as hex text. */
+};
+
+/**
+ * @brief Struct is one case.
+ * @note This struct is private. Not used outside bench/bench.c
+ */
+struct case_bench {
+    const char * m_name; /**< Name in output. */
+    uint16_t m_size; /**< Size data for case, bytes of one operation or 0. */
+    ssize_t (*m_run)(struct state_bench * const state, const uint64_t count); /**< Case. */
+};
+
+/** Result of cases, read so compiler keeps work. */
+static volatile uint64_t sink_bench = 0;
+
+/**
+ * @brief Case init and destroy of package.
+ * @param[in,out] state State for work.
+ * @param[in] count Count operations.
+ * @return 0 or -1 on error.
+ * @note This function is private. Not used outside bench/bench.c
+ */
+static ssize_t run_init_bench(struct state_bench * const state, const uint64_t count) {
+    (void)state;
+    for (uint64_t i = 0; i < count; i++) {
+        udp_pack_t pack = init_udp_pack();
+
+        if (pack == NULL)
+            return -1;
+        destroy_udp_pack(pack);
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Case add of data to empty package.
+ * @param[in,out] state State for work.
+ * @param[in] count Count operations.
+ * @return 0 or -1 on error.
+ * @note This function is private. Not used outside bench/bench.c
+ */
+static ssize_t run_add_data_bench(struct state_bench * const state, const uint64_t count) {
+    for (uint64_t i = 0; i < count; i++) {
+        if (set_data_udp_pack(state->m_pack, state->m_data, 0))
+            return -1;
+        if (add_data_udp_pack(state->m_pack, state->m_data, state->m_size))
+            return -1;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Case set of data.
+ * @param[in,out] state State for work.
+ * @param[in] count Count operations.
+ * @return 0 or -1 on error.
+ * @note This function is private. Not used outside bench/bench.c
+ */
+static ssize_t run_set_data_bench(struct state_bench * const state, const uint64_t count) {
+    for (uint64_t i = 0; i < count; i++) {
+        if (set_data_udp_pack(state->m_pack, state->m_data, state->m_size))
+            return -1;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Case sum and fold of checksum.
+ * @param[in,out] state State for work.
+ * @param[in] count Count operations.
+ * @return 0 or -1 on error.
+ * @note This function is private. Not used outside bench/bench.c
+ */
+static ssize_t run_checksum_bench(struct state_bench * const state, const uint64_t count) {
+    uint64_t result = 0;
+
+    for (uint64_t i = 0; i < count; i++) {
+        state->m_data[0] = (uint8_t)i;
+        result += checksum_compute(sum_compute(state->m_data, state->m_size));
+    }
+    sink_bench = result;
+
+    return 0;
+}
+
+/**
+ * @brief Case encode of data in hex text.
+ * @param[in,out] state State for work.
+ * @param[in] count Count operations.
+ * @return 0 or -1 on error.
+ * @note This function is private. Not used outside bench/bench.c
+ */
+static ssize_t run_hex_encode_bench(struct state_bench * const state, const uint64_t count) {
+    char text[MAX_SIZE_BENCH * 2];
+    uint64_t result = 0;
+
+    for (uint64_t i = 0; i < count; i++) {
+        state->m_data[0] = (uint8_t)i;
+        encode_udp_hex(text, state->m_data, state->m_size);
+        result += (uint8_t)text[i % (state->m_size * 2)];
+    }
+    sink_bench = result;
+
+    return 0;
+}
+
+/**
+ * @brief Case decode of hex text in data.
+ * @param[in,out] state State for work.
+ * @param[in] count Count operations.
+ * @return 0 or -1 on error.
+ * @note This function is private. Not used outside bench/bench.c
+ */
+static ssize_t run_hex_decode_bench(struct state_bench * const state, const uint64_t count) {
+    uint8_t data[MAX_SIZE_BENCH];
+    uint64_t result = 0;
+
+    for (uint64_t i = 0; i < count; i++) {
+        if (decode_udp_hex(data, sizeof(data), state->m_hex, state->m_size * 2) < 0)
+            return -1;
+        result += data[i % state->m_size];
+    }
+    sink_bench = result;
+
+    return 0;
+}
+
+/**
+ * @brief Case setters from strings.
+ * @param[in,out] state State for work.
+ * @param[in] count Count operations.
+ * @return 0 or -1 on error.
+ * @note This function is private. Not used outside bench/bench.c
+ */
+static ssize_t run_setters_bench(struct state_bench * const state, const uint64_t count) {
+    for (uint64_t i = 0; i < count; i++) {
+        if (set_port_source_udp_pack(state->m_pack, "8001") || \
+                set_port_destantion_udp_pack(state->m_pack, "8003") || \
+                set_ip_address_source_udp_pack(state->m_pack, "127.0.0.1") || \
+                set_ip_address_destantion_udp_pack(state->m_pack, "127.0.0.2") || \
+                set_mac_address_source_udp_pack(state->m_pack, "02:00:00:00:00:01") || \
+                set_mac_address_destantion_udp_pack(state->m_pack, "02:00:00:00:00:02"))
+            return -1;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Case getters to strings.
+ * @param[in,out] state State for work.
+ * @param[in] count Count operations.
+ * @return 0 or -1 on error.
+ * @note This function is private. Not used outside bench/bench.c
+ */
+static ssize_t run_getters_bench(struct state_bench * const state, const uint64_t count) {
+    char * (* const getters[])(udp_pack_t) = {
+        get_port_source_udp_pack,
+        get_port_destantion_udp_pack,
+        get_ip_address_source_udp_pack,
+        get_ip_address_destantion_udp_pack,
+        get_mac_address_source_udp_pack,
+        get_mac_address_destantion_udp_pack,
+        get_interface_udp_pack,
+        get_data_udp_pack,
+    };
+    uint64_t result = 0;
+
+    for (uint64_t i = 0; i < count; i++) {
+        for (size_t j = 0; j < sizeof(getters) / sizeof(*getters); j++) {
+            char * value = getters[j](state->m_pack);
+
+            if (value == NULL)
+                return -1;
+            result += (uint8_t)value[0];
+            free(value);
+        }
+    }
+    sink_bench = result;
+
+    return 0;
+}
+
+/**
+ * @brief Case build of frame with checksum and send on loopback.
+ * @param[in,out] state State for work.
+ * @param[in] count Count operations.
+ * @return 0 or -1 on error.
+ * @note This function is private. Not used outside bench/bench.c
+ */
+static ssize_t run_send_bench(struct state_bench * const state, const uint64_t count) {
+    if (set_data_udp_pack(state->m_pack, state->m_data, state->m_size))
+        return -1;
+    for (uint64_t i = 0; i < count; i++) {
+        if (send_udp_sender(state->m_sender, state->m_pack))
+            return -1;
+    }
+
+    return 0;
+}
+
+/** All cases in order of output. */
+static const struct case_bench cases_bench[] = {
+    {"init_destroy", 0, run_init_bench},
+    {"add_data_64", 64, run_add_data_bench},
+    {"add_data_1472", 1472, run_add_data_bench},
+    {"set_data_64", 64, run_set_data_bench},
+    {"set_data_1472", 1472, run_set_data_bench},
+    {"checksum_20", 20, run_checksum_bench},
+    {"checksum_64", 64, run_checksum_bench},
+    {"checksum_512", 512, run_checksum_bench},
+    {"checksum_1472", 1472, run_checksum_bench},
+    {"hex_encode_64", 64, run_hex_encode_bench},
+    {"hex_encode_1472", 1472, run_hex_encode_bench},
+    {"hex_decode_64", 64, run_hex_decode_bench},
+    {"hex_decode_1472", 1472, run_hex_decode_bench},
+    {"setters", 0, run_setters_bench},
+    {"getters", 0, run_getters_bench},
+    {"send_loopback_64", 64, run_send_bench},
+    {"send_loopback_1472", 1472, run_send_bench},
+};
+
+/**
+ * @brief Function check if case is chosen by arguments.
+ * @param[in] name Name case.
+ * @param[in] argc Count arguments.
+ * @param[in] argv Arguments.
+ * @return true if case runs.
+ * @note This function is private. Not used outside bench/bench.c
+ */
+static bool is_chosen_bench(const char * const name, const int argc, char ** const argv) {
+    if (argc < 2)
+        return true;
+    for (int i = 1; i < argc; i++) {
+        if (strstr(name, argv[i]) != NULL)
+            return true;
+    }
+
+    return false;
+}
+
+/**
+ * @brief Function run one case and print it.
+ * @param[in,out] state State for work.
+ * @param[in] one Case.
+ * @param[in] is_first Case is first in output.
+ * @return 0 or -1 on error.
+ * @note This function is private. Not used outside bench/bench.c
+ */
+static ssize_t run_case_bench(struct state_bench * const state, \
+        const struct case_bench * const one, const bool is_first) {
+    uint64_t count = 1;
+    uint64_t elapsed = 0;
+    double best = 0.0;
+
+    printf("%s\n    {\"name\": \"%s\"", is_first ? "" : ",", one->m_name);
+    if (one->m_run == run_send_bench && state->m_sender == NULL) {
+        printf(", \"skipped\": true}");
+        return 0;
+    }
+    state->m_size = one->m_size;
+
+    /* Find count of operations for one round. */
+    for (;;) {
+        uint64_t start = now_clock();
+
+        if (one->m_run(state, count))
+            goto run_not_case;
+        elapsed = now_clock() - start;
+        if (elapsed >= MIN_TIME_BENCH)
+            break;
+        count *= elapsed * 2 < MIN_TIME_BENCH / 8 ? 8 : 2;
+    }
+    best = (double)elapsed / count;
+
+    for (size_t i = 1; i < ROUNDS_BENCH; i++) {
+        uint64_t start = now_clock();
+
+        if (one->m_run(state, count))
+            goto run_not_case;
+        elapsed = now_clock() - start;
+        if ((double)elapsed / count < best)
+            best = (double)elapsed / count;
+    }
+
+    printf(", \"iterations\": %lu, \"ns_per_op\": %.2f, \"ops_per_second\": %.0f", \
+            count, best, NSEC_CLOCK / best);
+    if (one->m_size)
+        printf(", \"bytes_per_op\": %u, \"bytes_per_second\": %.0f", \
+                one->m_size, one->m_size * NSEC_CLOCK / best);
+    printf("}");
+
+    return 0;
+run_not_case:
+    printf(", \"error\": true}");
+    fprintf(stderr, "ERROR: case %s failed\n", one->m_name);
+    return -1;
+}
+
+int main(int argc, char ** argv) {
+    int ret = 0;
+    bool is_first = true;
+    struct state_bench * state = calloc(1, sizeof(*state));
+
+    if (state == NULL) {
+        ret = -1;
+        goto get_not_memory;
+    }
+
+    for (size_t i = 0; i < sizeof(state->m_data); i++)
+        state->m_data[i] = (uint8_t)(i * 31 + 7);
+    encode_udp_hex(state->m_hex, state->m_data, sizeof(state->m_data));
+
+    state->m_pack = init_udp_pack();
+    if (state->m_pack == NULL) {
+        ret = -1;
+        goto get_not_pack;
+    }
+    if (set_interface_udp_pack(state->m_pack, "lo") || \
+            run_setters_bench(state, 1)) {
+        ret = -1;
+        goto setting_not_pack;
+    }
+
+    state->m_sender = init_udp_sender("lo");
+
+    printf("{\n  \"compiler\": \"%s\",\n  \"min_round_ns\": %llu,\n  \"rounds\": %d,\n" \
+            "  \"benchmarks\": [", __VERSION__, MIN_TIME_BENCH, ROUNDS_BENCH);
+    for (size_t i = 0; i < sizeof(cases_bench) / sizeof(*cases_bench); i++) {
+        if (!is_chosen_bench(cases_bench[i].m_name, argc, argv))
+            continue;
+        fflush(stdout);
+        if (run_case_bench(state, &cases_bench[i], is_first))
+            ret = -1;
+        is_first = false;
+    }
+    printf("\n  ]\n}\n");
+
+    destroy_udp_sender(state->m_sender);
+setting_not_pack:
+    destroy_udp_pack(state->m_pack);
+get_not_pack:
+    free(state);
+get_not_memory:
+    return ret;
+}
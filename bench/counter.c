@@ -0,0 +1,194 @@
+/**
+ * @file bench/counter.c
+ * @author Vladsanin777
+ * @brief Receiver counting datagrams on port for bench/veth.sh.
+ *
+ * Usage: `counter PORT [IDLE_MS [EXPECTED]]`. Socket is dual stack, so IPv4
+ * and IPv6 are counted. Counter ends after IDLE_MS milliseconds without
+ * datagrams (first datagram is waited @ref START_COUNTER milliseconds) or
+ * when EXPECTED datagrams are received, then prints one JSON line with
+ * datagrams, payload bytes, time from first to last datagram, rates and
+ * datagrams dropped by full receive buffer.
+ */
+
+#include "udp_lib/clock_private.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <errno.h>
+#include <time.h>
+#include <poll.h>
+
+#include <sys/socket.h>
+
+#include <netinet/in.h>
+
+/** Datagrams in one call recvmmsg. */
+#define BATCH_COUNTER 64
+
+/** Max size of datagram. */
+#define SIZE_COUNTER 65536
+
+/** Receive buffer, kernel drops datagrams when it is full. */
+#define BUFFER_COUNTER (64 << 20)
+
+/** Milliseconds wait of first datagram. */
+#define START_COUNTER 10000
+
+/** Default milliseconds without datagrams before end. */
+#define IDLE_COUNTER 1000
+
+/**
+ * @brief Struct is result of counting.
+ * @note This struct is private. Not used outside bench/counter.c
+ */
+struct result_counter {
+    uint64_t m_packets; /**< Received datagrams. */
+    uint64_t m_bytes; /**< Payload bytes of received datagrams. */
+    uint64_t m_first; /**< Nanoseconds of first datagram. */
+    uint64_t m_last; /**< Nanoseconds of last datagram. */
+    uint32_t m_drops; /**< Datagrams dropped by kernel, from SO_RXQ_OVFL. */
+};
+
+/**
+ * @brief Function open dual stack socket on port.
+ * @param[in] port Port.
+ * @return Socket or -1 on error.
+ * @note This function is private. Not used outside bench/counter.c
+ */
+static int open_counter(const uint16_t port) {
+    struct sockaddr_in6 address = {
+        .sin6_family = AF_INET6,
+        .sin6_port = htons(port),
+        .sin6_addr = IN6ADDR_ANY_INIT,
+    };
+    int size = BUFFER_COUNTER;
+    int off = 0;
+    int on = 1;
+    int fd = socket(AF_INET6, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+
+    if (fd < 0) {
+        perror("ERROR: get not socket");
+        return -1;
+    }
+
+    setsockopt(fd, IPPROTO_IPV6, IPV6_V6ONLY, &off, sizeof(off));
+    setsockopt(fd, SOL_SOCKET, SO_RXQ_OVFL, &on, sizeof(on));
+    /* Without CAP_NET_ADMIN buffer is limited by net.core.rmem_max. */
+    if (setsockopt(fd, SOL_SOCKET, SO_RCVBUFFORCE, &size, sizeof(size)))
+        setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &size, sizeof(size));
+
+    if (bind(fd, (struct sockaddr *)&address, sizeof(address))) {
+        perror("ERROR: bind not socket");
+        close(fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+/**
+ * @brief Function receive datagrams until idle or expected count.
+ * @param[in] fd Socket.
+ * @param[in] idle Milliseconds without datagrams before end.
+ * @param[in] expected Count datagrams before end or 0.
+ * @param[out] result Result.
+ * @return 0 or -1 on error.
+ * @note This function is private. Not used outside bench/counter.c
+ */
+static ssize_t count_counter(const int fd, const int idle, const uint64_t expected, \
+        struct result_counter * const result) {
+    static uint8_t buffers[BATCH_COUNTER][SIZE_COUNTER];
+    struct iovec vectors[BATCH_COUNTER];
+    struct mmsghdr messages[BATCH_COUNTER];
+    uint8_t controls[BATCH_COUNTER][CMSG_SPACE(sizeof(uint32_t))];
+    struct pollfd wait = {.fd = fd, .events = POLLIN};
+
+    memset(messages, 0x00, sizeof(messages));
+    for (size_t i = 0; i < BATCH_COUNTER; i++) {
+        vectors[i].iov_base = buffers[i];
+        vectors[i].iov_len = SIZE_COUNTER;
+        messages[i].msg_hdr.msg_iov = &vectors[i];
+        messages[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    while (expected == 0 || result->m_packets < expected) {
+        int ret = poll(&wait, 1, result->m_packets ? idle : START_COUNTER);
+
+        if (ret < 0 && errno == EINTR)
+            continue;
+        if (ret < 0) {
+            perror("ERROR: poll not socket");
+            return -1;
+        }
+        if (ret == 0)
+            break;
+
+        for (size_t i = 0; i < BATCH_COUNTER; i++) {
+            messages[i].msg_hdr.msg_control = controls[i];
+            messages[i].msg_hdr.msg_controllen = sizeof(controls[i]);
+        }
+        ret = recvmmsg(fd, messages, BATCH_COUNTER, MSG_DONTWAIT, NULL);
+        if (ret <= 0)
+            continue;
+
+        result->m_last = now_clock();
+        if (result->m_packets == 0)
+            result->m_first = result->m_last;
+        result->m_packets += ret;
+        for (int i = 0; i < ret; i++) {
+            struct msghdr * message = &messages[i].msg_hdr;
+
+            result->m_bytes += messages[i].msg_len;
+            for (struct cmsghdr * control = CMSG_FIRSTHDR(message); control; \
+                    control = CMSG_NXTHDR(message, control)) {
+                if (control->cmsg_level == SOL_SOCKET && control->cmsg_type == SO_RXQ_OVFL)
+                    memcpy(&result->m_drops, CMSG_DATA(control), sizeof(result->m_drops));
+            }
+        }
+    }
+
+    return 0;
+}
+
+int main(int argc, char ** argv) {
+    int ret = 0;
+    int fd = -1;
+    int idle = IDLE_COUNTER;
+    uint64_t expected = 0;
+    double seconds = 0.0;
+    struct result_counter result = {0};
+
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s PORT [IDLE_MS [EXPECTED]]\n", argv[0]);
+        ret = -1;
+        goto wrong_arguments;
+    }
+    if (argc > 2)
+        idle = atoi(argv[2]);
+    if (argc > 3)
+        expected = strtoull(argv[3], NULL, 0);
+
+    fd = open_counter(strtoul(argv[1], NULL, 0));
+    if (fd < 0) {
+        ret = -1;
+        goto open_not_socket;
+    }
+
+    ret = count_counter(fd, idle, expected, &result);
+
+    seconds = (result.m_last - result.m_first) / (double)NSEC_CLOCK;
+    printf("{\"packets\": %lu, \"bytes\": %lu, \"seconds\": %.6f, \"pps\": %.0f, " \
+            "\"bps\": %.0f, \"drops\": %u}\n", result.m_packets, result.m_bytes, seconds, \
+            seconds > 0.0 ? result.m_packets / seconds : 0.0, \
+            seconds > 0.0 ? result.m_bytes * 8 / seconds : 0.0, result.m_drops);
+
+    close(fd);
+open_not_socket:
+wrong_arguments:
+    return ret;
+}
@@ -0,0 +1,153 @@
+#!/bin/bash
+# End-to-end throughput of udp over veth pair between two network namespaces.
+#
+# Sender runs in namespace udp_tx on vtx, bench/counter runs in namespace
+# udp_rx on vrx. For every backend, payload size, batch and threads one run
+# sends COUNT packets and row with sent and delivered packets, loss and
+# delivered rate is added to table RESULTS.
+#
+# Backends:
+#   single  one frame per send (--pattern), batch and threads are not used;
+#   batch   frames in sendmmsg batches (--imix table of one size, --batch);
+#   queue   producer threads through one queue and sender thread (--threads,
+#           --batch), every thread sends COUNT / THREADS packets.
+#
+# Settings by environment, lists are split by spaces:
+#   SIZES="64 512 1472" BATCHES="1 8 64" THREADS="1 2 4"
+#   BACKENDS="single batch queue" COUNT=200000 FAMILY=4 PORT=9000
+#   RESULTS=bench/veth_results.txt
+#
+# Needs root, run by `sudo make veth` or `sudo ./bench/veth.sh`.
+
+set -u
+
+cd "$(dirname "$0")/.."
+
+SIZES=${SIZES:-"64 512 1472"}
+BATCHES=${BATCHES:-"1 8 64"}
+THREADS=${THREADS:-"1 2 4"}
+BACKENDS=${BACKENDS:-"single batch queue"}
+COUNT=${COUNT:-200000}
+FAMILY=${FAMILY:-4}
+PORT=${PORT:-9000}
+RESULTS=${RESULTS:-bench/veth_results.txt}
+
+NS_TX=udp_tx
+NS_RX=udp_rx
+
+if [ "$(id -u)" != 0 ]; then
+    echo "ERROR: veth harness needs root" >&2
+    exit 1
+fi
+
+if [ ! -x ./udp ] || [ ! -x ./bench/counter ]; then
+    echo "ERROR: build ./udp and ./bench/counter first (make veth)" >&2
+    exit 1
+fi
+
+cleanup() {
+    ip netns del $NS_TX 2>/dev/null
+    ip netns del $NS_RX 2>/dev/null
+}
+
+trap cleanup EXIT
+cleanup
+
+ip netns add $NS_TX || exit 1
+ip netns add $NS_RX || exit 1
+ip link add vtx netns $NS_TX type veth peer name vrx netns $NS_RX || exit 1
+ip -n $NS_TX addr add 10.77.0.1/24 dev vtx
+ip -n $NS_RX addr add 10.77.0.2/24 dev vrx
+ip -n $NS_TX addr add fd77::1/64 dev vtx nodad
+ip -n $NS_RX addr add fd77::2/64 dev vrx nodad
+ip -n $NS_TX link set vtx up
+ip -n $NS_RX link set vrx up
+ip -n $NS_TX link set lo up
+ip -n $NS_RX link set lo up
+
+MAC_RX=$(ip netns exec $NS_RX cat /sys/class/net/vrx/address)
+
+if [ "$FAMILY" = 6 ]; then
+    ADDRESSES="-6 -s fd77::1 -i fd77::2"
+    HEAD_IP=48
+else
+    ADDRESSES="-s 10.77.0.1 -i 10.77.0.2"
+    HEAD_IP=28
+fi
+
+# Sends of one run, arguments are backend, size, batch and threads.
+run_sender() {
+    local backend=$1 size=$2 batch=$3 threads=$4
+
+    case $backend in
+        single)
+            ip netns exec $NS_TX ./udp -n vtx -m "$MAC_RX" $ADDRESSES -p $PORT -o 1000 \
+                --pattern fixed:x --size "$size" -c "$COUNT"
+            ;;
+        batch)
+            ip netns exec $NS_TX ./udp -n vtx -m "$MAC_RX" $ADDRESSES -p $PORT -o 1000 \
+                --batch "$batch" --imix "table:$((size + HEAD_IP)):1" -c "$COUNT"
+            ;;
+        queue)
+            ip netns exec $NS_TX ./udp -n vtx -m "$MAC_RX" $ADDRESSES -p $PORT -o 1000 \
+                --batch "$batch" --pattern fixed:x --size "$size" \
+                --threads "$threads" -c $((COUNT / threads))
+            ;;
+    esac
+}
+
+# One run, adds row to table.
+run_one() {
+    local backend=$1 size=$2 batch=$3 threads=$4
+    local received sent delivered pps bps loss
+
+    received=$(mktemp)
+    ip netns exec $NS_RX ./bench/counter $PORT 1000 > "$received" &
+    local counter=$!
+    while ! ip netns exec $NS_RX ss -Hlun "sport = :$PORT" | grep -q .; do
+        sleep 0.05
+    done
+
+    sent=$(run_sender "$backend" "$size" "$batch" "$threads" 2>/dev/null | \
+        sed -n 's/^sender packages: \([0-9]*\).*/\1/p' | awk '{sum += $1} END {print sum + 0}')
+    wait $counter
+
+    delivered=$(sed -n 's/.*"packets": \([0-9]*\).*/\1/p' "$received")
+    pps=$(sed -n 's/.*"pps": \([0-9]*\).*/\1/p' "$received")
+    bps=$(sed -n 's/.*"bps": \([0-9]*\).*/\1/p' "$received")
+    rm -f "$received"
+
+    loss=$(awk -v s="$sent" -v d="${delivered:-0}" \
+        'BEGIN {printf "%.3f", (s > 0) ? 100 * (s - d) / s : 0}')
+    printf "%-7s %6s %6s %8s %10s %10s %8s %10s %10.1f\n" "$backend" "$size" "$batch" \
+        "$threads" "$sent" "${delivered:-0}" "$loss" "${pps:-0}" \
+        "$(awk -v b="${bps:-0}" 'BEGIN {print b / 1e6}')" | tee -a "$RESULTS"
+}
+
+{
+    echo "# udp veth $(date -u +%Y-%m-%dT%H:%M:%SZ) $(uname -r) IPv$FAMILY count $COUNT"
+    printf "%-7s %6s %6s %8s %10s %10s %8s %10s %10s\n" backend size batch threads \
+        sent delivered loss% pps Mbit/s
+} | tee "$RESULTS"
+
+for backend in $BACKENDS; do
+    for size in $SIZES; do
+        case $backend in
+            single)
+                run_one single "$size" - -
+                ;;
+            batch)
+                for batch in $BATCHES; do
+                    run_one batch "$size" "$batch" -
+                done
+                ;;
+            queue)
+                for batch in $BATCHES; do
+                    for threads in $THREADS; do
+                        run_one queue "$size" "$batch" "$threads"
+                    done
+                done
+                ;;
+        esac
+    done
+done
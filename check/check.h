@@ -0,0 +1,63 @@
+/**
+ * @file check/check.h
+ * @author Vladsanin777
+ * @brief Helpers shared by checks of `make check`.
+ * @note Every check is one program of one file, so state lives here.
+ */
+
+#ifndef CHECK_CHECK_H
+#define CHECK_CHECK_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <stdio.h>
+
+/** Seed of random data, same data on every run. */
+static uint64_t seed_check = 0x9E3779B97F4A7C15ULL;
+
+/** Failed cases. */
+static uint64_t failed_check = 0;
+
+/** Passed cases. */
+static uint64_t passed_check = 0;
+
+/**
+ * @brief Function take next random number by xorshift.
+ * @return Random number.
+ */
+static inline uint64_t random_check(void) {
+    seed_check ^= seed_check << 13;
+    seed_check ^= seed_check >> 7;
+    seed_check ^= seed_check << 17;
+    return seed_check;
+}
+
+/**
+ * @brief Function count result of case and print failed case.
+ * @param[in] is_passed Case passed.
+ * @param[in] name Name of check.
+ * @param[in] what Name of case.
+ * @param[in] value Size or other number of case.
+ */
+static inline void expect_check(const bool is_passed, const char * const name, \
+        const char * const what, const size_t value) {
+    if (is_passed) {
+        passed_check++;
+        return;
+    }
+    failed_check++;
+    printf("FAIL %s %s %zu\n", name, what, value);
+}
+
+/**
+ * @brief Function print result of check.
+ * @param[in] name Name of check.
+ * @return Exit status of program.
+ */
+static inline int report_check(const char * const name) {
+    printf("%s passed: %lu failed: %lu\n", name, passed_check, failed_check);
+    return failed_check ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+#endif /* CHECK_CHECK_H */
@@ -0,0 +1,154 @@
+/**
+ * @file check/flow.c
+ * @author Vladsanin777
+ * @brief Check of checksums of flows taken from sums of payload for every size.
+ *
+ * Code file of flows is included, so private functions are called directly.
+ * Flow of IPv4 and IPv6 is built from package with payload of odd and even
+ * sizes, every frame of flow is wrapped for many sizes and checked by plain
+ * one's complement sum over pseudo header, UDP header and payload, and over
+ * IPv4 header. Run by `make check`, exit status is 0 only if all cases passed.
+ */
+
+#include "udp_lib/flow.c"
+#include "check/check.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+
+/** Every size is checked up to this size. */
+#define MAX_EVERY_CHECK 2048
+
+/** Step of sizes above @ref MAX_EVERY_CHECK. */
+#define STEP_SIZE_CHECK 997
+
+/**
+ * @brief Function sum bytes in big endian words, not folded.
+ * @param[in] data Bytes.
+ * @param[in] size Count bytes.
+ * @return Sum.
+ * @note This function is private. Not used outside check/flow.c
+ */
+static uint64_t sum_check(const void * const data, const size_t size) {
+    const uint8_t * bytes = data;
+    uint64_t sum = 0;
+
+    for (size_t i = 0; i < size; i++)
+        sum += i & 1 ? bytes[i] : bytes[i] << 8;
+
+    return sum;
+}
+
+/**
+ * @brief Function fold sum in 16 bits.
+ * @param[in] sum Sum.
+ * @return Folded sum, 0xFFFF for valid checksum.
+ * @note This function is private. Not used outside check/flow.c
+ */
+static uint16_t fold_check(uint64_t sum) {
+    while (sum >> 16)
+        sum = (sum & 0xFFFF) + (sum >> 16);
+
+    return sum;
+}
+
+/**
+ * @brief Function check checksums of one frame of flow.
+ * @param[in] flow Flow.
+ * @param[in] frame Headers of frame.
+ * @param[in] payload Payload of frame.
+ * @param[in] size Size payload.
+ * @return true if checksums are valid.
+ * @note This function is private. Not used outside check/flow.c
+ */
+static bool is_valid_check(const struct one_flow * const flow, \
+        const struct udp_frame * const frame, const uint8_t * const payload, \
+        const uint16_t size) {
+    const struct udp_head * head = (const struct udp_head *)(frame->m_l3 + flow->m_size_ip);
+    uint16_t length = HEAD_UDP + size;
+    uint64_t sum = IPPROTO_UDP + length + sum_check(head, HEAD_UDP) + sum_check(payload, size);
+
+    if (ntohs(head->m_length) != length)
+        return false;
+
+    if (flow->m_family == AF_INET6) {
+        sum += sum_check(&frame->m_ip6hdr.ip6_src, sizeof(struct in6_addr) * 2);
+        return ntohs(frame->m_ip6hdr.ip6_plen) == length && fold_check(sum) == 0xFFFF;
+    }
+
+    sum += sum_check(&frame->m_iphdr.saddr, sizeof(uint32_t) * 2);
+    return ntohs(frame->m_iphdr.tot_len) == HEAD_IP + length && fold_check(sum) == 0xFFFF && \
+            fold_check(sum_check(&frame->m_iphdr, HEAD_IP)) == 0xFFFF;
+}
+
+/**
+ * @brief Function check flow of family with payload of given size.
+ * @param[in,out] state State scheduler with package.
+ * @param[in] family AF_INET or AF_INET6.
+ * @param[in] size_data Size payload of package.
+ * @note This function is private. Not used outside check/flow.c
+ */
+static void check_flow(struct state_flow * const state, const uint8_t family, \
+        const uint16_t size_data) {
+    udp_pack_t pack = state->m_pack;
+    struct one_flow * flow = NULL;
+    struct udp_frame frame;
+    size_t max = 0;
+
+    set_family_udp_pack(pack, family);
+    set_ip_address_source_udp_pack(pack, family == AF_INET ? "10.0.0.1" : "fd00::1");
+    set_ip_address_destantion_udp_pack(pack, family == AF_INET ? "10.0.0.2" : "fd00::2");
+    set_size_udp_pack(pack, size_data);
+    for (size_t i = 0; i < size_data; i++)
+        pack->m_data[i] = random_check();
+
+    state->m_count = 0;
+    fill_payload_flow(state);
+    if (add_flow(state)) {
+        expect_check(false, "flow add", family == AF_INET ? "ipv4" : "ipv6", size_data);
+        return;
+    }
+    flow = &state->m_flows[0];
+
+    max = 0xFFFF - flow->m_size_ip - HEAD_UDP;
+    for (size_t size = 0; size <= max; size += size < MAX_EVERY_CHECK ? 1 : STEP_SIZE_CHECK) {
+        flow->m_next = flow->m_size_ip + HEAD_UDP + size;
+        wrap_flow(flow, &frame, state->m_prefix);
+        expect_check(is_valid_check(flow, &frame, state->m_payload, size), \
+                family == AF_INET ? "flow ipv4 data" : "flow ipv6 data", "size", size);
+    }
+}
+
+int main(void) {
+    static const uint16_t sizes[] = {0, 1, 2, 3, 7, 64, 333, 1471, 1472};
+    struct state_flow * state = calloc(1, sizeof(*state));
+
+    if (state == NULL) {
+        perror("ERROR: get not memory");
+        return EXIT_FAILURE;
+    }
+    state->m_pack = init_udp_pack();
+    if (state->m_pack == NULL) {
+        free(state);
+        return EXIT_FAILURE;
+    }
+    /* Size of flow is checked against MTU only on add, sizes here go above. */
+    state->m_mtu = 0xFFFF;
+    state->m_weight = 1;
+    set_port_source_udp_pack(state->m_pack, "4242");
+    set_port_destantion_udp_pack(state->m_pack, "5000");
+
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(*sizes); i++) {
+        check_flow(state, AF_INET, sizes[i]);
+        check_flow(state, AF_INET6, sizes[i]);
+    }
+
+    free(state->m_flows);
+    destroy_udp_pack(state->m_pack);
+    free(state);
+
+    return report_check("flow");
+}
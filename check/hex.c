@@ -0,0 +1,182 @@
+/**
+ * @file check/hex.c
+ * @author Vladsanin777
+ * @brief Check of hex codec: SIMD paths against scalar path.
+ *
+ * Code file of codec is included, so private paths are called directly. Every
+ * path supported by CPU encodes and decodes random data of every size up to
+ * @ref MAX_SIZE_CHECK, sizes go over edges of blocks of 16 and 32 bytes. Every
+ * char is put in every place of block of digits, only hex digits must be
+ * decoded. Public functions must reject odd count digits and too small buffer.
+ * Run by `make check`, exit status is 0 only if all cases passed.
+ */
+
+#include "udp_lib/hex.c"
+#include "check/check.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <ctype.h>
+
+/** Max size data in cases, some blocks of AVX2 and tail. */
+#define MAX_SIZE_CHECK 200
+
+/** Count digits in case with one wrong char, two blocks of AVX2. */
+#define SIZE_CHARS_CHECK 128
+
+/**
+ * @brief Struct is one path of codec.
+ * @note This struct is private. Not used outside check/hex.c
+ */
+struct path_check {
+    const char * m_name; /**< Name in output. */
+    bool m_is_supported; /**< CPU has instructions of path. */
+    size_t (*m_encode)(char * const text, const uint8_t * const data, \
+            const size_t size); /**< Encoder of whole blocks, NULL for scalar. */
+    ssize_t (*m_decode)(uint8_t * const data, const char * const text, \
+            const size_t size); /**< Decoder of whole blocks, NULL for scalar. */
+};
+
+/**
+ * @brief Function encode by path: whole blocks by path, tail by scalar path.
+ * @param[in] path Path.
+ * @param[out] text Buffer at least 2 * size chars.
+ * @param[in] data Bytes.
+ * @param[in] size Count bytes.
+ * @note This function is private. Not used outside check/hex.c
+ */
+static void encode_check(const struct path_check * const path, char * const text, \
+        const uint8_t * const data, const size_t size) {
+    size_t done = path->m_encode ? path->m_encode(text, data, size) : 0;
+
+    encode_scalar_hex(text + done * 2, data + done, size - done);
+}
+
+/**
+ * @brief Function decode by path: whole blocks by path, tail by scalar path.
+ * @param[in] path Path.
+ * @param[out] data Buffer for bytes, size / 2.
+ * @param[in] text Hex text.
+ * @param[in] size Count chars, even.
+ * @return 0 or -1 if text has not hex char.
+ * @note This function is private. Not used outside check/hex.c
+ */
+static ssize_t decode_check(const struct path_check * const path, uint8_t * const data, \
+        const char * const text, const size_t size) {
+    ssize_t done = path->m_decode ? path->m_decode(data, text, size) : 0;
+
+    if (done < 0)
+        return -1;
+    return decode_scalar_hex(data + done, text + done * 2, size - done * 2);
+}
+
+/**
+ * @brief Function check path on random data of every size, digits in random case.
+ * @param[in] path Path.
+ * @note This function is private. Not used outside check/hex.c
+ */
+static void check_round_trip(const struct path_check * const path) {
+    uint8_t data[MAX_SIZE_CHECK];
+    uint8_t decoded[MAX_SIZE_CHECK];
+    char expected[MAX_SIZE_CHECK * 2];
+    char text[MAX_SIZE_CHECK * 2];
+
+    for (size_t size = 0; size <= MAX_SIZE_CHECK; size++) {
+        for (size_t i = 0; i < size; i++)
+            data[i] = random_check();
+        for (size_t i = 0; i < size; i++) {
+            expected[i * 2] = digits_hex[data[i] >> 4];
+            expected[i * 2 + 1] = digits_hex[data[i] & 0x0F];
+        }
+
+        memset(text, 0x00, sizeof(text));
+        encode_check(path, text, data, size);
+        expect_check(memcmp(text, expected, size * 2) == 0, "hex encode", \
+                path->m_name, size);
+
+        for (size_t i = 0; i < size * 2; i++) {
+            if (random_check() & 1)
+                text[i] = toupper((unsigned char)text[i]);
+        }
+        memset(decoded, 0x00, sizeof(decoded));
+        expect_check(decode_check(path, decoded, text, size * 2) == 0 && \
+                memcmp(decoded, data, size) == 0, "hex decode", path->m_name, size);
+    }
+}
+
+/**
+ * @brief Function check path on every char in every place of digits.
+ * @param[in] path Path.
+ * @note This function is private. Not used outside check/hex.c
+ */
+static void check_chars(const struct path_check * const path) {
+    char text[SIZE_CHARS_CHECK];
+    uint8_t data[SIZE_CHARS_CHECK / 2];
+
+    for (int symbol = 0; symbol < 256; symbol++) {
+        bool is_digit = isxdigit(symbol);
+        bool is_passed = true;
+
+        for (size_t place = 0; place < SIZE_CHARS_CHECK; place++) {
+            ssize_t ret = 0;
+
+            memset(text, '7', sizeof(text));
+            text[place] = symbol;
+            ret = decode_check(path, data, text, sizeof(text));
+            if (is_digit)
+                is_passed &= ret == 0 && data[place / 2] == (place % 2 ? \
+                        0x70 | value_hex(symbol) : (value_hex(symbol) << 4 | 0x07));
+            else
+                is_passed &= ret < 0;
+        }
+        expect_check(is_passed, "hex char", path->m_name, symbol);
+    }
+}
+
+/**
+ * @brief Function check public functions reject wrong sizes.
+ * @note This function is private. Not used outside check/hex.c
+ */
+static void check_sizes(void) {
+    uint8_t data[MAX_SIZE_CHECK];
+    char text[MAX_SIZE_CHECK * 2 + 1];
+
+    memset(text, 'a', sizeof(text));
+    for (size_t size = 1; size <= sizeof(text); size += 2)
+        expect_check(decode_udp_hex(data, sizeof(data), text, size) < 0, \
+                "hex public", "odd", size);
+    for (size_t size = 0; size <= MAX_SIZE_CHECK; size++) {
+        expect_check(decode_udp_hex(data, size, text, size * 2) == (ssize_t)size, \
+                "hex public", "fit", size);
+        if (size)
+            expect_check(decode_udp_hex(data, size - 1, text, size * 2) < 0, \
+                    "hex public", "big", size);
+    }
+    expect_check(encode_udp_hex(text, data, MAX_SIZE_CHECK) == MAX_SIZE_CHECK * 2, \
+            "hex public", "encode", MAX_SIZE_CHECK);
+}
+
+int main(void) {
+    struct path_check paths[] = {
+        {"scalar", true, NULL, NULL},
+#if defined(__x86_64__) || defined(__i386__)
+        {"ssse3", __builtin_cpu_supports("ssse3"), encode_ssse3_hex, decode_ssse3_hex},
+        {"avx2", __builtin_cpu_supports("avx2"), encode_avx2_hex, decode_avx2_hex},
+#endif
+    };
+
+    for (size_t i = 0; i < sizeof(paths) / sizeof(*paths); i++) {
+        if (!paths[i].m_is_supported) {
+            printf("skip hex %s: not supported by CPU\n", paths[i].m_name);
+            continue;
+        }
+        check_round_trip(&paths[i]);
+        check_chars(&paths[i]);
+    }
+    check_sizes();
+
+    return report_check("hex");
+}
@@ -0,0 +1,195 @@
+/**
+ * @file check/imix.c
+ * @author Vladsanin777
+ * @brief Check of alias table of imix against weights of profile.
+ *
+ * Code file of imix is included, so private functions are called directly.
+ * For every profile probability of every class is taken exactly from alias
+ * table and compared with its share of weights, picker is run and counts of
+ * classes are compared with expected counts. Wrong profiles must be rejected.
+ * Run by `make check`, exit status is 0 only if all cases passed.
+ */
+
+#include "udp_lib/imix.c"
+#include "check/check.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <math.h>
+
+/** Max difference of probability from alias table and share of weights. */
+#define EPSILON_CHECK 1e-9
+
+/** Picks of picker for every profile. */
+#define PICKS_CHECK 1000000
+
+/** Max difference of count of class from expected count in standard deviations. */
+#define SIGMAS_CHECK 6.0
+
+/** Count classes of profile with random weights. */
+#define COUNT_RANDOM_CHECK 1000
+
+/**
+ * @brief Function parse profile and build alias table.
+ * @param[in] profile Profile string.
+ * @return Imix without frames or NULL on error.
+ * @note This function is private. Not used outside check/imix.c
+ */
+static udp_imix_t init_check(const char * const profile) {
+    udp_imix_t imix = calloc(1, sizeof(*imix));
+
+    if (imix == NULL)
+        return NULL;
+    imix->m_random = SEED_IMIX;
+    if (parse_imix(imix, profile) || build_alias_imix(imix)) {
+        free(imix->m_classes);
+        free(imix);
+        return NULL;
+    }
+
+    return imix;
+}
+
+/**
+ * @brief Function check alias table and picker of profile.
+ * @param[in] profile Profile string.
+ * @param[in] name Name of profile in output.
+ * @note This function is private. Not used outside check/imix.c
+ */
+static void check_profile(const char * const profile, const char * const name) {
+    udp_imix_t imix = init_check(profile);
+    double * probability = NULL;
+    uint64_t * picks = NULL;
+    double total = 0.0;
+    bool is_table = true;
+    bool is_exact = true;
+    bool is_picked = true;
+
+    if (imix == NULL) {
+        expect_check(false, "imix build", name, 0);
+        return;
+    }
+    probability = calloc(imix->m_count, sizeof(*probability));
+    picks = calloc(imix->m_count, sizeof(*picks));
+    if (probability == NULL || picks == NULL) {
+        expect_check(false, "imix memory", name, 0);
+        goto get_not_memory;
+    }
+
+    for (size_t i = 0; i < imix->m_count; i++) {
+        const struct class_imix * class = &imix->m_classes[i];
+        double taken = class->m_threshold / (double)(1ULL << 32);
+
+        is_table &= class->m_threshold <= 1ULL << 32 && class->m_alias < imix->m_count;
+        probability[i] += taken / imix->m_count;
+        if (class->m_alias < imix->m_count)
+            probability[class->m_alias] += (1.0 - taken) / imix->m_count;
+        total += class->m_weight;
+    }
+    expect_check(is_table, "imix table", name, imix->m_count);
+
+    for (size_t i = 0; i < imix->m_count; i++)
+        is_exact &= fabs(probability[i] - imix->m_classes[i].m_weight / total) < EPSILON_CHECK;
+    expect_check(is_exact, "imix probability", name, imix->m_count);
+
+    for (size_t i = 0; i < PICKS_CHECK; i++)
+        picks[pick_imix(imix)]++;
+    for (size_t i = 0; i < imix->m_count; i++) {
+        double expected = PICKS_CHECK * probability[i];
+        double sigma = sqrt(expected * (1.0 - probability[i]));
+
+        is_picked &= fabs(picks[i] - expected) <= SIGMAS_CHECK * sigma + 1.0;
+    }
+    expect_check(is_picked, "imix picks", name, PICKS_CHECK);
+
+get_not_memory:
+    free(picks);
+    free(probability);
+    free(imix->m_classes);
+    free(imix);
+}
+
+/**
+ * @brief Function check profile is rejected.
+ * @param[in] profile Profile string.
+ * @note This function is private. Not used outside check/imix.c
+ */
+static void check_wrong(const char * const profile) {
+    udp_imix_t imix = NULL;
+    int saved = dup(STDERR_FILENO);
+    int null = open("/dev/null", O_WRONLY);
+
+    /* Errors of rejected profiles are expected, they are not printed. */
+    fflush(stderr);
+    if (null >= 0)
+        dup2(null, STDERR_FILENO);
+    imix = init_check(profile);
+    fflush(stderr);
+    if (saved >= 0)
+        dup2(saved, STDERR_FILENO);
+
+    expect_check(imix == NULL, "imix wrong", profile, 0);
+    if (imix != NULL) {
+        free(imix->m_classes);
+        free(imix);
+    }
+    if (null >= 0)
+        close(null);
+    if (saved >= 0)
+        close(saved);
+}
+
+int main(void) {
+    static const char * const profiles[] = {
+        "imix",
+        "uniform:64-1500",
+        "uniform:100-100",
+        "table:64:1",
+        "table:64:1,1500:0",
+        "table:64:0,128:0,256:5",
+        "table:64:1,1500:4294967295",
+        "table:64:3,128:3,256:3",
+        "table:40:7,576:4,1500:1,9000:0,100:13",
+    };
+    static const char * const wrongs[] = {
+        "",
+        "table:",
+        "table:64",
+        "table:64:",
+        "table:64:1,",
+        "table:64:0",
+        "table:64:0,128:0",
+        "table:64:1,x:2",
+        "table:70000:1",
+        "uniform:100-50",
+        "uniform:64-70000",
+        "random",
+    };
+    char * profile = malloc(COUNT_RANDOM_CHECK * sizeof("65535:4294967295,") + sizeof("table:"));
+    size_t used = 0;
+
+    if (profile == NULL) {
+        perror("ERROR: get not memory");
+        return EXIT_FAILURE;
+    }
+
+    for (size_t i = 0; i < sizeof(profiles) / sizeof(*profiles); i++)
+        check_profile(profiles[i], profiles[i]);
+
+    used = sprintf(profile, "table:");
+    for (size_t i = 0; i < COUNT_RANDOM_CHECK; i++)
+        used += sprintf(profile + used, "%s%lu:%lu", i ? "," : "", 64 + i, \
+                random_check() % 1000 * (random_check() % 1000));
+    check_profile(profile, "table:random");
+    free(profile);
+
+    for (size_t i = 0; i < sizeof(wrongs) / sizeof(*wrongs); i++)
+        check_wrong(wrongs[i]);
+
+    return report_check("imix");
+}
@@ -1,7 +1,64 @@
 #include "udp_lib/udp.h"
+#include "udp_lib/loadgen.h"
+#include "udp_lib/stream.h"
+#include "udp_lib/replay.h"
+#include "udp_lib/store.h"
+#include "udp_lib/scenario.h"
+#include "udp_lib/daemon.h"
+#include "udp_lib/ring.h"
+#include "udp_lib/queue.h"
+#include "udp_lib/coalesce.h"
+#include "udp_lib/pattern.h"
+#include "udp_lib/imix.h"
+#include "udp_lib/flow.h"
+#include "udp_lib/stage.h"
+#include "udp_lib/export.h"
+#include "udp_lib/encap.h"
 #include <getopt.h>
 #include <stddef.h>
+#include <stdio.h>
 #include <string.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <sys/socket.h>
+
+/**
+ * @brief Codes for options without short name.
+ */
+enum long_option {
+    OPTION_OPEN_LOOP = 0x100, /**< `--open-loop` */
+    OPTION_TIMEOUT, /**< `--timeout` */
+    OPTION_ID_OFFSET, /**< `--id-offset` */
+    OPTION_OUTSTANDING, /**< `--outstanding` */
+    OPTION_STREAM, /**< `--stream` */
+    OPTION_TSC, /**< `--tsc` */
+    OPTION_ANALYZE, /**< `--analyze` */
+    OPTION_REPLAY, /**< `--replay` */
+    OPTION_SPEED, /**< `--speed` */
+    OPTION_MAX_SPEED, /**< `--max-speed` */
+    OPTION_PCAP, /**< `--pcap` */
+    OPTION_STORE, /**< `--store` */
+    OPTION_BLAST, /**< `--blast` */
+    OPTION_SCENARIO, /**< `--scenario` */
+    OPTION_DAEMON, /**< `--daemon` */
+    OPTION_SUBMIT, /**< `--submit` */
+    OPTION_RING, /**< `--ring` */
+    OPTION_BUSY_POLL, /**< `--busy-poll` */
+    OPTION_THREADS, /**< `--threads` */
+    OPTION_COALESCE, /**< `--coalesce` */
+    OPTION_DEFRAME, /**< `--deframe` */
+    OPTION_PATTERN, /**< `--pattern` */
+    OPTION_SIZE, /**< `--size` */
+    OPTION_IMIX, /**< `--imix` */
+    OPTION_FLOWS, /**< `--flows` */
+    OPTION_STAGES, /**< `--stages` */
+    OPTION_EXPORT, /**< `--export` */
+    OPTION_EXPORT_FORMAT, /**< `--export-format` */
+    OPTION_BATCH, /**< `--batch` */
+    OPTION_ENCAP, /**< `--encap` */
+    OPTION_PRINT_HEX, /**< `--print-hex` */
+    OPTION_IDLE, /**< `--idle` */
+};
 
 /**
  * @brief Entry point for the UDP packet crafting and transmission utility.
@@ -13,17 +70,75 @@
  * **Command-line Options:**
  * - `-w`, `--stdio`                  Read payload data from standard input.
  * - `-e`, `--print`                  Print the packet structure to the console before sending.
- * - `-i`, `--ip-address-destination` Set the destination IPv4 address.
- * - `-s`, `--ip-address-source`      Set the source IPv4 address.
+ * - `-i`, `--ip-address-destination` Set the destination IPv4 (IPv6 with `-6`) address.
+ * - `-s`, `--ip-address-source`      Set the source IPv4 (IPv6 with `-6`) address.
+ * - `-6`, `--ipv6`                   Build IPv6 packet.
  * - `-p`, `--port-destanition`       Set the destination UDP port.
  * - `-o`, `--port-source`            Set the source UDP port.
  * - `-n`, `--interface`              Specify the network interface (e.g., eth0).
  * - `-f`, `--file`                   Read payload data from a specified file.
- * - `-m`, `--mac-address-destantion` Set the destination MAC address.
- * - `-a`, `--mac-address-source`     Set the source MAC address.
+ * - `-x`, `--hex`                    Set payload data from hex digits (e.g. `deadbeef`).
+ * - `-m`, `--mac-address-destantion` Set the destination MAC address, by default
+ *                                    resolved from route and neighbor table.
+ * - `-a`, `--mac-address-source`     Set the source MAC address, by default MAC interface.
+ * - `-r`, `--rate`                   Packets per second for `--open-loop` and `--stream`.
+ * - `-c`, `--count`                  Count packets for `--open-loop`, `--stream` and `--analyze`.
+ * - `--open-loop`                    Send requests by fixed schedule, match replies
+ *                                    by ID in data and print latency report.
+ * - `--timeout`                      Milliseconds wait reply before request is lost.
+ * - `--id-offset`                    Offset 64-bit request ID in data.
+ * - `--outstanding`                  Max requests waiting reply, from 1 to 16777216.
+ * - `--stream`                       Send packets with header stream ID, sequence and timestamp.
+ * - `--tsc`                          Timestamp in header stream from rdtsc instead of CLOCK_REALTIME.
+ * - `--analyze`                      Receive packets with header stream on port and print
+ *                                    loss, duplicates, reordering and one-way delay.
+ * - `--replay`                       Send frames from pcap or pcapng file with timing of capture,
+ *                                    `-c` passes over file. Given `-m`, `-a`, `-i`, `-s`, `-p`
+ *                                    and `-o` rewrite addresses and ports in frames.
+ * - `--speed`                        Multiplier timing of capture for `--replay`.
+ * - `--max-speed`                    Send frames of `--replay` as fast as possible.
+ * - `--pcap`                         Write frames in pcap file instead of interface, root is not needed.
+ * - `--store`                        Write ready frames in store file instead of interface.
+ * - `--blast`                        Send all frames of store file as fast as possible, `-c` passes.
+ * - `--scenario`                     Send packets described by lines of file, other options
+ *                                    give start values of fields.
+ * - `--daemon`                       Run daemon with warm senders, it sends packets requested
+ *                                    on unix socket until SIGINT or SIGTERM.
+ * - `--submit`                       Send packet through daemon listening unix socket.
+ * - `--ring`                         Give shared memory ring to producer on unix socket and
+ *                                    send its payloads with headers of packet.
+ * - `--busy-poll`                    Spin on `--ring` instead of sleep on eventfd.
+ * - `--threads`                      Send `-c` packets from every of given threads through one
+ *                                    queue and one sender thread.
+ * - `--coalesce`                     Send lines of stdin as length framed messages packed in
+ *                                    packets up to MTU, packet waits first message at most
+ *                                    given microseconds.
+ * - `--deframe`                      Receive packets of `--coalesce` on port and print messages.
+ * - `--idle`                         Milliseconds without packets before `--analyze` and
+ *                                    `--deframe` stop, first packet is waited without limit.
+ * - `--pattern`                      Generate payload: `random[:SEED]`, `counter[:START]`,
+ *                                    `fixed:TEXT` or `file:PATH`, every of `-c` packets
+ *                                    gets next payload.
+ * - `--size`                         Size payload of `--pattern`.
+ * - `--imix`                         Send `-c` packets with IP sizes by profile: `imix`,
+ *                                    `uniform:MIN-MAX` or `table:SIZE:WEIGHT,...`.
+ * - `--flows`                        Send `-c` packets of flows from lines of file shared by
+ *                                    weights, `-r` limits all flows together.
+ * - `--stages`                       Measure stages of send path by TSC and print histograms
+ *                                    on exit and on SIGUSR1.
+ * - `--export`                       Export counters of senders to `unix:PATH` (plain or HTTP
+ *                                    GET) or `file:PATH` rewritten every second.
+ * - `--export-format`                Format of `--export`: `prometheus` (default) or `json`.
+ * - `--batch`                        Max frames in one sendmmsg, from 1 to 64 (default).
+ * - `--encap`                        Wrap frames in tunnel: `vlan:VID[:PCP]`, `qinq:SVID:CVID`,
+ *                                    `vxlan:VNI:SOURCE:DESTINATION[:PORT]` or
+ *                                    `gre:SOURCE:DESTINATION[:KEY]`, for single package,
+ *                                    `--pattern`, `--stream`, `--open-loop`, `--scenario`
+ *                                    and `--coalesce`.
+ * - `--print-hex`                    Print payload as hex digits, implies `-e`.
  * 
  * **Payload Logic:**
- * 1. If `-w` or `-f` is provided, the data is pulled from those sources.
+ * 1. If `-w`, `-f` or `-x` is provided, the data is pulled from those sources.
  * 2. If no source flag is provided, the program concatenates all remaining 
  *    positional arguments (argv) into a single space-separated string payload.
  * 
@@ -40,6 +155,52 @@ int main(int argc, char ** argv) {
     int cmd = true;
     bool is_print = false;
     int option_index = 0;
+    bool is_open_loop = false;
+    bool is_stream = false;
+    uint64_t count = 1;
+    uint64_t rate = 0;
+    char * analyze = NULL;
+    char * replay_file = NULL;
+    char * blast_file = NULL;
+    char * scenario_file = NULL;
+    char * daemon_path = NULL;
+    char * submit_path = NULL;
+    char * ring_path = NULL;
+    size_t threads = 0;
+    bool is_coalesce = false;
+    char * deframe = NULL;
+    uint64_t idle = DEFAULT_IDLE_STREAM;
+    char * pattern_spec = NULL;
+    uint16_t size = DEFAULT_SIZE_PATTERN;
+    udp_pattern_t pattern = NULL;
+    char * imix = NULL;
+    char * flows_file = NULL;
+    char * export_place = NULL;
+    char * encap = NULL;
+    uint8_t export_format = PROMETHEUS_EXPORT;
+    char * ip_destantion = NULL;
+    char * ip_source = NULL;
+    int family = AF_INET;
+    struct udp_stream_config stream = {
+        .m_clock = CLOCK_REALTIME_STREAM,
+    };
+    struct udp_loadgen_config loadgen = {
+        .m_rate = DEFAULT_RATE_LOADGEN,
+        .m_timeout = DEFAULT_TIMEOUT_LOADGEN,
+        .m_outstanding = DEFAULT_OUTSTANDING_LOADGEN,
+        .m_id_offset = 0,
+    };
+    struct udp_replay_config replay = {
+        .m_timing = TIMING_ORIGINAL_REPLAY,
+        .m_speed = 1.0,
+    };
+    struct udp_coalesce_config coalesce = {
+        .m_delay = DEFAULT_DELAY_COALESCE,
+    };
+    struct udp_ring_config ring = {
+        .m_mode = MODE_EVENT_RING,
+        .m_size = DEFAULT_SIZE_RING,
+    };
 
     static struct option long_options[] = { \
         {"stdio", no_argument, NULL, 'w'}, \
@@ -50,8 +211,44 @@ int main(int argc, char ** argv) {
         {"port-source", 1, NULL, 'o'}, \
         {"interface", 1, NULL, 'n'}, \
         {"file", 1, NULL, 'f'}, \
+        {"hex", 1, NULL, 'x'}, \
         {"mac-address-destantion", 1, NULL, 'm'}, \
         {"mac-address-source", 1, NULL, 'a'}, \
+        {"ipv6", no_argument, NULL, '6'}, \
+        {"rate", 1, NULL, 'r'}, \
+        {"count", 1, NULL, 'c'}, \
+        {"open-loop", no_argument, NULL, OPTION_OPEN_LOOP}, \
+        {"timeout", 1, NULL, OPTION_TIMEOUT}, \
+        {"id-offset", 1, NULL, OPTION_ID_OFFSET}, \
+        {"outstanding", 1, NULL, OPTION_OUTSTANDING}, \
+        {"stream", 1, NULL, OPTION_STREAM}, \
+        {"tsc", no_argument, NULL, OPTION_TSC}, \
+        {"analyze", 1, NULL, OPTION_ANALYZE}, \
+        {"replay", 1, NULL, OPTION_REPLAY}, \
+        {"speed", 1, NULL, OPTION_SPEED}, \
+        {"max-speed", no_argument, NULL, OPTION_MAX_SPEED}, \
+        {"pcap", 1, NULL, OPTION_PCAP}, \
+        {"store", 1, NULL, OPTION_STORE}, \
+        {"blast", 1, NULL, OPTION_BLAST}, \
+        {"scenario", 1, NULL, OPTION_SCENARIO}, \
+        {"daemon", 1, NULL, OPTION_DAEMON}, \
+        {"submit", 1, NULL, OPTION_SUBMIT}, \
+        {"ring", 1, NULL, OPTION_RING}, \
+        {"busy-poll", no_argument, NULL, OPTION_BUSY_POLL}, \
+        {"threads", 1, NULL, OPTION_THREADS}, \
+        {"coalesce", 1, NULL, OPTION_COALESCE}, \
+        {"deframe", 1, NULL, OPTION_DEFRAME}, \
+        {"pattern", 1, NULL, OPTION_PATTERN}, \
+        {"size", 1, NULL, OPTION_SIZE}, \
+        {"imix", 1, NULL, OPTION_IMIX}, \
+        {"flows", 1, NULL, OPTION_FLOWS}, \
+        {"stages", no_argument, NULL, OPTION_STAGES}, \
+        {"export", 1, NULL, OPTION_EXPORT}, \
+        {"export-format", 1, NULL, OPTION_EXPORT_FORMAT}, \
+        {"batch", 1, NULL, OPTION_BATCH}, \
+        {"encap", 1, NULL, OPTION_ENCAP}, \
+        {"print-hex", no_argument, NULL, OPTION_PRINT_HEX}, \
+        {"idle", 1, NULL, OPTION_IDLE}, \
         {NULL, 0, NULL, '\0'}, \
     };
 
@@ -63,7 +260,7 @@ int main(int argc, char ** argv) {
     }
 
     while (cmd) {
-        cmd = getopt_long(argc, argv, "wei:s:p:o:n:f:m:a:", long_options, &option_index);
+        cmd = getopt_long(argc, argv, "wei:s:p:o:n:f:x:m:a:6r:c:", long_options, &option_index);
 
         switch (cmd) {
             case 'w':
@@ -74,16 +271,23 @@ int main(int argc, char ** argv) {
                 is_print = true;
                 break;
             case 'i':
-                ret = set_ip_address_destantion_udp_pack(pack, optarg);
+                ip_destantion = optarg;
+                replay.m_rewrite |= REWRITE_IP_DESTANTION_REPLAY;
                 break;
             case 's':
-                ret = set_ip_address_source_udp_pack(pack, optarg);
+                ip_source = optarg;
+                replay.m_rewrite |= REWRITE_IP_SOURCE_REPLAY;
+                break;
+            case '6':
+                family = AF_INET6;
                 break;
             case 'p':
                 ret = set_port_destantion_udp_pack(pack, optarg);
+                replay.m_rewrite |= REWRITE_PORT_DESTANTION_REPLAY;
                 break;
             case 'o':
                 ret = set_port_source_udp_pack(pack, optarg);
+                replay.m_rewrite |= REWRITE_PORT_SOURCE_REPLAY;
                 break;
             case 'n':
                 ret = set_interface_udp_pack(pack, optarg);
@@ -92,11 +296,139 @@ int main(int argc, char ** argv) {
                 data = cmd;
                 ret = set_file_data_udp_pack(pack, optarg);
                 break;
+            case 'x':
+                data = cmd;
+                ret = set_data_hex_udp_pack(pack, optarg);
+                break;
             case 'm':
                 ret = set_mac_address_destantion_udp_pack(pack, optarg);
+                replay.m_rewrite |= REWRITE_MAC_DESTANTION_REPLAY;
                 break;
             case 'a':
                 ret = set_mac_address_source_udp_pack(pack, optarg);
+                replay.m_rewrite |= REWRITE_MAC_SOURCE_REPLAY;
+                break;
+            case 'r':
+                rate = strtoull(optarg, NULL, 0);
+                break;
+            case 'c':
+                count = strtoull(optarg, NULL, 0);
+                break;
+            case OPTION_OPEN_LOOP:
+                is_open_loop = true;
+                break;
+            case OPTION_TIMEOUT:
+                loadgen.m_timeout = strtoull(optarg, NULL, 0) * 1000000ULL;
+                break;
+            case OPTION_ID_OFFSET:
+                loadgen.m_id_offset = strtoul(optarg, NULL, 0);
+                break;
+            case OPTION_OUTSTANDING:
+                loadgen.m_outstanding = strtoull(optarg, NULL, 0);
+                if (loadgen.m_outstanding == 0 || \
+                        loadgen.m_outstanding > MAX_OUTSTANDING_LOADGEN) {
+                    ret = -1;
+                    fprintf(stderr, "ERROR: outstanding is out of range 1-%d\n", \
+                            MAX_OUTSTANDING_LOADGEN);
+                }
+                break;
+            case OPTION_STREAM:
+                is_stream = true;
+                stream.m_stream = strtoul(optarg, NULL, 0);
+                break;
+            case OPTION_TSC:
+                stream.m_clock = CLOCK_TSC_STREAM;
+                break;
+            case OPTION_ANALYZE:
+                analyze = optarg;
+                break;
+            case OPTION_REPLAY:
+                replay_file = optarg;
+                break;
+            case OPTION_SPEED:
+                replay.m_timing = TIMING_SCALED_REPLAY;
+                replay.m_speed = strtod(optarg, NULL);
+                break;
+            case OPTION_MAX_SPEED:
+                replay.m_timing = TIMING_MAX_REPLAY;
+                break;
+            case OPTION_PCAP:
+                ret = set_pcap_udp_pack(pack, optarg);
+                break;
+            case OPTION_STORE:
+                ret = set_store_udp_pack(pack, optarg);
+                break;
+            case OPTION_BLAST:
+                blast_file = optarg;
+                break;
+            case OPTION_SCENARIO:
+                scenario_file = optarg;
+                break;
+            case OPTION_DAEMON:
+                daemon_path = optarg;
+                break;
+            case OPTION_SUBMIT:
+                submit_path = optarg;
+                break;
+            case OPTION_RING:
+                ring_path = optarg;
+                break;
+            case OPTION_BUSY_POLL:
+                ring.m_mode = MODE_BUSY_RING;
+                break;
+            case OPTION_THREADS:
+                threads = strtoul(optarg, NULL, 0);
+                break;
+            case OPTION_COALESCE:
+                is_coalesce = true;
+                coalesce.m_delay = strtoull(optarg, NULL, 0) * 1000ULL;
+                break;
+            case OPTION_DEFRAME:
+                deframe = optarg;
+                break;
+            case OPTION_PATTERN:
+                pattern_spec = optarg;
+                break;
+            case OPTION_SIZE:
+                size = strtoul(optarg, NULL, 0);
+                break;
+            case OPTION_IMIX:
+                imix = optarg;
+                break;
+            case OPTION_FLOWS:
+                flows_file = optarg;
+                break;
+            case OPTION_STAGES:
+                ret = enable_udp_stage();
+                if (ret)
+                    goto error_in_action;
+                break;
+            case OPTION_EXPORT:
+                export_place = optarg;
+                break;
+            case OPTION_EXPORT_FORMAT:
+                if (strcmp(optarg, "json") == 0) {
+                    export_format = JSON_EXPORT;
+                } else if (strcmp(optarg, "prometheus") == 0) {
+                    export_format = PROMETHEUS_EXPORT;
+                } else {
+                    ret = -1;
+                    fprintf(stderr, "ERROR: wrong export format '%s'\n", optarg);
+                }
+                break;
+            case OPTION_BATCH:
+                ret = set_batch_udp_sender(strtoul(optarg, NULL, 0));
+                break;
+            case OPTION_ENCAP:
+                encap = optarg;
+                break;
+            case OPTION_PRINT_HEX:
+                is_print = true;
+                set_print_hex_udp_pack(pack, true);
+                break;
+            case OPTION_IDLE:
+                idle = strtoull(optarg, NULL, 0) * 1000000ULL;
+                break;
             case '?':
                 break;
             case -1:
@@ -108,7 +440,76 @@ int main(int argc, char ** argv) {
             goto error_in_action;
     }
 exit_parsing_comand:
-    if (data == '\0') {
+    if (export_place != NULL) {
+        ret = enable_udp_export(export_place, export_format);
+        if (ret)
+            goto error_in_action;
+    }
+    ret = set_family_udp_pack(pack, family);
+    if (ret)
+        goto error_in_action;
+    if (ip_destantion != NULL)
+        ret = set_ip_address_destantion_udp_pack(pack, ip_destantion);
+    if (ret)
+        goto error_in_action;
+    if (ip_source != NULL)
+        ret = set_ip_address_source_udp_pack(pack, ip_source);
+    if (ret)
+        goto error_in_action;
+    if (encap != NULL) {
+        if (imix != NULL || flows_file != NULL || threads || ring_path != NULL || \
+                submit_path != NULL || daemon_path != NULL || replay_file != NULL || \
+                blast_file != NULL) {
+            ret = -1;
+            fputs("ERROR: --encap is not supported in this mode\n", stderr);
+            goto error_in_action;
+        }
+        ret = set_encap_udp_pack(pack, encap);
+        if (ret)
+            goto error_in_action;
+    }
+    if (analyze != NULL) {
+        ret = run_analyzer_udp(analyze, count == 1 ? 0 : count, idle);
+        destroy_udp_pack(pack);
+        return ret;
+    }
+    if (deframe != NULL) {
+        ret = run_deframe_udp(deframe, count == 1 ? 0 : count, idle);
+        destroy_udp_pack(pack);
+        return ret;
+    }
+    if (is_coalesce) {
+        ret = run_coalesce_udp_pack(pack, &coalesce);
+        destroy_udp_pack(pack);
+        return ret;
+    }
+    if (daemon_path != NULL) {
+        ret = run_udp_daemon(daemon_path);
+        destroy_udp_pack(pack);
+        return ret;
+    }
+    if (ring_path != NULL) {
+        ret = run_ring_udp_pack(pack, ring_path, &ring);
+        destroy_udp_pack(pack);
+        return ret;
+    }
+    if (replay_file != NULL) {
+        replay.m_loops = count;
+        ret = run_replay_udp_pack(pack, replay_file, &replay);
+        destroy_udp_pack(pack);
+        return ret;
+    }
+    if (scenario_file != NULL) {
+        ret = run_scenario_udp_pack(pack, scenario_file);
+        destroy_udp_pack(pack);
+        return ret;
+    }
+    if (blast_file != NULL) {
+        ret = blast_udp_store(pack, blast_file, count);
+        destroy_udp_pack(pack);
+        return ret;
+    }
+    if (data == '\0' && optind < argc) {
         for (; optind < argc - 1; optind++) {
             ret = add_data_udp_pack(pack, argv[optind], strlen(argv[optind]));
             if (ret)
@@ -125,17 +526,75 @@ exit_parsing_comand:
         if (ret)
             goto error_in_action;
     }
+    if (pattern_spec != NULL) {
+        pattern = init_udp_pattern(pattern_spec, size);
+        if (pattern == NULL) {
+            ret = -1;
+            goto error_in_action;
+        }
+        fill_pattern_udp_pack(pattern, pack);
+    }
     if (is_print)
         ret = print_udp_pack(pack);
     if (ret)
         goto error_in_action;
-    ret = send_udp_pack(pack);
+    if (submit_path != NULL) {
+        ret = send_daemon_udp_pack(pack, submit_path, count);
+        destroy_udp_pattern(pattern);
+        destroy_udp_pack(pack);
+        return ret;
+    }
+    if (imix != NULL) {
+        ret = run_imix_udp_pack(pack, imix, count);
+        destroy_udp_pattern(pattern);
+        destroy_udp_pack(pack);
+        return ret;
+    }
+    if (flows_file != NULL) {
+        ret = run_flows_udp_pack(pack, flows_file, rate, count);
+        destroy_udp_pattern(pattern);
+        destroy_udp_pack(pack);
+        return ret;
+    }
+    if (threads) {
+        ret = run_queue_udp_pack(pack, threads, count);
+        destroy_udp_pattern(pattern);
+        destroy_udp_pack(pack);
+        return ret;
+    }
+    if (is_stream) {
+        stream.m_count = count;
+        stream.m_rate = rate;
+        ret = run_stream_udp_pack(pack, &stream);
+        if (ret)
+            goto send_not_udp_pack;
+        destroy_udp_pattern(pattern);
+        destroy_udp_pack(pack);
+        return ret;
+    }
+    if (is_open_loop) {
+        loadgen.m_count = count;
+        if (rate)
+            loadgen.m_rate = rate;
+        ret = run_loadgen_udp_pack(pack, &loadgen);
+        if (ret)
+            goto send_not_udp_pack;
+        destroy_udp_pattern(pattern);
+        destroy_udp_pack(pack);
+        return ret;
+    }
+    if (pattern != NULL)
+        ret = run_pattern_udp_pack(pack, pattern, count);
+    else
+        ret = send_udp_pack(pack);
     if (ret)
         goto send_not_udp_pack;
+    destroy_udp_pattern(pattern);
     destroy_udp_pack(pack);
     return ret;
 send_not_udp_pack:
 error_in_action:
+    destroy_udp_pattern(pattern);
     destroy_udp_pack(pack);
 get_not_memory_udp_pack:
     return ret;
@@ -0,0 +1,64 @@
+/**
+ * @file udp_lib/clock_private.h
+ * @author Vladsanin777
+ * @brief Private clock helpers shared between files udp_lib.
+ * @note This header is private. Not used outside udp_lib and bench.
+ */
+
+#ifndef UDP_LIB_CLOCK_PRIVATE_H
+#define UDP_LIB_CLOCK_PRIVATE_H
+
+#include <stdint.h>
+#include <time.h>
+
+/** Nanoseconds in one second. */
+#define NSEC_CLOCK 1000000000ULL
+
+/** Nanoseconds in one millisecond. */
+#define NSEC_MSEC_CLOCK 1000000ULL
+
+/**
+ * @brief Function turn time in nanoseconds.
+ * @param[in] ts Time.
+ * @return Nanoseconds.
+ */
+static inline uint64_t get_nsec_clock(const struct timespec * const ts) {
+    return ts->tv_sec * NSEC_CLOCK + ts->tv_nsec;
+}
+
+/**
+ * @brief Function turn nanoseconds in time.
+ * @param[in] nsec Nanoseconds.
+ * @return Time for clock_nanosleep, ppoll and like.
+ */
+static inline struct timespec get_timespec_clock(const uint64_t nsec) {
+    struct timespec ts = {
+        .tv_sec = nsec / NSEC_CLOCK,
+        .tv_nsec = nsec % NSEC_CLOCK,
+    };
+
+    return ts;
+}
+
+/**
+ * @brief Function read CLOCK_MONOTONIC.
+ * @return Nanoseconds.
+ */
+static inline uint64_t now_clock(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return get_nsec_clock(&ts);
+}
+
+/**
+ * @brief Function sleep till moment of CLOCK_MONOTONIC.
+ * @param[in] nsec Moment in nanoseconds, from @ref now_clock.
+ */
+static inline void sleep_until_clock(const uint64_t nsec) {
+    struct timespec target = get_timespec_clock(nsec);
+
+    clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &target, NULL);
+}
+
+#endif /* UDP_LIB_CLOCK_PRIVATE_H */
@@ -0,0 +1,312 @@
+/**
+ * @file udp_lib/coalesce.c
+ * @author Vladsanin777
+ * @brief Code file for coalescing small messages in one UDP package.
+ */
+
+#include "udp_lib/coalesce.h"
+#include "udp_lib/udp_private.h"
+#include "udp_lib/sender.h"
+#include "udp_lib/encap.h"
+#include "udp_lib/clock_private.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <errno.h>
+#include <poll.h>
+#include <time.h>
+
+#include <arpa/inet.h>
+
+#include <sys/socket.h>
+
+#include <netinet/in.h>
+
+/** Size buffer of stdin. */
+#define SIZE_INPUT_COALESCE (1 << 16)
+
+/** Max size received package. */
+#define SIZE_PACKAGE_COALESCE 0x10000
+
+/**
+ * @ingroup UdpCoalesce
+ * @brief Struct is coalesce.
+ * @note This struct is private. Not used outside udp_lib/coalesce.c
+ */
+struct udp_coalesce {
+    udp_pack_t m_pack; /**< UDP package, data is current messages. */
+    udp_sender_t m_sender; /**< Sender. */
+    uint64_t m_delay; /**< Max delay of first message, nanoseconds. */
+    uint64_t m_first; /**< Time first message in package, 0 if package is empty. */
+    uint16_t m_size; /**< Max size data of package. */
+    uint64_t m_messages; /**< Added messages. */
+    uint64_t m_packages; /**< Sended packages. */
+    uint64_t m_errors; /**< Not sended packages. */
+};
+
+udp_coalesce_t init_udp_coalesce(udp_pack_t pack, \
+        const struct udp_coalesce_config * const config) {
+    udp_coalesce_t coalesce = calloc(1, sizeof(*coalesce));
+    uint16_t size = 0;
+
+    if (coalesce == NULL)
+        goto get_not_memory;
+
+    coalesce->m_sender = init_pack_udp_sender(pack);
+    if (coalesce->m_sender == NULL)
+        goto get_not_sender;
+
+    /* Coalesced package is never fragmented, it is whole in one frame with tunnel. */
+    size = get_mtu_udp_sender(coalesce->m_sender) - get_size_ip_udp_pack(pack) - HEAD_UDP;
+    if (pack->m_encap != NULL)
+        size -= get_overhead_udp_encap(pack->m_encap);
+    if (config->m_size && config->m_size < size)
+        size = config->m_size;
+    if (size <= HEAD_COALESCE) {
+        fputs("ERROR: size package is too small for coalesce\n", stderr);
+        goto small_size;
+    }
+
+    coalesce->m_pack = pack;
+    coalesce->m_delay = config->m_delay;
+    coalesce->m_size = size;
+    set_size_udp_pack(pack, 0);
+
+    return coalesce;
+small_size:
+    destroy_udp_sender(coalesce->m_sender);
+get_not_sender:
+    free(coalesce);
+get_not_memory:
+    return NULL;
+}
+
+ssize_t flush_udp_coalesce(udp_coalesce_t coalesce) {
+    ssize_t ret = 0;
+
+    if (coalesce->m_first == 0)
+        return ret;
+
+    ret = send_udp_sender(coalesce->m_sender, coalesce->m_pack);
+    if (ret)
+        coalesce->m_errors++;
+    else
+        coalesce->m_packages++;
+
+    set_size_udp_pack(coalesce->m_pack, 0);
+    coalesce->m_first = 0;
+
+    return ret;
+}
+
+ssize_t add_message_udp_coalesce(udp_coalesce_t coalesce, const void * const data, \
+        const uint16_t size) {
+    ssize_t ret = 0;
+    uint16_t length = htons(size);
+    uint64_t now = 0;
+
+    if (size > coalesce->m_size - HEAD_COALESCE) {
+        ret = -1;
+        errno = EMSGSIZE;
+        goto big_message;
+    }
+
+    if (get_size_data_udp_pack(coalesce->m_pack) + HEAD_COALESCE + size > coalesce->m_size)
+        ret = flush_udp_coalesce(coalesce);
+
+    now = now_clock();
+    if (coalesce->m_first == 0)
+        coalesce->m_first = now;
+
+    add_data_udp_pack(coalesce->m_pack, &length, HEAD_COALESCE);
+    add_data_udp_pack(coalesce->m_pack, (void *)data, size);
+    coalesce->m_messages++;
+
+    /* Full package or expired delay is not kept until next message. */
+    if (get_size_data_udp_pack(coalesce->m_pack) + HEAD_COALESCE >= coalesce->m_size || \
+            now - coalesce->m_first >= coalesce->m_delay)
+        ret |= flush_udp_coalesce(coalesce);
+
+big_message:
+    return ret;
+}
+
+uint64_t poll_udp_coalesce(udp_coalesce_t coalesce) {
+    uint64_t passed = 0;
+
+    if (coalesce->m_first == 0)
+        return UINT64_MAX;
+
+    passed = now_clock() - coalesce->m_first;
+    if (passed < coalesce->m_delay)
+        return coalesce->m_delay - passed;
+
+    flush_udp_coalesce(coalesce);
+
+    return UINT64_MAX;
+}
+
+void destroy_udp_coalesce(udp_coalesce_t coalesce) {
+    if (coalesce == NULL)
+        return;
+    flush_udp_coalesce(coalesce);
+    destroy_udp_sender(coalesce->m_sender);
+    free(coalesce);
+}
+
+ssize_t next_message_udp_coalesce(const uint8_t * const data, const size_t size, \
+        size_t * const offset, const uint8_t ** const message, uint16_t * const size_message) {
+    uint16_t length = 0;
+
+    if (*offset >= size)
+        return 0;
+
+    if (size - *offset < HEAD_COALESCE)
+        return -1;
+
+    memcpy(&length, data + *offset, HEAD_COALESCE);
+    length = ntohs(length);
+    if (size - *offset - HEAD_COALESCE < length)
+        return -1;
+
+    *message = data + *offset + HEAD_COALESCE;
+    *size_message = length;
+    *offset += HEAD_COALESCE + length;
+
+    return 1;
+}
+
+ssize_t run_coalesce_udp_pack(udp_pack_t pack, const struct udp_coalesce_config * const config) {
+    ssize_t ret = 0;
+    static uint8_t input[SIZE_INPUT_COALESCE];
+    size_t used = 0;
+    udp_coalesce_t coalesce = init_udp_coalesce(pack, config);
+
+    if (coalesce == NULL) {
+        ret = -1;
+        goto get_not_coalesce;
+    }
+
+    for (;;) {
+        struct pollfd wait = {.fd = STDIN_FILENO, .events = POLLIN};
+        uint64_t left = poll_udp_coalesce(coalesce);
+        struct timespec timeout = get_timespec_clock(left);
+        size_t start = 0;
+        ssize_t size = 0;
+
+        if (ppoll(&wait, 1, left == UINT64_MAX ? NULL : &timeout, NULL) == 0)
+            continue;
+
+        size = read(STDIN_FILENO, input + used, sizeof(input) - used);
+        if (size < 0 && errno == EINTR)
+            continue;
+        if (size <= 0)
+            break;
+        used += size;
+
+        for (size_t i = 0; i < used; i++) {
+            if (input[i] != '\n')
+                continue;
+            if (add_message_udp_coalesce(coalesce, input + start, i - start) && \
+                    errno == EMSGSIZE)
+                fprintf(stderr, "ERROR: message of %zu bytes is bigger than package\n", \
+                        i - start);
+            start = i + 1;
+        }
+
+        if (start == 0 && used == sizeof(input)) {
+            fputs("ERROR: line is bigger than buffer of stdin\n", stderr);
+            start = used;
+        }
+        memmove(input, input + start, used - start);
+        used -= start;
+    }
+
+    if (used && add_message_udp_coalesce(coalesce, input, used) && errno == EMSGSIZE)
+        fprintf(stderr, "ERROR: message of %zu bytes is bigger than package\n", used);
+
+    flush_udp_coalesce(coalesce);
+    if (finish_udp_sender(coalesce->m_sender))
+        ret = -1;
+    printf("coalesce messages: %lu packages: %lu errors: %lu\n", coalesce->m_messages, \
+            coalesce->m_packages, coalesce->m_errors);
+    if (coalesce->m_errors)
+        ret = -1;
+
+    destroy_udp_coalesce(coalesce);
+get_not_coalesce:
+    return ret;
+}
+
+ssize_t run_deframe_udp(const char * const port, const uint64_t count, \
+        const uint64_t timeout) {
+    ssize_t ret = 0;
+    int fd = -1;
+    int disable = 0;
+    int size_buffer = 1 << 23;
+    uint64_t packages = 0;
+    uint64_t messages = 0;
+    uint64_t broken = 0;
+    struct sockaddr_in6 address = {0};
+    static uint8_t package[SIZE_PACKAGE_COALESCE];
+
+    fd = socket(AF_INET6, SOCK_DGRAM, 0);
+    if (fd < 0) {
+        ret = -1;
+        perror("ERROR: get not fd sock for deframe");
+        goto get_not_fd_socket;
+    }
+
+    setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &size_buffer, sizeof(size_buffer));
+    setsockopt(fd, IPPROTO_IPV6, IPV6_V6ONLY, &disable, sizeof(disable));
+
+    address.sin6_family = AF_INET6;
+    address.sin6_addr = in6addr_any;
+    address.sin6_port = htons(atoi(port));
+
+    if (bind(fd, (struct sockaddr *)&address, sizeof(address))) {
+        ret = -1;
+        perror("ERROR: bind not socket for deframe");
+        goto bind_not_socket;
+    }
+
+    while (count == 0 || packages < count) {
+        struct pollfd wait = {.fd = fd, .events = POLLIN};
+        const uint8_t * message = NULL;
+        uint16_t size_message = 0;
+        size_t offset = 0;
+        ssize_t size = 0;
+        ssize_t next = 0;
+
+        /* Before first package sender may not run yet, so wait without limit. */
+        if (poll(&wait, 1, packages ? (int)(timeout / 1000000) : -1) <= 0)
+            break;
+
+        size = recv(fd, package, sizeof(package), 0);
+        if (size < 0)
+            continue;
+        packages++;
+
+        while ((next = next_message_udp_coalesce(package, size, &offset, \
+                &message, &size_message)) == 1) {
+            fwrite(message, 1, size_message, stdout);
+            fputc('\n', stdout);
+            messages++;
+        }
+        if (next < 0)
+            broken++;
+    }
+
+    fflush(stdout);
+    fprintf(stderr, "deframe packages: %lu messages: %lu broken: %lu\n", \
+            packages, messages, broken);
+
+bind_not_socket:
+    close(fd);
+get_not_fd_socket:
+    return ret;
+}
@@ -0,0 +1,161 @@
+/**
+ * @file udp_lib/coalesce.h
+ * @author Vladsanin777
+ * @brief Header file for coalescing small messages in one UDP package.
+ */
+
+#ifndef UDP_LIB_COALESCE_H
+#define UDP_LIB_COALESCE_H
+
+#include "udp_lib/udp.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+
+/**
+ * @defgroup UdpCoalesce coalesce for udp
+ * @brief Group function for pack many small messages in one UDP package.
+ *
+ * Every message is framed by length, 2 bytes in network order, and appended
+ * to data of package. Package is sent when next message does not fit in MTU
+ * or when delay after first message in package is expired, what is first.
+ * Receiver takes messages back by @ref next_message_udp_coalesce.
+ * @{
+ */
+
+/** Size length before every message. */
+#define HEAD_COALESCE 2
+
+/** Default delay of first message in package, nanoseconds. */
+#define DEFAULT_DELAY_COALESCE 100000ULL
+
+/**
+ * @brief Private struct coalesce. (Hidden implementation)
+ */
+struct udp_coalesce;
+
+/**
+ * @brief Pointer on private struct coalesce.
+ */
+typedef struct udp_coalesce * udp_coalesce_t;
+
+/**
+ * @brief Struct config coalesce.
+ */
+struct udp_coalesce_config {
+    uint64_t m_delay; /**< Max delay of first message in package, nanoseconds. */
+    uint16_t m_size; /**< Max size data of package, 0 is by MTU of interface. */
+};
+
+/**
+ * @brief Function create coalesce for package.
+ * @note You must call @ref destroy_udp_coalesce after this.
+ * @param[in,out] pack UDP package with headers, its data is used for messages.
+ * @param[in] config Config coalesce.
+ * @return Coalesce or NULL on error.
+ * Usage example.
+ * @code
+ * struct udp_coalesce_config config = {.m_delay = DEFAULT_DELAY_COALESCE};
+ * udp_coalesce_t coalesce = init_udp_coalesce(pack, &config);
+ * if (coalesce == NULL)
+ *     goto get_not_coalesce;
+ * @endcode
+ */
+udp_coalesce_t init_udp_coalesce(udp_pack_t pack, \
+        const struct udp_coalesce_config * const config);
+
+/**
+ * @brief Function append message, package is sent if it is full or delay is expired.
+ * @param[in,out] coalesce Coalesce.
+ * @param[in] data Message.
+ * @param[in] size Size message.
+ * @return 0 or -1 on error of send or if message is bigger than package.
+ * Usage example.
+ * @code
+ * ret = add_message_udp_coalesce(coalesce, "tick", 4);
+ * if (ret)
+ *     goto add_not_message;
+ * @endcode
+ */
+ssize_t add_message_udp_coalesce(udp_coalesce_t coalesce, const void * const data, \
+        const uint16_t size);
+
+/**
+ * @brief Function send package if delay of its first message is expired.
+ * @param[in,out] coalesce Coalesce.
+ * @return Nanoseconds to next expire, UINT64_MAX if package is empty, or 0 on error.
+ * Usage example.
+ * @code
+ * uint64_t left = poll_udp_coalesce(coalesce);
+ * @endcode
+ */
+uint64_t poll_udp_coalesce(udp_coalesce_t coalesce);
+
+/**
+ * @brief Function send package now if it has messages.
+ * @param[in,out] coalesce Coalesce.
+ * @return 0 or -1 on error.
+ */
+ssize_t flush_udp_coalesce(udp_coalesce_t coalesce);
+
+/**
+ * @brief Function send rest messages and free coalesce.
+ * @param[in] coalesce Coalesce.
+ */
+void destroy_udp_coalesce(udp_coalesce_t coalesce);
+
+/**
+ * @brief Function take next message from data of received package.
+ * @param[in] data Data of package.
+ * @param[in] size Size data.
+ * @param[in,out] offset Offset of next message, 0 for first.
+ * @param[out] message Pointer on message in data.
+ * @param[out] size_message Size message.
+ * @return 1 if message is taken, 0 on end of data or -1 if data is broken.
+ * Usage example.
+ * @code
+ * size_t offset = 0;
+ * while (next_message_udp_coalesce(data, size, &offset, &message, &length) == 1)
+ *     handle_message(message, length);
+ * @endcode
+ */
+ssize_t next_message_udp_coalesce(const uint8_t * const data, const size_t size, \
+        size_t * const offset, const uint8_t ** const message, uint16_t * const size_message);
+
+/**
+ * @brief Function send lines of stdin as messages coalesced in packages.
+ * @note You must call @ref init_udp_pack and @ref set_interface_udp_pack before this.
+ * @param[in,out] pack UDP package with headers.
+ * @param[in] config Config coalesce.
+ * @return 0 or -1 on error.
+ * Usage example.
+ * @code
+ * ret = run_coalesce_udp_pack(pack, &config);
+ * if (ret)
+ *     goto run_not_coalesce;
+ * @endcode
+ */
+ssize_t run_coalesce_udp_pack(udp_pack_t pack, const struct udp_coalesce_config * const config);
+
+/**
+ * @brief Function receive packages on UDP port and print their messages by lines.
+ *
+ * Socket is dual stack. Receive stops after count packages or after timeout without packages,
+ * first package is waited without limit.
+ * @param[in] port Port to listen.
+ * @param[in] count Count packages, 0 is unlimited.
+ * @param[in] timeout Time wait next package in nanoseconds.
+ * @return 0 or -1 on error.
+ * Usage example.
+ * @code
+ * ret = run_deframe_udp("8001", 0, 1000000000ULL);
+ * if (ret)
+ *     goto run_not_deframe;
+ * @endcode
+ */
+ssize_t run_deframe_udp(const char * const port, const uint64_t count, \
+        const uint64_t timeout);
+
+/** @} */
+
+#endif /* UDP_LIB_COALESCE_H */
@@ -0,0 +1,502 @@
+/**
+ * @file udp_lib/daemon.c
+ * @author Vladsanin777
+ * @brief Code file for daemon sending UDP packages by requests on unix socket.
+ */
+
+#include "udp_lib/daemon.h"
+#include "udp_lib/udp_private.h"
+#include "udp_lib/sender.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <poll.h>
+
+#include <arpa/inet.h>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+
+/** Max clients connected at once. */
+#define MAX_CLIENTS_DAEMON 64
+
+/** Max different interfaces. */
+#define MAX_SENDERS_DAEMON 16
+
+/**
+ * @ingroup UdpDaemon
+ * @brief Struct is opened sender of one interface.
+ * @note This struct is private. Not used outside udp_lib/daemon.c
+ */
+struct cache_daemon {
+    char m_interface[IFNAMSIZ]; /**< Interface. */
+    udp_sender_t m_sender; /**< Warm sender. */
+};
+
+/**
+ * @ingroup UdpDaemon
+ * @brief Struct is state of daemon.
+ * @note This struct is private. Not used outside udp_lib/daemon.c
+ */
+struct state_daemon {
+    udp_pack_t m_pack; /**< UDP package reused for all records. */
+    size_t m_count_senders; /**< Count opened senders. */
+    struct cache_daemon m_senders[MAX_SENDERS_DAEMON]; /**< Opened senders. */
+    size_t m_count_fds; /**< Listen socket and clients. */
+    struct pollfd m_fds[1 + MAX_CLIENTS_DAEMON]; /**< Listen socket and clients. */
+    uint64_t m_messages; /**< Handled messages. */
+    uint64_t m_sended; /**< Sended packages. */
+    uint64_t m_errors; /**< Not sended packages. */
+    uint8_t m_message[SIZE_MESSAGE_DAEMON]; /**< Buffer of message. */
+};
+
+/** Daemon work until signal. */
+static volatile sig_atomic_t is_running_daemon = 0;
+
+/**
+ * @ingroup UdpDaemon
+ * @brief Function handler SIGINT and SIGTERM.
+ * @param[in] signal Signal.
+ * @note This function is private. Not used outside udp_lib/daemon.c
+ */
+static void stop_daemon(int signal) {
+    (void)signal;
+    is_running_daemon = 0;
+}
+
+/**
+ * @ingroup UdpDaemon
+ * @brief Function getting warm sender of interface, opened once.
+ * @param[in,out] state State daemon.
+ * @param[in] interface Interface.
+ * @return Sender or NULL on error.
+ * @note This function is private. Not used outside udp_lib/daemon.c
+ */
+static udp_sender_t get_sender_daemon(struct state_daemon * const state, \
+        const char * const interface) {
+    struct cache_daemon * cache = NULL;
+
+    for (size_t i = 0; i < state->m_count_senders; i++) {
+        if (strncmp(state->m_senders[i].m_interface, interface, IFNAMSIZ) == 0)
+            return state->m_senders[i].m_sender;
+    }
+
+    if (state->m_count_senders == MAX_SENDERS_DAEMON)
+        return NULL;
+
+    cache = &state->m_senders[state->m_count_senders];
+    cache->m_sender = init_udp_sender(interface);
+    if (cache->m_sender == NULL)
+        return NULL;
+
+    memcpy(cache->m_interface, interface, IFNAMSIZ);
+    state->m_count_senders++;
+
+    return cache->m_sender;
+}
+
+/**
+ * @ingroup UdpDaemon
+ * @brief Function send one record.
+ * @param[in,out] state State daemon.
+ * @param[in] record Record.
+ * @param[in] data Inline data.
+ * @param[in] size Size inline data.
+ * @param[in] shared Mapped shared memory or NULL.
+ * @param[in] size_shared Size shared memory.
+ * @return Count sended packages or -1 on wrong record.
+ * @note This function is private. Not used outside udp_lib/daemon.c
+ */
+static ssize_t send_record_daemon(struct state_daemon * const state, \
+        const struct udp_daemon_record * const record, \
+        const uint8_t * const data, const size_t size, \
+        const uint8_t * const shared, const size_t size_shared) {
+    udp_pack_t pack = state->m_pack;
+    const uint8_t * payload = data;
+    size_t limit = size;
+    char interface[IFNAMSIZ] = {0};
+    udp_sender_t sender = NULL;
+
+    if (record->m_flags & FLAG_SHARED_DAEMON) {
+        payload = shared;
+        limit = size_shared;
+    }
+
+    if (payload == NULL || record->m_offset > limit || \
+            record->m_size > limit - record->m_offset || record->m_size > MAX_SIZE_DATA)
+        return -1;
+
+    memcpy(interface, record->m_interface, IFNAMSIZ - 1);
+    sender = get_sender_daemon(state, interface);
+    if (sender == NULL)
+        return -1;
+
+    if (set_family_udp_pack(pack, record->m_family))
+        return -1;
+    if (strncmp(pack->m_interface, interface, IFNAMSIZ))
+        set_interface_udp_pack(pack, interface);
+    set_raw_addresses_udp_pack(pack, record->m_ip_source, record->m_ip_destantion);
+
+    pack->m_head->m_port_source = record->m_port_source;
+    pack->m_head->m_port_destantion = record->m_port_destantion;
+
+    /* Mac given by one record must not stay for next records. */
+    if (record->m_flags & FLAG_MAC_SOURCE_DAEMON) {
+        memcpy(pack->m_ethhdr->h_source, record->m_mac_source, ETH_ALEN);
+        pack->m_flags |= FLAG_MAC_SOURCE_UDP_PACK;
+    } else if (pack->m_flags & FLAG_MAC_SOURCE_UDP_PACK) {
+        pack->m_flags &= ~(FLAG_MAC_SOURCE_UDP_PACK | FLAG_RESOLVED_UDP_PACK);
+    }
+    if (record->m_flags & FLAG_MAC_DESTANTION_DAEMON) {
+        memcpy(pack->m_ethhdr->h_dest, record->m_mac_destantion, ETH_ALEN);
+        pack->m_flags |= FLAG_MAC_DESTANTION_UDP_PACK;
+    } else if (pack->m_flags & FLAG_MAC_DESTANTION_UDP_PACK) {
+        pack->m_flags &= ~(FLAG_MAC_DESTANTION_UDP_PACK | FLAG_RESOLVED_UDP_PACK);
+    }
+
+    memcpy(pack->m_data, payload + record->m_offset, record->m_size);
+    set_size_udp_pack(pack, record->m_size);
+
+    return send_repeat_udp_sender(sender, pack, record->m_count ? record->m_count : 1);
+}
+
+/**
+ * @ingroup UdpDaemon
+ * @brief Function read and handle one message of client.
+ * @param[in,out] state State daemon.
+ * @param[in] fd Socket client.
+ * @return 0 or -1 if client is closed.
+ * @note This function is private. Not used outside udp_lib/daemon.c
+ */
+static ssize_t handle_message_daemon(struct state_daemon * const state, const int fd) {
+    union {
+        struct cmsghdr m_header;
+        uint8_t m_buffer[CMSG_SPACE(sizeof(int))];
+    } control;
+    struct iovec vector = {state->m_message, SIZE_MESSAGE_DAEMON};
+    struct msghdr message = {
+        .msg_iov = &vector,
+        .msg_iovlen = 1,
+        .msg_control = control.m_buffer,
+        .msg_controllen = sizeof(control.m_buffer),
+    };
+    const struct udp_daemon_request * request = (void *)state->m_message;
+    const struct udp_daemon_record * records = (void *)(request + 1);
+    struct udp_daemon_reply reply = {0};
+    uint8_t * shared = MAP_FAILED;
+    size_t size_shared = 0;
+    int fd_shared = -1;
+    size_t size_head = 0;
+    ssize_t size = recvmsg(fd, &message, MSG_CMSG_CLOEXEC);
+
+    if (size <= 0)
+        return -1;
+
+    for (struct cmsghdr * header = CMSG_FIRSTHDR(&message); header != NULL; \
+            header = CMSG_NXTHDR(&message, header)) {
+        if (header->cmsg_level == SOL_SOCKET && header->cmsg_type == SCM_RIGHTS)
+            memcpy(&fd_shared, CMSG_DATA(header), sizeof(fd_shared));
+    }
+
+    /* Cut batch or list of descriptors must not be sended as whole. */
+    if (message.msg_flags & (MSG_TRUNC | MSG_CTRUNC)) {
+        reply.m_errors = 1;
+        fputs("WARNING: daemon got cut message\n", stderr);
+        goto wrong_request;
+    }
+
+    if ((size_t)size < sizeof(*request) || request->m_magic != MAGIC_DAEMON || \
+            request->m_version != VERSION_DAEMON) {
+        reply.m_errors = 1;
+        goto wrong_request;
+    }
+
+    reply.m_cookie = request->m_cookie;
+    size_head = sizeof(*request) + request->m_count * sizeof(*records);
+    if (size_head > (size_t)size) {
+        reply.m_errors = request->m_count;
+        goto wrong_request;
+    }
+
+    if (fd_shared >= 0) {
+        struct stat info;
+        int seals = fcntl(fd_shared, F_GET_SEALS);
+
+        /* Without seal client can shrink file and reads of mapping give SIGBUS. */
+        if (seals < 0 || !(seals & F_SEAL_SHRINK)) {
+            reply.m_errors = request->m_count;
+            fputs("WARNING: daemon got shared memory without F_SEAL_SHRINK\n", stderr);
+            goto wrong_request;
+        }
+        if (fstat(fd_shared, &info) == 0 && info.st_size > 0) {
+            size_shared = info.st_size;
+            shared = mmap(NULL, size_shared, PROT_READ, MAP_SHARED, fd_shared, 0);
+        }
+    }
+
+    for (uint16_t i = 0; i < request->m_count; i++) {
+        uint32_t count = records[i].m_count ? records[i].m_count : 1;
+        ssize_t sended = send_record_daemon(state, &records[i], \
+                state->m_message + size_head, size - size_head, \
+                shared == MAP_FAILED ? NULL : shared, size_shared);
+
+        if (sended < 0)
+            sended = 0;
+        reply.m_sended += sended;
+        reply.m_errors += count - sended;
+    }
+
+    if (shared != MAP_FAILED)
+        munmap(shared, size_shared);
+
+wrong_request:
+    if (fd_shared >= 0)
+        close(fd_shared);
+
+    state->m_messages++;
+    state->m_sended += reply.m_sended;
+    state->m_errors += reply.m_errors;
+
+    if (send(fd, &reply, sizeof(reply), MSG_NOSIGNAL) != sizeof(reply))
+        return -1;
+
+    return 0;
+}
+
+ssize_t run_udp_daemon(const char * const path) {
+    ssize_t ret = 0;
+    struct sockaddr_un address = {.sun_family = AF_UNIX};
+    struct sigaction action = {.sa_handler = stop_daemon};
+    struct state_daemon * state = NULL;
+    int fd = -1;
+
+    if (strlen(path) >= sizeof(address.sun_path)) {
+        ret = -1;
+        fputs("ERROR: path unix socket is too long\n", stderr);
+        goto long_path;
+    }
+    strcpy(address.sun_path, path);
+
+    state = calloc(1, sizeof(*state));
+    if (state == NULL) {
+        ret = -1;
+        goto get_not_memory;
+    }
+
+    state->m_pack = init_udp_pack();
+    if (state->m_pack == NULL) {
+        ret = -1;
+        goto get_not_udp_pack;
+    }
+
+    fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        ret = -1;
+        perror("ERROR: get not fd unix socket");
+        goto get_not_fd_socket;
+    }
+
+    unlink(path);
+    if (bind(fd, (struct sockaddr *)&address, sizeof(address)) || \
+            listen(fd, MAX_CLIENTS_DAEMON)) {
+        ret = -1;
+        perror("ERROR: listen not unix socket");
+        goto listen_not_socket;
+    }
+
+    is_running_daemon = 1;
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+
+    state->m_fds[0].fd = fd;
+    state->m_fds[0].events = POLLIN;
+    state->m_count_fds = 1;
+
+    printf("daemon listen %s\n", path);
+    fflush(stdout);
+
+    while (is_running_daemon) {
+        if (poll(state->m_fds, state->m_count_fds, -1) < 0) {
+            if (errno == EINTR)
+                continue;
+            ret = -1;
+            perror("ERROR: poll not daemon");
+            break;
+        }
+
+        for (size_t i = state->m_count_fds - 1; i > 0; i--) {
+            if (!(state->m_fds[i].revents & (POLLIN | POLLHUP | POLLERR)))
+                continue;
+            if (handle_message_daemon(state, state->m_fds[i].fd) == 0)
+                continue;
+            close(state->m_fds[i].fd);
+            state->m_fds[i] = state->m_fds[--state->m_count_fds];
+        }
+
+        if (state->m_fds[0].revents & POLLIN) {
+            int client = accept4(fd, NULL, NULL, SOCK_CLOEXEC);
+
+            if (client >= 0 && state->m_count_fds == 1 + MAX_CLIENTS_DAEMON) {
+                close(client);
+            } else if (client >= 0) {
+                state->m_fds[state->m_count_fds].fd = client;
+                state->m_fds[state->m_count_fds].events = POLLIN;
+                state->m_fds[state->m_count_fds].revents = 0;
+                state->m_count_fds++;
+            }
+        }
+    }
+
+    printf("daemon messages: %lu sended: %lu errors: %lu\n", state->m_messages, \
+            state->m_sended, state->m_errors);
+
+    for (size_t i = 1; i < state->m_count_fds; i++)
+        close(state->m_fds[i].fd);
+    for (size_t i = 0; i < state->m_count_senders; i++)
+        destroy_udp_sender(state->m_senders[i].m_sender);
+    unlink(path);
+listen_not_socket:
+    close(fd);
+get_not_fd_socket:
+    destroy_udp_pack(state->m_pack);
+get_not_udp_pack:
+    free(state);
+get_not_memory:
+long_path:
+    return ret;
+}
+
+int connect_udp_daemon(const char * const path) {
+    struct sockaddr_un address = {.sun_family = AF_UNIX};
+    int fd = -1;
+
+    if (strlen(path) >= sizeof(address.sun_path))
+        goto long_path;
+    strcpy(address.sun_path, path);
+
+    fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+    if (fd < 0)
+        goto get_not_fd_socket;
+
+    if (connect(fd, (struct sockaddr *)&address, sizeof(address))) {
+        perror("ERROR: connect not daemon");
+        goto connect_not_daemon;
+    }
+
+    return fd;
+connect_not_daemon:
+    close(fd);
+get_not_fd_socket:
+long_path:
+    return -1;
+}
+
+ssize_t submit_udp_daemon(const int fd, const struct udp_daemon_record * const records, \
+        const uint16_t count, const void * const data, const size_t size, \
+        const int shared, struct udp_daemon_reply * const reply) {
+    static uint64_t cookie = 0;
+    union {
+        struct cmsghdr m_header;
+        uint8_t m_buffer[CMSG_SPACE(sizeof(int))];
+    } control;
+    struct udp_daemon_request request = {
+        .m_magic = MAGIC_DAEMON,
+        .m_version = VERSION_DAEMON,
+        .m_count = count,
+        .m_cookie = ++cookie,
+    };
+    struct iovec vectors[3] = {
+        {&request, sizeof(request)},
+        {(void *)records, sizeof(*records) * count},
+        {(void *)data, size},
+    };
+    struct msghdr message = {
+        .msg_iov = vectors,
+        .msg_iovlen = 3,
+    };
+
+    if (sizeof(request) + sizeof(*records) * count + size > SIZE_MESSAGE_DAEMON)
+        return -1;
+
+    if (shared >= 0) {
+        struct cmsghdr * header = NULL;
+
+        message.msg_control = control.m_buffer;
+        message.msg_controllen = sizeof(control.m_buffer);
+        header = CMSG_FIRSTHDR(&message);
+        header->cmsg_level = SOL_SOCKET;
+        header->cmsg_type = SCM_RIGHTS;
+        header->cmsg_len = CMSG_LEN(sizeof(int));
+        memcpy(CMSG_DATA(header), &shared, sizeof(int));
+    }
+
+    if (sendmsg(fd, &message, MSG_NOSIGNAL) < 0) {
+        perror("ERROR: send not request daemon");
+        return -1;
+    }
+
+    if (recv(fd, reply, sizeof(*reply), 0) != sizeof(*reply) || \
+            reply->m_cookie != request.m_cookie)
+        return -1;
+
+    return 0;
+}
+
+ssize_t send_daemon_udp_pack(udp_pack_t pack, const char * const path, \
+        const uint32_t count) {
+    ssize_t ret = 0;
+    struct udp_daemon_record record = {
+        .m_size = get_size_data_udp_pack(pack),
+        .m_count = count,
+        .m_family = pack->m_family,
+        .m_port_source = pack->m_head->m_port_source,
+        .m_port_destantion = pack->m_head->m_port_destantion,
+    };
+    struct udp_daemon_reply reply = {0};
+    int fd = -1;
+
+    memcpy(record.m_interface, pack->m_interface, IFNAMSIZ);
+    memcpy(record.m_mac_source, pack->m_ethhdr->h_source, ETH_ALEN);
+    memcpy(record.m_mac_destantion, pack->m_ethhdr->h_dest, ETH_ALEN);
+    if (pack->m_flags & FLAG_MAC_SOURCE_UDP_PACK)
+        record.m_flags |= FLAG_MAC_SOURCE_DAEMON;
+    if (pack->m_flags & FLAG_MAC_DESTANTION_UDP_PACK)
+        record.m_flags |= FLAG_MAC_DESTANTION_DAEMON;
+
+    if (pack->m_family == AF_INET6) {
+        memcpy(record.m_ip_source, &pack->m_ip6hdr->ip6_src, sizeof(struct in6_addr));
+        memcpy(record.m_ip_destantion, &pack->m_ip6hdr->ip6_dst, sizeof(struct in6_addr));
+    } else {
+        memcpy(record.m_ip_source, &pack->m_iphdr->saddr, sizeof(in_addr_t));
+        memcpy(record.m_ip_destantion, &pack->m_iphdr->daddr, sizeof(in_addr_t));
+    }
+
+    fd = connect_udp_daemon(path);
+    if (fd < 0) {
+        ret = -1;
+        goto connect_not_daemon;
+    }
+
+    ret = submit_udp_daemon(fd, &record, 1, pack->m_data, record.m_size, -1, &reply);
+    if (ret)
+        goto submit_not_record;
+
+    printf("daemon sended: %u errors: %u\n", reply.m_sended, reply.m_errors);
+    if (reply.m_errors)
+        ret = -1;
+
+submit_not_record:
+    close(fd);
+connect_not_daemon:
+    return ret;
+}
@@ -0,0 +1,155 @@
+/**
+ * @file udp_lib/daemon.h
+ * @author Vladsanin777
+ * @brief Header file for daemon sending UDP packages by requests on unix socket.
+ */
+
+#ifndef UDP_LIB_DAEMON_H
+#define UDP_LIB_DAEMON_H
+
+#include "udp_lib/udp.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#include <net/if.h>
+
+/**
+ * @defgroup UdpDaemon daemon for udp
+ * @brief Group function for keep warm senders and send packages for other processes.
+ *
+ * Daemon listen unix socket SOCK_SEQPACKET. One message is one batch:
+ * @ref udp_daemon_request, then count @ref udp_daemon_record, then inline data.
+ * Record can take data from shared memory file (memfd) passed in the same
+ * message by SCM_RIGHTS. File must be sealed by F_SEAL_SHRINK, so client can
+ * not cut it under mapping of daemon. Message cut by size of buffer or with
+ * more than one descriptor is rejected. Every message get one @ref udp_daemon_reply.
+ * All numbers in host order, addresses and ports in network order.
+ * @{
+ */
+
+/** Magic in start request. */
+#define MAGIC_DAEMON 0x44504455U
+
+/** Version protocol. */
+#define VERSION_DAEMON 1
+
+/** Max size one message. */
+#define SIZE_MESSAGE_DAEMON (1 << 17)
+
+/** Mac source of record is used, else mac of interface. */
+#define FLAG_MAC_SOURCE_DAEMON 0x01
+
+/** Mac destantion of record is used, else it is resolved. */
+#define FLAG_MAC_DESTANTION_DAEMON 0x02
+
+/** Data of record is in shared memory file of message, else inline. */
+#define FLAG_SHARED_DAEMON 0x04
+
+/**
+ * @brief Header of request.
+ */
+struct udp_daemon_request {
+    uint32_t m_magic; /**< @ref MAGIC_DAEMON. */
+    uint16_t m_version; /**< @ref VERSION_DAEMON. */
+    uint16_t m_count; /**< Count records after header. */
+    uint64_t m_cookie; /**< Any value, it is returned in reply. */
+};
+
+/**
+ * @brief Record of request, one UDP package.
+ */
+struct udp_daemon_record {
+    uint64_t m_offset; /**< Offset data in inline area or in shared memory. */
+    uint32_t m_size; /**< Size data. */
+    uint32_t m_count; /**< Count repeats, 0 is one. */
+    char m_interface[IFNAMSIZ]; /**< Interface to send. */
+    uint8_t m_family; /**< AF_INET or AF_INET6. */
+    uint8_t m_flags; /**< Flags FLAG_*_DAEMON. */
+    uint16_t m_port_source; /**< Source port. */
+    uint16_t m_port_destantion; /**< Destantion port. */
+    uint8_t m_mac_source[6]; /**< Source mac. */
+    uint8_t m_mac_destantion[6]; /**< Destantion mac. */
+    uint8_t m_ip_source[16]; /**< Source address, 4 first bytes for AF_INET. */
+    uint8_t m_ip_destantion[16]; /**< Destantion address, 4 first bytes for AF_INET. */
+    uint8_t m_reserved[6]; /**< Zeros. */
+};
+
+/**
+ * @brief Reply on request.
+ */
+struct udp_daemon_reply {
+    uint64_t m_cookie; /**< Cookie from request. */
+    uint32_t m_sended; /**< Sended packages. */
+    uint32_t m_errors; /**< Not sended packages and wrong records. */
+};
+
+/**
+ * @brief Function run daemon until SIGINT or SIGTERM.
+ * @param[in] path Path to unix socket, old file is removed.
+ * @return 0 or -1 on error.
+ * Usage example.
+ * @code
+ * ret = run_udp_daemon("/run/udp.sock");
+ * if (ret)
+ *     goto run_not_daemon;
+ * @endcode
+ */
+ssize_t run_udp_daemon(const char * const path);
+
+/**
+ * @brief Function connect to daemon.
+ * @note You must close descriptor after this.
+ * @param[in] path Path to unix socket.
+ * @return Descriptor or -1 on error.
+ * Usage example.
+ * @code
+ * int fd = connect_udp_daemon("/run/udp.sock");
+ * if (fd < 0)
+ *     goto connect_not_daemon;
+ * @endcode
+ */
+int connect_udp_daemon(const char * const path);
+
+/**
+ * @brief Function send batch of records to daemon and wait reply.
+ * @param[in] fd Descriptor from @ref connect_udp_daemon.
+ * @param[in] records Records.
+ * @param[in] count Count records.
+ * @param[in] data Inline data, offsets of records are counted from it.
+ * @param[in] size Size inline data.
+ * @param[in] shared Shared memory file sealed by F_SEAL_SHRINK for FLAG_SHARED_DAEMON or -1.
+ * @param[out] reply Reply of daemon.
+ * @return 0 or -1 on error.
+ * Usage example.
+ * @code
+ * struct udp_daemon_reply reply;
+ * ret = submit_udp_daemon(fd, records, 2, "hello", 5, -1, &reply);
+ * if (ret)
+ *     goto submit_not_records;
+ * @endcode
+ */
+ssize_t submit_udp_daemon(const int fd, const struct udp_daemon_record * const records, \
+        const uint16_t count, const void * const data, const size_t size, \
+        const int shared, struct udp_daemon_reply * const reply);
+
+/**
+ * @brief Function send UDP package through daemon instead of own raw socket.
+ * @note You must call @ref init_udp_pack and @ref set_interface_udp_pack before this.
+ * @param[in] pack UDP package to send.
+ * @param[in] path Path to unix socket.
+ * @param[in] count Count repeats.
+ * @return 0 or -1 on error.
+ * Usage example.
+ * @code
+ * ret = send_daemon_udp_pack(pack, "/run/udp.sock", 1);
+ * if (ret)
+ *     goto send_not_udp_pack;
+ * @endcode
+ */
+ssize_t send_daemon_udp_pack(udp_pack_t pack, const char * const path, \
+        const uint32_t count);
+
+/** @} */
+
+#endif /* UDP_LIB_DAEMON_H */
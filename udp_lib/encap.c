@@ -0,0 +1,323 @@
+/**
+ * @file udp_lib/encap.c
+ * @author Vladsanin777
+ * @brief Code file for encapsulation of frames in tunnels.
+ */
+
+#include "udp_lib/encap.h"
+#include "udp_lib/udp_private.h"
+#include "udp_lib/neigh.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+
+#include <arpa/inet.h>
+
+#include <netinet/in.h>
+
+/** Tunnel 802.1Q. */
+#define VLAN_ENCAP 0
+
+/** Tunnel 802.1ad with 802.1Q. */
+#define QINQ_ENCAP 1
+
+/** Tunnel VXLAN. */
+#define VXLAN_ENCAP 2
+
+/** Tunnel GRE. */
+#define GRE_ENCAP 3
+
+/** Size of 802.1Q tag. */
+#define TAG_ENCAP 4
+
+/** Size of VXLAN header. */
+#define HEAD_VXLAN_ENCAP 8
+
+/** Size of GRE header without key. */
+#define HEAD_GRE_ENCAP 4
+
+/** Flag of key in GRE header. */
+#define KEY_GRE_ENCAP 0x2000
+
+/** Flag of valid VNI in VXLAN header. */
+#define FLAG_VXLAN_ENCAP 0x08
+
+/** Default destination port of VXLAN. */
+#define PORT_VXLAN_ENCAP 4789
+
+/** First source port of VXLAN, RFC 7348 recommends dynamic ports. */
+#define SOURCE_VXLAN_ENCAP 0xC000
+
+/** Max fields of tunnel string. */
+#define MAX_FIELDS_ENCAP 5
+
+/** Max VLAN ID. */
+#define MAX_VID_ENCAP 4095
+
+/** Max VXLAN network identifier. */
+#define MAX_VNI_ENCAP 0xFFFFFF
+
+/**
+ * @ingroup UdpEncap
+ * @brief Struct is tunnel.
+ * @note This struct is private. Not used outside udp_lib/encap.c
+ */
+struct udp_encap {
+    uint8_t m_type; /**< *_ENCAP. */
+    uint8_t m_size; /**< Bytes of outer headers. */
+    uint8_t m_overhead; /**< Bytes added to IP package. */
+    uint32_t m_sum_ip; /**< Sum of outer IPv4 header with length and checksum 0. */
+    uint8_t m_template[MAX_OUTER_ENCAP]; /**< Outer headers, for tags only tags. */
+};
+
+/**
+ * @ingroup UdpEncap
+ * @brief Function parse number of field in range.
+ * @param[in] field Field string.
+ * @param[in] max Max value.
+ * @param[out] value Value.
+ * @return 0 or -1 on error.
+ * @note This function is private. Not used outside udp_lib/encap.c
+ */
+static ssize_t parse_number_encap(const char * const field, const uint32_t max, \
+        uint32_t * const value) {
+    char * end = NULL;
+    unsigned long number = strtoul(field, &end, 0);
+
+    if (end == field || *end != '\0' || number > max)
+        return -1;
+    *value = number;
+
+    return 0;
+}
+
+/**
+ * @ingroup UdpEncap
+ * @brief Function build outer ethernet and IPv4 headers.
+ * @note Mac addresses of outer ethernet header are resolved here once: source is mac
+ * of interface, destantion is mac of next hop to outer destantion address. Mac
+ * addresses of package are of inner frame and are not used for outer header.
+ * @param[in,out] encap Tunnel, header is written from start of template.
+ * @param[in] interface Interface to send or empty string.
+ * @param[in] source Source address string.
+ * @param[in] destantion Destantion address string.
+ * @param[in] protocol Protocol of outer IPv4 package.
+ * @return 0 or -1 on error.
+ * @note This function is private. Not used outside udp_lib/encap.c
+ */
+static ssize_t build_ip_encap(udp_encap_t encap, const char * const interface, \
+        const char * const source, const char * const destantion, const uint8_t protocol) {
+    struct ethhdr * ethhdr = (struct ethhdr *)encap->m_template;
+    struct iphdr * iphdr = (struct iphdr *)(encap->m_template + HEAD_ETH);
+
+    if (inet_pton(AF_INET, source, &iphdr->saddr) != 1 || \
+            inet_pton(AF_INET, destantion, &iphdr->daddr) != 1) {
+        fputs("ERROR: outer address of tunnel must be IPv4\n", stderr);
+        return -1;
+    }
+
+    if (interface[0] == '\0' || get_interface_mac_udp_neighbor(interface, ethhdr->h_source) || \
+            lookup_udp_neighbor(interface, AF_INET, &iphdr->daddr, ethhdr->h_dest)) {
+        memset(ethhdr->h_dest, 0xFF, ETH_ALEN);
+        fputs("WARNING: mac address of tunnel is not resolved, send broadcast\n", stderr);
+    }
+
+    ethhdr->h_proto = htons(ETH_P_IP);
+    iphdr->version = 4;
+    iphdr->ihl = 5;
+    iphdr->frag_off = htons(IP_DF);
+    iphdr->ttl = 64;
+    iphdr->protocol = protocol;
+    encap->m_sum_ip = sum_compute(iphdr, HEAD_IP);
+
+    return 0;
+}
+
+/**
+ * @ingroup UdpEncap
+ * @brief Function build tunnel from fields of string.
+ * @param[in,out] encap Zeroed tunnel.
+ * @param[in] interface Interface to send or empty string.
+ * @param[in] fields Fields of tunnel string.
+ * @param[in] count Count fields.
+ * @return 0 or -1 on error.
+ * @note This function is private. Not used outside udp_lib/encap.c
+ */
+static ssize_t build_encap(udp_encap_t encap, const char * const interface, \
+        char ** const fields, const size_t count) {
+    uint32_t values[2] = {0};
+    uint16_t * words = (uint16_t *)encap->m_template;
+
+    if (strcmp(fields[0], "vlan") == 0 && (count == 2 || count == 3)) {
+        if (parse_number_encap(fields[1], MAX_VID_ENCAP, &values[0]) || \
+                (count == 3 && parse_number_encap(fields[2], 7, &values[1])))
+            return -1;
+        encap->m_type = VLAN_ENCAP;
+        encap->m_size = TAG_ENCAP;
+        words[0] = htons(ETH_P_8021Q);
+        words[1] = htons(values[1] << 13 | values[0]);
+    } else if (strcmp(fields[0], "qinq") == 0 && count == 3) {
+        if (parse_number_encap(fields[1], MAX_VID_ENCAP, &values[0]) || \
+                parse_number_encap(fields[2], MAX_VID_ENCAP, &values[1]))
+            return -1;
+        encap->m_type = QINQ_ENCAP;
+        encap->m_size = TAG_ENCAP * 2;
+        words[0] = htons(ETH_P_8021AD);
+        words[1] = htons(values[0]);
+        words[2] = htons(ETH_P_8021Q);
+        words[3] = htons(values[1]);
+    } else if (strcmp(fields[0], "vxlan") == 0 && (count == 4 || count == 5)) {
+        struct udp_head * head = (struct udp_head *)(encap->m_template + HEAD_ETH + HEAD_IP);
+        uint8_t * vxlan = (uint8_t *)(head + 1);
+
+        values[1] = PORT_VXLAN_ENCAP;
+        if (parse_number_encap(fields[1], MAX_VNI_ENCAP, &values[0]) || \
+                (count == 5 && parse_number_encap(fields[4], 0xFFFF, &values[1])))
+            return -1;
+        if (build_ip_encap(encap, interface, fields[2], fields[3], IPPROTO_UDP))
+            return -1;
+        encap->m_type = VXLAN_ENCAP;
+        encap->m_size = HEAD_ETH + HEAD_UDP_IP + HEAD_VXLAN_ENCAP;
+        encap->m_overhead = encap->m_size;
+        head->m_port_destantion = htons(values[1]);
+        vxlan[0] = FLAG_VXLAN_ENCAP;
+        vxlan[4] = values[0] >> 16;
+        vxlan[5] = values[0] >> 8;
+        vxlan[6] = values[0];
+    } else if (strcmp(fields[0], "gre") == 0 && (count == 3 || count == 4)) {
+        uint16_t * gre = (uint16_t *)(encap->m_template + HEAD_ETH + HEAD_IP);
+
+        if (count == 4 && parse_number_encap(fields[3], UINT32_MAX, &values[0]))
+            return -1;
+        if (build_ip_encap(encap, interface, fields[1], fields[2], IPPROTO_GRE))
+            return -1;
+        encap->m_type = GRE_ENCAP;
+        encap->m_size = HEAD_ETH + HEAD_IP + HEAD_GRE_ENCAP;
+        if (count == 4) {
+            uint32_t key = htonl(values[0]);
+
+            gre[0] = htons(KEY_GRE_ENCAP);
+            memcpy(gre + 2, &key, sizeof(key));
+            encap->m_size += sizeof(key);
+        }
+        encap->m_overhead = encap->m_size - HEAD_ETH;
+    } else {
+        return -1;
+    }
+
+    return 0;
+}
+
+ssize_t set_encap_udp_pack(udp_pack_t pack, const char * const spec) {
+    ssize_t ret = 0;
+    udp_encap_t encap = NULL;
+    char * copy = NULL;
+    char * fields[MAX_FIELDS_ENCAP + 1] = {NULL};
+    char * save = NULL;
+    size_t count = 0;
+
+    if (spec == NULL)
+        goto remove_encap;
+
+    encap = calloc(1, sizeof(*encap));
+    if (encap == NULL) {
+        ret = -1;
+        goto get_not_memory;
+    }
+
+    copy = strdup(spec);
+    if (copy == NULL) {
+        ret = -1;
+        goto get_not_copy;
+    }
+
+    for (char * field = strtok_r(copy, ":", &save); field && count <= MAX_FIELDS_ENCAP; \
+            field = strtok_r(NULL, ":", &save))
+        fields[count++] = field;
+
+    if (count == 0 || count > MAX_FIELDS_ENCAP || build_encap(encap, pack->m_interface, fields, count)) {
+        ret = -1;
+        fprintf(stderr, "ERROR: wrong tunnel '%s'\n", spec);
+        goto parse_not_spec;
+    }
+    free(copy);
+
+remove_encap:
+    destroy_udp_encap(pack->m_encap);
+    pack->m_encap = encap;
+
+    return ret;
+parse_not_spec:
+    free(copy);
+get_not_copy:
+    free(encap);
+get_not_memory:
+    return ret;
+}
+
+void * wrap_udp_encap(udp_pack_t pack, size_t * const size) {
+    udp_encap_t encap = pack->m_encap;
+    uint8_t * inner = (uint8_t *)pack->m_ethhdr;
+    size_t length = get_size_pack_udp_pack(pack);
+    uint8_t * start = NULL;
+    struct iphdr * iphdr = NULL;
+    uint16_t total = 0;
+
+    /* Outer headers of tags and GRE overlap ethernet header of package. */
+    pack->m_saved_ethhdr = *pack->m_ethhdr;
+
+    switch (encap->m_type) {
+        case VLAN_ENCAP:
+        case QINQ_ENCAP:
+            start = inner - encap->m_size;
+            memcpy(start, &pack->m_saved_ethhdr, ETH_ALEN * 2);
+            memcpy(start + ETH_ALEN * 2, encap->m_template, encap->m_size);
+            *size = length + encap->m_size;
+            return start;
+        case VXLAN_ENCAP:
+            start = inner - encap->m_size;
+            total = HEAD_UDP_IP + HEAD_VXLAN_ENCAP + length;
+            break;
+        default:
+            start = pack->m_l3 - encap->m_size;
+            length -= HEAD_ETH;
+            total = encap->m_overhead + length;
+            break;
+    }
+
+    memcpy(start, encap->m_template, encap->m_size);
+    iphdr = (struct iphdr *)(start + HEAD_ETH);
+    iphdr->tot_len = htons(total);
+    iphdr->check = checksum_compute(encap->m_sum_ip + total);
+
+    if (encap->m_type == VXLAN_ENCAP) {
+        struct udp_head * head = (struct udp_head *)(iphdr + 1);
+
+        head->m_port_source = htons(SOURCE_VXLAN_ENCAP | ((ntohs(pack->m_head->m_port_source) ^ \
+                ntohs(pack->m_head->m_port_destantion)) & ~SOURCE_VXLAN_ENCAP));
+        head->m_length = htons(total - HEAD_IP);
+    } else {
+        uint16_t * gre = (uint16_t *)(iphdr + 1);
+
+        gre[1] = pack->m_saved_ethhdr.h_proto;
+    }
+
+    *size = encap->m_size + length;
+
+    return start;
+}
+
+void unwrap_udp_encap(udp_pack_t pack) {
+    *pack->m_ethhdr = pack->m_saved_ethhdr;
+}
+
+size_t get_overhead_udp_encap(udp_encap_t encap) {
+    return encap->m_overhead;
+}
+
+void destroy_udp_encap(udp_encap_t encap) {
+    free(encap);
+}
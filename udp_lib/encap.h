@@ -0,0 +1,105 @@
+/**
+ * @file udp_lib/encap.h
+ * @author Vladsanin777
+ * @brief Header file for encapsulation of frames in tunnels.
+ */
+
+#ifndef UDP_LIB_ENCAP_H
+#define UDP_LIB_ENCAP_H
+
+#include "udp_lib/udp.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+
+/**
+ * @defgroup UdpEncap encapsulation for udp
+ * @brief Group function for wrap frames of package in outer headers.
+ *
+ * Tunnel is given by string:
+ * - `vlan:VID[:PCP]` is 802.1Q tag;
+ * - `qinq:SVID:CVID` is 802.1ad service tag and 802.1Q customer tag;
+ * - `vxlan:VNI:SOURCE:DESTINATION[:PORT]` is whole frame in VXLAN over UDP
+ *   over IPv4, port is 4789 by default, source port is taken from ports of
+ *   package for spreading by receive side scaling, UDP checksum is 0;
+ * - `gre:SOURCE:DESTINATION[:KEY]` is IP package without ethernet header in
+ *   GRE over IPv4, with key if given.
+ *
+ * Outer headers are built once when tunnel is set, with sum of outer IPv4
+ * header without length. For every frame outer headers are copied in headroom
+ * of package before ethernet header (before IP header for `gre`), only lengths
+ * are patched and checksum IPv4 is folded from ready sum, data is not copied.
+ * Tags keep MAC addresses of package. Outer ethernet header of `vxlan` and
+ * `gre` has MAC address of interface and MAC address of next hop to outer
+ * destination, resolved once when tunnel is set.
+ * @{
+ */
+
+/** Max bytes of outer headers. */
+#define MAX_OUTER_ENCAP 64
+
+/**
+ * @brief Private struct tunnel. (Hidden implementation)
+ */
+struct udp_encap;
+
+/**
+ * @brief Pointer on private struct tunnel.
+ */
+typedef struct udp_encap * udp_encap_t;
+
+/**
+ * @brief Function set tunnel of package, frames are wrapped when sended.
+ * @note Package owns tunnel, it is destroyed by @ref destroy_udp_pack.
+ * @note Set interface before tunnel, outer MAC addresses are resolved on it.
+ * @param[in,out] pack UDP package for work.
+ * @param[in] spec Tunnel string or NULL for remove tunnel.
+ * @return 0 or -1 on error.
+ * Usage example.
+ * @code
+ * ret = set_encap_udp_pack(pack, "vxlan:42:192.168.0.1:192.168.0.2");
+ * if (ret)
+ *     goto set_not_encap;
+ * @endcode
+ */
+ssize_t set_encap_udp_pack(udp_pack_t pack, const char * const spec);
+
+/**
+ * @brief Function write outer headers of tunnel in front of frame.
+ * @note Checksums of package must be calculated before this, frame is valid
+ *       until @ref unwrap_udp_encap.
+ * @param[in,out] pack UDP package with tunnel.
+ * @param[out] size Size of wrapped frame.
+ * @return Start of wrapped frame.
+ * Usage example.
+ * @code
+ * calculate_checksum_udp_pack(pack);
+ * vector.iov_base = wrap_udp_encap(pack, &vector.iov_len);
+ * // send frame
+ * unwrap_udp_encap(pack);
+ * @endcode
+ */
+void * wrap_udp_encap(udp_pack_t pack, size_t * const size);
+
+/**
+ * @brief Function restore headers of package overwritten by @ref wrap_udp_encap.
+ * @param[in,out] pack UDP package with tunnel.
+ */
+void unwrap_udp_encap(udp_pack_t pack);
+
+/**
+ * @brief Function for getting bytes added by tunnel to IP package.
+ * @param[in] encap Tunnel.
+ * @return Bytes to add to size IP package before compare with MTU.
+ */
+size_t get_overhead_udp_encap(udp_encap_t encap);
+
+/**
+ * @brief Function free tunnel.
+ * @param[in] encap Tunnel or NULL.
+ */
+void destroy_udp_encap(udp_encap_t encap);
+
+/** @} */
+
+#endif /* UDP_LIB_ENCAP_H */
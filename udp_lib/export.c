@@ -0,0 +1,699 @@
+/**
+ * @file udp_lib/export.c
+ * @author Vladsanin777
+ * @brief Code file for export counters of working process.
+ */
+
+#include "udp_lib/export.h"
+#include "udp_lib/stage.h"
+#include "udp_lib/histogram.h"
+#include "udp_lib/clock_private.h"
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <errno.h>
+#include <time.h>
+#include <poll.h>
+#include <pthread.h>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <net/if.h>
+
+/** Place is unix socket. */
+#define UNIX_EXPORT 0
+
+/** Place is file. */
+#define FILE_EXPORT 1
+
+/** Milliseconds client may write request before answer. */
+#define WAIT_REQUEST_EXPORT 100
+
+/** Max size of read request. */
+#define SIZE_REQUEST_EXPORT 1024
+
+/**
+ * @ingroup UdpExport
+ * @brief Struct is sender in snapshots.
+ * @note This struct is private. Not used outside udp_lib/export.c
+ */
+struct worker_export {
+    udp_sender_t m_sender; /**< Sender. */
+    size_t m_number; /**< Number worker in output. */
+    uint64_t m_start; /**< Nanoseconds CLOCK_MONOTONIC when added. */
+    uint64_t m_time; /**< Nanoseconds of last update of rate. */
+    uint64_t m_packets; /**< Packages at last update of rate. */
+    uint64_t m_bytes; /**< Bytes at last update of rate. */
+    double m_pps; /**< Packages per second over last interval. */
+    double m_bps; /**< Bits per second over last interval. */
+    struct worker_export * m_next; /**< Next worker in list. */
+};
+
+/**
+ * @ingroup UdpExport
+ * @brief Struct is copy of counters of one worker for output.
+ * @note This struct is private. Not used outside udp_lib/export.c
+ */
+struct snapshot_export {
+    char m_name[32]; /**< Number worker or `retired`. */
+    char m_interface[IFNAMSIZ]; /**< Interface or `file`. */
+    struct udp_sender_stats m_stats; /**< Counters. */
+    double m_pps; /**< Packages per second over last interval. */
+    double m_bps; /**< Bits per second over last interval. */
+    double m_average_pps; /**< Packages per second from start. */
+    double m_average_bps; /**< Bits per second from start. */
+};
+
+/**
+ * @ingroup UdpExport
+ * @brief Struct is counter of sender in output.
+ * @note This struct is private. Not used outside udp_lib/export.c
+ */
+struct metric_export {
+    const char * m_name; /**< Name without prefix. */
+    const char * m_help; /**< Help line of Prometheus. */
+    size_t m_offset; /**< Offset in struct udp_sender_stats. */
+};
+
+/** Counters of sender in output. */
+static const struct metric_export metrics_export[] = {
+    {"packets_total", "Frames taken by kernel or file.", \
+            offsetof(struct udp_sender_stats, m_packets)},
+    {"bytes_total", "Bytes of taken frames.", \
+            offsetof(struct udp_sender_stats, m_bytes)},
+    {"errors_total", "Frames not taken.", \
+            offsetof(struct udp_sender_stats, m_errors)},
+    {"retries_total", "Sends repeated after full queue.", \
+            offsetof(struct udp_sender_stats, m_retries)},
+    {"full_total", "Times queue of interface was full.", \
+            offsetof(struct udp_sender_stats, m_full)},
+    {"short_total", "Sends taken only part of frames.", \
+            offsetof(struct udp_sender_stats, m_short)},
+};
+
+/** Export is on. */
+static bool is_enabled_export = false;
+
+/** Format @ref PROMETHEUS_EXPORT or @ref JSON_EXPORT. */
+static uint8_t format_export = PROMETHEUS_EXPORT;
+
+/** Place @ref UNIX_EXPORT or @ref FILE_EXPORT. */
+static uint8_t type_export = UNIX_EXPORT;
+
+/** Path of socket or file. */
+static char * path_export = NULL;
+
+/** Listen socket for @ref UNIX_EXPORT. */
+static int fd_export = -1;
+
+/** Nanoseconds CLOCK_MONOTONIC when export started. */
+static uint64_t start_export = 0;
+
+/** Working senders. */
+static struct worker_export * workers_export = NULL;
+
+/** Count added senders, gives numbers of workers. */
+static size_t count_workers_export = 0;
+
+/** Sum counters of removed senders. */
+static struct udp_sender_stats retired_export;
+
+/** Lock of list workers, never taken by send path. */
+static pthread_mutex_t lock_export = PTHREAD_MUTEX_INITIALIZER;
+
+/**
+ * @ingroup UdpExport
+ * @brief Function add all counters of one stats to other.
+ * @param[in,out] sum Stats for work.
+ * @param[in] stats Stats for addition.
+ * @note This function is private. Not used outside udp_lib/export.c
+ */
+static void add_stats_export(struct udp_sender_stats * const sum, \
+        const struct udp_sender_stats * const stats) {
+    uint64_t * to = (uint64_t *)sum;
+    const uint64_t * from = (const uint64_t *)stats;
+
+    for (size_t i = 0; i < sizeof(*sum) / sizeof(*to); i++)
+        to[i] += from[i];
+}
+
+/**
+ * @ingroup UdpExport
+ * @brief Function update current rate of every worker.
+ * @note This function is private. Not used outside udp_lib/export.c
+ */
+static void tick_export(void) {
+    struct udp_sender_stats stats;
+
+    pthread_mutex_lock(&lock_export);
+    for (struct worker_export * worker = workers_export; worker; worker = worker->m_next) {
+        uint64_t now = now_clock();
+        double seconds = (now - worker->m_time) / (double)NSEC_CLOCK;
+
+        get_stats_udp_sender(worker->m_sender, &stats);
+        if (seconds > 0.0) {
+            worker->m_pps = (stats.m_packets - worker->m_packets) / seconds;
+            worker->m_bps = (stats.m_bytes - worker->m_bytes) * 8 / seconds;
+        }
+        worker->m_time = now;
+        worker->m_packets = stats.m_packets;
+        worker->m_bytes = stats.m_bytes;
+    }
+    pthread_mutex_unlock(&lock_export);
+}
+
+/**
+ * @ingroup UdpExport
+ * @brief Function copy counters of all workers and retired.
+ * @param[out] count Count snapshots.
+ * @return Array of snapshots, retired is last, or NULL on error.
+ * @note This function is private. Not used outside udp_lib/export.c
+ */
+static struct snapshot_export * take_export(size_t * const count) {
+    struct snapshot_export * snapshots = NULL;
+    size_t size = 1;
+    size_t index = 0;
+
+    pthread_mutex_lock(&lock_export);
+    for (struct worker_export * worker = workers_export; worker; worker = worker->m_next)
+        size++;
+
+    snapshots = calloc(size, sizeof(*snapshots));
+    if (snapshots == NULL)
+        goto get_not_memory;
+
+    /* List has newest first, output goes by numbers. */
+    index = size - 1;
+    for (struct worker_export * worker = workers_export; worker; worker = worker->m_next) {
+        struct snapshot_export * snapshot = &snapshots[--index];
+        double seconds = (now_clock() - worker->m_start) / (double)NSEC_CLOCK;
+        const char * interface = get_interface_udp_sender(worker->m_sender);
+
+        get_stats_udp_sender(worker->m_sender, &snapshot->m_stats);
+        snprintf(snapshot->m_name, sizeof(snapshot->m_name), "%zu", worker->m_number);
+        snprintf(snapshot->m_interface, sizeof(snapshot->m_interface), "%s", \
+                interface[0] ? interface : "file");
+        snapshot->m_pps = worker->m_pps;
+        snapshot->m_bps = worker->m_bps;
+        if (seconds > 0.0) {
+            snapshot->m_average_pps = snapshot->m_stats.m_packets / seconds;
+            snapshot->m_average_bps = snapshot->m_stats.m_bytes * 8 / seconds;
+        }
+    }
+
+    snprintf(snapshots[size - 1].m_name, sizeof(snapshots[size - 1].m_name), "retired");
+    snprintf(snapshots[size - 1].m_interface, sizeof(snapshots[size - 1].m_interface), "all");
+    snapshots[size - 1].m_stats = retired_export;
+    *count = size;
+
+get_not_memory:
+    pthread_mutex_unlock(&lock_export);
+    return snapshots;
+}
+
+/**
+ * @ingroup UdpExport
+ * @brief Function write snapshot in Prometheus text format.
+ * @param[in,out] out Stream for output.
+ * @param[in] snapshots Snapshots of workers.
+ * @param[in] count Count snapshots.
+ * @param[in] stages Snapshots of stages or NULL if stages are off.
+ * @note This function is private. Not used outside udp_lib/export.c
+ */
+static void render_prometheus_export(FILE * const out, \
+        const struct snapshot_export * const snapshots, const size_t count, \
+        const udp_histogram_t * const stages) {
+    static const double quantiles[] = {50.0, 90.0, 99.0, 99.9};
+
+    fprintf(out, "# HELP udp_uptime_seconds Seconds from start of export.\n" \
+            "# TYPE udp_uptime_seconds gauge\nudp_uptime_seconds %.3f\n", \
+            (now_clock() - start_export) / (double)NSEC_CLOCK);
+
+    for (size_t i = 0; i < sizeof(metrics_export) / sizeof(*metrics_export); i++) {
+        fprintf(out, "# HELP udp_%s %s\n# TYPE udp_%s counter\n", metrics_export[i].m_name, \
+                metrics_export[i].m_help, metrics_export[i].m_name);
+        for (size_t j = 0; j < count; j++) {
+            fprintf(out, "udp_%s{worker=\"%s\",interface=\"%s\"} %lu\n", \
+                    metrics_export[i].m_name, snapshots[j].m_name, snapshots[j].m_interface, \
+                    *(const uint64_t *)((const uint8_t *)&snapshots[j].m_stats + \
+                    metrics_export[i].m_offset));
+        }
+    }
+
+    fputs("# HELP udp_errno_total Frames not sended by errno.\n" \
+            "# TYPE udp_errno_total counter\n", out);
+    for (size_t j = 0; j < count; j++) {
+        for (size_t k = 0; k < COUNT_ERRNO_SENDER; k++) {
+            if (snapshots[j].m_stats.m_errnos[k] == 0)
+                continue;
+            fprintf(out, "udp_errno_total{worker=\"%s\",interface=\"%s\",errno=\"%zu\"} %lu\n", \
+                    snapshots[j].m_name, snapshots[j].m_interface, k, \
+                    snapshots[j].m_stats.m_errnos[k]);
+        }
+    }
+
+    fputs("# HELP udp_packets_per_second Rate over last interval and from start.\n" \
+            "# TYPE udp_packets_per_second gauge\n", out);
+    for (size_t j = 0; j + 1 < count; j++) {
+        fprintf(out, "udp_packets_per_second{worker=\"%s\",interface=\"%s\",window=\"current\"} " \
+                "%.1f\nudp_packets_per_second{worker=\"%s\",interface=\"%s\",window=\"average\"} " \
+                "%.1f\n", snapshots[j].m_name, snapshots[j].m_interface, snapshots[j].m_pps, \
+                snapshots[j].m_name, snapshots[j].m_interface, snapshots[j].m_average_pps);
+    }
+
+    fputs("# HELP udp_bits_per_second Rate over last interval and from start.\n" \
+            "# TYPE udp_bits_per_second gauge\n", out);
+    for (size_t j = 0; j + 1 < count; j++) {
+        fprintf(out, "udp_bits_per_second{worker=\"%s\",interface=\"%s\",window=\"current\"} " \
+                "%.1f\nudp_bits_per_second{worker=\"%s\",interface=\"%s\",window=\"average\"} " \
+                "%.1f\n", snapshots[j].m_name, snapshots[j].m_interface, snapshots[j].m_bps, \
+                snapshots[j].m_name, snapshots[j].m_interface, snapshots[j].m_average_bps);
+    }
+
+    if (stages == NULL)
+        return;
+
+    fputs("# HELP udp_stage_nanoseconds Time of stage of send path.\n" \
+            "# TYPE udp_stage_nanoseconds summary\n", out);
+    for (uint8_t stage = 0; stage < COUNT_STAGE; stage++) {
+        const char * name = get_name_udp_stage(stage);
+        udp_histogram_t histogram = stages[stage];
+
+        if (get_count_udp_histogram(histogram) == 0)
+            continue;
+        for (size_t i = 0; i < sizeof(quantiles) / sizeof(*quantiles); i++) {
+            fprintf(out, "udp_stage_nanoseconds{stage=\"%s\",quantile=\"%g\"} %lu\n", name, \
+                    quantiles[i] / 100.0, get_percentile_udp_histogram(histogram, quantiles[i]));
+        }
+        fprintf(out, "udp_stage_nanoseconds_count{stage=\"%s\"} %lu\n", name, \
+                get_count_udp_histogram(histogram));
+    }
+}
+
+/**
+ * @ingroup UdpExport
+ * @brief Function write snapshot in JSON format.
+ * @param[in,out] out Stream for output.
+ * @param[in] snapshots Snapshots of workers.
+ * @param[in] count Count snapshots.
+ * @param[in] stages Snapshots of stages or NULL if stages are off.
+ * @note This function is private. Not used outside udp_lib/export.c
+ */
+static void render_json_export(FILE * const out, \
+        const struct snapshot_export * const snapshots, const size_t count, \
+        const udp_histogram_t * const stages) {
+    bool is_first = true;
+
+    fprintf(out, "{\"uptime\":%.3f,\"workers\":[", \
+            (now_clock() - start_export) / (double)NSEC_CLOCK);
+
+    for (size_t j = 0; j < count; j++) {
+        const struct snapshot_export * snapshot = &snapshots[j];
+
+        fprintf(out, "%s{\"worker\":\"%s\",\"interface\":\"%s\"", j ? "," : "", \
+                snapshot->m_name, snapshot->m_interface);
+        for (size_t i = 0; i < sizeof(metrics_export) / sizeof(*metrics_export); i++) {
+            fprintf(out, ",\"%s\":%lu", metrics_export[i].m_name, \
+                    *(const uint64_t *)((const uint8_t *)&snapshot->m_stats + \
+                    metrics_export[i].m_offset));
+        }
+        if (j + 1 < count) {
+            fprintf(out, ",\"pps\":%.1f,\"bps\":%.1f,\"average_pps\":%.1f," \
+                    "\"average_bps\":%.1f", snapshot->m_pps, snapshot->m_bps, \
+                    snapshot->m_average_pps, snapshot->m_average_bps);
+        }
+        fputs(",\"errno\":{", out);
+        is_first = true;
+        for (size_t k = 0; k < COUNT_ERRNO_SENDER; k++) {
+            if (snapshot->m_stats.m_errnos[k] == 0)
+                continue;
+            fprintf(out, "%s\"%zu\":%lu", is_first ? "" : ",", k, snapshot->m_stats.m_errnos[k]);
+            is_first = false;
+        }
+        fputs("}}", out);
+    }
+    fputs("]", out);
+
+    if (stages != NULL) {
+        fputs(",\"stages\":{", out);
+        is_first = true;
+        for (uint8_t stage = 0; stage < COUNT_STAGE; stage++) {
+            udp_histogram_t histogram = stages[stage];
+
+            if (get_count_udp_histogram(histogram) == 0)
+                continue;
+            fprintf(out, "%s\"%s\":{\"count\":%lu,\"mean\":%lu,\"p50\":%lu,\"p90\":%lu," \
+                    "\"p99\":%lu,\"p99.9\":%lu,\"max\":%lu}", is_first ? "" : ",", \
+                    get_name_udp_stage(stage), get_count_udp_histogram(histogram), \
+                    get_mean_udp_histogram(histogram), \
+                    get_percentile_udp_histogram(histogram, 50.0), \
+                    get_percentile_udp_histogram(histogram, 90.0), \
+                    get_percentile_udp_histogram(histogram, 99.0), \
+                    get_percentile_udp_histogram(histogram, 99.9), \
+                    get_max_udp_histogram(histogram));
+            is_first = false;
+        }
+        fputs("}", out);
+    }
+
+    fputs("}\n", out);
+}
+
+/**
+ * @ingroup UdpExport
+ * @brief Function write snapshot in memory.
+ * @param[out] size Size text.
+ * @return Text or NULL on error, free it.
+ * @note This function is private. Not used outside udp_lib/export.c
+ */
+static char * render_export(size_t * const size) {
+    char * text = NULL;
+    FILE * out = NULL;
+    size_t count = 0;
+    struct snapshot_export * snapshots = NULL;
+    udp_histogram_t stages[COUNT_STAGE] = {NULL};
+    bool is_stages = is_enabled_udp_stage();
+
+    snapshots = take_export(&count);
+    if (snapshots == NULL)
+        goto take_not_snapshots;
+
+    /* Stages are taken once with counters, output never reads live histograms. */
+    for (uint8_t stage = 0; is_stages && stage < COUNT_STAGE; stage++) {
+        stages[stage] = init_udp_histogram();
+        if (stages[stage] == NULL)
+            goto get_not_histogram;
+        merge_udp_stage(stage, stages[stage]);
+    }
+
+    out = open_memstream(&text, size);
+    if (out == NULL)
+        goto open_not_stream;
+
+    if (format_export == JSON_EXPORT)
+        render_json_export(out, snapshots, count, is_stages ? stages : NULL);
+    else
+        render_prometheus_export(out, snapshots, count, is_stages ? stages : NULL);
+
+    fclose(out);
+
+open_not_stream:
+get_not_histogram:
+    for (uint8_t stage = 0; stage < COUNT_STAGE; stage++)
+        destroy_udp_histogram(stages[stage]);
+    free(snapshots);
+take_not_snapshots:
+    return text;
+}
+
+/**
+ * @ingroup UdpExport
+ * @brief Function write all buffer in descriptor.
+ * @param[in] fd Descriptor.
+ * @param[in] buffer Buffer.
+ * @param[in] size Size buffer.
+ * @return 0 or -1 on error.
+ * @note This function is private. Not used outside udp_lib/export.c
+ */
+static ssize_t write_all_export(const int fd, const char * const buffer, const size_t size) {
+    size_t written = 0;
+
+    while (written < size) {
+        ssize_t ret = send(fd, buffer + written, size - written, MSG_NOSIGNAL);
+
+        if (ret < 0 && errno == ENOTSOCK)
+            ret = write(fd, buffer + written, size - written);
+        if (ret < 0) {
+            if (errno == EINTR)
+                continue;
+            return -1;
+        }
+        written += ret;
+    }
+
+    return 0;
+}
+
+/**
+ * @ingroup UdpExport
+ * @brief Function rewrite file by full copy and rename.
+ * @note This function is private. Not used outside udp_lib/export.c
+ */
+static void write_file_export(void) {
+    size_t size = 0;
+    char * text = render_export(&size);
+    char * temporary = NULL;
+    FILE * file = NULL;
+
+    if (text == NULL)
+        return;
+    if (asprintf(&temporary, "%s.tmp", path_export) < 0)
+        goto get_not_temporary;
+
+    file = fopen(temporary, "w");
+    if (file == NULL)
+        goto open_not_file;
+    fwrite(text, 1, size, file);
+    if (fclose(file) == 0)
+        rename(temporary, path_export);
+
+open_not_file:
+    free(temporary);
+get_not_temporary:
+    free(text);
+}
+
+/**
+ * @ingroup UdpExport
+ * @brief Function answer one connection on unix socket.
+ * @param[in] client Socket of client.
+ * @note This function is private. Not used outside udp_lib/export.c
+ */
+static void serve_export(const int client) {
+    struct pollfd wait = {.fd = client, .events = POLLIN};
+    char request[SIZE_REQUEST_EXPORT];
+    char head[128];
+    ssize_t size_request = 0;
+    size_t size = 0;
+    char * text = NULL;
+
+    /* Plain reader may send nothing, HTTP client sends request first. */
+    if (poll(&wait, 1, WAIT_REQUEST_EXPORT) > 0)
+        size_request = recv(client, request, sizeof(request), MSG_DONTWAIT);
+
+    text = render_export(&size);
+    if (text == NULL)
+        return;
+
+    if (size_request >= 4 && memcmp(request, "GET ", 4) == 0) {
+        int size_head = snprintf(head, sizeof(head), "HTTP/1.0 200 OK\r\n" \
+                "Content-Type: %s\r\nContent-Length: %zu\r\n\r\n", \
+                format_export == JSON_EXPORT ? "application/json" : \
+                "text/plain; version=0.0.4", size);
+
+        if (write_all_export(client, head, size_head))
+            goto write_not_head;
+    }
+    write_all_export(client, text, size);
+
+write_not_head:
+    free(text);
+}
+
+/**
+ * @ingroup UdpExport
+ * @brief Function of thread of export.
+ * @param[in] argument Not used.
+ * @return NULL.
+ * @note This function is private. Not used outside udp_lib/export.c
+ */
+static void * run_export(void * argument) {
+    uint64_t next = now_clock() + INTERVAL_EXPORT * NSEC_MSEC_CLOCK;
+
+    (void)argument;
+    for (;;) {
+        uint64_t now = now_clock();
+        int timeout = now < next ? (int)((next - now) / NSEC_MSEC_CLOCK) + 1 : 0;
+
+        if (type_export == UNIX_EXPORT) {
+            struct pollfd wait = {.fd = fd_export, .events = POLLIN};
+
+            if (poll(&wait, 1, timeout) > 0) {
+                int client = accept4(fd_export, NULL, NULL, SOCK_CLOEXEC);
+
+                if (client >= 0) {
+                    serve_export(client);
+                    close(client);
+                }
+            }
+        } else {
+            struct timespec sleep = {
+                .tv_sec = timeout / 1000,
+                .tv_nsec = (timeout % 1000) * NSEC_MSEC_CLOCK,
+            };
+
+            nanosleep(&sleep, NULL);
+        }
+
+        if (now_clock() < next)
+            continue;
+        next += INTERVAL_EXPORT * NSEC_MSEC_CLOCK;
+        tick_export();
+        if (type_export == FILE_EXPORT)
+            write_file_export();
+    }
+
+    return NULL;
+}
+
+/**
+ * @ingroup UdpExport
+ * @brief Function write last snapshot in file or remove socket at exit.
+ * @note This function is private. Not used outside udp_lib/export.c
+ */
+static void finish_export(void) {
+    if (type_export == FILE_EXPORT) {
+        tick_export();
+        write_file_export();
+    } else {
+        unlink(path_export);
+    }
+}
+
+/**
+ * @ingroup UdpExport
+ * @brief Function open listen unix socket.
+ * @return 0 or -1 on error.
+ * @note This function is private. Not used outside udp_lib/export.c
+ */
+static ssize_t listen_export(void) {
+    struct sockaddr_un address = {.sun_family = AF_UNIX};
+
+    if (strlen(path_export) >= sizeof(address.sun_path)) {
+        fputs("ERROR: path export is too long\n", stderr);
+        return -1;
+    }
+    strcpy(address.sun_path, path_export);
+
+    fd_export = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd_export < 0) {
+        perror("ERROR: get not socket export");
+        return -1;
+    }
+
+    unlink(path_export);
+    if (bind(fd_export, (struct sockaddr *)&address, sizeof(address)) || \
+            listen(fd_export, SOMAXCONN)) {
+        perror("ERROR: listen not socket export");
+        close(fd_export);
+        fd_export = -1;
+        return -1;
+    }
+
+    return 0;
+}
+
+ssize_t enable_udp_export(const char * const place, const uint8_t format) {
+    ssize_t ret = 0;
+    pthread_t thread;
+    pthread_attr_t attributes;
+
+    if (is_enabled_export)
+        return ret;
+
+    if (strncmp(place, "unix:", 5) == 0) {
+        type_export = UNIX_EXPORT;
+    } else if (strncmp(place, "file:", 5) == 0) {
+        type_export = FILE_EXPORT;
+    } else {
+        ret = -1;
+        fprintf(stderr, "ERROR: wrong place of export '%s'\n", place);
+        goto wrong_place;
+    }
+
+    path_export = strdup(place + 5);
+    if (path_export == NULL) {
+        ret = -1;
+        goto get_not_memory;
+    }
+    format_export = format;
+    start_export = now_clock();
+
+    if (type_export == UNIX_EXPORT && listen_export()) {
+        ret = -1;
+        goto listen_not_socket;
+    }
+
+    pthread_attr_init(&attributes);
+    pthread_attr_setdetachstate(&attributes, PTHREAD_CREATE_DETACHED);
+    if (pthread_create(&thread, &attributes, run_export, NULL)) {
+        ret = -1;
+        fputs("ERROR: create not thread of export\n", stderr);
+        goto create_not_thread;
+    }
+    pthread_attr_destroy(&attributes);
+
+    is_enabled_export = true;
+    atexit(finish_export);
+
+    return ret;
+create_not_thread:
+    pthread_attr_destroy(&attributes);
+    if (fd_export >= 0) {
+        close(fd_export);
+        unlink(path_export);
+        fd_export = -1;
+    }
+listen_not_socket:
+    free(path_export);
+    path_export = NULL;
+get_not_memory:
+wrong_place:
+    return ret;
+}
+
+void add_sender_udp_export(udp_sender_t sender) {
+    struct worker_export * worker = NULL;
+
+    if (!is_enabled_export)
+        return;
+
+    worker = calloc(1, sizeof(*worker));
+    if (worker == NULL)
+        return;
+    worker->m_sender = sender;
+    worker->m_start = now_clock();
+    worker->m_time = worker->m_start;
+
+    pthread_mutex_lock(&lock_export);
+    worker->m_number = count_workers_export++;
+    worker->m_next = workers_export;
+    workers_export = worker;
+    pthread_mutex_unlock(&lock_export);
+}
+
+void remove_sender_udp_export(udp_sender_t sender) {
+    struct udp_sender_stats stats;
+
+    if (!is_enabled_export)
+        return;
+
+    pthread_mutex_lock(&lock_export);
+    for (struct worker_export ** link = &workers_export; *link; link = &(*link)->m_next) {
+        struct worker_export * worker = *link;
+
+        if (worker->m_sender != sender)
+            continue;
+        get_stats_udp_sender(sender, &stats);
+        add_stats_export(&retired_export, &stats);
+        *link = worker->m_next;
+        free(worker);
+        break;
+    }
+    pthread_mutex_unlock(&lock_export);
+}
@@ -0,0 +1,72 @@
+/**
+ * @file udp_lib/export.h
+ * @author Vladsanin777
+ * @brief Header file for export counters of working process.
+ */
+
+#ifndef UDP_LIB_EXPORT_H
+#define UDP_LIB_EXPORT_H
+
+#include "udp_lib/sender.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+
+/**
+ * @defgroup UdpExport export for udp
+ * @brief Group function for read counters of working process from outside.
+ *
+ * Place is given by string:
+ * - `unix:PATH` is unix stream socket, every connection gets one snapshot,
+ *   request starting with `GET ` gets HTTP answer, so
+ *   `curl --unix-socket PATH http://udp/metrics` works;
+ * - `file:PATH` is file rewritten every interval by rename of full copy.
+ *
+ * Snapshot has for every sender (worker) packages, bytes, errors, retries, full
+ * queue, short sends and errno, current rate over last interval and average rate
+ * from start of sender, closed senders are summed in worker `retired`. If
+ * @ref UdpStage is on, percentiles of stages are added. Counters are read by
+ * seqlock of sender and histograms of stages by seqlock snapshots of
+ * @ref merge_udp_stage in own thread, send path never waits.
+ * @{
+ */
+
+/** Prometheus text format. */
+#define PROMETHEUS_EXPORT 0
+
+/** JSON format. */
+#define JSON_EXPORT 1
+
+/** Milliseconds between updates of current rate and of file. */
+#define INTERVAL_EXPORT 1000
+
+/**
+ * @brief Function start thread of export.
+ * @note Call it before senders are created, they are added when created.
+ * @param[in] place Place string `unix:PATH` or `file:PATH`.
+ * @param[in] format @ref PROMETHEUS_EXPORT or @ref JSON_EXPORT.
+ * @return 0 or -1 on error.
+ * Usage example.
+ * @code
+ * ret = enable_udp_export("unix:/run/udp.sock", PROMETHEUS_EXPORT);
+ * if (ret)
+ *     goto enable_not_export;
+ * @endcode
+ */
+ssize_t enable_udp_export(const char * const place, const uint8_t format);
+
+/**
+ * @brief Function add sender in snapshots, nothing if export is off.
+ * @param[in] sender Sender for work.
+ */
+void add_sender_udp_export(udp_sender_t sender);
+
+/**
+ * @brief Function remove sender from snapshots, its counters go to `retired`.
+ * @param[in] sender Sender for work.
+ */
+void remove_sender_udp_export(udp_sender_t sender);
+
+/** @} */
+
+#endif /* UDP_LIB_EXPORT_H */
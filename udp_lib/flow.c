@@ -0,0 +1,442 @@
+/**
+ * @file udp_lib/flow.c
+ * @author Vladsanin777
+ * @brief Code file for weighted scheduler of many UDP flows.
+ */
+
+#include "udp_lib/flow.h"
+#include "udp_lib/udp_private.h"
+#include "udp_lib/sender.h"
+#include "udp_lib/imix.h"
+#include "udp_lib/stage.h"
+#include "udp_lib/record_private.h"
+#include "udp_lib/clock_private.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+
+#include <sys/socket.h>
+#include <sys/prctl.h>
+
+/** Max frames in one call of sender. */
+#define BATCH_FLOW 64
+
+/** Max flows printed apart in report. */
+#define MAX_PRINT_FLOW 16
+
+/** Start count flows in array. */
+#define START_FLOWS_FLOW 64
+
+/**
+ * @ingroup UdpFlow
+ * @brief Struct is one flow with ready headers.
+ * @note This struct is private. Not used outside udp_lib/flow.c
+ */
+struct one_flow {
+    struct udp_frame m_frame; /**< Headers, lengths and checksums are zero. */
+    uint8_t m_size_ip; /**< HEAD_IP or HEAD_IP6. */
+    uint8_t m_family; /**< AF_INET or AF_INET6. */
+    uint16_t m_next; /**< Size IP package of next package. */
+    uint32_t m_sum; /**< Partial sum pseudo header and ports. */
+    uint32_t m_sum_ip; /**< Partial sum IP header for AF_INET. */
+    uint64_t m_quantum; /**< Bytes added every turn. */
+    uint64_t m_deficit; /**< Bytes flow may send now. */
+    udp_imix_t m_imix; /**< Sizes of flow or NULL for fixed size. */
+    uint64_t m_sended; /**< Sended packages. */
+    uint64_t m_bytes; /**< Sended bytes of IP packages. */
+};
+
+/**
+ * @ingroup UdpFlow
+ * @brief Struct is built imix, shared by flows with same profile and family.
+ * @note This struct is private. Not used outside udp_lib/flow.c
+ */
+struct cache_flow {
+    char * m_profile; /**< Profile string. */
+    uint8_t m_family; /**< AF_INET or AF_INET6. */
+    udp_imix_t m_imix; /**< Imix. */
+};
+
+/**
+ * @ingroup UdpFlow
+ * @brief Struct is state of scheduler, all buffers are taken once.
+ * @note This struct is private. Not used outside udp_lib/flow.c
+ */
+struct state_flow {
+    udp_pack_t m_pack; /**< UDP package with fields of current line. */
+    uint16_t m_mtu; /**< MTU of sender. */
+    struct one_flow * m_flows; /**< Flows. */
+    size_t m_count; /**< Count flows. */
+    size_t m_capacity; /**< Place for flows. */
+    struct cache_flow * m_caches; /**< Built imixes. */
+    size_t m_count_caches; /**< Count built imixes. */
+    struct udp_record m_record; /**< Common fields current line. */
+    char m_profile[SIZE_VALUE_RECORD]; /**< Imix profile, empty for fixed size. */
+    uint32_t m_weight; /**< Weight current line. */
+    uint16_t m_size_data; /**< Size payload of fixed size. */
+    uint8_t m_payload[MAX_SIZE_DATA]; /**< Payload of all flows. */
+    uint32_t m_prefix[MAX_SIZE_DATA + 1]; /**< Sums of payload for every size. */
+};
+
+/**
+ * @ingroup UdpFlow
+ * @brief Function fill payload by data of package and sums for every size.
+ *
+ * Sum of first bytes is in same big endian words as @ref sum_compute, so
+ * checksum of any size is taken without reading payload.
+ * @param[in,out] state State scheduler.
+ * @note This function is private. Not used outside udp_lib/flow.c
+ */
+static void fill_payload_flow(struct state_flow * const state) {
+    udp_pack_t pack = state->m_pack;
+    uint16_t size_data = get_size_data_udp_pack(pack);
+
+    if (size_data == 0) {
+        memset(state->m_payload, 0x00, MAX_SIZE_DATA);
+    } else {
+        for (size_t filled = 0; filled < MAX_SIZE_DATA; filled += size_data)
+            memcpy(state->m_payload + filled, pack->m_data, \
+                    MIN(size_data, MAX_SIZE_DATA - filled));
+    }
+    state->m_size_data = size_data;
+
+    state->m_prefix[0] = 0;
+    for (size_t i = 1; i <= MAX_SIZE_DATA; i++) {
+        if (i & 1)
+            state->m_prefix[i] = state->m_prefix[i - 1] + \
+                    (state->m_payload[i - 1] << 8);
+        else
+            state->m_prefix[i] = state->m_prefix[i - 2] + \
+                    (state->m_payload[i - 2] << 8) + state->m_payload[i - 1];
+    }
+}
+
+/**
+ * @ingroup UdpFlow
+ * @brief Function find or build imix of profile for family.
+ * @param[in,out] state State scheduler.
+ * @param[in] family AF_INET or AF_INET6.
+ * @return Imix or NULL on error.
+ * @note This function is private. Not used outside udp_lib/flow.c
+ */
+static udp_imix_t get_imix_flow(struct state_flow * const state, const uint8_t family) {
+    struct cache_flow * caches = NULL;
+    struct cache_flow * cache = NULL;
+    udp_pack_t scratch = NULL;
+
+    for (size_t i = 0; i < state->m_count_caches; i++) {
+        if (state->m_caches[i].m_family == family && \
+                strcmp(state->m_caches[i].m_profile, state->m_profile) == 0)
+            return state->m_caches[i].m_imix;
+    }
+
+    caches = realloc(state->m_caches, sizeof(*caches) * (state->m_count_caches + 1));
+    if (caches == NULL)
+        goto get_not_memory;
+    state->m_caches = caches;
+    cache = &caches[state->m_count_caches];
+
+    /* Only sizes are taken from imix, so its frames are built without neighbors. */
+    scratch = init_udp_pack();
+    if (scratch == NULL)
+        goto get_not_scratch;
+    if (set_family_udp_pack(scratch, family))
+        goto set_not_family;
+    scratch->m_flags |= FLAG_RESOLVED_UDP_PACK;
+
+    cache->m_profile = strdup(state->m_profile);
+    if (cache->m_profile == NULL)
+        goto get_not_profile;
+    cache->m_family = family;
+    cache->m_imix = init_udp_imix(scratch, state->m_profile, state->m_mtu);
+    if (cache->m_imix == NULL)
+        goto get_not_imix;
+    state->m_count_caches++;
+
+    destroy_udp_pack(scratch);
+
+    return cache->m_imix;
+get_not_imix:
+    free(cache->m_profile);
+get_not_profile:
+set_not_family:
+    destroy_udp_pack(scratch);
+get_not_scratch:
+get_not_memory:
+    return NULL;
+}
+
+/**
+ * @ingroup UdpFlow
+ * @brief Function apply one field of line to state.
+ * @param[in,out] state State scheduler.
+ * @param[in] field Field.
+ * @return 0 or -1 on error.
+ * @note This function is private. Not used outside udp_lib/flow.c
+ */
+static ssize_t apply_field_flow(struct state_flow * const state, \
+        const struct udp_field * const field) {
+    ssize_t ret = apply_udp_record(&state->m_record, state->m_pack, field);
+
+    if (ret <= 0)
+        return ret;
+    if (field->m_value == NULL)
+        return -1;
+
+    if (is_key_udp_record(field, "imix")) {
+        if (copy_value_udp_record(state->m_profile, SIZE_VALUE_RECORD, field))
+            return -1;
+        if (strcmp(state->m_profile, "none") == 0)
+            state->m_profile[0] = '\0';
+        return 0;
+    }
+    if (is_key_udp_record(field, "weight")) {
+        unsigned long weight = 0;
+
+        if (copy_value_udp_record(state->m_record.m_value, SIZE_VALUE_RECORD, field))
+            return -1;
+        weight = strtoul(state->m_record.m_value, NULL, 0);
+        if (weight == 0 || weight > UINT32_MAX)
+            return -1;
+        state->m_weight = weight;
+        return 0;
+    }
+
+    return -1;
+}
+
+/**
+ * @ingroup UdpFlow
+ * @brief Function take headers and sums of package as new flow.
+ * @param[in,out] state State scheduler.
+ * @return 0 or -1 on error.
+ * @note This function is private. Not used outside udp_lib/flow.c
+ */
+static ssize_t add_flow(struct state_flow * const state) {
+    udp_pack_t pack = state->m_pack;
+    struct one_flow * flow = NULL;
+    struct udp_head * head = NULL;
+    size_t size_ip = get_size_ip_udp_pack(pack);
+
+    if (state->m_count == state->m_capacity) {
+        size_t capacity = state->m_capacity ? state->m_capacity * 2 : START_FLOWS_FLOW;
+        struct one_flow * flows = realloc(state->m_flows, sizeof(*flows) * capacity);
+
+        if (flows == NULL)
+            return -1;
+        state->m_flows = flows;
+        state->m_capacity = capacity;
+    }
+    flow = &state->m_flows[state->m_count];
+    memset(flow, 0x00, sizeof(*flow));
+
+    get_frame_udp_pack(pack, &flow->m_frame);
+    head = (struct udp_head *)(flow->m_frame.m_l3 + size_ip);
+
+    flow->m_size_ip = size_ip;
+    flow->m_family = pack->m_family;
+    flow->m_sum = pack->m_sum_address + IPPROTO_UDP + sum_compute(head, HEAD_UDP);
+    if (flow->m_family == AF_INET)
+        flow->m_sum_ip = sum_compute(&flow->m_frame.m_iphdr, HEAD_IP);
+
+    if (state->m_profile[0]) {
+        flow->m_imix = get_imix_flow(state, flow->m_family);
+        if (flow->m_imix == NULL)
+            return -1;
+        flow->m_next = next_size_udp_imix(flow->m_imix);
+    } else {
+        size_t size = size_ip + HEAD_UDP + state->m_size_data;
+
+        if (size > state->m_mtu) {
+            fprintf(stderr, "ERROR: size %zu of flow is bigger than MTU %u\n", \
+                    size, state->m_mtu);
+            return -1;
+        }
+        flow->m_next = size;
+    }
+
+    /* Quantum not smaller than MTU sends at least one package every turn. */
+    flow->m_quantum = (uint64_t)state->m_weight * state->m_mtu;
+    state->m_count++;
+
+    return 0;
+}
+
+/**
+ * @ingroup UdpFlow
+ * @brief Function parse one line of flows file.
+ * @param[in,out] context State scheduler.
+ * @param[in] line Start line.
+ * @param[in] end End line.
+ * @return 0 or -1 on error.
+ * @note This function is private. Not used outside udp_lib/flow.c
+ */
+static ssize_t parse_line_flow(void * const context, \
+        const char * line, const char * const end) {
+    struct state_flow * state = context;
+    struct udp_field field;
+    bool is_record = false;
+    ssize_t ret = 0;
+
+    begin_udp_record(&state->m_record, state->m_pack);
+    while ((ret = next_field_udp_record(&line, end, &field)) > 0) {
+        if (apply_field_flow(state, &field))
+            return -1;
+        is_record = true;
+    }
+    if (ret < 0)
+        return -1;
+
+    if (!is_record)
+        return 0;
+
+    if (end_udp_record(&state->m_record, state->m_pack))
+        return -1;
+
+    return add_flow(state);
+}
+
+/**
+ * @ingroup UdpFlow
+ * @brief Function write headers of next package of flow.
+ * @param[in,out] flow Flow.
+ * @param[out] frame Headers of package.
+ * @param[in] prefix Sums of payload for every size.
+ * @return Size payload.
+ * @note This function is private. Not used outside udp_lib/flow.c
+ */
+static inline uint16_t wrap_flow(const struct one_flow * const flow, \
+        struct udp_frame * const frame, const uint32_t * const prefix) {
+    uint16_t length = flow->m_next - flow->m_size_ip;
+    uint16_t size = length - HEAD_UDP;
+    struct udp_head * head = wrap_frame_udp_pack(frame, &flow->m_frame, flow->m_family, length);
+
+    head->m_checksum = checksum_compute(flow->m_sum + 2 * length + prefix[size]);
+    if (flow->m_family == AF_INET)
+        frame->m_iphdr.check = checksum_compute(flow->m_sum_ip + flow->m_next);
+
+    return size;
+}
+
+ssize_t run_flows_udp_pack(udp_pack_t pack, const char * const file, \
+        const uint64_t rate, const uint64_t count) {
+    ssize_t ret = 0;
+    udp_sender_t sender = NULL;
+    struct state_flow * state = NULL;
+    struct udp_frame frames[BATCH_FLOW];
+    struct iovec parts[BATCH_FLOW][2];
+    uint32_t indexes[BATCH_FLOW];
+    uint64_t start = 0;
+    uint64_t sended = 0;
+    uint64_t bytes = 0;
+    size_t current = 0;
+    double seconds = 0.0;
+
+    sender = init_pack_udp_sender(pack);
+    if (sender == NULL) {
+        ret = -1;
+        goto get_not_sender;
+    }
+
+    state = calloc(1, sizeof(*state));
+    if (state == NULL) {
+        ret = -1;
+        goto get_not_memory;
+    }
+    state->m_pack = pack;
+    state->m_mtu = get_mtu_udp_sender(sender);
+    state->m_weight = 1;
+    fill_payload_flow(state);
+
+    ret = read_udp_record(file, "flows", parse_line_flow, state);
+    if (ret)
+        goto parse_not_flows;
+    if (state->m_count == 0) {
+        ret = -1;
+        fprintf(stderr, "ERROR: flows %s has not flows\n", file);
+        goto empty_flows;
+    }
+
+    if (rate)
+        prctl(PR_SET_TIMERSLACK, 1UL);
+    start = now_clock();
+
+    state->m_flows[0].m_deficit = state->m_flows[0].m_quantum;
+    for (uint64_t done = 0; done < count;) {
+        size_t batch = MIN(count - done, BATCH_FLOW);
+        ssize_t batch_sended = 0;
+        uint64_t begin = 0;
+
+        if (rate)
+            sleep_until_clock(start + done * NSEC_CLOCK / rate);
+
+        begin = begin_udp_stage();
+        for (size_t i = 0; i < batch;) {
+            struct one_flow * flow = &state->m_flows[current];
+
+            if (flow->m_deficit < flow->m_next) {
+                current = current + 1 == state->m_count ? 0 : current + 1;
+                state->m_flows[current].m_deficit += state->m_flows[current].m_quantum;
+                continue;
+            }
+
+            parts[i][0].iov_base = &frames[i];
+            parts[i][0].iov_len = HEAD_ETH + flow->m_size_ip + HEAD_UDP;
+            parts[i][1].iov_base = state->m_payload;
+            parts[i][1].iov_len = wrap_flow(flow, &frames[i], state->m_prefix);
+            indexes[i++] = current;
+
+            flow->m_deficit -= flow->m_next;
+            if (flow->m_imix != NULL)
+                flow->m_next = next_size_udp_imix(flow->m_imix);
+        }
+        end_udp_stage(BUILD_STAGE, begin);
+
+        batch_sended = send_scatter_udp_sender(sender, parts[0], 2, batch);
+        for (ssize_t i = 0; i < batch_sended; i++) {
+            struct one_flow * flow = &state->m_flows[indexes[i]];
+            uint16_t size = parts[i][0].iov_len + parts[i][1].iov_len - HEAD_ETH;
+
+            flow->m_sended++;
+            flow->m_bytes += size;
+            bytes += size;
+        }
+        if (batch_sended > 0)
+            sended += batch_sended;
+        done += batch;
+    }
+
+    seconds = (now_clock() - start) / (double)NSEC_CLOCK;
+    if (finish_udp_sender(sender))
+        ret = -1;
+
+    printf("flows: %zu sended: %lu errors: %lu bytes: %lu seconds: %.3f " \
+            "rate: %.0f pps %.3f Gbit/s\n", state->m_count, sended, count - sended, \
+            bytes, seconds, seconds > 0.0 ? sended / seconds : 0.0, \
+            seconds > 0.0 ? bytes * 8 / seconds / 1e9 : 0.0);
+    for (size_t i = 0; i < state->m_count && state->m_count <= MAX_PRINT_FLOW; i++) {
+        printf("  flow %zu: %lu packages %lu bytes (%.2f%%)\n", i, \
+                state->m_flows[i].m_sended, state->m_flows[i].m_bytes, \
+                bytes ? 100.0 * state->m_flows[i].m_bytes / bytes : 0.0);
+    }
+    print_stats_udp_sender(sender);
+    if (sended != count)
+        ret = -1;
+
+empty_flows:
+parse_not_flows:
+    for (size_t i = 0; i < state->m_count_caches; i++) {
+        destroy_udp_imix(state->m_caches[i].m_imix);
+        free(state->m_caches[i].m_profile);
+    }
+    free(state->m_caches);
+    free(state->m_flows);
+    free(state);
+get_not_memory:
+    destroy_udp_sender(sender);
+get_not_sender:
+    return ret;
+}
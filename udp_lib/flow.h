@@ -0,0 +1,61 @@
+/**
+ * @file udp_lib/flow.h
+ * @author Vladsanin777
+ * @brief Header file for weighted scheduler of many UDP flows.
+ */
+
+#ifndef UDP_LIB_FLOW_H
+#define UDP_LIB_FLOW_H
+
+#include "udp_lib/udp.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+
+/**
+ * @defgroup UdpFlow flow for udp
+ * @brief Group function for send many flows together by weights.
+ *
+ * One line of flows file is one flow: fields `key=value` divided by spaces,
+ * `#` start comment. Keys are as in scenario: `mac-address-source`,
+ * `mac-address-destantion`, `ip-address-source`, `ip-address-destination`,
+ * `port-source`, `port-destanition`, `ipv4`, `ipv6`, and own keys
+ * `weight` (share of bytes, default 1) and `imix` (profile of sizes as in
+ * @ref UdpImix, `none` is size of data of package). Fields not set are kept
+ * from previous flow, `ipv4` and `ipv6` reset addresses. Lines are parsed by
+ * same code as scenario, so values can be in quotes. Keys `interface`, `data`,
+ * `hex` and `file` are not taken: all flows go by one sender and share payload.
+ *
+ * Flows are served by deficit round robin over bytes: every turn flow gets
+ * weight multiplied by MTU, so every turn sends at least one package and
+ * cost of one package does not depend on count flows. Every flow keeps ready
+ * headers and partial checksums, payload is one buffer for all flows.
+ * @code
+ * ip-address-source=10.0.0.1 ip-address-destination=10.0.1.1 port-destanition=53 imix=imix
+ * port-source=1001
+ * port-source=1002 weight=4 imix=table:1400:1
+ * @endcode
+ * @{
+ */
+
+/**
+ * @brief Function send packages of all flows from file by weights.
+ * @note You must call @ref init_udp_pack and @ref set_interface_udp_pack before this.
+ * @param[in,out] pack UDP package with start values of fields and payload.
+ * @param[in] file Path to flows file.
+ * @param[in] rate Packages per second for all flows, 0 is max speed.
+ * @param[in] count Count packages for all flows.
+ * @return 0 or -1 on error.
+ * Usage example.
+ * @code
+ * ret = run_flows_udp_pack(pack, "mix.flows", 100000, 1000000);
+ * if (ret)
+ *     goto run_not_flows;
+ * @endcode
+ */
+ssize_t run_flows_udp_pack(udp_pack_t pack, const char * const file, \
+        const uint64_t rate, const uint64_t count);
+
+/** @} */
+
+#endif /* UDP_LIB_FLOW_H */
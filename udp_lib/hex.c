@@ -0,0 +1,277 @@
+/**
+ * @file udp_lib/hex.c
+ * @author Vladsanin777
+ * @brief Code file for hex codec of payloads.
+ */
+
+#include "udp_lib/hex.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+/** Digits of hex by value of nibble. */
+static const char digits_hex[] = "0123456789abcdef";
+
+/**
+ * @ingroup UdpHex
+ * @brief Function getting value of one hex digit.
+ * @param[in] digit Char.
+ * @return Value or -1 if char is not hex digit.
+ * @note This function is private. Not used outside udp_lib/hex.c
+ */
+static int value_hex(const char digit) {
+    if (digit >= '0' && digit <= '9')
+        return digit - '0';
+    if (digit >= 'a' && digit <= 'f')
+        return digit - 'a' + 10;
+    if (digit >= 'A' && digit <= 'F')
+        return digit - 'A' + 10;
+    return -1;
+}
+
+/**
+ * @ingroup UdpHex
+ * @brief Function encode bytes by table, one byte per step.
+ * @param[out] text Buffer at least 2 * size chars.
+ * @param[in] data Bytes.
+ * @param[in] size Count bytes.
+ * @note This function is private. Not used outside udp_lib/hex.c
+ */
+static void encode_scalar_hex(char * text, const uint8_t * data, size_t size) {
+    for (; size; size--, data++, text += 2) {
+        text[0] = digits_hex[*data >> 4];
+        text[1] = digits_hex[*data & 0x0F];
+    }
+}
+
+/**
+ * @ingroup UdpHex
+ * @brief Function decode digits, one byte per step.
+ * @param[out] data Buffer for bytes, size / 2.
+ * @param[in] text Hex text.
+ * @param[in] size Count chars, even.
+ * @return 0 or -1 if text has not hex char.
+ * @note This function is private. Not used outside udp_lib/hex.c
+ */
+static ssize_t decode_scalar_hex(uint8_t * data, const char * text, size_t size) {
+    for (; size; size -= 2, data++, text += 2) {
+        int high = value_hex(text[0]);
+        int low = value_hex(text[1]);
+
+        if (high < 0 || low < 0)
+            return -1;
+        *data = (high << 4) | low;
+    }
+
+    return 0;
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+/**
+ * @ingroup UdpHex
+ * @brief Function encode whole blocks of 16 bytes by SSSE3 shuffle.
+ * @param[out] text Buffer at least 2 * size chars.
+ * @param[in] data Bytes.
+ * @param[in] size Count bytes.
+ * @return Count encoded bytes, multiple of 16.
+ * @note This function is private. Not used outside udp_lib/hex.c
+ */
+__attribute__((target("ssse3")))
+static size_t encode_ssse3_hex(char * const text, const uint8_t * const data, const size_t size) {
+    const __m128i digits = _mm_loadu_si128((const __m128i *)digits_hex);
+    const __m128i mask = _mm_set1_epi8(0x0F);
+    size_t done = 0;
+
+    for (; done + 16 <= size; done += 16) {
+        __m128i bytes = _mm_loadu_si128((const __m128i *)(data + done));
+        __m128i high = _mm_shuffle_epi8(digits, _mm_and_si128(_mm_srli_epi16(bytes, 4), mask));
+        __m128i low = _mm_shuffle_epi8(digits, _mm_and_si128(bytes, mask));
+
+        _mm_storeu_si128((__m128i *)(text + done * 2), _mm_unpacklo_epi8(high, low));
+        _mm_storeu_si128((__m128i *)(text + done * 2 + 16), _mm_unpackhi_epi8(high, low));
+    }
+
+    return done;
+}
+
+/**
+ * @ingroup UdpHex
+ * @brief Function encode whole blocks of 32 bytes by AVX2 shuffle.
+ * @param[out] text Buffer at least 2 * size chars.
+ * @param[in] data Bytes.
+ * @param[in] size Count bytes.
+ * @return Count encoded bytes, multiple of 32.
+ * @note This function is private. Not used outside udp_lib/hex.c
+ */
+__attribute__((target("avx2")))
+static size_t encode_avx2_hex(char * const text, const uint8_t * const data, const size_t size) {
+    const __m256i digits = _mm256_broadcastsi128_si256( \
+            _mm_loadu_si128((const __m128i *)digits_hex));
+    const __m256i mask = _mm256_set1_epi8(0x0F);
+    size_t done = 0;
+
+    for (; done + 32 <= size; done += 32) {
+        __m256i bytes = _mm256_loadu_si256((const __m256i *)(data + done));
+        __m256i high = _mm256_shuffle_epi8(digits, \
+                _mm256_and_si256(_mm256_srli_epi16(bytes, 4), mask));
+        __m256i low = _mm256_shuffle_epi8(digits, _mm256_and_si256(bytes, mask));
+        /* Unpack works in 128 bit lanes, bytes 0-7 and 16-23 are in first. */
+        __m256i first = _mm256_unpacklo_epi8(high, low);
+        __m256i second = _mm256_unpackhi_epi8(high, low);
+
+        _mm256_storeu_si256((__m256i *)(text + done * 2), \
+                _mm256_permute2x128_si256(first, second, 0x20));
+        _mm256_storeu_si256((__m256i *)(text + done * 2 + 32), \
+                _mm256_permute2x128_si256(first, second, 0x31));
+    }
+
+    return done;
+}
+
+/**
+ * @ingroup UdpHex
+ * @brief Function turn 16 hex digits in values of nibbles.
+ * @param[in] chars Digits.
+ * @param[in,out] valid Lanes stay all ones only for hex digits.
+ * @return Values of nibbles.
+ * @note This function is private. Not used outside udp_lib/hex.c
+ */
+__attribute__((target("ssse3")))
+static inline __m128i value_ssse3_hex(const __m128i chars, __m128i * const valid) {
+    __m128i digit = _mm_sub_epi8(chars, _mm_set1_epi8('0'));
+    __m128i alpha = _mm_sub_epi8(_mm_or_si128(chars, _mm_set1_epi8(0x20)), _mm_set1_epi8('a'));
+    __m128i is_digit = _mm_cmpeq_epi8(_mm_min_epu8(digit, _mm_set1_epi8(9)), digit);
+    __m128i is_alpha = _mm_cmpeq_epi8(_mm_min_epu8(alpha, _mm_set1_epi8(5)), alpha);
+
+    *valid = _mm_and_si128(*valid, _mm_or_si128(is_digit, is_alpha));
+    return _mm_or_si128(_mm_and_si128(is_digit, digit), \
+            _mm_and_si128(is_alpha, _mm_add_epi8(alpha, _mm_set1_epi8(10))));
+}
+
+/**
+ * @ingroup UdpHex
+ * @brief Function decode whole blocks of 32 digits by SSSE3.
+ * @param[out] data Buffer for bytes, size / 2.
+ * @param[in] text Hex text.
+ * @param[in] size Count chars, even.
+ * @return Count decoded bytes, multiple of 16, or -1 if text has not hex char.
+ * @note This function is private. Not used outside udp_lib/hex.c
+ */
+__attribute__((target("ssse3")))
+static ssize_t decode_ssse3_hex(uint8_t * const data, const char * const text, \
+        const size_t size) {
+    /* Pair of nibbles high * 16 + low in one 16 bit lane. */
+    const __m128i weights = _mm_set1_epi16(0x0110);
+    size_t done = 0;
+
+    for (; done * 2 + 32 <= size; done += 16) {
+        __m128i valid = _mm_set1_epi8(-1);
+        __m128i first = value_ssse3_hex( \
+                _mm_loadu_si128((const __m128i *)(text + done * 2)), &valid);
+        __m128i second = value_ssse3_hex( \
+                _mm_loadu_si128((const __m128i *)(text + done * 2 + 16)), &valid);
+
+        if (_mm_movemask_epi8(valid) != 0xFFFF)
+            return -1;
+        _mm_storeu_si128((__m128i *)(data + done), _mm_packus_epi16( \
+                _mm_maddubs_epi16(first, weights), _mm_maddubs_epi16(second, weights)));
+    }
+
+    return done;
+}
+
+/**
+ * @ingroup UdpHex
+ * @brief Function turn 32 hex digits in values of nibbles.
+ * @param[in] chars Digits.
+ * @param[in,out] valid Lanes stay all ones only for hex digits.
+ * @return Values of nibbles.
+ * @note This function is private. Not used outside udp_lib/hex.c
+ */
+__attribute__((target("avx2")))
+static inline __m256i value_avx2_hex(const __m256i chars, __m256i * const valid) {
+    __m256i digit = _mm256_sub_epi8(chars, _mm256_set1_epi8('0'));
+    __m256i alpha = _mm256_sub_epi8(_mm256_or_si256(chars, _mm256_set1_epi8(0x20)), \
+            _mm256_set1_epi8('a'));
+    __m256i is_digit = _mm256_cmpeq_epi8(_mm256_min_epu8(digit, _mm256_set1_epi8(9)), digit);
+    __m256i is_alpha = _mm256_cmpeq_epi8(_mm256_min_epu8(alpha, _mm256_set1_epi8(5)), alpha);
+
+    *valid = _mm256_and_si256(*valid, _mm256_or_si256(is_digit, is_alpha));
+    return _mm256_or_si256(_mm256_and_si256(is_digit, digit), \
+            _mm256_and_si256(is_alpha, _mm256_add_epi8(alpha, _mm256_set1_epi8(10))));
+}
+
+/**
+ * @ingroup UdpHex
+ * @brief Function decode whole blocks of 64 digits by AVX2.
+ * @param[out] data Buffer for bytes, size / 2.
+ * @param[in] text Hex text.
+ * @param[in] size Count chars, even.
+ * @return Count decoded bytes, multiple of 32, or -1 if text has not hex char.
+ * @note This function is private. Not used outside udp_lib/hex.c
+ */
+__attribute__((target("avx2")))
+static ssize_t decode_avx2_hex(uint8_t * const data, const char * const text, \
+        const size_t size) {
+    const __m256i weights = _mm256_set1_epi16(0x0110);
+    size_t done = 0;
+
+    for (; done * 2 + 64 <= size; done += 32) {
+        __m256i valid = _mm256_set1_epi8(-1);
+        __m256i first = value_avx2_hex( \
+                _mm256_loadu_si256((const __m256i *)(text + done * 2)), &valid);
+        __m256i second = value_avx2_hex( \
+                _mm256_loadu_si256((const __m256i *)(text + done * 2 + 32)), &valid);
+        __m256i bytes = _mm256_packus_epi16(_mm256_maddubs_epi16(first, weights), \
+                _mm256_maddubs_epi16(second, weights));
+
+        if (_mm256_movemask_epi8(valid) != -1)
+            return -1;
+        /* Pack works in 128 bit lanes, quarters are in order 0, 2, 1, 3. */
+        _mm256_storeu_si256((__m256i *)(data + done), _mm256_permute4x64_epi64(bytes, 0xD8));
+    }
+
+    return done;
+}
+#endif
+
+size_t encode_udp_hex(char * const text, const void * const data, const size_t size) {
+    const uint8_t * bytes = data;
+    size_t done = 0;
+
+#if defined(__x86_64__) || defined(__i386__)
+    if (__builtin_cpu_supports("avx2"))
+        done = encode_avx2_hex(text, bytes, size);
+    else if (__builtin_cpu_supports("ssse3"))
+        done = encode_ssse3_hex(text, bytes, size);
+#endif
+    encode_scalar_hex(text + done * 2, bytes + done, size - done);
+
+    return size * 2;
+}
+
+ssize_t decode_udp_hex(void * const data, const size_t size_data, \
+        const char * const text, const size_t size) {
+    uint8_t * bytes = data;
+    ssize_t done = 0;
+
+    if (size % 2 || size / 2 > size_data)
+        return -1;
+
+#if defined(__x86_64__) || defined(__i386__)
+    if (__builtin_cpu_supports("avx2"))
+        done = decode_avx2_hex(bytes, text, size);
+    else if (__builtin_cpu_supports("ssse3"))
+        done = decode_ssse3_hex(bytes, text, size);
+    if (done < 0)
+        return -1;
+#endif
+    if (decode_scalar_hex(bytes + done, text + done * 2, size - done * 2))
+        return -1;
+
+    return size / 2;
+}
@@ -0,0 +1,60 @@
+/**
+ * @file udp_lib/hex.h
+ * @author Vladsanin777
+ * @brief Header file for hex codec of payloads.
+ */
+
+#ifndef UDP_LIB_HEX_H
+#define UDP_LIB_HEX_H
+
+#include <stdint.h>
+#include <stdlib.h>
+
+/**
+ * @defgroup UdpHex hex for udp
+ * @brief Group function for encode bytes in hex text and decode it back.
+ *
+ * Both ways work by blocks in vector registers: nibbles are turned in digits
+ * and digits in nibbles by byte shuffle and compare, 32 bytes per step with
+ * AVX2, 16 bytes with SSSE3, so text of tens of KB is done without call per
+ * byte. Instruction set is chosen by processor at run time, tail of block
+ * and processors without SSSE3 use scalar code with same result.
+ * Encoded digits are lowercase, decoded digits are in any case.
+ * @{
+ */
+
+/**
+ * @brief Function encode bytes in hex text.
+ * @note Text is not terminated by '\0'.
+ * @param[out] text Buffer at least 2 * size chars.
+ * @param[in] data Bytes.
+ * @param[in] size Count bytes.
+ * @return Count chars, 2 * size.
+ * Usage example.
+ * @code
+ * char text[2 * 4];
+ * encode_udp_hex(text, "\xDE\xAD\xBE\xEF", 4); // "deadbeef"
+ * @endcode
+ */
+size_t encode_udp_hex(char * const text, const void * const data, const size_t size);
+
+/**
+ * @brief Function decode hex text in bytes.
+ * @param[out] data Buffer for bytes.
+ * @param[in] size_data Size buffer.
+ * @param[in] text Hex text, even count digits.
+ * @param[in] size Count chars.
+ * @return Count bytes or -1 if text has odd size, not hex char or does not fit in buffer.
+ * Usage example.
+ * @code
+ * uint8_t data[4];
+ * if (decode_udp_hex(data, sizeof(data), "DEADbeef", 8) < 0)
+ *     goto decode_not_hex;
+ * @endcode
+ */
+ssize_t decode_udp_hex(void * const data, const size_t size_data, \
+        const char * const text, const size_t size);
+
+/** @} */
+
+#endif /* UDP_LIB_HEX_H */
@@ -0,0 +1,183 @@
+/**
+ * @file udp_lib/histogram.c
+ * @author Vladsanin777
+ * @brief Code file for log-linear histogram of latency.
+ */
+
+#include "udp_lib/histogram.h"
+
+#include <stdint.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+
+/** Bits linear part in one power of two. */
+#define SUB_BITS_HISTOGRAM 5
+
+/** Count linear buckets in one power of two. */
+#define SUB_COUNT_HISTOGRAM (1 << SUB_BITS_HISTOGRAM)
+
+/** Count all buckets for 64 bit values. */
+#define BUCKETS_HISTOGRAM ((64 - SUB_BITS_HISTOGRAM + 1) * SUB_COUNT_HISTOGRAM)
+
+/**
+ * @ingroup UdpHistogram
+ * @brief Struct is histogram.
+ * @note This struct is private. Not used outside udp_lib/histogram.c
+ */
+struct udp_histogram {
+    uint64_t m_count; /**< Count values. */
+    uint64_t m_sum; /**< Sum values for mean. */
+    uint64_t m_min; /**< Minimum value. */
+    uint64_t m_max; /**< Maximum value. */
+    uint64_t m_buckets[BUCKETS_HISTOGRAM]; /**< Counters for buckets. */
+};
+
+/**
+ * @ingroup UdpHistogram
+ * @brief Function getting bucket for value.
+ * @param[in] value Value for record.
+ * @return Index bucket.
+ * @note This function is private. Not used outside udp_lib/histogram.c
+ */
+static size_t index_histogram(const uint64_t value) {
+    size_t shift = 0;
+
+    if (value < 2 * SUB_COUNT_HISTOGRAM)
+        return value;
+
+    shift = 63 - __builtin_clzll(value) - SUB_BITS_HISTOGRAM;
+
+    return shift * SUB_COUNT_HISTOGRAM + (value >> shift);
+}
+
+/**
+ * @ingroup UdpHistogram
+ * @brief Function getting upper value bucket.
+ * @param[in] index Index bucket.
+ * @return Maximum value in bucket.
+ * @note This function is private. Not used outside udp_lib/histogram.c
+ */
+static uint64_t value_histogram(const size_t index) {
+    size_t shift = 0;
+    uint64_t sub = 0;
+
+    if (index < 2 * SUB_COUNT_HISTOGRAM)
+        return index;
+
+    shift = index / SUB_COUNT_HISTOGRAM - 1;
+    sub = index - shift * SUB_COUNT_HISTOGRAM;
+
+    return ((sub + 1) << shift) - 1;
+}
+
+udp_histogram_t init_udp_histogram(void) {
+    udp_histogram_t histogram = calloc(1, sizeof(*histogram));
+
+    if (histogram == NULL)
+        goto get_not_memory;
+
+    histogram->m_min = UINT64_MAX;
+
+    return histogram;
+get_not_memory:
+    return NULL;
+}
+
+void record_udp_histogram(udp_histogram_t histogram, const uint64_t value) {
+    uint64_t * bucket = &histogram->m_buckets[index_histogram(value)];
+
+    /* Single writer, so load and store are enough, no locked add. */
+    __atomic_store_n(bucket, *bucket + 1, __ATOMIC_RELAXED);
+    __atomic_store_n(&histogram->m_count, histogram->m_count + 1, __ATOMIC_RELAXED);
+    __atomic_store_n(&histogram->m_sum, histogram->m_sum + value, __ATOMIC_RELAXED);
+    if (value < histogram->m_min)
+        __atomic_store_n(&histogram->m_min, value, __ATOMIC_RELAXED);
+    if (value > histogram->m_max)
+        __atomic_store_n(&histogram->m_max, value, __ATOMIC_RELAXED);
+}
+
+void copy_udp_histogram(udp_histogram_t histogram, const udp_histogram_t other) {
+    for (size_t i = 0; i < BUCKETS_HISTOGRAM; i++)
+        histogram->m_buckets[i] = __atomic_load_n(&other->m_buckets[i], __ATOMIC_RELAXED);
+    histogram->m_count = __atomic_load_n(&other->m_count, __ATOMIC_RELAXED);
+    histogram->m_sum = __atomic_load_n(&other->m_sum, __ATOMIC_RELAXED);
+    histogram->m_min = __atomic_load_n(&other->m_min, __ATOMIC_RELAXED);
+    histogram->m_max = __atomic_load_n(&other->m_max, __ATOMIC_RELAXED);
+}
+
+void merge_udp_histogram(udp_histogram_t histogram, const udp_histogram_t other) {
+    for (size_t i = 0; i < BUCKETS_HISTOGRAM; i++)
+        histogram->m_buckets[i] += other->m_buckets[i];
+    histogram->m_count += other->m_count;
+    histogram->m_sum += other->m_sum;
+    if (other->m_min < histogram->m_min)
+        histogram->m_min = other->m_min;
+    if (other->m_max > histogram->m_max)
+        histogram->m_max = other->m_max;
+}
+
+void reset_udp_histogram(udp_histogram_t histogram) {
+    memset(histogram, 0x00, sizeof(*histogram));
+    histogram->m_min = UINT64_MAX;
+}
+
+uint64_t get_count_udp_histogram(const udp_histogram_t histogram) {
+    return histogram->m_count;
+}
+
+uint64_t get_min_udp_histogram(const udp_histogram_t histogram) {
+    return histogram->m_count ? histogram->m_min : 0;
+}
+
+uint64_t get_max_udp_histogram(const udp_histogram_t histogram) {
+    return histogram->m_max;
+}
+
+uint64_t get_mean_udp_histogram(const udp_histogram_t histogram) {
+    return histogram->m_count ? histogram->m_sum / histogram->m_count : 0;
+}
+
+uint64_t get_percentile_udp_histogram(const udp_histogram_t histogram, \
+        const double percentile) {
+    uint64_t rank = 0;
+    uint64_t seen = 0;
+
+    if (histogram->m_count == 0)
+        return 0;
+
+    rank = (uint64_t)(percentile / 100.0 * histogram->m_count + 0.5);
+    if (rank == 0)
+        rank = 1;
+    if (rank > histogram->m_count)
+        rank = histogram->m_count;
+
+    for (size_t i = 0; i < BUCKETS_HISTOGRAM; i++) {
+        seen += histogram->m_buckets[i];
+        if (seen >= rank) {
+            uint64_t value = value_histogram(i);
+            return value < histogram->m_max ? value : histogram->m_max;
+        }
+    }
+
+    return histogram->m_max;
+}
+
+void print_udp_histogram(const udp_histogram_t histogram, \
+        const char * const name, const char * const unit) {
+    printf("%s: count %lu min %lu%s mean %lu%s p50 %lu%s p90 %lu%s " \
+            "p99 %lu%s p99.9 %lu%s p99.99 %lu%s max %lu%s\n", name, \
+            histogram->m_count, \
+            get_min_udp_histogram(histogram), unit, \
+            get_mean_udp_histogram(histogram), unit, \
+            get_percentile_udp_histogram(histogram, 50.0), unit, \
+            get_percentile_udp_histogram(histogram, 90.0), unit, \
+            get_percentile_udp_histogram(histogram, 99.0), unit, \
+            get_percentile_udp_histogram(histogram, 99.9), unit, \
+            get_percentile_udp_histogram(histogram, 99.99), unit, \
+            get_max_udp_histogram(histogram), unit);
+}
+
+void destroy_udp_histogram(udp_histogram_t histogram) {
+    free(histogram);
+}
@@ -0,0 +1,137 @@
+/**
+ * @file udp_lib/histogram.h
+ * @author Vladsanin777
+ * @brief Header file for log-linear histogram of latency.
+ */
+
+#ifndef UDP_LIB_HISTOGRAM_H
+#define UDP_LIB_HISTOGRAM_H
+
+#include <stdint.h>
+#include <stdlib.h>
+
+/**
+ * @defgroup UdpHistogram histogram for udp
+ * @brief Group function for record values (nanoseconds, bytes, ...) in log-linear buckets.
+ *
+ * Every power of two is split on 32 linear buckets, so relative error is below 3%
+ * and record is one count leading zeros plus one increment.
+ * @{
+ */
+
+/**
+ * @brief Private struct histogram. (Hidden implementation)
+ */
+struct udp_histogram;
+
+/**
+ * @brief Histogram descriptor.
+ */
+typedef struct udp_histogram * udp_histogram_t;
+
+/**
+ * @brief Function for create empty histogram.
+ * @note You must call @ref destroy_udp_histogram after this.
+ * @return pointer or null on error.
+ * Usage example.
+ * @code
+ * udp_histogram_t histogram = init_udp_histogram();
+ * if (histogram == NULL)
+ *     goto get_not_histogram;
+ * record_udp_histogram(histogram, 1500);
+ * destroy_udp_histogram(histogram);
+ * get_not_histogram:
+ * @endcode
+ */
+udp_histogram_t init_udp_histogram(void);
+
+/**
+ * @brief Function record one value in histogram.
+ * @note Only one thread records in histogram, every counter is written by
+ * relaxed atomic store, so @ref copy_udp_histogram can read it from other thread.
+ * @param[in,out] histogram Histogram for work.
+ * @param[in] value Value for record.
+ */
+void record_udp_histogram(udp_histogram_t histogram, const uint64_t value);
+
+/**
+ * @brief Function copy all values from other histogram.
+ * @note Counters are read by relaxed atomic loads. If other histogram is
+ * recorded while copy, copy is not consistent, caller checks it by seqlock.
+ * @param[out] histogram Histogram for work.
+ * @param[in] other Histogram for copy.
+ */
+void copy_udp_histogram(udp_histogram_t histogram, const udp_histogram_t other);
+
+/**
+ * @brief Function add all values from other histogram.
+ * @param[in,out] histogram Histogram for work.
+ * @param[in] other Histogram for addition.
+ */
+void merge_udp_histogram(udp_histogram_t histogram, const udp_histogram_t other);
+
+/**
+ * @brief Function forget all values in histogram.
+ * @param[in,out] histogram Histogram for work.
+ */
+void reset_udp_histogram(udp_histogram_t histogram);
+
+/**
+ * @brief Function for getting count values in histogram.
+ * @param[in] histogram Histogram for work.
+ * @return Count recorded values.
+ */
+uint64_t get_count_udp_histogram(const udp_histogram_t histogram);
+
+/**
+ * @brief Function for getting minimum value in histogram.
+ * @param[in] histogram Histogram for work.
+ * @return Minimum or 0 for empty histogram.
+ */
+uint64_t get_min_udp_histogram(const udp_histogram_t histogram);
+
+/**
+ * @brief Function for getting maximum value in histogram.
+ * @param[in] histogram Histogram for work.
+ * @return Maximum or 0 for empty histogram.
+ */
+uint64_t get_max_udp_histogram(const udp_histogram_t histogram);
+
+/**
+ * @brief Function for getting mean value in histogram.
+ * @param[in] histogram Histogram for work.
+ * @return Mean or 0 for empty histogram.
+ */
+uint64_t get_mean_udp_histogram(const udp_histogram_t histogram);
+
+/**
+ * @brief Function for getting percentile value in histogram.
+ * @param[in] histogram Histogram for work.
+ * @param[in] percentile Percentile from 0.0 to 100.0.
+ * @return Upper bound bucket with percentile or 0 for empty histogram.
+ * Usage example.
+ * @code
+ * uint64_t p99 = get_percentile_udp_histogram(histogram, 99.0);
+ * @endcode
+ */
+uint64_t get_percentile_udp_histogram(const udp_histogram_t histogram, \
+        const double percentile);
+
+/**
+ * @brief Function print count, min, mean, percentiles and max histogram.
+ * @param[in] histogram Histogram for work.
+ * @param[in] name Name histogram in output.
+ * @param[in] unit Unit values in output.
+ */
+void print_udp_histogram(const udp_histogram_t histogram, \
+        const char * const name, const char * const unit);
+
+/**
+ * @brief Function free histogram.
+ * @param[in,out] histogram Histogram for work.
+ */
+void destroy_udp_histogram(udp_histogram_t histogram);
+
+/** @} */
+
+#endif /* UDP_LIB_HISTOGRAM_H */
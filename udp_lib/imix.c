@@ -0,0 +1,411 @@
+/**
+ * @file udp_lib/imix.c
+ * @author Vladsanin777
+ * @brief Code file for traffic profiles with distribution of package sizes.
+ */
+
+#include "udp_lib/imix.h"
+#include "udp_lib/udp_private.h"
+#include "udp_lib/sender.h"
+#include "udp_lib/neigh.h"
+#include "udp_lib/stage.h"
+#include "udp_lib/clock_private.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <time.h>
+
+/** Max frames in one call of sender. */
+#define BATCH_IMIX 64
+
+/** Max classes printed apart in report. */
+#define MAX_PRINT_IMIX 16
+
+/** Seed of picker, same seed gives same order of sizes. */
+#define SEED_IMIX 0x1A1A5EEDULL
+
+/**
+ * @ingroup UdpImix
+ * @brief Struct is size class.
+ * @note This struct is private. Not used outside udp_lib/imix.c
+ */
+struct class_imix {
+    struct iovec m_frame; /**< Ready frame. */
+    uint64_t m_threshold; /**< Class is taken if random 32 bits below it, else alias. */
+    uint32_t m_alias; /**< Other class of this cell of alias table. */
+    uint32_t m_weight; /**< Weight from profile. */
+    uint16_t m_size; /**< Size IP package. */
+    uint64_t m_sended; /**< Sended packages. */
+};
+
+/**
+ * @ingroup UdpImix
+ * @brief Struct is imix.
+ * @note This struct is private. Not used outside udp_lib/imix.c
+ */
+struct udp_imix {
+    struct class_imix * m_classes; /**< Size classes. */
+    size_t m_count; /**< Count classes. */
+    uint8_t * m_frames; /**< Memory of all frames. */
+    uint64_t m_random; /**< State picker. */
+};
+
+/**
+ * @ingroup UdpImix
+ * @brief Function parse profile in classes with sizes and weights.
+ * @param[in,out] imix Imix.
+ * @param[in] profile Profile string.
+ * @return 0 or -1 on error.
+ * @note This function is private. Not used outside udp_lib/imix.c
+ */
+static ssize_t parse_imix(udp_imix_t imix, const char * const profile) {
+    static const uint16_t sizes_simple[] = {40, 576, 1500};
+    static const uint32_t weights_simple[] = {7, 4, 1};
+    const char * cursor = NULL;
+    char * end = NULL;
+    size_t count = 0;
+
+    if (strcmp(profile, "imix") == 0) {
+        count = sizeof(sizes_simple) / sizeof(*sizes_simple);
+        imix->m_classes = calloc(count, sizeof(*imix->m_classes));
+        if (imix->m_classes == NULL)
+            return -1;
+        for (size_t i = 0; i < count; i++) {
+            imix->m_classes[i].m_size = sizes_simple[i];
+            imix->m_classes[i].m_weight = weights_simple[i];
+        }
+    } else if (strncmp(profile, "uniform:", 8) == 0) {
+        unsigned long minimum = strtoul(profile + 8, &end, 0);
+        unsigned long maximum = *end == '-' ? strtoul(end + 1, &end, 0) : 0;
+
+        if (*end != '\0' || minimum > maximum || maximum > 0xFFFF)
+            goto wrong_profile;
+        count = maximum - minimum + 1;
+        imix->m_classes = calloc(count, sizeof(*imix->m_classes));
+        if (imix->m_classes == NULL)
+            return -1;
+        for (size_t i = 0; i < count; i++) {
+            imix->m_classes[i].m_size = minimum + i;
+            imix->m_classes[i].m_weight = 1;
+        }
+    } else if (strncmp(profile, "table:", 6) == 0) {
+        count = 1;
+        for (cursor = profile + 6; *cursor; cursor++)
+            count += *cursor == ',';
+        if (count > MAX_CLASSES_IMIX)
+            goto wrong_profile;
+        imix->m_classes = calloc(count, sizeof(*imix->m_classes));
+        if (imix->m_classes == NULL)
+            return -1;
+        cursor = profile + 6;
+        for (size_t i = 0; i < count; i++) {
+            unsigned long size = strtoul(cursor, &end, 0);
+            unsigned long weight = 0;
+            bool is_valid = end != cursor && *end == ':';
+
+            /* Empty class (trailing comma) and class without weight are errors. */
+            if (is_valid) {
+                const char * start = end + 1;
+
+                weight = strtoul(start, &end, 0);
+                is_valid = end != start;
+            }
+            if (!is_valid || (*end != ',' && *end != '\0') || size > 0xFFFF || \
+                    weight > UINT32_MAX) {
+                fprintf(stderr, "ERROR: wrong imix class '%.*s', must be SIZE:WEIGHT\n", \
+                        (int)strcspn(cursor, ","), cursor);
+                goto wrong_profile;
+            }
+            imix->m_classes[i].m_size = size;
+            imix->m_classes[i].m_weight = weight;
+            cursor = end + 1;
+        }
+    } else {
+        goto wrong_profile;
+    }
+
+    imix->m_count = count;
+
+    return 0;
+wrong_profile:
+    fprintf(stderr, "ERROR: wrong imix profile '%s'\n", profile);
+    return -1;
+}
+
+/**
+ * @ingroup UdpImix
+ * @brief Function build alias table by weights (Vose).
+ * @param[in,out] imix Imix with parsed classes.
+ * @return 0 or -1 on error.
+ * @note This function is private. Not used outside udp_lib/imix.c
+ */
+static ssize_t build_alias_imix(udp_imix_t imix) {
+    size_t count = imix->m_count;
+    double * scaled = malloc(sizeof(*scaled) * count);
+    uint32_t * small = malloc(sizeof(*small) * count);
+    uint32_t * large = malloc(sizeof(*large) * count);
+    size_t size_small = 0;
+    size_t size_large = 0;
+    double total = 0.0;
+    ssize_t ret = 0;
+
+    if (scaled == NULL || small == NULL || large == NULL) {
+        ret = -1;
+        goto get_not_memory;
+    }
+
+    for (size_t i = 0; i < count; i++)
+        total += imix->m_classes[i].m_weight;
+    if (total <= 0.0) {
+        ret = -1;
+        fputs("ERROR: sum weights of imix is zero\n", stderr);
+        goto zero_weights;
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        scaled[i] = imix->m_classes[i].m_weight * count / total;
+        if (scaled[i] < 1.0)
+            small[size_small++] = i;
+        else
+            large[size_large++] = i;
+    }
+
+    while (size_small && size_large) {
+        uint32_t less = small[--size_small];
+        uint32_t more = large[size_large - 1];
+
+        imix->m_classes[less].m_threshold = scaled[less] * (1ULL << 32);
+        imix->m_classes[less].m_alias = more;
+        scaled[more] -= 1.0 - scaled[less];
+        if (scaled[more] < 1.0) {
+            size_large--;
+            small[size_small++] = more;
+        }
+    }
+
+    /* Rest cells are full, rounding of doubles must not move them to alias. */
+    while (size_large) {
+        uint32_t index = large[--size_large];
+
+        imix->m_classes[index].m_threshold = 1ULL << 32;
+        imix->m_classes[index].m_alias = index;
+    }
+    while (size_small) {
+        uint32_t index = small[--size_small];
+
+        imix->m_classes[index].m_threshold = 1ULL << 32;
+        imix->m_classes[index].m_alias = index;
+    }
+
+zero_weights:
+get_not_memory:
+    free(large);
+    free(small);
+    free(scaled);
+    return ret;
+}
+
+/**
+ * @ingroup UdpImix
+ * @brief Function build ready frame of every class.
+ * @param[in,out] imix Imix with parsed classes.
+ * @param[in,out] pack UDP package with headers and data.
+ * @param[in] mtu Max size IP package.
+ * @return 0 or -1 on error.
+ * @note This function is private. Not used outside udp_lib/imix.c
+ */
+static ssize_t build_frames_imix(udp_imix_t imix, udp_pack_t pack, const uint16_t mtu) {
+    size_t size_head = get_size_ip_udp_pack(pack) + HEAD_UDP;
+    uint16_t size_data = get_size_data_udp_pack(pack);
+    uint8_t * data = NULL;
+    size_t total = 0;
+    size_t offset = 0;
+
+    for (size_t i = 0; i < imix->m_count; i++) {
+        struct class_imix * class = &imix->m_classes[i];
+
+        if (class->m_size < size_head)
+            class->m_size = size_head;
+        if (class->m_size > mtu || class->m_size - size_head > MAX_SIZE_DATA) {
+            fprintf(stderr, "ERROR: size %u of imix is bigger than MTU %u\n", \
+                    class->m_size, mtu);
+            return -1;
+        }
+        total += HEAD_ETH + class->m_size;
+    }
+
+    data = malloc(size_data ? size_data : 1);
+    imix->m_frames = malloc(total);
+    if (data == NULL || imix->m_frames == NULL) {
+        free(data);
+        return -1;
+    }
+    memcpy(data, pack->m_data, size_data);
+
+    if (!(pack->m_flags & FLAG_RESOLVED_UDP_PACK))
+        resolve_mac_address_udp_pack(pack);
+
+    for (size_t i = 0; i < imix->m_count; i++) {
+        struct class_imix * class = &imix->m_classes[i];
+        size_t size = class->m_size - size_head;
+
+        if (size_data == 0) {
+            memset(pack->m_data, 0x00, size);
+        } else {
+            for (size_t filled = 0; filled < size; filled += size_data)
+                memcpy(pack->m_data + filled, data, MIN(size_data, size - filled));
+        }
+        set_size_udp_pack(pack, size);
+        calculate_checksum_udp_pack(pack);
+
+        class->m_frame.iov_base = imix->m_frames + offset;
+        class->m_frame.iov_len = get_size_pack_udp_pack(pack);
+        memcpy(class->m_frame.iov_base, get_pack_udp_pack(pack), class->m_frame.iov_len);
+        offset += class->m_frame.iov_len;
+    }
+
+    free(data);
+
+    return 0;
+}
+
+udp_imix_t init_udp_imix(udp_pack_t pack, const char * const profile, const uint16_t mtu) {
+    udp_imix_t imix = calloc(1, sizeof(*imix));
+
+    if (imix == NULL)
+        goto get_not_memory;
+
+    imix->m_random = SEED_IMIX;
+
+    if (parse_imix(imix, profile))
+        goto parse_not_profile;
+
+    if (build_alias_imix(imix))
+        goto build_not_alias;
+
+    if (build_frames_imix(imix, pack, mtu))
+        goto build_not_frames;
+
+    return imix;
+build_not_frames:
+    free(imix->m_frames);
+build_not_alias:
+parse_not_profile:
+    free(imix->m_classes);
+    free(imix);
+get_not_memory:
+    return NULL;
+}
+
+/**
+ * @ingroup UdpImix
+ * @brief Function pick index of class.
+ * @param[in,out] imix Imix.
+ * @return Index class.
+ * @note This function is private. Not used outside udp_lib/imix.c
+ */
+static inline uint32_t pick_imix(udp_imix_t imix) {
+    uint64_t value = (imix->m_random += 0x9E3779B97F4A7C15ULL);
+    uint32_t index = 0;
+
+    value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    value = (value ^ (value >> 27)) * 0x94D049BB133111EBULL;
+    value ^= value >> 31;
+
+    /* High half picks cell without division, low half picks class or its alias. */
+    index = ((value >> 32) * imix->m_count) >> 32;
+    if ((value & 0xFFFFFFFFULL) < imix->m_classes[index].m_threshold)
+        return index;
+
+    return imix->m_classes[index].m_alias;
+}
+
+const struct iovec * next_frame_udp_imix(udp_imix_t imix) {
+    return &imix->m_classes[pick_imix(imix)].m_frame;
+}
+
+uint16_t next_size_udp_imix(udp_imix_t imix) {
+    return imix->m_classes[pick_imix(imix)].m_size;
+}
+
+ssize_t run_imix_udp_pack(udp_pack_t pack, const char * const profile, const uint64_t count) {
+    ssize_t ret = 0;
+    udp_sender_t sender = NULL;
+    udp_imix_t imix = NULL;
+    struct iovec frames[BATCH_IMIX];
+    uint32_t classes[BATCH_IMIX];
+    uint64_t start = 0;
+    uint64_t sended = 0;
+    uint64_t bytes = 0;
+    double seconds = 0.0;
+
+    sender = init_pack_udp_sender(pack);
+    if (sender == NULL) {
+        ret = -1;
+        goto get_not_sender;
+    }
+
+    imix = init_udp_imix(pack, profile, get_mtu_udp_sender(sender));
+    if (imix == NULL) {
+        ret = -1;
+        goto get_not_imix;
+    }
+
+    start = now_clock();
+
+    for (uint64_t done = 0; done < count;) {
+        size_t batch = MIN(count - done, BATCH_IMIX);
+        ssize_t batch_sended = 0;
+        uint64_t begin = begin_udp_stage();
+
+        for (size_t i = 0; i < batch; i++) {
+            classes[i] = pick_imix(imix);
+            frames[i] = imix->m_classes[classes[i]].m_frame;
+        }
+        end_udp_stage(BUILD_STAGE, begin);
+
+        batch_sended = send_batch_udp_sender(sender, frames, batch);
+        for (ssize_t i = 0; i < batch_sended; i++) {
+            imix->m_classes[classes[i]].m_sended++;
+            bytes += imix->m_classes[classes[i]].m_size;
+        }
+        if (batch_sended > 0)
+            sended += batch_sended;
+        done += batch;
+    }
+
+    seconds = (now_clock() - start) / (double)NSEC_CLOCK;
+    if (finish_udp_sender(sender))
+        ret = -1;
+
+    printf("imix sended: %lu errors: %lu bytes: %lu average: %.1f seconds: %.3f " \
+            "rate: %.0f pps %.3f Gbit/s\n", sended, count - sended, bytes, \
+            sended ? (double)bytes / sended : 0.0, seconds, \
+            seconds > 0.0 ? sended / seconds : 0.0, \
+            seconds > 0.0 ? bytes * 8 / seconds / 1e9 : 0.0);
+    for (size_t i = 0; i < imix->m_count && imix->m_count <= MAX_PRINT_IMIX; i++) {
+        printf("  size %5u: %lu (%.2f%%)\n", imix->m_classes[i].m_size, \
+                imix->m_classes[i].m_sended, \
+                sended ? 100.0 * imix->m_classes[i].m_sended / sended : 0.0);
+    }
+    print_stats_udp_sender(sender);
+    if (sended != count)
+        ret = -1;
+
+    destroy_udp_imix(imix);
+get_not_imix:
+    destroy_udp_sender(sender);
+get_not_sender:
+    return ret;
+}
+
+void destroy_udp_imix(udp_imix_t imix) {
+    if (imix == NULL)
+        return;
+    free(imix->m_frames);
+    free(imix->m_classes);
+    free(imix);
+}
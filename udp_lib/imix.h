@@ -0,0 +1,109 @@
+/**
+ * @file udp_lib/imix.h
+ * @author Vladsanin777
+ * @brief Header file for traffic profiles with distribution of package sizes.
+ */
+
+#ifndef UDP_LIB_IMIX_H
+#define UDP_LIB_IMIX_H
+
+#include "udp_lib/udp.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#include <sys/uio.h>
+
+/**
+ * @defgroup UdpImix imix for udp
+ * @brief Group function for send packages with sizes by distribution.
+ *
+ * Sizes are sizes of IP packages, as routers count them. Profile is given by string:
+ * - `imix` is simple IMIX: 40, 576 and 1500 bytes in parts 7:4:1;
+ * - `uniform:MIN-MAX` is every size from MIN to MAX with equal weight;
+ * - `table:SIZE:WEIGHT,SIZE:WEIGHT,...` is own weighted sizes.
+ *
+ * Every size class has ready frame with calculated checksums, size is picked
+ * by alias method in constant time, so send loop only takes pointer on frame.
+ * Size smaller than headers of family is rounded up to headers.
+ * @{
+ */
+
+/** Max size classes of one profile. */
+#define MAX_CLASSES_IMIX 0x10000
+
+/**
+ * @brief Private struct imix. (Hidden implementation)
+ */
+struct udp_imix;
+
+/**
+ * @brief Pointer on private struct imix.
+ */
+typedef struct udp_imix * udp_imix_t;
+
+/**
+ * @brief Function build frames of every size class and alias table.
+ *
+ * Data of package is repeated to size of class, empty data give zeros.
+ * @note You must call @ref destroy_udp_imix after this.
+ * @param[in,out] pack UDP package with headers and data, its size is changed.
+ * @param[in] profile Profile string.
+ * @param[in] mtu Max size IP package.
+ * @return Imix or NULL on error.
+ * Usage example.
+ * @code
+ * udp_imix_t imix = init_udp_imix(pack, "table:64:5,1500:1", 1500);
+ * if (imix == NULL)
+ *     goto get_not_imix;
+ * @endcode
+ */
+udp_imix_t init_udp_imix(udp_pack_t pack, const char * const profile, const uint16_t mtu);
+
+/**
+ * @brief Function pick frame of next package.
+ * @param[in,out] imix Imix.
+ * @return Ready frame.
+ * Usage example.
+ * @code
+ * frames[i] = *next_frame_udp_imix(imix);
+ * @endcode
+ */
+const struct iovec * next_frame_udp_imix(udp_imix_t imix);
+
+/**
+ * @brief Function pick size of next package without frame.
+ * @param[in,out] imix Imix.
+ * @return Size IP package.
+ * Usage example.
+ * @code
+ * uint16_t size = next_size_udp_imix(imix);
+ * @endcode
+ */
+uint16_t next_size_udp_imix(udp_imix_t imix);
+
+/**
+ * @brief Function send count packages with sizes by profile and print mix.
+ * @note You must call @ref init_udp_pack and @ref set_interface_udp_pack before this.
+ * @param[in,out] pack UDP package with headers and data.
+ * @param[in] profile Profile string.
+ * @param[in] count Count packages.
+ * @return 0 or -1 on error.
+ * Usage example.
+ * @code
+ * ret = run_imix_udp_pack(pack, "imix", 1000000);
+ * if (ret)
+ *     goto run_not_imix;
+ * @endcode
+ */
+ssize_t run_imix_udp_pack(udp_pack_t pack, const char * const profile, const uint64_t count);
+
+/**
+ * @brief Function free imix.
+ * @param[in] imix Imix.
+ */
+void destroy_udp_imix(udp_imix_t imix);
+
+/** @} */
+
+#endif /* UDP_LIB_IMIX_H */
@@ -0,0 +1,397 @@
+/**
+ * @file udp_lib/loadgen.c
+ * @author Vladsanin777
+ * @brief Code file for open-loop request/response load generator.
+ */
+
+#include "udp_lib/loadgen.h"
+#include "udp_lib/udp_private.h"
+#include "udp_lib/sender.h"
+#include "udp_lib/histogram.h"
+#include "udp_lib/clock_private.h"
+
+#include <stdint.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <errno.h>
+#include <time.h>
+#include <poll.h>
+#include <endian.h>
+
+#include <sys/prctl.h>
+
+#include <arpa/inet.h>
+
+#include <sys/socket.h>
+
+#include <netinet/in.h>
+
+/** Max replies in one call recvmmsg. */
+#define BATCH_LOADGEN 64
+
+/** Max size one reply. */
+#define SIZE_REPLY_LOADGEN 2048
+
+/** Size request ID in data. */
+#define SIZE_ID_LOADGEN sizeof(uint64_t)
+
+/** Max sleep between checks of schedule in nanoseconds. */
+#define MAX_SLEEP_LOADGEN 1000000ULL
+
+/**
+ * @ingroup UdpLoadgen
+ * @brief Struct is request waiting reply.
+ * @note This struct is private. Not used outside udp_lib/loadgen.c
+ */
+struct request_loadgen {
+    uint64_t m_id; /**< ID request, 0 is empty slot. */
+    uint64_t m_intended; /**< Time send by schedule. */
+    uint64_t m_sended; /**< Real time send. */
+};
+
+/**
+ * @ingroup UdpLoadgen
+ * @brief Struct is open-addressing table requests with linear probing.
+ * @note This struct is private. Not used outside udp_lib/loadgen.c
+ */
+struct table_loadgen {
+    struct request_loadgen * m_slots; /**< Slots, count is power of two. */
+    uint64_t m_mask; /**< Count slots minus one. */
+    uint64_t m_shift; /**< Shift hash to slot. */
+    uint64_t m_size; /**< Count busy slots. */
+    uint64_t m_limit; /**< Max busy slots. */
+};
+
+/**
+ * @ingroup UdpLoadgen
+ * @brief Function getting home slot of request.
+ * @param[in] table Table requests.
+ * @param[in] id ID request.
+ * @return Index slot.
+ * @note This function is private. Not used outside udp_lib/loadgen.c
+ */
+static uint64_t home_loadgen(const struct table_loadgen * const table, \
+        const uint64_t id) {
+    return (id * 0x9E3779B97F4A7C15ULL) >> table->m_shift;
+}
+
+/**
+ * @ingroup UdpLoadgen
+ * @brief Function allocate table for requests.
+ * @param[in,out] table Table requests.
+ * @param[in] limit Max requests in table, from 1 to @ref MAX_OUTSTANDING_LOADGEN.
+ * @return 0 or -1 on error.
+ * @note This function is private. Not used outside udp_lib/loadgen.c
+ */
+static ssize_t init_table_loadgen(struct table_loadgen * const table, \
+        const uint64_t limit) {
+    uint64_t bits = 4;
+
+    while ((1ULL << bits) < limit * 2)
+        bits++;
+
+    table->m_slots = calloc(1ULL << bits, sizeof(*table->m_slots));
+
+    if (table->m_slots == NULL)
+        return -1;
+
+    table->m_mask = (1ULL << bits) - 1;
+    table->m_shift = 64 - bits;
+    table->m_size = 0;
+    table->m_limit = limit;
+
+    return 0;
+}
+
+/**
+ * @ingroup UdpLoadgen
+ * @brief Function insert request in table.
+ * @param[in,out] table Table requests.
+ * @param[in] request Request for insert.
+ * @return 0 or -1 if table is full.
+ * @note This function is private. Not used outside udp_lib/loadgen.c
+ */
+static ssize_t insert_table_loadgen(struct table_loadgen * const table, \
+        const struct request_loadgen * const request) {
+    uint64_t index = home_loadgen(table, request->m_id);
+
+    if (table->m_size >= table->m_limit)
+        return -1;
+
+    while (table->m_slots[index].m_id)
+        index = (index + 1) & table->m_mask;
+
+    table->m_slots[index] = *request;
+    table->m_size++;
+
+    return 0;
+}
+
+/**
+ * @ingroup UdpLoadgen
+ * @brief Function find and remove request from table.
+ *
+ * Remove use backward shift, so table never keep tombstones.
+ * @param[in,out] table Table requests.
+ * @param[in] id ID request.
+ * @param[out] request Removed request.
+ * @return 0 or -1 if request not in table.
+ * @note This function is private. Not used outside udp_lib/loadgen.c
+ */
+static ssize_t remove_table_loadgen(struct table_loadgen * const table, \
+        const uint64_t id, struct request_loadgen * const request) {
+    uint64_t hole = home_loadgen(table, id);
+    uint64_t index = 0;
+
+    if (id == 0)
+        return -1;
+
+    while (table->m_slots[hole].m_id != id) {
+        if (table->m_slots[hole].m_id == 0)
+            return -1;
+        hole = (hole + 1) & table->m_mask;
+    }
+
+    *request = table->m_slots[hole];
+    index = hole;
+
+    for (;;) {
+        uint64_t home = 0;
+
+        index = (index + 1) & table->m_mask;
+        if (table->m_slots[index].m_id == 0)
+            break;
+        home = home_loadgen(table, table->m_slots[index].m_id);
+        if (((index - home) & table->m_mask) >= ((index - hole) & table->m_mask)) {
+            table->m_slots[hole] = table->m_slots[index];
+            hole = index;
+        }
+    }
+
+    table->m_slots[hole].m_id = 0;
+    table->m_size--;
+
+    return 0;
+}
+
+/**
+ * @ingroup UdpLoadgen
+ * @brief Function open UDP socket for replies.
+ * @param[in] pack UDP package used as request template.
+ * @return Socket or -1 on error.
+ * @note This function is private. Not used outside udp_lib/loadgen.c
+ */
+static int open_reply_loadgen(udp_pack_t pack) {
+    struct sockaddr_storage address = {0};
+    socklen_t size_address = sizeof(struct sockaddr_in);
+    int size_buffer = 1 << 22;
+    int fd = socket(pack->m_family, SOCK_DGRAM | SOCK_NONBLOCK, 0);
+
+    if (fd < 0) {
+        perror("ERROR: get not fd sock for replies");
+        goto get_not_fd_socket;
+    }
+
+    setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &size_buffer, sizeof(size_buffer));
+
+    if (pack->m_family == AF_INET6) {
+        struct sockaddr_in6 * address6 = (struct sockaddr_in6 *)&address;
+        address6->sin6_family = AF_INET6;
+        address6->sin6_addr = pack->m_ip6hdr->ip6_src;
+        address6->sin6_port = pack->m_head->m_port_source;
+        size_address = sizeof(*address6);
+    } else {
+        struct sockaddr_in * address4 = (struct sockaddr_in *)&address;
+        address4->sin_family = AF_INET;
+        address4->sin_addr.s_addr = pack->m_iphdr->saddr;
+        address4->sin_port = pack->m_head->m_port_source;
+    }
+
+    if (bind(fd, (struct sockaddr *)&address, size_address)) {
+        perror("ERROR: bind not socket for replies");
+        goto bind_not_socket;
+    }
+
+    return fd;
+bind_not_socket:
+    close(fd);
+get_not_fd_socket:
+    return -1;
+}
+
+ssize_t run_loadgen_udp_pack(udp_pack_t pack, \
+        const struct udp_loadgen_config * const config) {
+    ssize_t ret = 0;
+    int fd_reply = -1;
+    udp_sender_t sender = NULL;
+    udp_histogram_t corrected = NULL;
+    udp_histogram_t uncorrected = NULL;
+    struct table_loadgen table = {0};
+    static uint8_t replies[BATCH_LOADGEN][SIZE_REPLY_LOADGEN];
+    struct iovec vectors[BATCH_LOADGEN];
+    struct mmsghdr messages[BATCH_LOADGEN];
+    uint64_t start = 0;
+    uint64_t finish = 0;
+    uint64_t next_id = 1;
+    uint64_t expire_id = 1;
+    uint64_t sended = 0;
+    uint64_t received = 0;
+    uint64_t lost = 0;
+    uint64_t unmatched = 0;
+    uint64_t overflow = 0;
+    uint64_t errors = 0;
+    uint16_t offset = config->m_id_offset;
+
+#define INTENDED_LOADGEN(id) \
+    (start + ((id) - 1) * NSEC_CLOCK / config->m_rate)
+
+    if (config->m_rate == 0 || config->m_count == 0) {
+        fputs("ERROR: rate and count for open loop must be above zero\n", stderr);
+        ret = -1;
+        goto bad_config;
+    }
+
+    if (get_size_data_udp_pack(pack) < offset + SIZE_ID_LOADGEN || \
+            offset + SIZE_ID_LOADGEN > SIZE_REPLY_LOADGEN) {
+        fputs("ERROR: data too short for request ID\n", stderr);
+        ret = -1;
+        goto bad_config;
+    }
+
+    if (config->m_outstanding == 0 || config->m_outstanding > MAX_OUTSTANDING_LOADGEN) {
+        fprintf(stderr, "ERROR: outstanding is out of range 1-%d\n", MAX_OUTSTANDING_LOADGEN);
+        ret = -1;
+        goto bad_config;
+    }
+
+    ret = init_table_loadgen(&table, config->m_outstanding);
+    if (ret)
+        goto get_not_table;
+
+    corrected = init_udp_histogram();
+    uncorrected = init_udp_histogram();
+    if (corrected == NULL || uncorrected == NULL) {
+        ret = -1;
+        goto get_not_histogram;
+    }
+
+    fd_reply = open_reply_loadgen(pack);
+    if (fd_reply < 0) {
+        ret = -1;
+        goto get_not_reply_socket;
+    }
+
+    sender = init_pack_udp_sender(pack);
+    if (sender == NULL) {
+        ret = -1;
+        goto get_not_sender;
+    }
+
+    for (size_t i = 0; i < BATCH_LOADGEN; i++) {
+        vectors[i].iov_base = replies[i];
+        vectors[i].iov_len = SIZE_REPLY_LOADGEN;
+        memset(&messages[i], 0x00, sizeof(messages[i]));
+        messages[i].msg_hdr.msg_iov = &vectors[i];
+        messages[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    /* Default slack 50us of ppoll make every request late by schedule. */
+    prctl(PR_SET_TIMERSLACK, 1UL);
+
+    start = now_clock();
+
+    while (next_id <= config->m_count || table.m_size) {
+        uint64_t now = now_clock();
+        ssize_t count = 0;
+
+        while (next_id <= config->m_count && INTENDED_LOADGEN(next_id) <= now) {
+            struct request_loadgen request = {
+                .m_id = next_id,
+                .m_intended = INTENDED_LOADGEN(next_id),
+            };
+            uint64_t id = htobe64(next_id);
+
+            memcpy(pack->m_data + offset, &id, SIZE_ID_LOADGEN);
+            request.m_sended = now_clock();
+            if (send_udp_sender(sender, pack))
+                errors++;
+            else if (insert_table_loadgen(&table, &request))
+                overflow++;
+            sended++;
+            next_id++;
+            now = request.m_sended;
+        }
+
+        count = recvmmsg(fd_reply, messages, BATCH_LOADGEN, MSG_DONTWAIT, NULL);
+        if (count > 0) {
+            now = now_clock();
+            for (ssize_t i = 0; i < count; i++) {
+                struct request_loadgen request;
+                uint64_t id = 0;
+
+                if (messages[i].msg_len < offset + SIZE_ID_LOADGEN) {
+                    unmatched++;
+                    continue;
+                }
+                memcpy(&id, replies[i] + offset, SIZE_ID_LOADGEN);
+                if (remove_table_loadgen(&table, be64toh(id), &request)) {
+                    unmatched++;
+                    continue;
+                }
+                record_udp_histogram(corrected, now - request.m_intended);
+                record_udp_histogram(uncorrected, now - request.m_sended);
+                received++;
+            }
+        }
+
+        while (expire_id < next_id && \
+                INTENDED_LOADGEN(expire_id) + config->m_timeout <= now) {
+            struct request_loadgen request;
+
+            if (remove_table_loadgen(&table, expire_id, &request) == 0)
+                lost++;
+            expire_id++;
+        }
+
+        if (count <= 0) {
+            uint64_t wake = now + MAX_SLEEP_LOADGEN;
+            struct pollfd pollfd = {.fd = fd_reply, .events = POLLIN};
+            struct timespec timeout = {0};
+
+            if (next_id <= config->m_count && INTENDED_LOADGEN(next_id) < wake)
+                wake = INTENDED_LOADGEN(next_id);
+            if (wake > now) {
+                timeout.tv_nsec = wake - now;
+                ppoll(&pollfd, 1, &timeout, NULL);
+            }
+        }
+    }
+
+    finish = now_clock();
+    if (finish_udp_sender(sender))
+        ret = -1;
+
+    printf("sended: %lu received: %lu lost: %lu unmatched: %lu " \
+            "overflow: %lu errors: %lu\n", sended, received, lost, \
+            unmatched, overflow, errors);
+    printf("rate target: %lu/s achieved: %lu/s\n", config->m_rate, \
+            (uint64_t)(sended * NSEC_CLOCK / (finish - start + 1)));
+    print_udp_histogram(corrected, "latency corrected", "ns");
+    print_udp_histogram(uncorrected, "latency uncorrected", "ns");
+
+#undef INTENDED_LOADGEN
+
+    destroy_udp_sender(sender);
+get_not_sender:
+    close(fd_reply);
+get_not_reply_socket:
+get_not_histogram:
+    destroy_udp_histogram(uncorrected);
+    destroy_udp_histogram(corrected);
+    free(table.m_slots);
+get_not_table:
+bad_config:
+    return ret;
+}
@@ -0,0 +1,76 @@
+/**
+ * @file udp_lib/loadgen.h
+ * @author Vladsanin777
+ * @brief Header file for open-loop request/response load generator.
+ */
+
+#ifndef UDP_LIB_LOADGEN_H
+#define UDP_LIB_LOADGEN_H
+
+#include "udp_lib/udp.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+
+/**
+ * @defgroup UdpLoadgen open-loop load generator for udp
+ * @brief Group function for send requests by fixed schedule and match replies.
+ *
+ * Requests go out at fixed rate and never wait for replies. Every request carry
+ * 64-bit ID (big endian) at configured offset in data, reply must carry same ID
+ * at same offset. Latency is measured twice: from real send time and from
+ * intended send time in schedule. Second one is corrected for coordinated
+ * omission: when sender fall behind, the wait in queue is counted too.
+ * @{
+ */
+
+/**
+ * @brief Configuration open-loop load generator.
+ */
+struct udp_loadgen_config {
+    uint64_t m_rate; /**< Requests per second. */
+    uint64_t m_count; /**< Count requests to send. */
+    uint64_t m_timeout; /**< Time wait reply in nanoseconds, after request is lost. */
+    uint64_t m_outstanding; /**< Max requests waiting reply, 1 to MAX_OUTSTANDING_LOADGEN. */
+    uint16_t m_id_offset; /**< Offset of request ID in data UDP package. */
+};
+
+/** Default requests per second. */
+#define DEFAULT_RATE_LOADGEN 1000
+
+/** Default time wait reply in nanoseconds. */
+#define DEFAULT_TIMEOUT_LOADGEN 1000000000ULL
+
+/** Default max requests waiting reply. */
+#define DEFAULT_OUTSTANDING_LOADGEN (1 << 20)
+
+/** Max requests waiting reply, table has twice more slots. */
+#define MAX_OUTSTANDING_LOADGEN (1 << 24)
+
+/**
+ * @brief Function run open-loop load and print report.
+ * @note You must call @ref init_udp_pack before this.
+ * @note Replies are received on UDP socket binded to source ip and port package.
+ * @param[in,out] pack UDP package used as request template.
+ * @param[in] config Configuration load.
+ * @return 0 or -1 on error.
+ * Usage example.
+ * @code
+ * struct udp_loadgen_config config = {
+ *     .m_rate = 100000,
+ *     .m_count = 1000000,
+ *     .m_timeout = DEFAULT_TIMEOUT_LOADGEN,
+ *     .m_outstanding = DEFAULT_OUTSTANDING_LOADGEN,
+ *     .m_id_offset = 0,
+ * };
+ * ret = run_loadgen_udp_pack(pack, &config);
+ * if (ret)
+ *     goto run_not_loadgen;
+ * @endcode
+ */
+ssize_t run_loadgen_udp_pack(udp_pack_t pack, \
+        const struct udp_loadgen_config * const config);
+
+/** @} */
+
+#endif /* UDP_LIB_LOADGEN_H */
@@ -0,0 +1,583 @@
+/**
+ * @file udp_lib/neigh.c
+ * @author Vladsanin777
+ * @brief Code file for resolve mac addresses through kernel neighbor table.
+ */
+
+#include "udp_lib/neigh.h"
+#include "udp_lib/udp_private.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+
+#include <net/if.h>
+
+#include <arpa/inet.h>
+
+#include <sys/socket.h>
+
+#include <netinet/in.h>
+
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+#include <linux/neighbour.h>
+
+/** Count entries in cache, power of two. */
+#define SIZE_CACHE_NEIGH 1024
+
+/** Max probes in cache before overwrite. */
+#define PROBES_CACHE_NEIGH 8
+
+/** Size buffer for answers netlink. */
+#define SIZE_BUFFER_NEIGH 32768
+
+/** Tries read neighbor table after ask kernel resolve next hop. */
+#define TRIES_NEIGH 20
+
+/** Pause between tries in nanoseconds. */
+#define PAUSE_NEIGH 10000000L
+
+/** Port discard, used for ask kernel resolve next hop. */
+#define PORT_DISCARD_NEIGH 9
+
+/**
+ * @ingroup UdpNeigh
+ * @brief Struct is entry cache of neighbors.
+ * @note This struct is private. Not used outside udp_lib/neigh.c
+ */
+struct entry_neigh {
+    bool m_used; /**< Slot is busy. */
+    uint8_t m_family; /**< AF_INET or AF_INET6. */
+    int m_ifindex; /**< Index interface. */
+    uint8_t m_address[sizeof(struct in6_addr)]; /**< Address next hop. */
+    uint8_t m_mac[ETH_ALEN]; /**< Mac address next hop. */
+    bool m_is_failed; /**< Lookup failed, entry has not mac. */
+    time_t m_expire; /**< Time when entry is old. */
+};
+
+/** Cache neighbors of process. */
+static struct entry_neigh cache_neigh[SIZE_CACHE_NEIGH];
+
+/** Lock cache neighbors. */
+static pthread_mutex_t lock_neigh = PTHREAD_MUTEX_INITIALIZER;
+
+/** Sequence for netlink requests. */
+static uint32_t sequence_neigh = 0;
+
+/**
+ * @ingroup UdpNeigh
+ * @brief Function getting monotonic seconds.
+ * @return Seconds.
+ * @note This function is private. Not used outside udp_lib/neigh.c
+ */
+static time_t now_neigh(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec;
+}
+
+/**
+ * @ingroup UdpNeigh
+ * @brief Function getting size address family.
+ * @param[in] family AF_INET or AF_INET6.
+ * @return Size address in bytes.
+ * @note This function is private. Not used outside udp_lib/neigh.c
+ */
+static size_t size_address_neigh(const int family) {
+    return family == AF_INET6 ? sizeof(struct in6_addr) : sizeof(struct in_addr);
+}
+
+/**
+ * @ingroup UdpNeigh
+ * @brief Function getting home slot in cache.
+ * @param[in] family AF_INET or AF_INET6.
+ * @param[in] ifindex Index interface.
+ * @param[in] address Address next hop.
+ * @return Index slot.
+ * @note This function is private. Not used outside udp_lib/neigh.c
+ */
+static size_t home_neigh(const int family, const int ifindex, \
+        const void * const address) {
+    const uint8_t * bytes = address;
+    uint32_t hash = 2166136261U ^ (uint32_t)ifindex;
+
+    for (size_t i = 0; i < size_address_neigh(family); i++)
+        hash = (hash ^ bytes[i]) * 16777619U;
+
+    return hash & (SIZE_CACHE_NEIGH - 1);
+}
+
+/**
+ * @ingroup UdpNeigh
+ * @brief Function find entry in cache.
+ * @note Lock cache must be taken.
+ * @param[in] family AF_INET or AF_INET6.
+ * @param[in] ifindex Index interface.
+ * @param[in] address Address next hop.
+ * @param[out] mac Mac address next hop.
+ * @return 0, -1 on miss or 1 if entry remembers failed lookup.
+ * @note This function is private. Not used outside udp_lib/neigh.c
+ */
+static ssize_t find_cache_neigh(const int family, const int ifindex, \
+        const void * const address, uint8_t * const mac) {
+    size_t index = home_neigh(family, ifindex, address);
+    time_t now = now_neigh();
+
+    for (size_t i = 0; i < PROBES_CACHE_NEIGH; i++) {
+        struct entry_neigh * entry = &cache_neigh[(index + i) & (SIZE_CACHE_NEIGH - 1)];
+
+        if (entry->m_used && entry->m_family == family && \
+                entry->m_ifindex == ifindex && entry->m_expire > now && \
+                memcmp(entry->m_address, address, size_address_neigh(family)) == 0) {
+            if (entry->m_is_failed)
+                return 1;
+            memcpy(mac, entry->m_mac, ETH_ALEN);
+            return 0;
+        }
+    }
+
+    return -1;
+}
+
+/**
+ * @ingroup UdpNeigh
+ * @brief Function write entry in cache.
+ * @note Lock cache must be taken.
+ * @param[in] family AF_INET or AF_INET6.
+ * @param[in] ifindex Index interface.
+ * @param[in] address Address next hop.
+ * @param[in] mac Mac address next hop or NULL for failed lookup.
+ * @note This function is private. Not used outside udp_lib/neigh.c
+ */
+static void insert_cache_neigh(const int family, const int ifindex, \
+        const void * const address, const uint8_t * const mac) {
+    size_t home = home_neigh(family, ifindex, address);
+    struct entry_neigh * victim = &cache_neigh[home];
+    time_t now = now_neigh();
+
+    for (size_t i = 0; i < PROBES_CACHE_NEIGH; i++) {
+        struct entry_neigh * entry = &cache_neigh[(home + i) & (SIZE_CACHE_NEIGH - 1)];
+
+        if (!entry->m_used || entry->m_expire <= now || \
+                (entry->m_family == family && entry->m_ifindex == ifindex && \
+                memcmp(entry->m_address, address, size_address_neigh(family)) == 0)) {
+            victim = entry;
+            break;
+        }
+    }
+
+    victim->m_used = true;
+    victim->m_family = family;
+    victim->m_ifindex = ifindex;
+    memset(victim->m_address, 0x00, sizeof(victim->m_address));
+    memcpy(victim->m_address, address, size_address_neigh(family));
+    victim->m_is_failed = mac == NULL;
+    if (mac == NULL) {
+        memset(victim->m_mac, 0x00, ETH_ALEN);
+        victim->m_expire = now + FAILED_EXPIRE_NEIGH;
+    } else {
+        memcpy(victim->m_mac, mac, ETH_ALEN);
+        victim->m_expire = now + EXPIRE_NEIGH;
+    }
+}
+
+/**
+ * @ingroup UdpNeigh
+ * @brief Function add attribute in netlink message.
+ * @param[in,out] message Netlink message with free space after it.
+ * @param[in] type Type attribute.
+ * @param[in] data Data attribute.
+ * @param[in] size Size data.
+ * @note This function is private. Not used outside udp_lib/neigh.c
+ */
+static void add_attribute_neigh(struct nlmsghdr * const message, \
+        const unsigned short type, const void * const data, const size_t size) {
+    struct rtattr * attribute = (struct rtattr *)((uint8_t *)message + \
+            NLMSG_ALIGN(message->nlmsg_len));
+
+    attribute->rta_type = type;
+    attribute->rta_len = RTA_LENGTH(size);
+    memcpy(RTA_DATA(attribute), data, size);
+    message->nlmsg_len = NLMSG_ALIGN(message->nlmsg_len) + RTA_ALIGN(attribute->rta_len);
+}
+
+/**
+ * @ingroup UdpNeigh
+ * @brief Function find next hop and type route to destination.
+ * @param[in] fd Socket netlink.
+ * @param[in] family AF_INET or AF_INET6.
+ * @param[in] ifindex Index interface.
+ * @param[in] address Destination address.
+ * @param[out] hop Address next hop.
+ * @param[out] type Type route, RTN_LOCAL is address of this host.
+ * @return 0 or -1 on error.
+ * @note This function is private. Not used outside udp_lib/neigh.c
+ */
+static ssize_t route_neigh(const int fd, const int family, const int ifindex, \
+        const void * const address, uint8_t * const hop, uint8_t * const type) {
+    uint8_t request[NLMSG_SPACE(sizeof(struct rtmsg)) + 64] \
+            __attribute__((aligned(NLMSG_ALIGNTO))) = {0};
+    struct nlmsghdr * header = (struct nlmsghdr *)request;
+    struct rtmsg * question = NLMSG_DATA(header);
+    static uint8_t buffer[SIZE_BUFFER_NEIGH];
+    ssize_t size = 0;
+    size_t size_address = size_address_neigh(family);
+
+    header->nlmsg_len = NLMSG_LENGTH(sizeof(struct rtmsg));
+    header->nlmsg_type = RTM_GETROUTE;
+    header->nlmsg_flags = NLM_F_REQUEST;
+    header->nlmsg_seq = ++sequence_neigh;
+    question->rtm_family = family;
+    question->rtm_dst_len = size_address * 8;
+    add_attribute_neigh(header, RTA_DST, address, size_address);
+    add_attribute_neigh(header, RTA_OIF, &ifindex, sizeof(ifindex));
+
+    if (send(fd, request, header->nlmsg_len, 0) < 0)
+        goto send_not_request;
+
+    size = recv(fd, buffer, sizeof(buffer), 0);
+
+    for (struct nlmsghdr * message = (struct nlmsghdr *)buffer; \
+            NLMSG_OK(message, size); message = NLMSG_NEXT(message, size)) {
+        struct rtmsg * route = NLMSG_DATA(message);
+        int length = RTM_PAYLOAD(message);
+
+        if (message->nlmsg_type != RTM_NEWROUTE)
+            goto bad_answer;
+
+        memcpy(hop, address, size_address);
+        *type = route->rtm_type;
+
+        for (struct rtattr * attribute = RTM_RTA(route); RTA_OK(attribute, length); \
+                attribute = RTA_NEXT(attribute, length)) {
+            if (attribute->rta_type == RTA_GATEWAY)
+                memcpy(hop, RTA_DATA(attribute), size_address);
+        }
+
+        return 0;
+    }
+
+bad_answer:
+send_not_request:
+    return -1;
+}
+
+/**
+ * @ingroup UdpNeigh
+ * @brief Function read neighbor table of interface in cache.
+ * @note Lock cache must be taken.
+ * @param[in] fd Socket netlink.
+ * @param[in] family AF_INET or AF_INET6.
+ * @param[in] ifindex Index interface.
+ * @return 0 or -1 on error.
+ * @note This function is private. Not used outside udp_lib/neigh.c
+ */
+static ssize_t dump_neigh(const int fd, const int family, const int ifindex) {
+    struct {
+        struct nlmsghdr m_header;
+        struct ndmsg m_neighbor;
+    } request = {0};
+    static uint8_t buffer[SIZE_BUFFER_NEIGH];
+    size_t size_address = size_address_neigh(family);
+
+    request.m_header.nlmsg_len = NLMSG_LENGTH(sizeof(struct ndmsg));
+    request.m_header.nlmsg_type = RTM_GETNEIGH;
+    request.m_header.nlmsg_flags = NLM_F_REQUEST | NLM_F_DUMP;
+    request.m_header.nlmsg_seq = ++sequence_neigh;
+    request.m_neighbor.ndm_family = family;
+    request.m_neighbor.ndm_ifindex = ifindex;
+
+    if (send(fd, &request, request.m_header.nlmsg_len, 0) < 0)
+        return -1;
+
+    for (;;) {
+        ssize_t size = recv(fd, buffer, sizeof(buffer), 0);
+
+        if (size <= 0)
+            return -1;
+
+        for (struct nlmsghdr * message = (struct nlmsghdr *)buffer; \
+                NLMSG_OK(message, size); message = NLMSG_NEXT(message, size)) {
+            struct ndmsg * neighbor = NLMSG_DATA(message);
+            int length = message->nlmsg_len - NLMSG_LENGTH(sizeof(*neighbor));
+            const void * address = NULL;
+            const void * mac = NULL;
+
+            if (message->nlmsg_type == NLMSG_DONE)
+                return 0;
+            if (message->nlmsg_type == NLMSG_ERROR)
+                return -1;
+            if (message->nlmsg_type != RTM_NEWNEIGH || \
+                    neighbor->ndm_ifindex != ifindex || \
+                    (neighbor->ndm_state & (NUD_INCOMPLETE | NUD_FAILED)))
+                continue;
+
+            for (struct rtattr * attribute = (struct rtattr *)((uint8_t *)neighbor + \
+                    NLMSG_ALIGN(sizeof(*neighbor))); RTA_OK(attribute, length); \
+                    attribute = RTA_NEXT(attribute, length)) {
+                if (attribute->rta_type == NDA_DST && \
+                        RTA_PAYLOAD(attribute) == size_address)
+                    address = RTA_DATA(attribute);
+                else if (attribute->rta_type == NDA_LLADDR && \
+                        RTA_PAYLOAD(attribute) == ETH_ALEN)
+                    mac = RTA_DATA(attribute);
+            }
+
+            if (address != NULL && mac != NULL)
+                insert_cache_neigh(family, ifindex, address, mac);
+        }
+    }
+}
+
+/**
+ * @ingroup UdpNeigh
+ * @brief Function ask kernel resolve next hop by empty datagram on port discard.
+ * @param[in] interface Interface to send.
+ * @param[in] family AF_INET or AF_INET6.
+ * @param[in] hop Address next hop.
+ * @note This function is private. Not used outside udp_lib/neigh.c
+ */
+static void poke_neigh(const char * const interface, const int family, \
+        const void * const hop) {
+    struct sockaddr_storage address = {0};
+    socklen_t size = sizeof(struct sockaddr_in);
+    int fd = socket(family, SOCK_DGRAM, 0);
+
+    if (fd < 0)
+        return;
+
+    setsockopt(fd, SOL_SOCKET, SO_BINDTODEVICE, interface, strlen(interface));
+
+    if (family == AF_INET6) {
+        struct sockaddr_in6 * address6 = (struct sockaddr_in6 *)&address;
+        address6->sin6_family = AF_INET6;
+        address6->sin6_port = htons(PORT_DISCARD_NEIGH);
+        address6->sin6_scope_id = if_nametoindex(interface);
+        memcpy(&address6->sin6_addr, hop, sizeof(struct in6_addr));
+        size = sizeof(*address6);
+    } else {
+        struct sockaddr_in * address4 = (struct sockaddr_in *)&address;
+        address4->sin_family = AF_INET;
+        address4->sin_port = htons(PORT_DISCARD_NEIGH);
+        memcpy(&address4->sin_addr, hop, sizeof(struct in_addr));
+    }
+
+    sendto(fd, NULL, 0, MSG_DONTWAIT, (struct sockaddr *)&address, size);
+    close(fd);
+}
+
+/**
+ * @ingroup UdpNeigh
+ * @brief Function getting mac address interface.
+ * @param[in] interface Interface.
+ * @param[out] mac Mac address.
+ * @param[out] is_loopback Interface is loopback.
+ * @return 0 or -1 on error.
+ * @note This function is private. Not used outside udp_lib/neigh.c
+ */
+static ssize_t interface_mac_neigh(const char * const interface, \
+        uint8_t * const mac, bool * const is_loopback) {
+    struct ifreq ifr = {0};
+    ssize_t ret = 0;
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+
+    if (fd < 0) {
+        ret = -1;
+        goto get_not_fd_socket;
+    }
+
+    strncpy(ifr.ifr_name, interface, IFNAMSIZ - 1);
+
+    ret = ioctl(fd, SIOCGIFFLAGS, &ifr);
+    if (ret)
+        goto give_not_siocgifflags;
+
+    *is_loopback = ifr.ifr_flags & IFF_LOOPBACK;
+
+    ret = ioctl(fd, SIOCGIFHWADDR, &ifr);
+    if (ret)
+        goto give_not_siocgifhwaddr;
+
+    memcpy(mac, ifr.ifr_hwaddr.sa_data, ETH_ALEN);
+
+give_not_siocgifhwaddr:
+give_not_siocgifflags:
+    close(fd);
+get_not_fd_socket:
+    return ret;
+}
+
+/**
+ * @ingroup UdpNeigh
+ * @brief Function getting mac address for multicast and broadcast destination.
+ * @param[in] family AF_INET or AF_INET6.
+ * @param[in] address Destination address.
+ * @param[out] mac Mac address.
+ * @return 0 or -1 if address is unicast.
+ * @note This function is private. Not used outside udp_lib/neigh.c
+ */
+static ssize_t group_mac_neigh(const int family, const void * const address, \
+        uint8_t * const mac) {
+    const uint8_t * bytes = address;
+
+    if (family == AF_INET6) {
+        if (bytes[0] != 0xff)
+            return -1;
+        mac[0] = 0x33;
+        mac[1] = 0x33;
+        memcpy(mac + 2, bytes + 12, 4);
+        return 0;
+    }
+
+    if (bytes[0] == 0xff && bytes[1] == 0xff && bytes[2] == 0xff && bytes[3] == 0xff) {
+        memset(mac, 0xff, ETH_ALEN);
+        return 0;
+    }
+
+    if ((bytes[0] & 0xf0) != 0xe0)
+        return -1;
+
+    mac[0] = 0x01;
+    mac[1] = 0x00;
+    mac[2] = 0x5e;
+    mac[3] = bytes[1] & 0x7f;
+    mac[4] = bytes[2];
+    mac[5] = bytes[3];
+
+    return 0;
+}
+
+ssize_t get_interface_mac_udp_neighbor(const char * const interface, uint8_t * const mac) {
+    bool is_loopback = false;
+
+    return interface_mac_neigh(interface, mac, &is_loopback);
+}
+
+ssize_t lookup_udp_neighbor(const char * const interface, const int family, \
+        const void * const address, uint8_t * const mac) {
+    ssize_t ret = 0;
+    int fd = -1;
+    int ifindex = if_nametoindex(interface);
+    uint8_t hop[sizeof(struct in6_addr)] = {0};
+    uint8_t type = RTN_UNICAST;
+    bool is_loopback = false;
+
+    if (ifindex == 0) {
+        ret = -1;
+        goto get_not_ifindex;
+    }
+
+    if (group_mac_neigh(family, address, mac) == 0)
+        return 0;
+
+    ret = interface_mac_neigh(interface, mac, &is_loopback);
+    if (ret)
+        goto get_not_interface_mac;
+    if (is_loopback)
+        return 0;
+
+    pthread_mutex_lock(&lock_neigh);
+
+    fd = socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC, NETLINK_ROUTE);
+    if (fd < 0) {
+        ret = -1;
+        perror("ERROR: get not fd sock netlink");
+        goto get_not_fd_socket;
+    }
+
+    ret = route_neigh(fd, family, ifindex, address, hop, &type);
+    if (ret) {
+        memcpy(hop, address, size_address_neigh(family));
+        type = RTN_UNICAST;
+    }
+
+    /* Address of this host, frame go back through interface with own mac. */
+    if (type == RTN_LOCAL) {
+        ret = 0;
+        goto resolved;
+    }
+
+    ret = find_cache_neigh(family, ifindex, hop, mac);
+    if (ret == 0)
+        goto resolved;
+    if (ret > 0) {
+        ret = -1;
+        goto resolved;
+    }
+
+    for (size_t i = 0; i < TRIES_NEIGH; i++) {
+        struct timespec pause = {.tv_sec = 0, .tv_nsec = PAUSE_NEIGH};
+
+        dump_neigh(fd, family, ifindex);
+        ret = find_cache_neigh(family, ifindex, hop, mac);
+        if (ret == 0)
+            goto resolved;
+        if (i == 0)
+            poke_neigh(interface, family, hop);
+        nanosleep(&pause, NULL);
+    }
+    insert_cache_neigh(family, ifindex, hop, NULL);
+
+resolved:
+    close(fd);
+get_not_fd_socket:
+    pthread_mutex_unlock(&lock_neigh);
+get_not_interface_mac:
+get_not_ifindex:
+    return ret;
+}
+
+void flush_udp_neighbor(void) {
+    pthread_mutex_lock(&lock_neigh);
+    memset(cache_neigh, 0x00, sizeof(cache_neigh));
+    pthread_mutex_unlock(&lock_neigh);
+}
+
+ssize_t resolve_mac_address_udp_pack(udp_pack_t pack) {
+    ssize_t ret = 0;
+    bool is_loopback = false;
+    const void * address = &pack->m_iphdr->daddr;
+    uint8_t mac[ETH_ALEN];
+
+    pack->m_flags |= FLAG_RESOLVED_UDP_PACK;
+
+    if (pack->m_interface[0] == '\0') {
+        ret = -1;
+        goto get_not_interface;
+    }
+
+    if (!(pack->m_flags & FLAG_MAC_SOURCE_UDP_PACK) && \
+            interface_mac_neigh(pack->m_interface, mac, &is_loopback) == 0)
+        memcpy(pack->m_ethhdr->h_source, mac, ETH_ALEN);
+
+    if (pack->m_flags & FLAG_MAC_DESTANTION_UDP_PACK)
+        return ret;
+
+    if (pack->m_family == AF_INET6)
+        address = &pack->m_ip6hdr->ip6_dst;
+
+    ret = lookup_udp_neighbor(pack->m_interface, pack->m_family, address, mac);
+    if (ret) {
+        /* Mac of previous destination must not stay. */
+        memset(pack->m_ethhdr->h_dest, 0xFF, ETH_ALEN);
+        fputs("WARNING: mac address destantion is not resolved, " \
+                "send broadcast\n", stderr);
+        goto lookup_not_neighbor;
+    }
+
+    memcpy(pack->m_ethhdr->h_dest, mac, ETH_ALEN);
+
+lookup_not_neighbor:
+get_not_interface:
+    return ret;
+}
@@ -0,0 +1,91 @@
+/**
+ * @file udp_lib/neigh.h
+ * @author Vladsanin777
+ * @brief Header file for resolve mac addresses through kernel neighbor table.
+ */
+
+#ifndef UDP_LIB_NEIGH_H
+#define UDP_LIB_NEIGH_H
+
+#include "udp_lib/udp.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+
+/**
+ * @defgroup UdpNeigh neighbor cache for udp
+ * @brief Group function for fill mac addresses UDP package without broadcast.
+ *
+ * Source mac is taken from interface (SIOCGIFHWADDR). Destination mac is mac of
+ * next hop: route table (RTM_GETROUTE) give gateway or say destination is on link,
+ * neighbor table (RTM_GETNEIGH) give mac. Answers are kept in cache of process,
+ * table of kernel is read again only on miss or after entry is expired.
+ * Failed lookup waits kernel resolve next hop at most TRIES_NEIGH * PAUSE_NEIGH
+ * and is remembered for @ref FAILED_EXPIRE_NEIGH seconds, so every package to
+ * unreachable destination does not wait again.
+ * @{
+ */
+
+/** Seconds entry live in cache. */
+#define EXPIRE_NEIGH 30
+
+/** Seconds failed lookup is remembered, next lookups fail without wait. */
+#define FAILED_EXPIRE_NEIGH 3
+
+/**
+ * @brief Function find mac address of next hop to destination.
+ * @param[in] interface Interface to send.
+ * @param[in] family AF_INET or AF_INET6.
+ * @param[in] address Destination address in network order.
+ * @param[out] mac Buffer for 6 bytes mac address.
+ * @return 0 or -1 on error.
+ * Usage example.
+ * @code
+ * uint8_t mac[6];
+ * struct in_addr address = {.s_addr = inet_addr("192.168.0.1")};
+ * ret = lookup_udp_neighbor("eth0", AF_INET, &address, mac);
+ * if (ret)
+ *     goto lookup_not_neighbor;
+ * @endcode
+ */
+ssize_t lookup_udp_neighbor(const char * const interface, const int family, \
+        const void * const address, uint8_t * const mac);
+
+/**
+ * @brief Function getting mac address of interface.
+ * @param[in] interface Interface.
+ * @param[out] mac Buffer for 6 bytes mac address.
+ * @return 0 or -1 on error.
+ * Usage example.
+ * @code
+ * uint8_t mac[6];
+ * ret = get_interface_mac_udp_neighbor("eth0", mac);
+ * if (ret)
+ *     goto get_not_interface_mac;
+ * @endcode
+ */
+ssize_t get_interface_mac_udp_neighbor(const char * const interface, uint8_t * const mac);
+
+/**
+ * @brief Function forget all entries in cache.
+ */
+void flush_udp_neighbor(void);
+
+/**
+ * @brief Function fill mac addresses UDP package from interface and neighbor table.
+ * @note You must call @ref init_udp_pack and @ref set_interface_udp_pack before this.
+ * @note Mac addresses set by user are kept. Sender call this before first send.
+ * @param[in,out] pack UDP package for work.
+ * @return 0 or -1 if destination mac is not resolved and is set broadcast.
+ * Usage example.
+ * @code
+ * ret = resolve_mac_address_udp_pack(pack);
+ * if (ret)
+ *     puts("destination mac is broadcast");
+ * @endcode
+ */
+ssize_t resolve_mac_address_udp_pack(udp_pack_t pack);
+
+/** @} */
+
+#endif /* UDP_LIB_NEIGH_H */
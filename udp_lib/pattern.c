@@ -0,0 +1,334 @@
+/**
+ * @file udp_lib/pattern.c
+ * @author Vladsanin777
+ * @brief Code file for generators of payload by pattern.
+ */
+
+#include "udp_lib/pattern.h"
+#include "udp_lib/udp_private.h"
+#include "udp_lib/sender.h"
+#include "udp_lib/clock_private.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+#include <endian.h>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+/** Payload is random. */
+#define TYPE_RANDOM_PATTERN 0
+
+/** Payload is counters. */
+#define TYPE_COUNTER_PATTERN 1
+
+/** Payload is repeated text. */
+#define TYPE_FIXED_PATTERN 2
+
+/** Payload is cycled file. */
+#define TYPE_FILE_PATTERN 3
+
+/** Lanes of random generator, one AVX2 register. */
+#define LANES_PATTERN 4
+
+/** Bytes of one step random generator. */
+#define BLOCK_PATTERN (LANES_PATTERN * sizeof(uint64_t))
+
+/** Seed of random without given seed. */
+#define DEFAULT_SEED_PATTERN 0x5EED5EED5EED5EEDULL
+
+/**
+ * @ingroup UdpPattern
+ * @brief Struct is pattern.
+ * @note This struct is private. Not used outside udp_lib/pattern.c
+ */
+struct udp_pattern {
+    uint64_t m_state[4][LANES_PATTERN] __attribute__((aligned(32))); /**< Words of xoshiro by lanes. */
+    void (*m_random)(udp_pattern_t, uint8_t *, size_t); /**< Fill blocks of random. */
+    uint8_t m_type; /**< TYPE_*_PATTERN. */
+    uint16_t m_size; /**< Size payload. */
+    uint64_t m_counter; /**< Next counter. */
+    uint8_t * m_source; /**< Text or mapped file. */
+    size_t m_size_source; /**< Size text or file. */
+    size_t m_offset; /**< Offset next payload in file. */
+};
+
+/**
+ * @ingroup UdpPattern
+ * @brief Function next value splitmix64, it spreads seed over states.
+ * @param[in,out] seed State splitmix64.
+ * @return Value.
+ * @note This function is private. Not used outside udp_lib/pattern.c
+ */
+static uint64_t splitmix_pattern(uint64_t * const seed) {
+    uint64_t value = (*seed += 0x9E3779B97F4A7C15ULL);
+
+    value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    value = (value ^ (value >> 27)) * 0x94D049BB133111EBULL;
+
+    return value ^ (value >> 31);
+}
+
+/**
+ * @ingroup UdpPattern
+ * @brief Function fill whole blocks by xoshiro256+ in 4 lanes, portable.
+ * @param[in,out] pattern Pattern.
+ * @param[out] data Buffer.
+ * @param[in] blocks Count blocks of @ref BLOCK_PATTERN.
+ * @note This function is private. Not used outside udp_lib/pattern.c
+ */
+static void random_scalar_pattern(udp_pattern_t pattern, uint8_t * data, size_t blocks) {
+    uint64_t (*s)[LANES_PATTERN] = pattern->m_state;
+
+    for (; blocks; blocks--, data += BLOCK_PATTERN) {
+        for (size_t lane = 0; lane < LANES_PATTERN; lane++) {
+            uint64_t result = s[0][lane] + s[3][lane];
+            uint64_t t = s[1][lane] << 17;
+
+            memcpy(data + lane * sizeof(result), &result, sizeof(result));
+            s[2][lane] ^= s[0][lane];
+            s[3][lane] ^= s[1][lane];
+            s[1][lane] ^= s[2][lane];
+            s[0][lane] ^= s[3][lane];
+            s[2][lane] ^= t;
+            s[3][lane] = (s[3][lane] << 45) | (s[3][lane] >> 19);
+        }
+    }
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+/**
+ * @ingroup UdpPattern
+ * @brief Function fill whole blocks by xoshiro256+ in 4 lanes of AVX2 register.
+ * @param[in,out] pattern Pattern.
+ * @param[out] data Buffer.
+ * @param[in] blocks Count blocks of @ref BLOCK_PATTERN.
+ * @note This function is private. Not used outside udp_lib/pattern.c
+ */
+__attribute__((target("avx2")))
+static void random_avx2_pattern(udp_pattern_t pattern, uint8_t * data, size_t blocks) {
+    __m256i s0 = _mm256_load_si256((const __m256i *)pattern->m_state[0]);
+    __m256i s1 = _mm256_load_si256((const __m256i *)pattern->m_state[1]);
+    __m256i s2 = _mm256_load_si256((const __m256i *)pattern->m_state[2]);
+    __m256i s3 = _mm256_load_si256((const __m256i *)pattern->m_state[3]);
+
+    for (; blocks; blocks--, data += BLOCK_PATTERN) {
+        __m256i t = _mm256_slli_epi64(s1, 17);
+
+        _mm256_storeu_si256((__m256i *)data, _mm256_add_epi64(s0, s3));
+        s2 = _mm256_xor_si256(s2, s0);
+        s3 = _mm256_xor_si256(s3, s1);
+        s1 = _mm256_xor_si256(s1, s2);
+        s0 = _mm256_xor_si256(s0, s3);
+        s2 = _mm256_xor_si256(s2, t);
+        s3 = _mm256_or_si256(_mm256_slli_epi64(s3, 45), _mm256_srli_epi64(s3, 19));
+    }
+
+    _mm256_store_si256((__m256i *)pattern->m_state[0], s0);
+    _mm256_store_si256((__m256i *)pattern->m_state[1], s1);
+    _mm256_store_si256((__m256i *)pattern->m_state[2], s2);
+    _mm256_store_si256((__m256i *)pattern->m_state[3], s3);
+}
+#endif
+
+/**
+ * @ingroup UdpPattern
+ * @brief Function open file for cycled payload.
+ * @param[in,out] pattern Pattern.
+ * @param[in] file Path to file.
+ * @return 0 or -1 on error.
+ * @note This function is private. Not used outside udp_lib/pattern.c
+ */
+static ssize_t map_file_pattern(udp_pattern_t pattern, const char * const file) {
+    ssize_t ret = 0;
+    struct stat info;
+    int fd = open(file, O_RDONLY | O_CLOEXEC);
+
+    if (fd < 0) {
+        ret = -1;
+        perror("ERROR: open not file of pattern");
+        goto open_not_file;
+    }
+
+    if (fstat(fd, &info) || info.st_size == 0) {
+        ret = -1;
+        fputs("ERROR: file of pattern is empty\n", stderr);
+        goto stat_not_file;
+    }
+
+    pattern->m_source = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (pattern->m_source == MAP_FAILED) {
+        ret = -1;
+        pattern->m_source = NULL;
+        perror("ERROR: map not file of pattern");
+        goto map_not_file;
+    }
+    pattern->m_size_source = info.st_size;
+
+map_not_file:
+stat_not_file:
+    close(fd);
+open_not_file:
+    return ret;
+}
+
+udp_pattern_t init_udp_pattern(const char * const pattern, const uint16_t size) {
+    const char * argument = strchr(pattern, ':');
+    size_t length = argument ? (size_t)(argument - pattern) : strlen(pattern);
+    uint64_t seed = DEFAULT_SEED_PATTERN;
+    udp_pattern_t generator = NULL;
+
+    if (posix_memalign((void **)&generator, 32, sizeof(*generator)))
+        goto get_not_memory;
+    memset(generator, 0x00, sizeof(*generator));
+    generator->m_size = MIN(size, MAX_SIZE_DATA);
+    if (argument != NULL)
+        argument++;
+
+    if (length == 6 && strncmp(pattern, "random", length) == 0) {
+        generator->m_type = TYPE_RANDOM_PATTERN;
+        if (argument != NULL)
+            seed = strtoull(argument, NULL, 0);
+        for (size_t lane = 0; lane < LANES_PATTERN; lane++) {
+            for (size_t word = 0; word < 4; word++)
+                generator->m_state[word][lane] = splitmix_pattern(&seed);
+        }
+        generator->m_random = random_scalar_pattern;
+#if defined(__x86_64__) || defined(__i386__)
+        if (__builtin_cpu_supports("avx2"))
+            generator->m_random = random_avx2_pattern;
+#endif
+    } else if (length == 7 && strncmp(pattern, "counter", length) == 0) {
+        generator->m_type = TYPE_COUNTER_PATTERN;
+        if (argument != NULL)
+            generator->m_counter = strtoull(argument, NULL, 0);
+    } else if (length == 5 && strncmp(pattern, "fixed", length) == 0 && \
+            argument != NULL && *argument != '\0') {
+        generator->m_type = TYPE_FIXED_PATTERN;
+        generator->m_size_source = strlen(argument);
+        generator->m_source = (uint8_t *)strdup(argument);
+        if (generator->m_source == NULL)
+            goto get_not_source;
+    } else if (length == 4 && strncmp(pattern, "file", length) == 0 && argument != NULL) {
+        generator->m_type = TYPE_FILE_PATTERN;
+        if (map_file_pattern(generator, argument))
+            goto get_not_source;
+    } else {
+        fprintf(stderr, "ERROR: unknown pattern '%s'\n", pattern);
+        goto get_not_source;
+    }
+
+    return generator;
+get_not_source:
+    free(generator);
+get_not_memory:
+    return NULL;
+}
+
+void fill_pattern_udp_pack(udp_pattern_t pattern, udp_pack_t pack) {
+    uint8_t * data = pack->m_data;
+    size_t size = pattern->m_size;
+
+    set_size_udp_pack(pack, size);
+
+    switch (pattern->m_type) {
+        case TYPE_RANDOM_PATTERN: {
+            uint8_t block[BLOCK_PATTERN];
+
+            pattern->m_random(pattern, data, size / BLOCK_PATTERN);
+            if (size % BLOCK_PATTERN) {
+                pattern->m_random(pattern, block, 1);
+                memcpy(data + size - size % BLOCK_PATTERN, block, size % BLOCK_PATTERN);
+            }
+            break;
+        }
+        case TYPE_COUNTER_PATTERN:
+            for (size_t i = 0; i < size; i += sizeof(uint64_t)) {
+                uint64_t value = htobe64(pattern->m_counter++);
+
+                memcpy(data + i, &value, MIN(sizeof(value), size - i));
+            }
+            break;
+        case TYPE_FIXED_PATTERN: {
+            /* Copy doubles every time, so fill is log of size calls. */
+            size_t filled = MIN(pattern->m_size_source, size);
+
+            memcpy(data, pattern->m_source, filled);
+            while (filled < size) {
+                size_t chunk = MIN(filled, size - filled);
+
+                memcpy(data + filled, data, chunk);
+                filled += chunk;
+            }
+            break;
+        }
+        case TYPE_FILE_PATTERN:
+            while (size) {
+                size_t chunk = MIN(size, pattern->m_size_source - pattern->m_offset);
+
+                memcpy(data, pattern->m_source + pattern->m_offset, chunk);
+                data += chunk;
+                size -= chunk;
+                pattern->m_offset = (pattern->m_offset + chunk) % pattern->m_size_source;
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+ssize_t run_pattern_udp_pack(udp_pack_t pack, udp_pattern_t pattern, const uint64_t count) {
+    ssize_t ret = 0;
+    udp_sender_t sender = init_pack_udp_sender(pack);
+    uint64_t start = 0;
+    uint64_t sended = 0;
+    double seconds = 0.0;
+
+    if (sender == NULL) {
+        ret = -1;
+        goto get_not_sender;
+    }
+
+    start = now_clock();
+
+    for (uint64_t i = 0; i < count; i++) {
+        if (i)
+            fill_pattern_udp_pack(pattern, pack);
+        if (send_udp_sender(sender, pack) == 0)
+            sended++;
+    }
+
+    seconds = (now_clock() - start) / (double)NSEC_CLOCK;
+    if (finish_udp_sender(sender))
+        ret = -1;
+
+    printf("pattern sended: %lu errors: %lu seconds: %.3f rate: %.0f pps\n", sended, \
+            count - sended, seconds, seconds > 0.0 ? sended / seconds : 0.0);
+    print_stats_udp_sender(sender);
+    if (sended != count)
+        ret = -1;
+
+    destroy_udp_sender(sender);
+get_not_sender:
+    return ret;
+}
+
+void destroy_udp_pattern(udp_pattern_t pattern) {
+    if (pattern == NULL)
+        return;
+    if (pattern->m_type == TYPE_FILE_PATTERN)
+        munmap(pattern->m_source, pattern->m_size_source);
+    else
+        free(pattern->m_source);
+    free(pattern);
+}
@@ -0,0 +1,94 @@
+/**
+ * @file udp_lib/pattern.h
+ * @author Vladsanin777
+ * @brief Header file for generators of payload by pattern.
+ */
+
+#ifndef UDP_LIB_PATTERN_H
+#define UDP_LIB_PATTERN_H
+
+#include "udp_lib/udp.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+
+/**
+ * @defgroup UdpPattern pattern for udp
+ * @brief Group function for fill data of package by generated payload.
+ *
+ * Pattern is given by string:
+ * - `random` or `random:SEED` is xoshiro256+ in 4 lanes, AVX2 if processor has it,
+ *   output is same with and without AVX2 for one seed;
+ * - `counter` or `counter:START` is 64 bit counters in network order, they go on
+ *   through all payloads;
+ * - `fixed:TEXT` is text repeated to size;
+ * - `file:PATH` is content of file, every payload starts where previous ended,
+ *   after end of file it starts again.
+ * @{
+ */
+
+/** Default size payload. */
+#define DEFAULT_SIZE_PATTERN 64
+
+/**
+ * @brief Private struct pattern. (Hidden implementation)
+ */
+struct udp_pattern;
+
+/**
+ * @brief Pointer on private struct pattern.
+ */
+typedef struct udp_pattern * udp_pattern_t;
+
+/**
+ * @brief Function create generator by pattern.
+ * @note You must call @ref destroy_udp_pattern after this.
+ * @param[in] pattern Pattern string.
+ * @param[in] size Size every payload.
+ * @return Pattern or NULL on error.
+ * Usage example.
+ * @code
+ * udp_pattern_t pattern = init_udp_pattern("random:42", 1400);
+ * if (pattern == NULL)
+ *     goto get_not_pattern;
+ * @endcode
+ */
+udp_pattern_t init_udp_pattern(const char * const pattern, const uint16_t size);
+
+/**
+ * @brief Function write next payload straight in data of package.
+ * @param[in,out] pattern Pattern.
+ * @param[in,out] pack UDP package.
+ * Usage example.
+ * @code
+ * fill_pattern_udp_pack(pattern, pack);
+ * @endcode
+ */
+void fill_pattern_udp_pack(udp_pattern_t pattern, udp_pack_t pack);
+
+/**
+ * @brief Function send count packages, every with next payload.
+ * @note Package must have first payload already, it is sent first.
+ * @param[in,out] pack UDP package.
+ * @param[in,out] pattern Pattern.
+ * @param[in] count Count packages.
+ * @return 0 or -1 on error.
+ * Usage example.
+ * @code
+ * fill_pattern_udp_pack(pattern, pack);
+ * ret = run_pattern_udp_pack(pack, pattern, 1000);
+ * if (ret)
+ *     goto run_not_pattern;
+ * @endcode
+ */
+ssize_t run_pattern_udp_pack(udp_pack_t pack, udp_pattern_t pattern, const uint64_t count);
+
+/**
+ * @brief Function free pattern.
+ * @param[in] pattern Pattern.
+ */
+void destroy_udp_pattern(udp_pattern_t pattern);
+
+/** @} */
+
+#endif /* UDP_LIB_PATTERN_H */
@@ -0,0 +1,70 @@
+/**
+ * @file udp_lib/probe.h
+ * @author Vladsanin777
+ * @brief Header file for USDT static probes of library.
+ * @note This header is private. Not used outside udp_lib.
+ */
+
+#ifndef UDP_LIB_PROBE_H
+#define UDP_LIB_PROBE_H
+
+/**
+ * @defgroup UdpProbe probes for udp
+ * @brief Group macros for USDT probes of provider `udp`.
+ *
+ * Probes are made by `<sys/sdt.h>` of systemtap (package systemtap-sdt-dev or
+ * systemtap-sdt-devel), so they are one nop in code and note in section
+ * `.note.stapsdt`. Probes have no semaphores, so arguments are computed on every
+ * call also when probe is not attached: they must stay cheap, values already in
+ * registers or simple conversions. Without `<sys/sdt.h>` or with
+ * `-DDISABLE_PROBE` macros are empty and binary has no probes, make warns then.
+ *
+ * Probes and arguments:
+ * - `pack_init(pack)` package is created;
+ * - `payload_set(pack, size)` data of package is set or added, size is new size;
+ * - `checksum(pack, length, checksum)` checksums are calculated, length is UDP length;
+ * - `send_start(sender, count)` frames are given to backend;
+ * - `send_end(sender, count, result, bytes)` backend took result frames of bytes;
+ * - `send_error(sender, errno, count)` backend did not take frames.
+ *
+ * Usage example.
+ * @code
+ * bpftrace -e 'usdt:./udp:udp:send_end { @bytes = sum(arg3); }'
+ * perf probe -x ./udp sdt_udp:send_start
+ * @endcode
+ * @{
+ */
+
+#if !defined(DISABLE_PROBE) && defined(__has_include)
+#if __has_include(<sys/sdt.h>)
+#include <sys/sdt.h>
+#define ENABLED_PROBE 1
+#endif
+#endif
+
+#ifdef ENABLED_PROBE
+
+/** Probe with one argument. */
+#define FIRE1_PROBE(name, a) DTRACE_PROBE1(udp, name, a)
+
+/** Probe with two arguments. */
+#define FIRE2_PROBE(name, a, b) DTRACE_PROBE2(udp, name, a, b)
+
+/** Probe with three arguments. */
+#define FIRE3_PROBE(name, a, b, c) DTRACE_PROBE3(udp, name, a, b, c)
+
+/** Probe with four arguments. */
+#define FIRE4_PROBE(name, a, b, c, d) DTRACE_PROBE4(udp, name, a, b, c, d)
+
+#else
+
+#define FIRE1_PROBE(name, a) do {} while (0)
+#define FIRE2_PROBE(name, a, b) do {} while (0)
+#define FIRE3_PROBE(name, a, b, c) do {} while (0)
+#define FIRE4_PROBE(name, a, b, c, d) do {} while (0)
+
+#endif
+
+/** @} */
+
+#endif /* UDP_LIB_PROBE_H */
@@ -0,0 +1,400 @@
+/**
+ * @file udp_lib/queue.c
+ * @author Vladsanin777
+ * @brief Code file for thread safe queue of frames with one sender thread.
+ */
+
+#include "udp_lib/queue.h"
+#include "udp_lib/udp_private.h"
+#include "udp_lib/sender.h"
+#include "udp_lib/neigh.h"
+#include "udp_lib/stage.h"
+#include "udp_lib/clock_private.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <errno.h>
+#include <poll.h>
+#include <time.h>
+#include <sched.h>
+#include <pthread.h>
+
+#include <sys/uio.h>
+#include <sys/eventfd.h>
+
+/** Size cache line, shared counters never share it. */
+#define CACHE_LINE_QUEUE 64
+
+/** Minimal count slots. */
+#define MIN_CAPACITY_QUEUE 64
+
+/** Max frames in one call of sender. */
+#define BATCH_QUEUE 64
+
+/** Milliseconds of sleep on eventfd between checks of stop. */
+#define WAIT_QUEUE 100
+
+/** Max producer threads of @ref run_queue_udp_pack. */
+#define MAX_THREADS_QUEUE 256
+
+/**
+ * @ingroup UdpQueue
+ * @brief Struct is slot of queue, frame is after it.
+ *
+ * Sequence equal position means slot is free for producer of this position,
+ * position plus one means frame is ready for sender.
+ * @note This struct is private. Not used outside udp_lib/queue.c
+ */
+struct slot_queue {
+    uint64_t m_sequence; /**< State slot. */
+    uint64_t m_stamp; /**< Start of @ref QUEUE_STAGE or 0. */
+    uint32_t m_size; /**< Size frame. */
+    uint32_t m_reserved; /**< Zero. */
+};
+
+/**
+ * @ingroup UdpQueue
+ * @brief Struct is queue.
+ * @note This struct is private. Not used outside udp_lib/queue.c
+ */
+struct udp_queue {
+    udp_sender_t m_sender; /**< Sender, used only by sender thread. */
+    uint8_t * m_slots; /**< Slots with frames. */
+    size_t m_stride; /**< Size slot with frame, multiple of cache line. */
+    size_t m_max_frame; /**< Max size frame. */
+    uint64_t m_mask; /**< Count slots minus one. */
+    int m_fd_event; /**< eventfd for wake sender thread. */
+    pthread_t m_thread; /**< Sender thread. */
+    bool m_is_joined; /**< Sender thread is finished. */
+    uint64_t m_sended; /**< Sended frames, written by sender thread. */
+    uint64_t m_errors; /**< Not sended frames, written by sender thread. */
+    uint64_t m_enqueue __attribute__((aligned(CACHE_LINE_QUEUE))); /**< Next position of producers. */
+    uint64_t m_full __attribute__((aligned(CACHE_LINE_QUEUE))); /**< Rejected submits. */
+    uint32_t m_sleeping __attribute__((aligned(CACHE_LINE_QUEUE))); /**< Sender waits eventfd. */
+    uint32_t m_stop; /**< Sender thread must finish when queue is empty. */
+};
+
+/**
+ * @ingroup UdpQueue
+ * @brief Function get slot of position.
+ * @param[in] queue Queue.
+ * @param[in] position Position.
+ * @return Slot.
+ * @note This function is private. Not used outside udp_lib/queue.c
+ */
+static inline struct slot_queue * get_slot_queue(udp_queue_t queue, const uint64_t position) {
+    return (struct slot_queue *)(queue->m_slots + (position & queue->m_mask) * queue->m_stride);
+}
+
+/**
+ * @ingroup UdpQueue
+ * @brief Function wait ready slot on eventfd.
+ * @param[in,out] queue Queue.
+ * @param[in] position Position of sender thread.
+ * @note This function is private. Not used outside udp_lib/queue.c
+ */
+static void wait_queue(udp_queue_t queue, const uint64_t position) {
+    struct pollfd wait = {.fd = queue->m_fd_event, .events = POLLIN};
+    struct slot_queue * slot = get_slot_queue(queue, position);
+    uint64_t value = 0;
+
+    /* Flag before second check of slot, so producer wakes us or we see its frame. */
+    __atomic_store_n(&queue->m_sleeping, 1, __ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&slot->m_sequence, __ATOMIC_SEQ_CST) != position + 1 && \
+            !__atomic_load_n(&queue->m_stop, __ATOMIC_ACQUIRE))
+        poll(&wait, 1, WAIT_QUEUE);
+    __atomic_store_n(&queue->m_sleeping, 0, __ATOMIC_RELAXED);
+
+    if (read(queue->m_fd_event, &value, sizeof(value)) < 0 && errno != EAGAIN)
+        perror("ERROR: read not eventfd");
+}
+
+/**
+ * @ingroup UdpQueue
+ * @brief Function of sender thread, send ready slots by batches.
+ * @param[in,out] argument Queue.
+ * @return NULL.
+ * @note This function is private. Not used outside udp_lib/queue.c
+ */
+static void * run_sender_queue(void * argument) {
+    udp_queue_t queue = argument;
+    struct iovec frames[BATCH_QUEUE];
+    uint64_t position = 0;
+
+    for (;;) {
+        size_t count = 0;
+        ssize_t sended = 0;
+
+        for (; count < BATCH_QUEUE; count++) {
+            struct slot_queue * slot = get_slot_queue(queue, position + count);
+
+            if (__atomic_load_n(&slot->m_sequence, __ATOMIC_ACQUIRE) != position + count + 1)
+                break;
+            frames[count].iov_base = slot + 1;
+            frames[count].iov_len = slot->m_size;
+            end_udp_stage(QUEUE_STAGE, slot->m_stamp);
+        }
+
+        if (count == 0) {
+            if (__atomic_load_n(&queue->m_stop, __ATOMIC_ACQUIRE))
+                break;
+            wait_queue(queue, position);
+            continue;
+        }
+
+        sended = send_batch_udp_sender(queue->m_sender, frames, count);
+        if (sended < 0)
+            sended = 0;
+        queue->m_sended += sended;
+        queue->m_errors += count - sended;
+
+        /* Frames are in kernel or file now, slots are given back to producers. */
+        for (size_t i = 0; i < count; i++) {
+            __atomic_store_n(&get_slot_queue(queue, position + i)->m_sequence, \
+                    position + i + queue->m_mask + 1, __ATOMIC_RELEASE);
+        }
+        position += count;
+    }
+
+    return NULL;
+}
+
+udp_queue_t init_udp_queue(udp_pack_t pack, const size_t capacity) {
+    udp_queue_t queue = NULL;
+    uint64_t count = MIN_CAPACITY_QUEUE;
+
+    while (count < capacity && count < (1ULL << 24))
+        count <<= 1;
+
+    if (posix_memalign((void **)&queue, CACHE_LINE_QUEUE, sizeof(*queue)))
+        goto get_not_memory;
+    memset(queue, 0x00, sizeof(*queue));
+
+    queue->m_sender = init_pack_udp_sender(pack);
+    if (queue->m_sender == NULL)
+        goto get_not_sender;
+
+    queue->m_max_frame = HEAD_ETH + get_mtu_udp_sender(queue->m_sender);
+    queue->m_stride = (sizeof(struct slot_queue) + queue->m_max_frame + \
+            CACHE_LINE_QUEUE - 1) & ~(size_t)(CACHE_LINE_QUEUE - 1);
+    queue->m_mask = count - 1;
+
+    if (posix_memalign((void **)&queue->m_slots, CACHE_LINE_QUEUE, queue->m_stride * count))
+        goto get_not_slots;
+    for (uint64_t i = 0; i < count; i++)
+        get_slot_queue(queue, i)->m_sequence = i;
+
+    queue->m_fd_event = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (queue->m_fd_event < 0)
+        goto get_not_eventfd;
+
+    if (pthread_create(&queue->m_thread, NULL, run_sender_queue, queue))
+        goto start_not_thread;
+
+    return queue;
+start_not_thread:
+    close(queue->m_fd_event);
+get_not_eventfd:
+    free(queue->m_slots);
+get_not_slots:
+    destroy_udp_sender(queue->m_sender);
+get_not_sender:
+    free(queue);
+get_not_memory:
+    perror("ERROR: init not queue");
+    return NULL;
+}
+
+ssize_t submit_frame_udp_queue(udp_queue_t queue, const void * const frame, \
+        const size_t size) {
+    struct slot_queue * slot = NULL;
+    uint64_t position = __atomic_load_n(&queue->m_enqueue, __ATOMIC_RELAXED);
+    uint64_t value = 1;
+
+    if (size > queue->m_max_frame) {
+        errno = EMSGSIZE;
+        return -1;
+    }
+
+    for (;;) {
+        int64_t difference = 0;
+
+        slot = get_slot_queue(queue, position);
+        difference = (int64_t)(__atomic_load_n(&slot->m_sequence, __ATOMIC_ACQUIRE) - position);
+
+        if (difference == 0) {
+            if (__atomic_compare_exchange_n(&queue->m_enqueue, &position, position + 1, \
+                    true, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+                break;
+        } else if (difference < 0) {
+            __atomic_fetch_add(&queue->m_full, 1, __ATOMIC_RELAXED);
+            errno = EAGAIN;
+            return -1;
+        } else {
+            position = __atomic_load_n(&queue->m_enqueue, __ATOMIC_RELAXED);
+        }
+    }
+
+    memcpy(slot + 1, frame, size);
+    slot->m_size = size;
+    slot->m_stamp = begin_udp_stage();
+    __atomic_store_n(&slot->m_sequence, position + 1, __ATOMIC_SEQ_CST);
+
+    if (__atomic_load_n(&queue->m_sleeping, __ATOMIC_SEQ_CST) && \
+            write(queue->m_fd_event, &value, sizeof(value)) < 0 && errno != EAGAIN)
+        perror("ERROR: write not eventfd");
+
+    return 0;
+}
+
+ssize_t submit_udp_queue(udp_queue_t queue, udp_pack_t pack) {
+    uint64_t begin = 0;
+
+    if (!(pack->m_flags & FLAG_RESOLVED_UDP_PACK))
+        resolve_mac_address_udp_pack(pack);
+
+    begin = begin_udp_stage();
+    calculate_checksum_udp_pack(pack);
+    end_udp_stage(CHECKSUM_STAGE, begin);
+
+    return submit_frame_udp_queue(queue, get_pack_udp_pack(pack), \
+            get_size_pack_udp_pack(pack));
+}
+
+/**
+ * @ingroup UdpQueue
+ * @brief Function send all submitted frames and wait end of sender thread.
+ * @param[in,out] queue Queue.
+ * @note This function is private. Not used outside udp_lib/queue.c
+ */
+static void stop_queue(udp_queue_t queue) {
+    uint64_t value = 1;
+
+    if (queue->m_is_joined)
+        return;
+
+    __atomic_store_n(&queue->m_stop, 1, __ATOMIC_SEQ_CST);
+    if (write(queue->m_fd_event, &value, sizeof(value)) < 0 && errno != EAGAIN)
+        perror("ERROR: write not eventfd");
+
+    pthread_join(queue->m_thread, NULL);
+    queue->m_is_joined = true;
+}
+
+void destroy_udp_queue(udp_queue_t queue) {
+    if (queue == NULL)
+        return;
+    stop_queue(queue);
+    close(queue->m_fd_event);
+    destroy_udp_sender(queue->m_sender);
+    free(queue->m_slots);
+    free(queue);
+}
+
+/**
+ * @ingroup UdpQueue
+ * @brief Struct is work of one producer thread.
+ * @note This struct is private. Not used outside udp_lib/queue.c
+ */
+struct worker_queue {
+    udp_queue_t m_queue; /**< Queue. */
+    const void * m_frame; /**< Ready frame, shared by all threads. */
+    size_t m_size; /**< Size frame. */
+    uint64_t m_count; /**< Count frames. */
+    pthread_t m_thread; /**< Thread. */
+};
+
+/**
+ * @ingroup UdpQueue
+ * @brief Function of producer thread, submit frame with waiting on full queue.
+ * @param[in] argument Work.
+ * @return NULL.
+ * @note This function is private. Not used outside udp_lib/queue.c
+ */
+static void * run_worker_queue(void * argument) {
+    struct worker_queue * worker = argument;
+
+    for (uint64_t i = 0; i < worker->m_count; i++) {
+        while (submit_frame_udp_queue(worker->m_queue, worker->m_frame, worker->m_size))
+            sched_yield();
+    }
+
+    return NULL;
+}
+
+ssize_t run_queue_udp_pack(udp_pack_t pack, const size_t threads, const uint64_t count) {
+    ssize_t ret = 0;
+    struct worker_queue * workers = NULL;
+    udp_queue_t queue = NULL;
+    uint64_t start = 0;
+    double seconds = 0.0;
+    size_t started = 0;
+
+    if (threads == 0 || threads > MAX_THREADS_QUEUE) {
+        ret = -1;
+        fputs("ERROR: count threads is out of range\n", stderr);
+        goto wrong_threads;
+    }
+
+    workers = calloc(threads, sizeof(*workers));
+    if (workers == NULL) {
+        ret = -1;
+        goto get_not_memory;
+    }
+
+    queue = init_udp_queue(pack, DEFAULT_CAPACITY_QUEUE);
+    if (queue == NULL) {
+        ret = -1;
+        goto get_not_queue;
+    }
+
+    if (!(pack->m_flags & FLAG_RESOLVED_UDP_PACK))
+        resolve_mac_address_udp_pack(pack);
+    calculate_checksum_udp_pack(pack);
+
+    if (get_size_pack_udp_pack(pack) > queue->m_max_frame) {
+        ret = -1;
+        fputs("ERROR: package is bigger than MTU\n", stderr);
+        goto big_pack;
+    }
+
+    start = now_clock();
+
+    for (; started < threads; started++) {
+        workers[started].m_queue = queue;
+        workers[started].m_frame = get_pack_udp_pack(pack);
+        workers[started].m_size = get_size_pack_udp_pack(pack);
+        workers[started].m_count = count;
+        if (pthread_create(&workers[started].m_thread, NULL, run_worker_queue, \
+                &workers[started])) {
+            ret = -1;
+            perror("ERROR: start not thread");
+            break;
+        }
+    }
+
+    for (size_t i = 0; i < started; i++)
+        pthread_join(workers[i].m_thread, NULL);
+    stop_queue(queue);
+    if (finish_udp_sender(queue->m_sender))
+        ret = -1;
+
+    seconds = (now_clock() - start) / (double)NSEC_CLOCK;
+
+    printf("queue threads: %zu sended: %lu errors: %lu full: %lu seconds: %.3f " \
+            "rate: %.0f pps\n", started, queue->m_sended, queue->m_errors, \
+            queue->m_full, seconds, seconds > 0.0 ? queue->m_sended / seconds : 0.0);
+    print_stats_udp_sender(queue->m_sender);
+
+big_pack:
+    destroy_udp_queue(queue);
+get_not_queue:
+    free(workers);
+get_not_memory:
+wrong_threads:
+    return ret;
+}
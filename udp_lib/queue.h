@@ -0,0 +1,111 @@
+/**
+ * @file udp_lib/queue.h
+ * @author Vladsanin777
+ * @brief Header file for thread safe queue of frames with one sender thread.
+ */
+
+#ifndef UDP_LIB_QUEUE_H
+#define UDP_LIB_QUEUE_H
+
+#include "udp_lib/udp.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+
+/**
+ * @defgroup UdpQueue queue for udp
+ * @brief Group function for send from many threads through one sender.
+ *
+ * Queue is bounded lock-free multi producer single consumer ring of slots.
+ * Any thread copies ready frame in free slot, one sender thread takes ready
+ * slots in order and sends them by batches. Full queue is not waited:
+ * submit returns -1 with errno EAGAIN, so producer decides to drop, retry
+ * or slow down.
+ * @{
+ */
+
+/** Default count slots of queue. */
+#define DEFAULT_CAPACITY_QUEUE 4096
+
+/**
+ * @brief Private struct queue. (Hidden implementation)
+ */
+struct udp_queue;
+
+/**
+ * @brief Pointer on private struct queue.
+ */
+typedef struct udp_queue * udp_queue_t;
+
+/**
+ * @brief Function create queue and start sender thread.
+ * @note You must call @ref destroy_udp_queue after this.
+ * @param[in] pack UDP package, its interface or output file is used by sender.
+ * @param[in] capacity Count slots, rounded up to power of two.
+ * @return Queue or NULL on error.
+ * Usage example.
+ * @code
+ * udp_queue_t queue = init_udp_queue(pack, DEFAULT_CAPACITY_QUEUE);
+ * if (queue == NULL)
+ *     goto get_not_queue;
+ * @endcode
+ */
+udp_queue_t init_udp_queue(udp_pack_t pack, const size_t capacity);
+
+/**
+ * @brief Function put ready frame in queue, safe from any thread.
+ * @param[in,out] queue Queue.
+ * @param[in] frame Frame from ethernet header.
+ * @param[in] size Size frame, not bigger than MTU of sender and ethernet header.
+ * @return 0 or -1 with errno EAGAIN if queue is full, EMSGSIZE if frame is too big.
+ * Usage example.
+ * @code
+ * while (submit_frame_udp_queue(queue, frame, size))
+ *     sched_yield();
+ * @endcode
+ */
+ssize_t submit_frame_udp_queue(udp_queue_t queue, const void * const frame, \
+        const size_t size);
+
+/**
+ * @brief Function put UDP package in queue, safe from any thread with own package.
+ *
+ * Mac addresses are resolved and checksum is calculated in calling thread,
+ * so sender thread only sends.
+ * @param[in,out] queue Queue.
+ * @param[in,out] pack UDP package of calling thread.
+ * @return 0 or -1 with errno EAGAIN if queue is full, EMSGSIZE if package is above MTU.
+ * Usage example.
+ * @code
+ * ret = submit_udp_queue(queue, pack);
+ * if (ret && errno == EAGAIN)
+ *     dropped++;
+ * @endcode
+ */
+ssize_t submit_udp_queue(udp_queue_t queue, udp_pack_t pack);
+
+/**
+ * @brief Function send all submitted frames, stop sender thread and free queue.
+ * @param[in] queue Queue.
+ */
+void destroy_udp_queue(udp_queue_t queue);
+
+/**
+ * @brief Function send UDP package from many threads through one queue.
+ * @note You must call @ref init_udp_pack and @ref set_interface_udp_pack before this.
+ * @param[in,out] pack UDP package to send.
+ * @param[in] threads Count producer threads.
+ * @param[in] count Count packages of every thread.
+ * @return 0 or -1 on error.
+ * Usage example.
+ * @code
+ * ret = run_queue_udp_pack(pack, 4, 100000);
+ * if (ret)
+ *     goto run_not_queue;
+ * @endcode
+ */
+ssize_t run_queue_udp_pack(udp_pack_t pack, const size_t threads, const uint64_t count);
+
+/** @} */
+
+#endif /* UDP_LIB_QUEUE_H */
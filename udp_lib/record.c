@@ -0,0 +1,216 @@
+/**
+ * @file udp_lib/record.c
+ * @author Vladsanin777
+ * @brief Code file for parser of records of text files shared by scenario and flows.
+ */
+
+#include "udp_lib/record_private.h"
+#include "udp_lib/udp_private.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+
+/**
+ * @ingroup UdpRecord
+ * @brief Struct is setter of package for common key.
+ * @note This struct is private. Not used outside udp_lib/record.c
+ */
+struct setter_record {
+    const char * m_key; /**< Key. */
+    ssize_t (*m_set)(udp_pack_t pack, const char * const value); /**< Setter. */
+};
+
+/** Common keys set directly in package. */
+static const struct setter_record setters_record[] = {
+    {"mac-address-source", set_mac_address_source_udp_pack},
+    {"mac-address-destantion", set_mac_address_destantion_udp_pack},
+    {"port-source", set_port_source_udp_pack},
+    {"port-destanition", set_port_destantion_udp_pack},
+};
+
+/**
+ * @ingroup UdpRecord
+ * @brief Function check char divides fields.
+ * @param[in] symbol Char.
+ * @return true if space.
+ * @note This function is private. Not used outside udp_lib/record.c
+ */
+static inline bool is_space_record(const char symbol) {
+    return symbol == ' ' || symbol == '\t' || symbol == '\r';
+}
+
+ssize_t read_udp_record(const char * const file, const char * const kind, \
+        const udp_record_line_t line, void * const context) {
+    ssize_t ret = 0;
+    int fd = -1;
+    struct stat info;
+    const char * map = NULL;
+    const char * start = NULL;
+    size_t number = 0;
+
+    fd = open(file, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        ret = -1;
+        fprintf(stderr, "ERROR: open not %s: %s\n", kind, strerror(errno));
+        goto open_not_file;
+    }
+
+    if (fstat(fd, &info)) {
+        ret = -1;
+        fprintf(stderr, "ERROR: stat not %s: %s\n", kind, strerror(errno));
+        goto stat_not_file;
+    }
+
+    if (info.st_size == 0)
+        goto empty_file;
+
+    map = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (map == MAP_FAILED) {
+        ret = -1;
+        fprintf(stderr, "ERROR: map not %s: %s\n", kind, strerror(errno));
+        goto map_not_file;
+    }
+    madvise((void *)map, info.st_size, MADV_SEQUENTIAL);
+
+    start = map;
+    while (start < map + info.st_size) {
+        const char * end = memchr(start, '\n', map + info.st_size - start);
+
+        if (end == NULL)
+            end = map + info.st_size;
+        number++;
+
+        ret = line(context, start, end);
+        if (ret) {
+            fprintf(stderr, "ERROR: %s %s line %zu is wrong\n", kind, file, number);
+            break;
+        }
+
+        start = end + 1;
+    }
+
+    munmap((void *)map, info.st_size);
+map_not_file:
+empty_file:
+stat_not_file:
+    close(fd);
+open_not_file:
+    return ret;
+}
+
+ssize_t next_field_udp_record(const char ** const line, const char * const end, \
+        struct udp_field * const field) {
+    const char * current = *line;
+
+    memset(field, 0x00, sizeof(*field));
+
+    while (current < end && is_space_record(*current))
+        current++;
+    if (current == end || *current == '#') {
+        *line = end;
+        return 0;
+    }
+
+    field->m_key = current;
+    while (current < end && *current != '=' && !is_space_record(*current))
+        current++;
+    field->m_size_key = current - field->m_key;
+
+    if (current < end && *current == '=') {
+        current++;
+        if (current < end && *current == '"') {
+            field->m_is_quoted = true;
+            field->m_value = ++current;
+            while (current < end && *current != '"') {
+                if (*current == '\\' && current + 1 < end)
+                    current++;
+                current++;
+            }
+            if (current == end)
+                return -1;
+            field->m_size_value = current++ - field->m_value;
+        } else {
+            field->m_value = current;
+            while (current < end && !is_space_record(*current))
+                current++;
+            field->m_size_value = current - field->m_value;
+        }
+    }
+
+    *line = current;
+
+    return 1;
+}
+
+bool is_key_udp_record(const struct udp_field * const field, const char * const name) {
+    return strlen(name) == field->m_size_key && \
+            memcmp(field->m_key, name, field->m_size_key) == 0;
+}
+
+ssize_t copy_value_udp_record(char * const buffer, const size_t size_buffer, \
+        const struct udp_field * const field) {
+    if (field->m_size_value >= size_buffer)
+        return -1;
+
+    memcpy(buffer, field->m_value, field->m_size_value);
+    buffer[field->m_size_value] = '\0';
+
+    return 0;
+}
+
+void begin_udp_record(struct udp_record * const record, udp_pack_t pack) {
+    record->m_family = pack->m_family;
+    record->m_ip_source[0] = '\0';
+    record->m_ip_destantion[0] = '\0';
+}
+
+ssize_t apply_udp_record(struct udp_record * const record, udp_pack_t pack, \
+        const struct udp_field * const field) {
+    if (field->m_value == NULL) {
+        if (is_key_udp_record(field, "ipv4"))
+            record->m_family = AF_INET;
+        else if (is_key_udp_record(field, "ipv6"))
+            record->m_family = AF_INET6;
+        else
+            return 1;
+        return 0;
+    }
+
+    if (is_key_udp_record(field, "ip-address-source"))
+        return copy_value_udp_record(record->m_ip_source, SIZE_ADDRESS_RECORD, field);
+    if (is_key_udp_record(field, "ip-address-destination"))
+        return copy_value_udp_record(record->m_ip_destantion, SIZE_ADDRESS_RECORD, field);
+
+    for (size_t i = 0; i < sizeof(setters_record) / sizeof(*setters_record); i++) {
+        if (!is_key_udp_record(field, setters_record[i].m_key))
+            continue;
+        if (copy_value_udp_record(record->m_value, SIZE_VALUE_RECORD, field))
+            return -1;
+        return setters_record[i].m_set(pack, record->m_value);
+    }
+
+    return 1;
+}
+
+ssize_t end_udp_record(const struct udp_record * const record, udp_pack_t pack) {
+    if (set_family_udp_pack(pack, record->m_family))
+        return -1;
+    if (record->m_ip_source[0] && \
+            set_ip_address_source_udp_pack(pack, record->m_ip_source))
+        return -1;
+    if (record->m_ip_destantion[0] && \
+            set_ip_address_destantion_udp_pack(pack, record->m_ip_destantion))
+        return -1;
+
+    return 0;
+}
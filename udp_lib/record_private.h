@@ -0,0 +1,133 @@
+/**
+ * @file udp_lib/record_private.h
+ * @author Vladsanin777
+ * @brief Private parser of records of text files shared by scenario and flows.
+ * @note This header is private. Not used outside udp_lib.
+ */
+
+#ifndef UDP_LIB_RECORD_PRIVATE_H
+#define UDP_LIB_RECORD_PRIVATE_H
+
+#include "udp_lib/udp.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+
+/**
+ * @defgroup UdpRecord record for udp
+ * @brief Group function for parse lines of scenario and flows files.
+ *
+ * One line is one record: fields `key=value` or `key="value"` divided by
+ * spaces, flag `key` without value, `#` start comment. Fields common for
+ * both files are applied to package here, own fields stay for caller.
+ * @{
+ */
+
+/** Max size value of field except data. */
+#define SIZE_VALUE_RECORD 4096
+
+/** Max size address in text. */
+#define SIZE_ADDRESS_RECORD 64
+
+/**
+ * @brief Struct is one field of line, pointers are in line without zero.
+ * @note This struct is private. Not used outside udp_lib.
+ */
+struct udp_field {
+    const char * m_key; /**< Key. */
+    size_t m_size_key; /**< Size key. */
+    const char * m_value; /**< Value without quotes, NULL for flag. */
+    size_t m_size_value; /**< Size value. */
+    bool m_is_quoted; /**< Value was in quotes, escapes are not decoded. */
+};
+
+/**
+ * @brief Struct is common fields of current record.
+ * @note This struct is private. Not used outside udp_lib.
+ */
+struct udp_record {
+    int m_family; /**< Family of record. */
+    char m_value[SIZE_VALUE_RECORD]; /**< Value current field with zero in end. */
+    char m_ip_source[SIZE_ADDRESS_RECORD]; /**< Source address current record. */
+    char m_ip_destantion[SIZE_ADDRESS_RECORD]; /**< Destantion address current record. */
+};
+
+/**
+ * @brief Function called for every line of file.
+ * @param[in,out] context Context of caller.
+ * @param[in] line Start line.
+ * @param[in] end End line, without '\n'.
+ * @return 0 or -1 on error.
+ */
+typedef ssize_t (*udp_record_line_t)(void * const context, const char * line, \
+        const char * const end);
+
+/**
+ * @brief Function map file and call function for every line.
+ * @param[in] file Path to file.
+ * @param[in] kind Name of file in errors, "scenario" or "flows".
+ * @param[in] line Function for one line.
+ * @param[in,out] context Context for function.
+ * @return 0 or -1 on error, number of wrong line is printed.
+ */
+ssize_t read_udp_record(const char * const file, const char * const kind, \
+        const udp_record_line_t line, void * const context);
+
+/**
+ * @brief Function take next field of line.
+ * @param[in,out] line Current place in line, moved after field.
+ * @param[in] end End line.
+ * @param[out] field Field.
+ * @return 1 if field is taken, 0 on end of line or comment, -1 on not closed quote.
+ */
+ssize_t next_field_udp_record(const char ** const line, const char * const end, \
+        struct udp_field * const field);
+
+/**
+ * @brief Function compare key of field with name.
+ * @param[in] field Field.
+ * @param[in] name Name to compare.
+ * @return true if same.
+ */
+bool is_key_udp_record(const struct udp_field * const field, const char * const name);
+
+/**
+ * @brief Function copy value of field in buffer with zero in end.
+ * @param[out] buffer Buffer.
+ * @param[in] size_buffer Size buffer.
+ * @param[in] field Field with value.
+ * @return 0 or -1 if value is too long.
+ */
+ssize_t copy_value_udp_record(char * const buffer, const size_t size_buffer, \
+        const struct udp_field * const field);
+
+/**
+ * @brief Function start new record from family of package.
+ * @param[out] record Record.
+ * @param[in] pack UDP package.
+ */
+void begin_udp_record(struct udp_record * const record, udp_pack_t pack);
+
+/**
+ * @brief Function apply common field: `ipv4`, `ipv6`, addresses, mac addresses and ports.
+ * @note Addresses are kept in record until @ref end_udp_record, family can be after them.
+ * @param[in,out] record Record.
+ * @param[in,out] pack UDP package.
+ * @param[in] field Field.
+ * @return 0 if applied, 1 if key is not common, -1 on error.
+ */
+ssize_t apply_udp_record(struct udp_record * const record, udp_pack_t pack, \
+        const struct udp_field * const field);
+
+/**
+ * @brief Function write family and addresses of record in package.
+ * @param[in] record Record.
+ * @param[in,out] pack UDP package.
+ * @return 0 or -1 on error.
+ */
+ssize_t end_udp_record(const struct udp_record * const record, udp_pack_t pack);
+
+/** @} */
+
+#endif /* UDP_LIB_RECORD_PRIVATE_H */
@@ -0,0 +1,800 @@
+/**
+ * @file udp_lib/replay.c
+ * @author Vladsanin777
+ * @brief Code file for replay pcap and pcapng captures.
+ */
+
+#include "udp_lib/replay.h"
+#include "udp_lib/udp_private.h"
+#include "udp_lib/sender.h"
+#include "udp_lib/neigh.h"
+#include "udp_lib/clock_private.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+#include <byteswap.h>
+
+#include <arpa/inet.h>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <sys/prctl.h>
+
+#include <netinet/in.h>
+
+/** Magic pcap with timestamps in microseconds. */
+#define MAGIC_MICRO_PCAP 0xA1B2C3D4U
+
+/** Magic pcap with timestamps in nanoseconds. */
+#define MAGIC_NANO_PCAP 0xA1B23C4DU
+
+/** Size header pcap file. */
+#define HEAD_FILE_PCAP 24
+
+/** Size header pcap record. */
+#define HEAD_RECORD_PCAP 16
+
+/** Type block section header pcapng, same in both byte orders. */
+#define TYPE_SECTION_PCAPNG 0x0A0D0D0AU
+
+/** Type block interface description pcapng. */
+#define TYPE_INTERFACE_PCAPNG 0x00000001U
+
+/** Type block simple packet pcapng. */
+#define TYPE_SIMPLE_PCAPNG 0x00000003U
+
+/** Type block enhanced packet pcapng. */
+#define TYPE_ENHANCED_PCAPNG 0x00000006U
+
+/** Magic byte order in section header pcapng. */
+#define MAGIC_ORDER_PCAPNG 0x1A2B3C4DU
+
+/** Option resolution timestamps in interface description pcapng. */
+#define OPTION_TSRESOL_PCAPNG 9
+
+/** Link type ethernet. */
+#define LINK_ETHERNET_REPLAY 1
+
+/** Link type raw IP, value used by some systems. */
+#define LINK_RAW_OLD_REPLAY 12
+
+/** Link type raw IP. */
+#define LINK_RAW_REPLAY 101
+
+/** Link type Linux cooked capture. */
+#define LINK_SLL_REPLAY 113
+
+/** Link type raw IPv4. */
+#define LINK_IPV4_REPLAY 228
+
+/** Link type raw IPv6. */
+#define LINK_IPV6_REPLAY 229
+
+/** Link type Linux cooked capture version 2. */
+#define LINK_SLL2_REPLAY 276
+
+/** Size header Linux cooked capture. */
+#define HEAD_SLL_REPLAY 16
+
+/** Size header Linux cooked capture version 2. */
+#define HEAD_SLL2_REPLAY 20
+
+/** Size VLAN tag. */
+#define HEAD_VLAN_REPLAY 4
+
+/** Max interfaces in one section pcapng. */
+#define MAX_INTERFACES_REPLAY 64
+
+/** Max frames in one batch. */
+#define BATCH_REPLAY 64
+
+/** Max size copied headers of one frame. */
+#define MAX_HEAD_REPLAY 128
+
+/** Bytes of TCP header up to checksum included. */
+#define HEAD_TCP_CHECK_REPLAY 18
+
+/**
+ * @ingroup UdpReplay
+ * @brief Struct is interface from pcapng section.
+ * @note This struct is private. Not used outside udp_lib/replay.c
+ */
+struct interface_replay {
+    uint16_t m_link; /**< Link type. */
+    uint8_t m_power; /**< Resolution timestamps is base ^ -power seconds. */
+    bool m_binary; /**< Base resolution is 2, else 10. */
+};
+
+/**
+ * @ingroup UdpReplay
+ * @brief Struct is reader mapped capture.
+ * @note This struct is private. Not used outside udp_lib/replay.c
+ */
+struct reader_replay {
+    const uint8_t * m_map; /**< Mapped file. */
+    size_t m_size; /**< Size file. */
+    size_t m_offset; /**< Offset next record. */
+    size_t m_start; /**< Offset first record. */
+    bool m_pcapng; /**< File is pcapng. */
+    bool m_swap; /**< Byte order file differ from host. */
+    bool m_nano; /**< Timestamps pcap in nanoseconds. */
+    uint16_t m_link; /**< Link type pcap. */
+    size_t m_count_interfaces; /**< Count interfaces current section pcapng. */
+    struct interface_replay m_interfaces[MAX_INTERFACES_REPLAY]; /**< Interfaces current section pcapng. */
+};
+
+/**
+ * @ingroup UdpReplay
+ * @brief Struct is one frame from capture, pointed into mapping.
+ * @note This struct is private. Not used outside udp_lib/replay.c
+ */
+struct frame_replay {
+    const uint8_t * m_data; /**< Captured bytes. */
+    uint32_t m_size; /**< Count captured bytes. */
+    uint32_t m_size_original; /**< Size frame on wire. */
+    uint16_t m_link; /**< Link type. */
+    bool m_has_time; /**< Record has timestamp. */
+    uint64_t m_time; /**< Timestamp in nanoseconds. */
+};
+
+/**
+ * @ingroup UdpReplay
+ * @brief Struct is state of replay.
+ * @note This struct is private. Not used outside udp_lib/replay.c
+ */
+struct state_replay {
+    udp_pack_t m_pack; /**< Template with new values. */
+    uint32_t m_rewrite; /**< Flags REWRITE_*_REPLAY. */
+    size_t m_max_size; /**< Max size frame, MTU and ethernet header. */
+    size_t m_pending; /**< Frames in batch. */
+    uint64_t m_sended; /**< Sended frames. */
+    uint64_t m_bytes; /**< Sended bytes. */
+    uint64_t m_errors; /**< Frames not sended. */
+    uint64_t m_skipped; /**< Frames with unknown link, truncated or bigger than MTU. */
+    uint8_t m_heads[BATCH_REPLAY][MAX_HEAD_REPLAY]; /**< Copied headers frames in batch. */
+    struct iovec m_parts[BATCH_REPLAY][2]; /**< Headers and rest of frames in batch. */
+};
+
+/**
+ * @ingroup UdpReplay
+ * @brief Function read 16 bits in byte order of file.
+ * @param[in] reader Reader for work.
+ * @param[in] ptr Pointer in mapping.
+ * @return Value in host order.
+ * @note This function is private. Not used outside udp_lib/replay.c
+ */
+static uint16_t read_16_replay(const struct reader_replay * const reader, \
+        const uint8_t * const ptr) {
+    uint16_t value;
+
+    memcpy(&value, ptr, sizeof(value));
+
+    return reader->m_swap ? bswap_16(value) : value;
+}
+
+/**
+ * @ingroup UdpReplay
+ * @brief Function read 32 bits in byte order of file.
+ * @param[in] reader Reader for work.
+ * @param[in] ptr Pointer in mapping.
+ * @return Value in host order.
+ * @note This function is private. Not used outside udp_lib/replay.c
+ */
+static uint32_t read_32_replay(const struct reader_replay * const reader, \
+        const uint8_t * const ptr) {
+    uint32_t value;
+
+    memcpy(&value, ptr, sizeof(value));
+
+    return reader->m_swap ? bswap_32(value) : value;
+}
+
+/**
+ * @ingroup UdpReplay
+ * @brief Function check format file and read header.
+ * @param[in,out] reader Reader with mapped file.
+ * @return 0 or -1 if file is not pcap or pcapng.
+ * @note This function is private. Not used outside udp_lib/replay.c
+ */
+static ssize_t open_reader_replay(struct reader_replay * const reader) {
+    uint32_t magic = 0;
+
+    if (reader->m_size < HEAD_FILE_PCAP)
+        return -1;
+
+    memcpy(&magic, reader->m_map, sizeof(magic));
+
+    /* Section header is parsed as usual block, it give byte order. */
+    if (magic == TYPE_SECTION_PCAPNG) {
+        reader->m_pcapng = true;
+        reader->m_start = 0;
+        reader->m_offset = 0;
+        return 0;
+    }
+
+    if (magic == MAGIC_MICRO_PCAP || magic == MAGIC_NANO_PCAP) {
+        reader->m_swap = false;
+    } else if (bswap_32(magic) == MAGIC_MICRO_PCAP || \
+            bswap_32(magic) == MAGIC_NANO_PCAP) {
+        reader->m_swap = true;
+        magic = bswap_32(magic);
+    } else {
+        return -1;
+    }
+
+    reader->m_nano = magic == MAGIC_NANO_PCAP;
+    reader->m_link = read_32_replay(reader, reader->m_map + 20) & 0xFFFF;
+    reader->m_start = HEAD_FILE_PCAP;
+    reader->m_offset = HEAD_FILE_PCAP;
+
+    return 0;
+}
+
+/**
+ * @ingroup UdpReplay
+ * @brief Function convert timestamp pcapng in nanoseconds.
+ * @param[in] interface Interface of record.
+ * @param[in] ticks Timestamp in units of interface.
+ * @return Timestamp in nanoseconds.
+ * @note This function is private. Not used outside udp_lib/replay.c
+ */
+static uint64_t nanoseconds_replay(const struct interface_replay * const interface, \
+        const uint64_t ticks) {
+    uint64_t divider = 1;
+
+    if (interface->m_binary)
+        return (uint64_t)(((__uint128_t)ticks * NSEC_CLOCK) >> interface->m_power);
+
+    if (interface->m_power <= 9) {
+        uint64_t multiplier = 1;
+        for (uint8_t i = interface->m_power; i < 9; i++)
+            multiplier *= 10;
+        return ticks * multiplier;
+    }
+
+    for (uint8_t i = 9; i < interface->m_power && i < 28; i++)
+        divider *= 10;
+
+    return ticks / divider;
+}
+
+/**
+ * @ingroup UdpReplay
+ * @brief Function read interface description pcapng.
+ * @param[in,out] reader Reader for work.
+ * @param[in] body Body block.
+ * @param[in] size Size body.
+ * @note This function is private. Not used outside udp_lib/replay.c
+ */
+static void add_interface_replay(struct reader_replay * const reader, \
+        const uint8_t * const body, const size_t size) {
+    struct interface_replay interface = {.m_power = 6};
+    size_t offset = 8;
+
+    if (size < offset || reader->m_count_interfaces >= MAX_INTERFACES_REPLAY)
+        return;
+
+    interface.m_link = read_16_replay(reader, body);
+
+    while (offset + 4 <= size) {
+        uint16_t code = read_16_replay(reader, body + offset);
+        uint16_t length = read_16_replay(reader, body + offset + 2);
+
+        if (code == 0 || offset + 4 + length > size)
+            break;
+        if (code == OPTION_TSRESOL_PCAPNG && length >= 1) {
+            interface.m_binary = body[offset + 4] & 0x80;
+            interface.m_power = body[offset + 4] & 0x7F;
+        }
+        offset += 4 + ((length + 3) & ~3U);
+    }
+
+    reader->m_interfaces[reader->m_count_interfaces++] = interface;
+}
+
+/**
+ * @ingroup UdpReplay
+ * @brief Function get next frame from pcap.
+ * @param[in,out] reader Reader for work.
+ * @param[out] frame Frame.
+ * @return 1 frame, 0 end file or -1 on broken file.
+ * @note This function is private. Not used outside udp_lib/replay.c
+ */
+static ssize_t next_pcap_replay(struct reader_replay * const reader, \
+        struct frame_replay * const frame) {
+    const uint8_t * record = reader->m_map + reader->m_offset;
+    uint32_t fraction = 0;
+
+    if (reader->m_offset + HEAD_RECORD_PCAP > reader->m_size)
+        return 0;
+
+    frame->m_size = read_32_replay(reader, record + 8);
+    frame->m_size_original = read_32_replay(reader, record + 12);
+
+    if (frame->m_size > reader->m_size - reader->m_offset - HEAD_RECORD_PCAP)
+        return -1;
+
+    fraction = read_32_replay(reader, record + 4);
+    frame->m_time = read_32_replay(reader, record) * NSEC_CLOCK + \
+            (reader->m_nano ? fraction : fraction * 1000ULL);
+    frame->m_has_time = true;
+    frame->m_link = reader->m_link;
+    frame->m_data = record + HEAD_RECORD_PCAP;
+    reader->m_offset += HEAD_RECORD_PCAP + frame->m_size;
+
+    return 1;
+}
+
+/**
+ * @ingroup UdpReplay
+ * @brief Function get next frame from pcapng, other blocks are skipped.
+ * @param[in,out] reader Reader for work.
+ * @param[out] frame Frame.
+ * @return 1 frame, 0 end file or -1 on broken file.
+ * @note This function is private. Not used outside udp_lib/replay.c
+ */
+static ssize_t next_pcapng_replay(struct reader_replay * const reader, \
+        struct frame_replay * const frame) {
+    while (reader->m_offset + 12 <= reader->m_size) {
+        const uint8_t * block = reader->m_map + reader->m_offset;
+        const uint8_t * body = block + 8;
+        uint32_t type = 0;
+        uint32_t length = 0;
+        size_t size = 0;
+
+        memcpy(&type, block, sizeof(type));
+
+        if (type == TYPE_SECTION_PCAPNG) {
+            uint32_t magic = 0;
+
+            memcpy(&magic, body, sizeof(magic));
+            if (magic == MAGIC_ORDER_PCAPNG)
+                reader->m_swap = false;
+            else if (bswap_32(magic) == MAGIC_ORDER_PCAPNG)
+                reader->m_swap = true;
+            else
+                return -1;
+            reader->m_count_interfaces = 0;
+        }
+
+        type = read_32_replay(reader, block);
+        length = read_32_replay(reader, block + 4);
+
+        if (length < 12 || (length & 3) || length > reader->m_size - reader->m_offset)
+            return -1;
+
+        size = length - 12;
+        reader->m_offset += length;
+
+        if (type == TYPE_INTERFACE_PCAPNG) {
+            add_interface_replay(reader, body, size);
+        } else if (type == TYPE_ENHANCED_PCAPNG && size >= 20) {
+            uint32_t interface = read_32_replay(reader, body);
+
+            if (interface >= reader->m_count_interfaces)
+                continue;
+
+            frame->m_size = read_32_replay(reader, body + 12);
+            frame->m_size_original = read_32_replay(reader, body + 16);
+            if (frame->m_size > size - 20)
+                return -1;
+            frame->m_data = body + 20;
+            frame->m_link = reader->m_interfaces[interface].m_link;
+            frame->m_has_time = true;
+            frame->m_time = nanoseconds_replay(&reader->m_interfaces[interface], \
+                    ((uint64_t)read_32_replay(reader, body + 4) << 32) | \
+                    read_32_replay(reader, body + 8));
+            return 1;
+        } else if (type == TYPE_SIMPLE_PCAPNG && size >= 4 && \
+                reader->m_count_interfaces) {
+            frame->m_size_original = read_32_replay(reader, body);
+            frame->m_size = MIN(frame->m_size_original, size - 4);
+            frame->m_data = body + 4;
+            frame->m_link = reader->m_interfaces[0].m_link;
+            frame->m_has_time = false;
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * @ingroup UdpReplay
+ * @brief Function update checksum after change of field by RFC 1624.
+ * @param[in,out] check Checksum in network order, NULL if absent.
+ * @param[in] old Old value field.
+ * @param[in] new New value field.
+ * @param[in] size Size field, even.
+ * @param[in] is_udp Zero is written as 0xFFFF, because zero is no checksum in UDP.
+ * @note This function is private. Not used outside udp_lib/replay.c
+ */
+static void fixup_checksum_replay(uint8_t * const check, const uint8_t * const old, \
+        const uint8_t * const new, const size_t size, const bool is_udp) {
+    uint32_t sum = 0;
+    uint16_t result = 0;
+
+    if (check == NULL)
+        return;
+
+    sum = (uint16_t)~((check[0] << 8) | check[1]);
+    for (size_t i = 0; i < size; i += 2) {
+        sum += (uint16_t)~((old[i] << 8) | old[i + 1]);
+        sum += (new[i] << 8) | new[i + 1];
+    }
+    while (sum >> 16)
+        sum = (sum & 0xFFFF) + (sum >> 16);
+
+    result = ~sum;
+    if (is_udp && result == 0)
+        result = 0xFFFF;
+
+    check[0] = result >> 8;
+    check[1] = result & 0xFF;
+}
+
+/**
+ * @ingroup UdpReplay
+ * @brief Function replace field in headers and update checksums.
+ * @param[in,out] field Field in copied headers.
+ * @param[in] value New value.
+ * @param[in] size Size field.
+ * @param[in,out] check_ip Checksum IPv4 header or NULL.
+ * @param[in,out] check_l4 Checksum UDP or TCP or NULL.
+ * @param[in] is_udp Checksum L4 is UDP.
+ * @note This function is private. Not used outside udp_lib/replay.c
+ */
+static void replace_replay(uint8_t * const field, const void * const value, \
+        const size_t size, uint8_t * const check_ip, uint8_t * const check_l4, \
+        const bool is_udp) {
+    fixup_checksum_replay(check_ip, field, value, size, false);
+    fixup_checksum_replay(check_l4, field, value, size, is_udp);
+    memcpy(field, value, size);
+}
+
+/**
+ * @ingroup UdpReplay
+ * @brief Function rewrite addresses and ports in copied IP and L4 headers.
+ * @param[in] state State replay with template.
+ * @param[in,out] l3 Copied IP header.
+ * @param[in] size Count copied bytes from IP header.
+ * @param[in] proto Ethernet type in network order.
+ * @note This function is private. Not used outside udp_lib/replay.c
+ */
+static void rewrite_l3_replay(const struct state_replay * const state, \
+        uint8_t * const l3, const size_t size, const uint16_t proto) {
+    udp_pack_t pack = state->m_pack;
+    uint8_t * check_ip = NULL;
+    uint8_t * check_l4 = NULL;
+    uint8_t * l4 = NULL;
+    uint8_t * source = NULL;
+    uint8_t * destantion = NULL;
+    const void * new_source = NULL;
+    const void * new_destantion = NULL;
+    size_t size_address = 0;
+    uint8_t protocol = 0;
+    bool is_family = false;
+
+    if (proto == htons(ETH_P_IP) && size >= HEAD_IP && (l3[0] >> 4) == 4) {
+        size_t size_head = (l3[0] & 0x0F) * 4;
+
+        if (size_head < HEAD_IP || size_head > size)
+            return;
+        check_ip = l3 + 10;
+        source = l3 + 12;
+        destantion = l3 + 16;
+        size_address = sizeof(struct in_addr);
+        protocol = l3[9];
+        is_family = pack->m_family == AF_INET;
+        new_source = &pack->m_iphdr->saddr;
+        new_destantion = &pack->m_iphdr->daddr;
+        /* Only first fragment carries UDP or TCP header. */
+        if (((l3[6] << 8) | l3[7]) & 0x1FFF)
+            protocol = 0;
+        l4 = l3 + size_head;
+    } else if (proto == htons(ETH_P_IPV6) && size >= HEAD_IP6 && (l3[0] >> 4) == 6) {
+        source = l3 + 8;
+        destantion = l3 + 24;
+        size_address = sizeof(struct in6_addr);
+        protocol = l3[6];
+        is_family = pack->m_family == AF_INET6;
+        new_source = &pack->m_ip6hdr->ip6_src;
+        new_destantion = &pack->m_ip6hdr->ip6_dst;
+        l4 = l3 + HEAD_IP6;
+    } else {
+        return;
+    }
+
+    if (protocol == IPPROTO_UDP && (size_t)(l4 - l3) + HEAD_UDP <= size) {
+        check_l4 = l4 + 6;
+        /* Zero in IPv4 is no checksum, it stay zero. */
+        if (check_l4[0] == 0 && check_l4[1] == 0)
+            check_l4 = NULL;
+    } else if (protocol == IPPROTO_TCP && \
+            (size_t)(l4 - l3) + HEAD_TCP_CHECK_REPLAY <= size) {
+        check_l4 = l4 + 16;
+    } else {
+        l4 = NULL;
+    }
+
+    if (is_family && (state->m_rewrite & REWRITE_IP_SOURCE_REPLAY))
+        replace_replay(source, new_source, size_address, check_ip, check_l4, \
+                protocol == IPPROTO_UDP);
+    if (is_family && (state->m_rewrite & REWRITE_IP_DESTANTION_REPLAY))
+        replace_replay(destantion, new_destantion, size_address, check_ip, check_l4, \
+                protocol == IPPROTO_UDP);
+
+    if (l4 == NULL)
+        return;
+
+    if (state->m_rewrite & REWRITE_PORT_SOURCE_REPLAY)
+        replace_replay(l4, &pack->m_head->m_port_source, sizeof(uint16_t), \
+                NULL, check_l4, protocol == IPPROTO_UDP);
+    if (state->m_rewrite & REWRITE_PORT_DESTANTION_REPLAY)
+        replace_replay(l4 + 2, &pack->m_head->m_port_destantion, sizeof(uint16_t), \
+                NULL, check_l4, protocol == IPPROTO_UDP);
+}
+
+/**
+ * @ingroup UdpReplay
+ * @brief Function prepare pieces of frame in batch.
+ *
+ * Frame without rewrite and with ethernet link go as one piece straight
+ * from mapping. Else headers are copied in own buffer and rewritten,
+ * for not ethernet link ethernet header is made from template.
+ * @param[in,out] state State replay.
+ * @param[in] frame Frame from capture.
+ * @return 0 or -1 if frame is skipped.
+ * @note This function is private. Not used outside udp_lib/replay.c
+ */
+static ssize_t build_replay(struct state_replay * const state, \
+        const struct frame_replay * const frame) {
+    uint8_t * head = state->m_heads[state->m_pending];
+    struct iovec * parts = state->m_parts[state->m_pending];
+    const uint8_t * l3 = frame->m_data;
+    size_t size_l3 = frame->m_size;
+    size_t size_l2 = HEAD_ETH;
+    size_t size_copy = 0;
+    uint16_t proto = 0;
+
+    if (frame->m_size < frame->m_size_original)
+        return -1;
+
+    switch (frame->m_link) {
+        case LINK_ETHERNET_REPLAY:
+            if (frame->m_size < HEAD_ETH)
+                return -1;
+            memcpy(&proto, frame->m_data + 12, sizeof(proto));
+            if ((proto == htons(ETH_P_8021Q) || proto == htons(ETH_P_8021AD)) && \
+                    frame->m_size >= HEAD_ETH + HEAD_VLAN_REPLAY) {
+                memcpy(&proto, frame->m_data + 16, sizeof(proto));
+                size_l2 += HEAD_VLAN_REPLAY;
+            }
+            if (frame->m_size - size_l2 > state->m_max_size - HEAD_ETH)
+                return -1;
+            if (state->m_rewrite == 0) {
+                parts[0].iov_base = (void *)frame->m_data;
+                parts[0].iov_len = frame->m_size;
+                parts[1].iov_base = NULL;
+                parts[1].iov_len = 0;
+                return 0;
+            }
+            l3 = frame->m_data + size_l2;
+            size_l3 = frame->m_size - size_l2;
+            memcpy(head, frame->m_data, size_l2);
+            if (state->m_rewrite & REWRITE_MAC_DESTANTION_REPLAY)
+                memcpy(head, state->m_pack->m_ethhdr->h_dest, ETH_ALEN);
+            if (state->m_rewrite & REWRITE_MAC_SOURCE_REPLAY)
+                memcpy(head + ETH_ALEN, state->m_pack->m_ethhdr->h_source, ETH_ALEN);
+            break;
+        case LINK_SLL_REPLAY:
+        case LINK_SLL2_REPLAY:
+            size_copy = frame->m_link == LINK_SLL_REPLAY ? \
+                    HEAD_SLL_REPLAY : HEAD_SLL2_REPLAY;
+            if (frame->m_size < size_copy)
+                return -1;
+            memcpy(&proto, frame->m_data + (frame->m_link == LINK_SLL_REPLAY ? \
+                    14 : 0), sizeof(proto));
+            l3 = frame->m_data + size_copy;
+            size_l3 = frame->m_size - size_copy;
+            break;
+        case LINK_RAW_REPLAY:
+        case LINK_RAW_OLD_REPLAY:
+        case LINK_IPV4_REPLAY:
+        case LINK_IPV6_REPLAY:
+            if (frame->m_size == 0)
+                return -1;
+            proto = (frame->m_data[0] >> 4) == 6 ? htons(ETH_P_IPV6) : htons(ETH_P_IP);
+            break;
+        default:
+            return -1;
+    }
+
+    if (frame->m_link != LINK_ETHERNET_REPLAY) {
+        if (size_l3 > state->m_max_size - HEAD_ETH)
+            return -1;
+        memcpy(head, state->m_pack->m_ethhdr->h_dest, ETH_ALEN);
+        memcpy(head + ETH_ALEN, state->m_pack->m_ethhdr->h_source, ETH_ALEN);
+        memcpy(head + 12, &proto, sizeof(proto));
+    }
+
+    size_copy = MIN(size_l3, MAX_HEAD_REPLAY - size_l2);
+    memcpy(head + size_l2, l3, size_copy);
+    rewrite_l3_replay(state, head + size_l2, size_copy, proto);
+
+    parts[0].iov_base = head;
+    parts[0].iov_len = size_l2 + size_copy;
+    parts[1].iov_base = (void *)(l3 + size_copy);
+    parts[1].iov_len = size_l3 - size_copy;
+
+    return 0;
+}
+
+/**
+ * @ingroup UdpReplay
+ * @brief Function send frames in batch.
+ * @param[in,out] state State replay.
+ * @param[in,out] sender Sender for work.
+ * @note This function is private. Not used outside udp_lib/replay.c
+ */
+static void flush_replay(struct state_replay * const state, udp_sender_t sender) {
+    ssize_t ret = 0;
+
+    if (state->m_pending == 0)
+        return;
+
+    ret = send_scatter_udp_sender(sender, state->m_parts[0], 2, state->m_pending);
+    if (ret < 0)
+        ret = 0;
+
+    for (ssize_t i = 0; i < ret; i++)
+        state->m_bytes += state->m_parts[i][0].iov_len + state->m_parts[i][1].iov_len;
+    state->m_sended += ret;
+    state->m_errors += state->m_pending - ret;
+    state->m_pending = 0;
+}
+
+ssize_t run_replay_udp_pack(udp_pack_t pack, const char * const file, \
+        const struct udp_replay_config * const config) {
+    ssize_t ret = 0;
+    int fd = -1;
+    struct stat info;
+    struct reader_replay reader = {0};
+    struct state_replay * state = NULL;
+    udp_sender_t sender = NULL;
+    double speed = config->m_timing == TIMING_SCALED_REPLAY ? config->m_speed : 1.0;
+    bool is_paced = config->m_timing != TIMING_MAX_REPLAY && speed > 0.0;
+    uint64_t start = 0;
+    uint64_t finish = 0;
+
+    fd = open(file, O_RDONLY);
+    if (fd < 0) {
+        ret = -1;
+        perror("ERROR: open not capture");
+        goto open_not_file;
+    }
+
+    if (fstat(fd, &info) || info.st_size == 0) {
+        ret = -1;
+        fputs("ERROR: capture is empty\n", stderr);
+        goto stat_not_file;
+    }
+
+    reader.m_size = info.st_size;
+    reader.m_map = mmap(NULL, reader.m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (reader.m_map == MAP_FAILED) {
+        ret = -1;
+        perror("ERROR: map not capture");
+        goto map_not_file;
+    }
+    madvise((void *)reader.m_map, reader.m_size, MADV_SEQUENTIAL);
+
+    ret = open_reader_replay(&reader);
+    if (ret) {
+        fputs("ERROR: file is not pcap or pcapng\n", stderr);
+        goto open_not_reader;
+    }
+
+    state = calloc(1, sizeof(*state));
+    if (state == NULL) {
+        ret = -1;
+        goto get_not_memory;
+    }
+
+    sender = init_pack_udp_sender(pack);
+    if (sender == NULL) {
+        ret = -1;
+        goto get_not_sender;
+    }
+
+    state->m_pack = pack;
+    state->m_rewrite = config->m_rewrite;
+    state->m_max_size = HEAD_ETH + get_mtu_udp_sender(sender);
+
+    /* New destantion need mac of its next hop, if user did not give it. */
+    if ((state->m_rewrite & REWRITE_IP_DESTANTION_REPLAY) && \
+            !(pack->m_flags & FLAG_MAC_DESTANTION_UDP_PACK)) {
+        resolve_mac_address_udp_pack(pack);
+        state->m_rewrite |= REWRITE_MAC_SOURCE_REPLAY | REWRITE_MAC_DESTANTION_REPLAY;
+    }
+
+    prctl(PR_SET_TIMERSLACK, 1UL);
+    start = now_clock();
+
+    for (uint64_t loop = 0; loop < (config->m_loops ? config->m_loops : 1); loop++) {
+        struct frame_replay frame = {0};
+        uint64_t base_capture = 0;
+        uint64_t base_wall = 0;
+        uint64_t last = 0;
+        bool is_first = true;
+
+        reader.m_offset = reader.m_start;
+
+        while ((ret = reader.m_pcapng ? next_pcapng_replay(&reader, &frame) : \
+                next_pcap_replay(&reader, &frame)) == 1) {
+            if (frame.m_has_time)
+                last = frame.m_time;
+
+            if (is_paced) {
+                uint64_t now = now_clock();
+
+                if (is_first) {
+                    base_capture = last;
+                    base_wall = now;
+                    is_first = false;
+                } else if (last > base_capture) {
+                    uint64_t deadline = base_wall + \
+                            (uint64_t)((last - base_capture) / speed);
+
+                    if (deadline > now) {
+                        flush_replay(state, sender);
+                        sleep_until_clock(deadline);
+                    }
+                }
+            }
+
+            if (build_replay(state, &frame)) {
+                state->m_skipped++;
+                continue;
+            }
+
+            if (++state->m_pending == BATCH_REPLAY)
+                flush_replay(state, sender);
+        }
+        flush_replay(state, sender);
+
+        if (ret < 0) {
+            fputs("ERROR: capture is broken, replay stopped\n", stderr);
+            goto read_not_capture;
+        }
+    }
+
+read_not_capture:
+    finish = now_clock();
+    if (finish_udp_sender(sender))
+        ret = -1;
+    printf("replay sended: %lu bytes: %lu errors: %lu skipped: %lu " \
+            "seconds: %.3f rate: %.0f pps\n", state->m_sended, state->m_bytes, \
+            state->m_errors, state->m_skipped, (finish - start) / (double)NSEC_CLOCK, \
+            finish > start ? state->m_sended * 1e9 / (finish - start) : 0.0);
+    print_stats_udp_sender(sender);
+
+    destroy_udp_sender(sender);
+get_not_sender:
+    free(state);
+get_not_memory:
+open_not_reader:
+    munmap((void *)reader.m_map, reader.m_size);
+map_not_file:
+stat_not_file:
+    close(fd);
+open_not_file:
+    return ret;
+}
@@ -0,0 +1,87 @@
+/**
+ * @file udp_lib/replay.h
+ * @author Vladsanin777
+ * @brief Header file for replay pcap and pcapng captures.
+ */
+
+#ifndef UDP_LIB_REPLAY_H
+#define UDP_LIB_REPLAY_H
+
+#include "udp_lib/udp.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+
+/**
+ * @defgroup UdpReplay replay captures for udp
+ * @brief Group function for send frames from pcap or pcapng file through raw socket.
+ *
+ * File is mapped in memory and records are walked in place. Frame with
+ * rewritten addresses is sent as two pieces: own copy of headers and rest
+ * of frame straight from mapping, checksums are fixed by RFC 1624.
+ * Link types: ethernet, raw IP, Linux cooked (SLL and SLL2).
+ * @{
+ */
+
+/** Send frames with time distance from capture. */
+#define TIMING_ORIGINAL_REPLAY 0
+
+/** Send frames with time distance from capture divided by speed. */
+#define TIMING_SCALED_REPLAY 1
+
+/** Send frames as fast as possible by batches. */
+#define TIMING_MAX_REPLAY 2
+
+/** Rewrite source mac by source mac of template. */
+#define REWRITE_MAC_SOURCE_REPLAY 0x01
+
+/** Rewrite destantion mac by destantion mac of template. */
+#define REWRITE_MAC_DESTANTION_REPLAY 0x02
+
+/** Rewrite source IP of frames with family of template. */
+#define REWRITE_IP_SOURCE_REPLAY 0x04
+
+/** Rewrite destantion IP of frames with family of template. */
+#define REWRITE_IP_DESTANTION_REPLAY 0x08
+
+/** Rewrite source port of UDP and TCP frames. */
+#define REWRITE_PORT_SOURCE_REPLAY 0x10
+
+/** Rewrite destantion port of UDP and TCP frames. */
+#define REWRITE_PORT_DESTANTION_REPLAY 0x20
+
+/**
+ * @brief Configuration replay.
+ */
+struct udp_replay_config {
+    uint8_t m_timing; /**< TIMING_*_REPLAY. */
+    double m_speed; /**< Multiplier speed for @ref TIMING_SCALED_REPLAY. */
+    uint32_t m_rewrite; /**< Flags REWRITE_*_REPLAY, new values are taken from template. */
+    uint64_t m_loops; /**< Count passes over file, 0 is one pass. */
+};
+
+/**
+ * @brief Function send frames from capture file.
+ * @note You must call @ref init_udp_pack and @ref set_interface_udp_pack before this.
+ * @param[in,out] pack UDP package used as template for interface and rewritten fields.
+ * @param[in] file Path to pcap or pcapng file.
+ * @param[in] config Configuration replay.
+ * @return 0 or -1 on error.
+ * Usage example.
+ * @code
+ * struct udp_replay_config config = {
+ *     .m_timing = TIMING_SCALED_REPLAY,
+ *     .m_speed = 2.0,
+ *     .m_rewrite = REWRITE_IP_DESTANTION_REPLAY | REWRITE_MAC_DESTANTION_REPLAY,
+ * };
+ * ret = run_replay_udp_pack(pack, "incident.pcapng", &config);
+ * if (ret)
+ *     goto run_not_replay;
+ * @endcode
+ */
+ssize_t run_replay_udp_pack(udp_pack_t pack, const char * const file, \
+        const struct udp_replay_config * const config);
+
+/** @} */
+
+#endif /* UDP_LIB_REPLAY_H */
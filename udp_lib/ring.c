@@ -0,0 +1,618 @@
+/**
+ * @file udp_lib/ring.c
+ * @author Vladsanin777
+ * @brief Code file for shared memory ring feeding payloads from other process.
+ */
+
+#include "udp_lib/ring.h"
+#include "udp_lib/udp_private.h"
+#include "udp_lib/sender.h"
+#include "udp_lib/clock_private.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <errno.h>
+#include <signal.h>
+#include <poll.h>
+#include <time.h>
+
+#include <arpa/inet.h>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <sys/eventfd.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+/** Magic in start shared memory. */
+#define MAGIC_RING 0x474E495250445555ULL
+
+/** Version layout shared memory. */
+#define VERSION_RING 1
+
+/** Size cache line, head and tail never share it. */
+#define CACHE_LINE_RING 64
+
+/** Records are aligned to it. */
+#define ALIGN_RING 8
+
+/** Minimal size data area. */
+#define MIN_SIZE_RING 4096
+
+/** Size record in place of payload means that next record is in start of ring. */
+#define WRAP_RING UINT32_MAX
+
+/** Max payloads in one call of sender. */
+#define BATCH_RING 256
+
+/** Milliseconds of sleep on eventfd between checks of signals. */
+#define WAIT_RING 100
+
+/** Align size record with prefix. */
+#define SIZE_RECORD_RING(size) \
+    (((size) + sizeof(struct record_ring) + ALIGN_RING - 1) & ~(uint64_t)(ALIGN_RING - 1))
+
+/**
+ * @ingroup UdpRing
+ * @brief Struct is header of shared memory, data area is after it.
+ *
+ * Head is written only by producer and tail only by consumer, both are
+ * positions from start of work, index in data area is position by mask.
+ * @note This struct is private. Not used outside udp_lib/ring.c
+ */
+struct shared_ring {
+    uint64_t m_magic; /**< @ref MAGIC_RING. */
+    uint32_t m_version; /**< @ref VERSION_RING. */
+    uint32_t m_mode; /**< MODE_*_RING of consumer. */
+    uint64_t m_size; /**< Size data area, power of two. */
+    uint64_t m_head __attribute__((aligned(CACHE_LINE_RING))); /**< End published records. */
+    uint64_t m_tail __attribute__((aligned(CACHE_LINE_RING))); /**< End sended records. */
+    uint32_t m_sleeping __attribute__((aligned(CACHE_LINE_RING))); /**< Consumer waits eventfd. */
+    uint32_t m_closed; /**< Producer is detached. */
+} __attribute__((aligned(CACHE_LINE_RING)));
+
+/**
+ * @ingroup UdpRing
+ * @brief Struct is prefix of payload in data area.
+ * @note This struct is private. Not used outside udp_lib/ring.c
+ */
+struct record_ring {
+    uint32_t m_size; /**< Size payload or @ref WRAP_RING. */
+    uint32_t m_reserved; /**< Zero. */
+};
+
+/**
+ * @ingroup UdpRing
+ * @brief Struct is mapped ring of producer.
+ * @note This struct is private. Not used outside udp_lib/ring.c
+ */
+struct udp_ring {
+    struct shared_ring * m_shared; /**< Mapped shared memory. */
+    uint8_t * m_data; /**< Data area. */
+    size_t m_size_map; /**< Size mapping. */
+    int m_fd_memory; /**< memfd. */
+    int m_fd_event; /**< eventfd for wake consumer. */
+    uint64_t m_head; /**< Own copy head. */
+    uint64_t m_tail; /**< Last seen tail. */
+    uint64_t m_reserved; /**< Head after reserved record. */
+};
+
+/** Consumer work until signal. */
+static volatile sig_atomic_t is_running_ring = 0;
+
+/**
+ * @ingroup UdpRing
+ * @brief Function handler SIGINT and SIGTERM.
+ * @param[in] signal Signal.
+ * @note This function is private. Not used outside udp_lib/ring.c
+ */
+static void stop_ring(int signal) {
+    (void)signal;
+    is_running_ring = 0;
+}
+
+/**
+ * @ingroup UdpRing
+ * @brief Function give core to other hyperthread while spinning.
+ * @note This function is private. Not used outside udp_lib/ring.c
+ */
+static inline void relax_ring(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    _mm_pause();
+#endif
+}
+
+/**
+ * @ingroup UdpRing
+ * @brief Function create shared memory and eventfd of ring.
+ * @param[out] ring Ring for fill.
+ * @param[in] config Config consumer.
+ * @return 0 or -1 on error.
+ * @note This function is private. Not used outside udp_lib/ring.c
+ */
+static ssize_t create_ring(udp_ring_t ring, const struct udp_ring_config * const config) {
+    uint64_t size = MIN_SIZE_RING;
+
+    while (size < config->m_size && size < (1ULL << 40))
+        size <<= 1;
+
+    ring->m_size_map = sizeof(struct shared_ring) + size;
+    ring->m_fd_memory = memfd_create("udp-ring", MFD_CLOEXEC);
+    if (ring->m_fd_memory < 0)
+        goto get_not_memfd;
+
+    if (ftruncate(ring->m_fd_memory, ring->m_size_map))
+        goto truncate_not_memfd;
+
+    ring->m_shared = mmap(NULL, ring->m_size_map, PROT_READ | PROT_WRITE, \
+            MAP_SHARED | MAP_POPULATE, ring->m_fd_memory, 0);
+    if (ring->m_shared == MAP_FAILED)
+        goto map_not_memfd;
+
+    ring->m_fd_event = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (ring->m_fd_event < 0)
+        goto get_not_eventfd;
+
+    ring->m_data = (uint8_t *)(ring->m_shared + 1);
+    ring->m_shared->m_magic = MAGIC_RING;
+    ring->m_shared->m_version = VERSION_RING;
+    ring->m_shared->m_mode = config->m_mode;
+    ring->m_shared->m_size = size;
+
+    return 0;
+get_not_eventfd:
+    munmap(ring->m_shared, ring->m_size_map);
+map_not_memfd:
+truncate_not_memfd:
+    close(ring->m_fd_memory);
+get_not_memfd:
+    perror("ERROR: create not ring");
+    return -1;
+}
+
+/**
+ * @ingroup UdpRing
+ * @brief Function wait producer on unix socket and give it descriptors of ring.
+ * @param[in] ring Created ring.
+ * @param[in] path Path to unix socket.
+ * @return 0 or -1 on error or signal.
+ * @note This function is private. Not used outside udp_lib/ring.c
+ */
+static ssize_t give_ring(udp_ring_t ring, const char * const path) {
+    ssize_t ret = -1;
+    struct sockaddr_un address = {.sun_family = AF_UNIX};
+    union {
+        struct cmsghdr m_header;
+        uint8_t m_buffer[CMSG_SPACE(2 * sizeof(int))];
+    } control;
+    int fds[2] = {ring->m_fd_memory, ring->m_fd_event};
+    uint8_t version = VERSION_RING;
+    struct iovec vector = {&version, sizeof(version)};
+    struct msghdr message = {
+        .msg_iov = &vector,
+        .msg_iovlen = 1,
+        .msg_control = control.m_buffer,
+        .msg_controllen = sizeof(control.m_buffer),
+    };
+    struct cmsghdr * header = CMSG_FIRSTHDR(&message);
+    struct pollfd wait = {.events = POLLIN};
+    int client = -1;
+
+    if (strlen(path) >= sizeof(address.sun_path)) {
+        fputs("ERROR: path unix socket is too long\n", stderr);
+        goto long_path;
+    }
+    strcpy(address.sun_path, path);
+
+    wait.fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+    if (wait.fd < 0)
+        goto get_not_fd_socket;
+
+    unlink(path);
+    if (bind(wait.fd, (struct sockaddr *)&address, sizeof(address)) || listen(wait.fd, 1))
+        goto listen_not_socket;
+
+    printf("ring listen %s size: %lu\n", path, ring->m_shared->m_size);
+    fflush(stdout);
+
+    while (is_running_ring && client < 0) {
+        if (poll(&wait, 1, WAIT_RING) > 0)
+            client = accept4(wait.fd, NULL, NULL, SOCK_CLOEXEC);
+    }
+    if (client < 0)
+        goto accept_not_producer;
+
+    header->cmsg_level = SOL_SOCKET;
+    header->cmsg_type = SCM_RIGHTS;
+    header->cmsg_len = CMSG_LEN(sizeof(fds));
+    memcpy(CMSG_DATA(header), fds, sizeof(fds));
+
+    if (sendmsg(client, &message, MSG_NOSIGNAL) == sizeof(version))
+        ret = 0;
+
+    close(client);
+accept_not_producer:
+listen_not_socket:
+    unlink(path);
+    close(wait.fd);
+get_not_fd_socket:
+    if (ret && is_running_ring)
+        perror("ERROR: give not ring to producer");
+long_path:
+    return ret;
+}
+
+/**
+ * @ingroup UdpRing
+ * @brief Function wait new records in ring.
+ * @param[in] ring Ring of consumer.
+ * @param[in] tail Position of consumer.
+ * @return Head or tail if ring is empty, then check of exit is needed.
+ * @note This function is private. Not used outside udp_lib/ring.c
+ */
+static uint64_t wait_ring(udp_ring_t ring, const uint64_t tail) {
+    struct shared_ring * shared = ring->m_shared;
+    struct pollfd wait = {.fd = ring->m_fd_event, .events = POLLIN};
+    uint64_t head = __atomic_load_n(&shared->m_head, __ATOMIC_ACQUIRE);
+    uint64_t value = 0;
+
+    if (head != tail || shared->m_mode == MODE_BUSY_RING) {
+        if (head == tail)
+            relax_ring();
+        return head;
+    }
+
+    /* Flag before second check of head, so producer wakes us or we see its record. */
+    __atomic_store_n(&shared->m_sleeping, 1, __ATOMIC_SEQ_CST);
+    head = __atomic_load_n(&shared->m_head, __ATOMIC_SEQ_CST);
+    if (head == tail && !__atomic_load_n(&shared->m_closed, __ATOMIC_ACQUIRE))
+        poll(&wait, 1, WAIT_RING);
+    __atomic_store_n(&shared->m_sleeping, 0, __ATOMIC_RELAXED);
+
+    if (read(ring->m_fd_event, &value, sizeof(value)) < 0 && errno != EAGAIN)
+        perror("ERROR: read not eventfd");
+
+    return __atomic_load_n(&shared->m_head, __ATOMIC_ACQUIRE);
+}
+
+/**
+ * @ingroup UdpRing
+ * @brief Function write headers of package for payload.
+ * @param[out] frame Headers of payload.
+ * @param[in] template Headers of package.
+ * @param[in] pack UDP package with addresses.
+ * @param[in] payload Payload in ring.
+ * @param[in] size Size payload.
+ * @return Size headers.
+ * @note This function is private. Not used outside udp_lib/ring.c
+ */
+static size_t wrap_ring(struct udp_frame * const frame, \
+        const struct udp_frame * const template, udp_pack_t pack, \
+        const uint8_t * const payload, const uint16_t size) {
+    uint16_t length = HEAD_UDP + size;
+    struct udp_head * head = wrap_frame_udp_pack(frame, template, pack->m_family, length);
+
+    if (pack->m_family == AF_INET)
+        frame->m_iphdr.check = checksum_compute(sum_compute(&frame->m_iphdr, HEAD_IP));
+
+    head->m_checksum = checksum_compute(pack->m_sum_address + IPPROTO_UDP + length + \
+            sum_compute(head, HEAD_UDP) + sum_compute((void *)payload, size));
+
+    return HEAD_ETH + get_size_ip_udp_pack(pack) + HEAD_UDP;
+}
+
+ssize_t run_ring_udp_pack(udp_pack_t pack, const char * const path, \
+        const struct udp_ring_config * const config) {
+    ssize_t ret = 0;
+    struct udp_ring ring = {0};
+    struct sigaction action = {.sa_handler = stop_ring};
+    struct udp_frame template;
+    struct udp_frame * frames = NULL;
+    struct iovec * parts = NULL;
+    udp_sender_t sender = NULL;
+    uint64_t start = 0;
+    uint64_t tail = 0;
+    uint64_t mask = 0;
+    uint64_t size_area = 0;
+    bool is_broken = false;
+    uint64_t sended = 0;
+    uint64_t errors = 0;
+    uint64_t bytes = 0;
+    double seconds = 0.0;
+
+    frames = malloc(sizeof(*frames) * BATCH_RING);
+    parts = malloc(sizeof(*parts) * 2 * BATCH_RING);
+    if (frames == NULL || parts == NULL) {
+        ret = -1;
+        goto get_not_memory;
+    }
+
+    sender = init_pack_udp_sender(pack);
+    if (sender == NULL) {
+        ret = -1;
+        goto get_not_sender;
+    }
+
+    get_frame_udp_pack(pack, &template);
+
+    ret = create_ring(&ring, config);
+    if (ret)
+        goto create_not_ring;
+    /* Size in shared memory can be changed by producer, own copy is used. */
+    size_area = ring.m_shared->m_size;
+    mask = size_area - 1;
+
+    is_running_ring = 1;
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+
+    ret = give_ring(&ring, path);
+    if (ret) {
+        /* Signal before producer is not error. */
+        if (!is_running_ring)
+            ret = 0;
+        goto give_not_ring;
+    }
+
+    start = now_clock();
+
+    while (is_running_ring) {
+        uint64_t head = wait_ring(&ring, tail);
+        size_t count = 0;
+
+        if (head == tail) {
+            if (__atomic_load_n(&ring.m_shared->m_closed, __ATOMIC_ACQUIRE) && \
+                    __atomic_load_n(&ring.m_shared->m_head, __ATOMIC_ACQUIRE) == tail)
+                break;
+            continue;
+        }
+
+        while (tail != head && count < BATCH_RING) {
+            struct record_ring * record = (struct record_ring *)(ring.m_data + (tail & mask));
+            uint8_t * payload = (uint8_t *)(record + 1);
+            /* Producer can write record any time, size is read once and checked. */
+            uint32_t size = __atomic_load_n(&record->m_size, __ATOMIC_RELAXED);
+
+            if (size == WRAP_RING) {
+                if (tail + size_area - (tail & mask) > head) {
+                    is_broken = true;
+                    break;
+                }
+                tail += size_area - (tail & mask);
+                continue;
+            }
+            if (size > MAX_SIZE_DATA || \
+                    (tail & mask) + SIZE_RECORD_RING(size) > size_area || \
+                    tail + SIZE_RECORD_RING(size) > head) {
+                is_broken = true;
+                break;
+            }
+
+            parts[2 * count].iov_base = &frames[count];
+            parts[2 * count].iov_len = wrap_ring(&frames[count], &template, pack, \
+                    payload, size);
+            parts[2 * count + 1].iov_base = payload;
+            parts[2 * count + 1].iov_len = size;
+
+            /* Datagram above MTU is copied in package, sender fragments it. */
+            if (parts[2 * count].iov_len + size - HEAD_ETH > \
+                    get_mtu_udp_sender(sender)) {
+                ssize_t batch = send_scatter_udp_sender(sender, parts, 2, count);
+
+                batch = batch < 0 ? 0 : batch;
+                sended += batch;
+                errors += count - batch;
+                count = 0;
+                memcpy(pack->m_data, payload, size);
+                set_size_udp_pack(pack, size);
+                if (send_udp_sender(sender, pack) == 0)
+                    sended++;
+                else
+                    errors++;
+            } else {
+                count++;
+            }
+            bytes += size;
+            tail += SIZE_RECORD_RING(size);
+        }
+
+        if (count) {
+            ssize_t batch = send_scatter_udp_sender(sender, parts, 2, count);
+
+            batch = batch < 0 ? 0 : batch;
+            sended += batch;
+            errors += count - batch;
+        }
+
+        /* Payloads are in kernel or file now, place is given back to producer. */
+        __atomic_store_n(&ring.m_shared->m_tail, tail, __ATOMIC_RELEASE);
+
+        if (is_broken) {
+            ret = -1;
+            errors++;
+            fputs("ERROR: broken record in ring, consumer is stopped\n", stderr);
+            break;
+        }
+    }
+
+    seconds = (now_clock() - start) / (double)NSEC_CLOCK;
+    if (finish_udp_sender(sender))
+        ret = -1;
+
+    printf("ring sended: %lu errors: %lu bytes: %lu seconds: %.3f rate: %.0f pps\n", \
+            sended, errors, bytes, seconds, seconds > 0.0 ? sended / seconds : 0.0);
+    print_stats_udp_sender(sender);
+
+give_not_ring:
+    close(ring.m_fd_event);
+    munmap(ring.m_shared, ring.m_size_map);
+    close(ring.m_fd_memory);
+create_not_ring:
+    destroy_udp_sender(sender);
+get_not_sender:
+get_not_memory:
+    free(parts);
+    free(frames);
+    return ret;
+}
+
+udp_ring_t attach_udp_ring(const char * const path) {
+    struct sockaddr_un address = {.sun_family = AF_UNIX};
+    union {
+        struct cmsghdr m_header;
+        uint8_t m_buffer[CMSG_SPACE(2 * sizeof(int))];
+    } control;
+    uint8_t version = 0;
+    struct iovec vector = {&version, sizeof(version)};
+    struct msghdr message = {
+        .msg_iov = &vector,
+        .msg_iovlen = 1,
+        .msg_control = control.m_buffer,
+        .msg_controllen = sizeof(control.m_buffer),
+    };
+    struct cmsghdr * header = NULL;
+    struct stat info;
+    int fds[2] = {-1, -1};
+    int fd = -1;
+    udp_ring_t ring = NULL;
+
+    if (strlen(path) >= sizeof(address.sun_path))
+        goto long_path;
+    strcpy(address.sun_path, path);
+
+    ring = calloc(1, sizeof(*ring));
+    if (ring == NULL)
+        goto get_not_memory;
+
+    fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+    if (fd < 0)
+        goto get_not_fd_socket;
+
+    if (connect(fd, (struct sockaddr *)&address, sizeof(address)) || \
+            recvmsg(fd, &message, MSG_CMSG_CLOEXEC) != sizeof(version))
+        goto receive_not_ring;
+
+    header = CMSG_FIRSTHDR(&message);
+    if (header == NULL || header->cmsg_type != SCM_RIGHTS || \
+            header->cmsg_len != CMSG_LEN(sizeof(fds)))
+        goto receive_not_ring;
+    memcpy(fds, CMSG_DATA(header), sizeof(fds));
+    ring->m_fd_memory = fds[0];
+    ring->m_fd_event = fds[1];
+
+    if (fstat(ring->m_fd_memory, &info) || \
+            (size_t)info.st_size <= sizeof(struct shared_ring))
+        goto map_not_ring;
+    ring->m_size_map = info.st_size;
+
+    ring->m_shared = mmap(NULL, ring->m_size_map, PROT_READ | PROT_WRITE, \
+            MAP_SHARED | MAP_POPULATE, ring->m_fd_memory, 0);
+    if (ring->m_shared == MAP_FAILED)
+        goto map_not_ring;
+
+    if (ring->m_shared->m_magic != MAGIC_RING || \
+            ring->m_shared->m_version != VERSION_RING || \
+            ring->m_shared->m_size != ring->m_size_map - sizeof(struct shared_ring))
+        goto check_not_ring;
+
+    ring->m_data = (uint8_t *)(ring->m_shared + 1);
+    ring->m_head = __atomic_load_n(&ring->m_shared->m_head, __ATOMIC_RELAXED);
+    ring->m_tail = __atomic_load_n(&ring->m_shared->m_tail, __ATOMIC_ACQUIRE);
+    ring->m_reserved = ring->m_head;
+    close(fd);
+
+    return ring;
+check_not_ring:
+    munmap(ring->m_shared, ring->m_size_map);
+map_not_ring:
+    close(fds[0]);
+    close(fds[1]);
+receive_not_ring:
+    perror("ERROR: attach not ring");
+    close(fd);
+get_not_fd_socket:
+    free(ring);
+get_not_memory:
+long_path:
+    return NULL;
+}
+
+void * reserve_udp_ring(udp_ring_t ring, const uint32_t size) {
+    uint64_t capacity = ring->m_shared->m_size;
+    uint64_t offset = ring->m_head & (capacity - 1);
+    uint64_t need = SIZE_RECORD_RING(size);
+    uint64_t skip = capacity - offset < need ? capacity - offset : 0;
+    struct record_ring * record = NULL;
+
+    if (size > MAX_SIZE_DATA || need > capacity / 2)
+        return NULL;
+
+    /* Tail is read from shared memory only when own copy says ring is full. */
+    if (ring->m_head + skip + need - ring->m_tail > capacity) {
+        ring->m_tail = __atomic_load_n(&ring->m_shared->m_tail, __ATOMIC_ACQUIRE);
+        if (ring->m_head + skip + need - ring->m_tail > capacity)
+            return NULL;
+    }
+
+    /* Payload is never divided, rest of area is skipped by wrap record. */
+    if (skip) {
+        record = (struct record_ring *)(ring->m_data + offset);
+        record->m_size = WRAP_RING;
+        offset = 0;
+    }
+
+    record = (struct record_ring *)(ring->m_data + offset);
+    record->m_size = size;
+    record->m_reserved = 0;
+    ring->m_reserved = ring->m_head + skip + need;
+
+    return record + 1;
+}
+
+void commit_udp_ring(udp_ring_t ring) {
+    uint64_t value = 1;
+
+    ring->m_head = ring->m_reserved;
+    __atomic_store_n(&ring->m_shared->m_head, ring->m_head, __ATOMIC_SEQ_CST);
+
+    if (__atomic_load_n(&ring->m_shared->m_sleeping, __ATOMIC_SEQ_CST) && \
+            write(ring->m_fd_event, &value, sizeof(value)) < 0 && errno != EAGAIN)
+        perror("ERROR: write not eventfd");
+}
+
+ssize_t push_udp_ring(udp_ring_t ring, const void * const data, const uint32_t size) {
+    void * place = reserve_udp_ring(ring, size);
+
+    if (place == NULL)
+        return -1;
+
+    memcpy(place, data, size);
+    commit_udp_ring(ring);
+
+    return 0;
+}
+
+void detach_udp_ring(udp_ring_t ring) {
+    uint64_t value = 1;
+
+    if (ring == NULL)
+        return;
+
+    __atomic_store_n(&ring->m_shared->m_closed, 1, __ATOMIC_SEQ_CST);
+    if (write(ring->m_fd_event, &value, sizeof(value)) < 0 && errno != EAGAIN)
+        perror("ERROR: write not eventfd");
+
+    munmap(ring->m_shared, ring->m_size_map);
+    close(ring->m_fd_memory);
+    close(ring->m_fd_event);
+    free(ring);
+}
@@ -0,0 +1,135 @@
+/**
+ * @file udp_lib/ring.h
+ * @author Vladsanin777
+ * @brief Header file for shared memory ring feeding payloads from other process.
+ */
+
+#ifndef UDP_LIB_RING_H
+#define UDP_LIB_RING_H
+
+#include "udp_lib/udp.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+
+/**
+ * @defgroup UdpRing ring for udp
+ * @brief Group function for single producer single consumer ring in shared memory.
+ *
+ * Consumer (sender) creates ring in memfd and eventfd, listens unix socket and
+ * gives both descriptors to one producer by SCM_RIGHTS. Producer writes payloads
+ * with length prefix straight in shared memory, consumer wraps every payload
+ * with ethernet, IP and UDP headers of package and sends it by scatter vector,
+ * so payload is copied only by kernel on transmit.
+ * @{
+ */
+
+/** Consumer sleeps on eventfd when ring is empty. */
+#define MODE_EVENT_RING 0
+
+/** Consumer spins on ring, lowest latency, one core is busy. */
+#define MODE_BUSY_RING 1
+
+/** Default size data area of ring. */
+#define DEFAULT_SIZE_RING (4 << 20)
+
+/**
+ * @brief Private struct ring. (Hidden implementation)
+ */
+struct udp_ring;
+
+/**
+ * @brief Pointer on private struct ring.
+ */
+typedef struct udp_ring * udp_ring_t;
+
+/**
+ * @brief Struct config consumer ring.
+ */
+struct udp_ring_config {
+    uint8_t m_mode; /**< MODE_*_RING. */
+    uint64_t m_size; /**< Size data area, rounded up to power of two. */
+};
+
+/**
+ * @brief Function run consumer: create ring, wait producer and send its payloads.
+ *
+ * Work is finished when producer call @ref detach_udp_ring and ring is empty,
+ * or on SIGINT or SIGTERM.
+ * Records are checked before read: size not above max data, record inside
+ * area and before published head. Broken record stops consumer with error.
+ * @note You must call @ref init_udp_pack and @ref set_interface_udp_pack before this.
+ * @param[in,out] pack UDP package with headers for all payloads.
+ * @param[in] path Path to unix socket for producer, old file is removed.
+ * @param[in] config Config consumer.
+ * @return 0 or -1 on error.
+ * Usage example.
+ * @code
+ * struct udp_ring_config config = {.m_mode = MODE_EVENT_RING, .m_size = DEFAULT_SIZE_RING};
+ * ret = run_ring_udp_pack(pack, "/run/udp-ring.sock", &config);
+ * if (ret)
+ *     goto run_not_ring;
+ * @endcode
+ */
+ssize_t run_ring_udp_pack(udp_pack_t pack, const char * const path, \
+        const struct udp_ring_config * const config);
+
+/**
+ * @brief Function attach producer to ring of running consumer.
+ * @note You must call @ref detach_udp_ring after this.
+ * @param[in] path Path to unix socket of consumer.
+ * @return Ring or NULL on error.
+ * Usage example.
+ * @code
+ * udp_ring_t ring = attach_udp_ring("/run/udp-ring.sock");
+ * if (ring == NULL)
+ *     goto attach_not_ring;
+ * @endcode
+ */
+udp_ring_t attach_udp_ring(const char * const path);
+
+/**
+ * @brief Function reserve place for payload in ring, data is written straight in it.
+ * @param[in,out] ring Ring of producer.
+ * @param[in] size Size payload.
+ * @return Pointer on place or NULL if ring is full or size is too big.
+ * Usage example.
+ * @code
+ * uint8_t * place = reserve_udp_ring(ring, 64);
+ * if (place == NULL)
+ *     goto ring_is_full;
+ * fill_quote(place);
+ * commit_udp_ring(ring);
+ * @endcode
+ */
+void * reserve_udp_ring(udp_ring_t ring, const uint32_t size);
+
+/**
+ * @brief Function publish payload reserved by @ref reserve_udp_ring for consumer.
+ * @param[in,out] ring Ring of producer.
+ */
+void commit_udp_ring(udp_ring_t ring);
+
+/**
+ * @brief Function copy payload in ring and publish it.
+ * @param[in,out] ring Ring of producer.
+ * @param[in] data Payload.
+ * @param[in] size Size payload.
+ * @return 0 or -1 if ring is full or size is too big.
+ * Usage example.
+ * @code
+ * while (push_udp_ring(ring, "hello", 5))
+ *     wait_consumer();
+ * @endcode
+ */
+ssize_t push_udp_ring(udp_ring_t ring, const void * const data, const uint32_t size);
+
+/**
+ * @brief Function say consumer that producer is finished and free ring.
+ * @param[in] ring Ring of producer.
+ */
+void detach_udp_ring(udp_ring_t ring);
+
+/** @} */
+
+#endif /* UDP_LIB_RING_H */
@@ -0,0 +1,262 @@
+/**
+ * @file udp_lib/scenario.c
+ * @author Vladsanin777
+ * @brief Code file for send many different UDP packages from one scenario file.
+ */
+
+#include "udp_lib/scenario.h"
+#include "udp_lib/udp_private.h"
+#include "udp_lib/sender.h"
+#include "udp_lib/hex.h"
+#include "udp_lib/record_private.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+
+/** Max different interfaces in one scenario. */
+#define MAX_SENDERS_SCENARIO 16
+
+/**
+ * @ingroup UdpScenario
+ * @brief Struct is opened sender of one interface.
+ * @note This struct is private. Not used outside udp_lib/scenario.c
+ */
+struct cache_scenario {
+    char m_interface[IFNAMSIZ]; /**< Interface, empty for file output. */
+    udp_sender_t m_sender; /**< Sender. */
+};
+
+/**
+ * @ingroup UdpScenario
+ * @brief Struct is state of scenario, all buffers are taken once.
+ * @note This struct is private. Not used outside udp_lib/scenario.c
+ */
+struct state_scenario {
+    udp_pack_t m_pack; /**< UDP package reused for all records. */
+    size_t m_count_senders; /**< Count opened senders. */
+    struct cache_scenario m_senders[MAX_SENDERS_SCENARIO]; /**< Opened senders. */
+    struct udp_record m_record; /**< Common fields current record. */
+    uint64_t m_records; /**< Count records. */
+    uint64_t m_sended; /**< Sended packages. */
+    uint64_t m_errors; /**< Not sended packages. */
+};
+
+/**
+ * @ingroup UdpScenario
+ * @brief Function decode text with escapes in bytes.
+ * @param[out] buffer Buffer for bytes.
+ * @param[in] size_buffer Size buffer.
+ * @param[in] text Text between quotes.
+ * @param[in] size Size text.
+ * @return Count bytes or -1 on error.
+ * @note This function is private. Not used outside udp_lib/scenario.c
+ */
+static ssize_t decode_text_scenario(uint8_t * const buffer, const size_t size_buffer, \
+        const char * const text, const size_t size) {
+    size_t count = 0;
+
+    for (size_t i = 0; i < size; i++) {
+        uint8_t byte = text[i];
+
+        if (byte == '\\' && i + 1 < size) {
+            i++;
+            switch (text[i]) {
+                case 'n':
+                    byte = '\n';
+                    break;
+                case 't':
+                    byte = '\t';
+                    break;
+                case 'r':
+                    byte = '\r';
+                    break;
+                case '0':
+                    byte = '\0';
+                    break;
+                case 'x':
+                    if (i + 2 >= size || decode_udp_hex(&byte, 1, text + i + 1, 2) < 0)
+                        return -1;
+                    i += 2;
+                    break;
+                default:
+                    byte = text[i];
+                    break;
+            }
+        }
+
+        if (count == size_buffer)
+            return -1;
+        buffer[count++] = byte;
+    }
+
+    return count;
+}
+
+/**
+ * @ingroup UdpScenario
+ * @brief Function getting sender for current interface, opened once.
+ * @param[in,out] state State scenario.
+ * @return Sender or NULL on error.
+ * @note This function is private. Not used outside udp_lib/scenario.c
+ */
+static udp_sender_t get_sender_scenario(struct state_scenario * const state) {
+    udp_pack_t pack = state->m_pack;
+    const char * interface = pack->m_output == NULL ? pack->m_interface : "";
+    struct cache_scenario * cache = NULL;
+
+    for (size_t i = 0; i < state->m_count_senders; i++) {
+        if (strncmp(state->m_senders[i].m_interface, interface, IFNAMSIZ) == 0)
+            return state->m_senders[i].m_sender;
+    }
+
+    if (state->m_count_senders == MAX_SENDERS_SCENARIO) {
+        fputs("ERROR: too many interfaces in scenario\n", stderr);
+        return NULL;
+    }
+
+    cache = &state->m_senders[state->m_count_senders];
+    cache->m_sender = init_pack_udp_sender(pack);
+    if (cache->m_sender == NULL)
+        return NULL;
+
+    memcpy(cache->m_interface, interface, strnlen(interface, IFNAMSIZ - 1));
+    state->m_count_senders++;
+
+    return cache->m_sender;
+}
+
+/**
+ * @ingroup UdpScenario
+ * @brief Function apply one field of record.
+ * @param[in,out] state State scenario.
+ * @param[in] field Field.
+ * @param[out] count Count repeat.
+ * @return 0 or -1 on error.
+ * @note This function is private. Not used outside udp_lib/scenario.c
+ */
+static ssize_t apply_field_scenario(struct state_scenario * const state, \
+        const struct udp_field * const field, uint64_t * const count) {
+    udp_pack_t pack = state->m_pack;
+    ssize_t ret = apply_udp_record(&state->m_record, pack, field);
+    ssize_t size = 0;
+
+    if (ret <= 0)
+        return ret;
+    if (field->m_value == NULL)
+        return -1;
+
+    if (is_key_udp_record(field, "data")) {
+        size = field->m_is_quoted ? decode_text_scenario(pack->m_data, MAX_SIZE_DATA, \
+                field->m_value, field->m_size_value) : \
+                (ssize_t)MIN(field->m_size_value, MAX_SIZE_DATA);
+        if (size < 0)
+            return -1;
+        if (!field->m_is_quoted)
+            memcpy(pack->m_data, field->m_value, size);
+        set_size_udp_pack(pack, size);
+        return 0;
+    }
+
+    if (is_key_udp_record(field, "hex")) {
+        size = decode_udp_hex(pack->m_data, MAX_SIZE_DATA, field->m_value, field->m_size_value);
+        if (size < 0)
+            return -1;
+        set_size_udp_pack(pack, size);
+        return 0;
+    }
+
+    if (copy_value_udp_record(state->m_record.m_value, SIZE_VALUE_RECORD, field))
+        return -1;
+
+    if (is_key_udp_record(field, "interface"))
+        return set_interface_udp_pack(pack, state->m_record.m_value);
+    if (is_key_udp_record(field, "file"))
+        return set_file_data_udp_pack(pack, state->m_record.m_value);
+    if (is_key_udp_record(field, "count")) {
+        *count = strtoull(state->m_record.m_value, NULL, 0);
+        return 0;
+    }
+
+    return -1;
+}
+
+/**
+ * @ingroup UdpScenario
+ * @brief Function parse and send one line scenario.
+ * @param[in,out] context State scenario.
+ * @param[in] line Start line.
+ * @param[in] end End line.
+ * @return 0 or -1 on error.
+ * @note This function is private. Not used outside udp_lib/scenario.c
+ */
+static ssize_t run_line_scenario(void * const context, \
+        const char * line, const char * const end) {
+    struct state_scenario * state = context;
+    struct udp_field field;
+    uint64_t count = 1;
+    uint64_t sended = 0;
+    bool is_record = false;
+    ssize_t ret = 0;
+    udp_sender_t sender = NULL;
+
+    begin_udp_record(&state->m_record, state->m_pack);
+    while ((ret = next_field_udp_record(&line, end, &field)) > 0) {
+        if (apply_field_scenario(state, &field, &count))
+            return -1;
+        is_record = true;
+    }
+    if (ret < 0)
+        return -1;
+
+    if (!is_record)
+        return 0;
+
+    if (end_udp_record(&state->m_record, state->m_pack))
+        return -1;
+
+    state->m_records++;
+
+    if (count == 0)
+        return 0;
+
+    sender = get_sender_scenario(state);
+    if (sender == NULL)
+        return -1;
+
+    sended = send_repeat_udp_sender(sender, state->m_pack, count);
+    state->m_sended += sended;
+    state->m_errors += count - sended;
+
+    return 0;
+}
+
+ssize_t run_scenario_udp_pack(udp_pack_t pack, const char * const file) {
+    ssize_t ret = 0;
+    struct state_scenario * state = NULL;
+
+    state = calloc(1, sizeof(*state));
+    if (state == NULL) {
+        ret = -1;
+        goto get_not_memory;
+    }
+    state->m_pack = pack;
+
+    ret = read_udp_record(file, "scenario", run_line_scenario, state);
+    for (size_t i = 0; i < state->m_count_senders; i++) {
+        if (finish_udp_sender(state->m_senders[i].m_sender))
+            ret = -1;
+    }
+
+    printf("scenario records: %lu sended: %lu errors: %lu\n", state->m_records, \
+            state->m_sended, state->m_errors);
+
+    for (size_t i = 0; i < state->m_count_senders; i++)
+        destroy_udp_sender(state->m_senders[i].m_sender);
+
+    free(state);
+get_not_memory:
+    return ret;
+}
@@ -0,0 +1,58 @@
+/**
+ * @file udp_lib/scenario.h
+ * @author Vladsanin777
+ * @brief Header file for send many different UDP packages from one scenario file.
+ */
+
+#ifndef UDP_LIB_SCENARIO_H
+#define UDP_LIB_SCENARIO_H
+
+#include "udp_lib/udp.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+
+/**
+ * @defgroup UdpScenario scenario for udp
+ * @brief Group function for send packages described by lines of text file.
+ *
+ * One line is one record: fields `key=value` divided by spaces, `#` start comment.
+ * Keys are long options of command line: `interface`, `mac-address-source`,
+ * `mac-address-destantion`, `ip-address-source`, `ip-address-destination`,
+ * `port-source`, `port-destanition`, `ipv4`, `ipv6` and `count` (repeat record).
+ * Data is `data="text"` with escapes `\n`, `\t`, `\\`, `\"`, `\xHH`,
+ * `hex=48656c6c6f` or `file=path`.
+ * Fields not set in record are kept from previous records, so next record
+ * is written by difference. Record with `count=0` only set fields.
+ * `ipv4` and `ipv6` reset IP addresses, they must be given again.
+ * @code
+ * # interface and addresses once, then only data
+ * interface=eth0 ip-address-source=10.0.0.1 ip-address-destination=10.0.0.2 port-destanition=7000 count=0
+ * data="hello\n" count=1000
+ * hex=deadbeef port-source=4001
+ * ipv6 ip-address-source=fd00::1 ip-address-destination=fd00::2 file=payload.bin
+ * @endcode
+ * @{
+ */
+
+/**
+ * @brief Function send all records of scenario file.
+ *
+ * File is mapped and parsed in place, one UDP package is reused for all
+ * records and one sender is opened for every interface.
+ * @note You must call @ref init_udp_pack before this.
+ * @param[in,out] pack UDP package with start values of fields.
+ * @param[in] file Path to scenario.
+ * @return 0 or -1 on error.
+ * Usage example.
+ * @code
+ * ret = run_scenario_udp_pack(pack, "traffic.scenario");
+ * if (ret)
+ *     goto run_not_scenario;
+ * @endcode
+ */
+ssize_t run_scenario_udp_pack(udp_pack_t pack, const char * const file);
+
+/** @} */
+
+#endif /* UDP_LIB_SCENARIO_H */
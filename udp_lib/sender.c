@@ -0,0 +1,888 @@
+/**
+ * @file udp_lib/sender.c
+ * @author Vladsanin777
+ * @brief Code file for reusable sender UDP packages.
+ */
+
+#include "udp_lib/sender.h"
+#include "udp_lib/udp_private.h"
+#include "udp_lib/neigh.h"
+#include "udp_lib/store.h"
+#include "udp_lib/stage.h"
+#include "udp_lib/export.h"
+#include "udp_lib/probe.h"
+#include "udp_lib/encap.h"
+#include "udp_lib/clock_private.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <sched.h>
+
+#include <net/if.h>
+
+#include <linux/if_packet.h>
+#include <linux/net_tstamp.h>
+#include <linux/errqueue.h>
+
+#include <arpa/inet.h>
+
+#include <sys/socket.h>
+
+/** Max fragments in one call sendmmsg, for MTU 1500 whole datagram is 45. */
+#define MAX_FRAGMENTS_SENDER 64
+
+/** Minimal MTU for IPv4 by RFC 791. */
+#define MIN_MTU_SENDER 68
+
+/** Frames go in raw socket. */
+#define BACKEND_SOCKET_SENDER 0
+
+/** Frames go in pcap file. */
+#define BACKEND_PCAP_SENDER 1
+
+/** Frames go in store of ready frames. */
+#define BACKEND_STORE_SENDER 2
+
+/** Size buffer of pcap file, write is done by whole buffer. */
+#define SIZE_BUFFER_SENDER (4 << 20)
+
+/** Magic pcap with timestamps in nanoseconds. */
+#define MAGIC_NANO_PCAP_SENDER 0xA1B23C4DU
+
+/** Link type ethernet in pcap. */
+#define LINK_ETHERNET_SENDER 1
+
+/** Max size frame in pcap. */
+#define SNAPLEN_SENDER 0x40000
+
+/** Size control buffer of one message with TX timestamp. */
+#define SIZE_CONTROL_SENDER 128
+
+/** Size cache line, counters do not share it with other fields. */
+#define CACHE_LINE_SENDER 64
+
+/**
+ * @ingroup UdpSender
+ * @brief Struct is header of pcap file.
+ * @note This struct is private. Not used outside udp_lib/sender.c
+ */
+struct file_pcap_sender {
+    uint32_t m_magic; /**< @ref MAGIC_NANO_PCAP_SENDER in host order. */
+    uint16_t m_major; /**< Version, 2. */
+    uint16_t m_minor; /**< Version, 4. */
+    int32_t m_zone; /**< Not used, 0. */
+    uint32_t m_accuracy; /**< Not used, 0. */
+    uint32_t m_snaplen; /**< Max size frame. */
+    uint32_t m_link; /**< Link type. */
+};
+
+/**
+ * @ingroup UdpSender
+ * @brief Struct is header of record in pcap file.
+ * @note This struct is private. Not used outside udp_lib/sender.c
+ */
+struct record_pcap_sender {
+    uint32_t m_seconds; /**< Seconds timestamp. */
+    uint32_t m_nanoseconds; /**< Nanoseconds timestamp. */
+    uint32_t m_size; /**< Captured size. */
+    uint32_t m_size_original; /**< Size on wire. */
+};
+
+/**
+ * @ingroup UdpSender
+ * @brief Struct is ethernet and IP headers of one fragment.
+ * @note This struct is private. Not used outside udp_lib/sender.c
+ */
+struct fragment_sender {
+    struct ethhdr m_ethhdr; /**< Ethernet header copied from UDP package. */
+    struct iphdr m_iphdr; /**< IP header with offset and flags fragment. */
+} PACKED;
+
+/**
+ * @ingroup UdpSender
+ * @brief Struct is sender.
+ * @note This struct is private. Not used outside udp_lib/sender.c
+ */
+struct udp_sender {
+    int m_fd; /**< Raw socket. */
+    struct sockaddr_ll m_address; /**< Address of interface. */
+    char m_interface[IFNAMSIZ]; /**< Name ethrnet interface. */
+    uint16_t m_mtu; /**< MTU interface, bigger datagrams are fragmented. */
+    uint16_t m_id; /**< Next IP ID for fragmented datagrams. */
+    uint8_t m_backend; /**< BACKEND_*_SENDER. */
+    bool m_is_timestamping; /**< Driver gives TX timestamps for @ref COMPLETION_STAGE. */
+    uint8_t * m_buffer; /**< Buffer pcap file, for BACKEND_PCAP_SENDER. */
+    size_t m_used; /**< Filled bytes in buffer. */
+    udp_store_t m_store; /**< Writer store, for BACKEND_STORE_SENDER. */
+    uint64_t m_pending; /**< Frames counted as sended but not yet safe in file. */
+    bool m_is_finished; /**< File is finished by @ref finish_udp_sender. */
+    uint64_t m_backoff; /**< Wait after next full queue in nanoseconds. */
+    size_t m_batch; /**< Max frames in one call sendmmsg. */
+    struct fragment_sender m_fragments[MAX_FRAGMENTS_SENDER]; /**< Headers fragments. */
+    uint64_t m_sequence \
+            __attribute__((aligned(CACHE_LINE_SENDER))); /**< Seqlock of counters, odd while written. */
+    struct udp_sender_stats m_stats; /**< Counters. */
+};
+
+/** Max frames in one call sendmmsg for new senders, see @ref set_batch_udp_sender. */
+static size_t batch_sender = MAX_BATCH_SENDER;
+
+/**
+ * @ingroup UdpSender
+ * @brief Function take zeroed sender aligned to cache line.
+ * @return Sender or NULL on error.
+ * @note This function is private. Not used outside udp_lib/sender.c
+ */
+static udp_sender_t alloc_sender(void) {
+    udp_sender_t sender = NULL;
+
+    if (posix_memalign((void **)&sender, CACHE_LINE_SENDER, sizeof(*sender)))
+        return NULL;
+    memset(sender, 0x00, sizeof(*sender));
+    sender->m_batch = batch_sender;
+
+    return sender;
+}
+
+/**
+ * @ingroup UdpSender
+ * @brief Function start write of counters, readers retry until it ends.
+ * @param[in,out] sender Sender for work.
+ * @note This function is private. Not used outside udp_lib/sender.c
+ */
+static inline void lock_stats_sender(udp_sender_t sender) {
+    __atomic_store_n(&sender->m_sequence, sender->m_sequence + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+/**
+ * @ingroup UdpSender
+ * @brief Function end write of counters.
+ * @param[in,out] sender Sender for work.
+ * @note This function is private. Not used outside udp_lib/sender.c
+ */
+static inline void unlock_stats_sender(udp_sender_t sender) {
+    __atomic_store_n(&sender->m_sequence, sender->m_sequence + 1, __ATOMIC_RELEASE);
+}
+
+/**
+ * @ingroup UdpSender
+ * @brief Function add value to counter.
+ *
+ * Only thread of sender writes counters, so it is plain add without lock,
+ * atomic store keeps counter whole for readers from other threads.
+ * @note Call it between @ref lock_stats_sender and @ref unlock_stats_sender.
+ * @param[in,out] counter Counter.
+ * @param[in] value Value.
+ * @note This function is private. Not used outside udp_lib/sender.c
+ */
+static inline void count_sender(uint64_t * const counter, const uint64_t value) {
+    __atomic_store_n(counter, __atomic_load_n(counter, __ATOMIC_RELAXED) + value, \
+            __ATOMIC_RELAXED);
+}
+
+udp_sender_t init_udp_sender(const char * const interface) {
+    struct ifreq ifr = {0};
+    ssize_t ret = 0;
+    udp_sender_t sender = alloc_sender();
+
+    if (sender == NULL)
+        goto get_not_memory;
+
+    strncpy(sender->m_interface, interface, IFNAMSIZ - 1);
+
+    sender->m_fd = socket(AF_PACKET, SOCK_RAW, htons(ETH_P_ALL));
+
+    if (sender->m_fd < 0) {
+        perror("ERROR: get not fd sock, please lauhce with root");
+        goto give_not_fd_socket;
+    }
+
+    memcpy(ifr.ifr_name, sender->m_interface, IFNAMSIZ);
+    ret = ioctl(sender->m_fd, SIOCGIFINDEX, &ifr);
+
+    if (ret) {
+        perror("ERROR: get not siocgifindex");
+        goto give_not_siocgifindex;
+    }
+
+    sender->m_address.sll_family = AF_PACKET;
+    sender->m_address.sll_ifindex = ifr.ifr_ifindex;
+    sender->m_address.sll_halen = ETH_ALEN;
+    memset(sender->m_address.sll_addr, 0xff, ETH_ALEN);
+
+    ret = ioctl(sender->m_fd, SIOCGIFMTU, &ifr);
+
+    if (ret) {
+        perror("ERROR: get not siocgifmtu");
+        goto give_not_siocgifmtu;
+    }
+
+    sender->m_mtu = MIN(ifr.ifr_mtu, 0xFFFF);
+    if (sender->m_mtu < MIN_MTU_SENDER)
+        sender->m_mtu = MIN_MTU_SENDER;
+    sender->m_id = getpid();
+
+    if (is_enabled_udp_stage()) {
+        int flags = SOF_TIMESTAMPING_TX_SOFTWARE | SOF_TIMESTAMPING_SOFTWARE | \
+                SOF_TIMESTAMPING_OPT_TSONLY;
+
+        sender->m_is_timestamping = setsockopt(sender->m_fd, SOL_SOCKET, \
+                SO_TIMESTAMPING, &flags, sizeof(flags)) == 0;
+    }
+    add_sender_udp_export(sender);
+
+    return sender;
+give_not_siocgifmtu:
+give_not_siocgifindex:
+    close(sender->m_fd);
+give_not_fd_socket:
+    free(sender);
+get_not_memory:
+    return NULL;
+}
+
+udp_sender_t init_pcap_udp_sender(const char * const file, const uint16_t mtu) {
+    struct file_pcap_sender header = {
+        .m_magic = MAGIC_NANO_PCAP_SENDER,
+        .m_major = 2,
+        .m_minor = 4,
+        .m_snaplen = SNAPLEN_SENDER,
+        .m_link = LINK_ETHERNET_SENDER,
+    };
+    udp_sender_t sender = alloc_sender();
+
+    if (sender == NULL)
+        goto get_not_memory;
+
+    sender->m_buffer = malloc(SIZE_BUFFER_SENDER);
+    if (sender->m_buffer == NULL)
+        goto get_not_buffer;
+
+    sender->m_fd = open(file, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (sender->m_fd < 0) {
+        perror("ERROR: open not pcap file");
+        goto open_not_file;
+    }
+
+    sender->m_backend = BACKEND_PCAP_SENDER;
+    sender->m_mtu = mtu < MIN_MTU_SENDER ? MIN_MTU_SENDER : mtu;
+    sender->m_id = getpid();
+    memcpy(sender->m_buffer, &header, sizeof(header));
+    sender->m_used = sizeof(header);
+    add_sender_udp_export(sender);
+
+    return sender;
+open_not_file:
+    free(sender->m_buffer);
+get_not_buffer:
+    free(sender);
+get_not_memory:
+    return NULL;
+}
+
+udp_sender_t init_store_udp_sender(const char * const file, const uint16_t mtu) {
+    udp_sender_t sender = alloc_sender();
+
+    if (sender == NULL)
+        goto get_not_memory;
+
+    sender->m_store = init_udp_store(file);
+    if (sender->m_store == NULL)
+        goto get_not_store;
+
+    sender->m_fd = -1;
+    sender->m_backend = BACKEND_STORE_SENDER;
+    sender->m_mtu = mtu < MIN_MTU_SENDER ? MIN_MTU_SENDER : mtu;
+    sender->m_id = getpid();
+    add_sender_udp_export(sender);
+
+    return sender;
+get_not_store:
+    free(sender);
+get_not_memory:
+    return NULL;
+}
+
+udp_sender_t init_pack_udp_sender(udp_pack_t pack) {
+    struct ifreq ifr = {0};
+    uint16_t mtu = ETH_DATA_LEN;
+    int fd = -1;
+
+    if (pack->m_output == NULL)
+        return init_udp_sender(pack->m_interface);
+
+    /* MTU of interface is readable without root, frames are same as on wire. */
+    fd = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    if (fd >= 0 && pack->m_interface[0] != '\0') {
+        memcpy(ifr.ifr_name, pack->m_interface, IFNAMSIZ - 1);
+        if (ioctl(fd, SIOCGIFMTU, &ifr) == 0)
+            mtu = MIN(ifr.ifr_mtu, 0xFFFF);
+    }
+    if (fd >= 0)
+        close(fd);
+
+    if (pack->m_output_type == OUTPUT_STORE_UDP_PACK)
+        return init_store_udp_sender(pack->m_output, mtu);
+
+    return init_pcap_udp_sender(pack->m_output, mtu);
+}
+
+/**
+ * @ingroup UdpSender
+ * @brief Function write buffer in pcap file.
+ * @param[in,out] sender Sender with BACKEND_PCAP_SENDER.
+ * @return 0 or -1 on error.
+ * @note This function is private. Not used outside udp_lib/sender.c
+ */
+static ssize_t flush_pcap_sender(udp_sender_t sender) {
+    size_t written = 0;
+    int error = 0;
+
+    while (written < sender->m_used) {
+        ssize_t ret = write(sender->m_fd, sender->m_buffer + written, \
+                sender->m_used - written);
+
+        if (ret < 0) {
+            if (errno == EINTR)
+                continue;
+            /* Errno is kept for counters of sender. */
+            error = errno;
+            perror("ERROR: write not pcap file");
+            errno = error;
+            return -1;
+        }
+        written += ret;
+    }
+
+    sender->m_used = 0;
+    sender->m_pending = 0;
+
+    return 0;
+}
+
+/**
+ * @ingroup UdpSender
+ * @brief Function append frames in buffer pcap file.
+ * @param[in,out] sender Sender with BACKEND_PCAP_SENDER.
+ * @param[in] messages Frames as for sendmmsg.
+ * @param[in] count Count frames.
+ * @return Count written frames or -1 on error.
+ * @note This function is private. Not used outside udp_lib/sender.c
+ */
+static ssize_t write_pcap_sender(udp_sender_t sender, \
+        const struct mmsghdr * const messages, const size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        const struct msghdr * message = &messages[i].msg_hdr;
+        struct record_pcap_sender record = {0};
+        struct timespec ts;
+        size_t size = 0;
+
+        for (size_t j = 0; j < message->msg_iovlen; j++)
+            size += message->msg_iov[j].iov_len;
+
+        if (sizeof(record) + size > SIZE_BUFFER_SENDER - sender->m_used && \
+                flush_pcap_sender(sender))
+            return i ? (ssize_t)i : -1;
+
+        clock_gettime(CLOCK_REALTIME, &ts);
+        record.m_seconds = ts.tv_sec;
+        record.m_nanoseconds = ts.tv_nsec;
+        record.m_size = size;
+        record.m_size_original = size;
+        memcpy(sender->m_buffer + sender->m_used, &record, sizeof(record));
+        sender->m_used += sizeof(record);
+
+        for (size_t j = 0; j < message->msg_iovlen; j++) {
+            memcpy(sender->m_buffer + sender->m_used, message->msg_iov[j].iov_base, \
+                    message->msg_iov[j].iov_len);
+            sender->m_used += message->msg_iov[j].iov_len;
+        }
+        sender->m_pending++;
+    }
+
+    return count;
+}
+
+/**
+ * @ingroup UdpSender
+ * @brief Function wait after full queue, every wait in a row is twice longer.
+ * @param[in,out] sender Sender for work.
+ * @note This function is private. Not used outside udp_lib/sender.c
+ */
+static void backoff_sender(udp_sender_t sender) {
+    struct timespec wait = {0};
+
+    sender->m_backoff *= 2;
+    if (sender->m_backoff < MIN_BACKOFF_SENDER)
+        sender->m_backoff = MIN_BACKOFF_SENDER;
+    if (sender->m_backoff > MAX_BACKOFF_SENDER)
+        sender->m_backoff = MAX_BACKOFF_SENDER;
+
+    wait.tv_nsec = sender->m_backoff;
+    nanosleep(&wait, NULL);
+}
+
+/**
+ * @ingroup UdpSender
+ * @brief Function send frames in raw socket, full queue is waited by backoff.
+ * @param[in,out] sender Sender with BACKEND_SOCKET_SENDER.
+ * @param[in] messages Frames as for sendmmsg.
+ * @param[in] count Count frames.
+ * @return Count sended frames or -1 on error, errno is kept.
+ * @note This function is private. Not used outside udp_lib/sender.c
+ */
+static ssize_t send_socket_sender(udp_sender_t sender, struct mmsghdr * const messages, \
+        const size_t count) {
+    size_t sended = 0;
+    size_t retries = 0;
+
+    while (sended < count) {
+        size_t batch = MIN(count - sended, sender->m_batch);
+        ssize_t ret = sendmmsg(sender->m_fd, messages + sended, batch, 0);
+
+        if (ret > 0) {
+            /* Error of first not taken frame is returned by next call. */
+            if ((size_t)ret < batch) {
+                lock_stats_sender(sender);
+                count_sender(&sender->m_stats.m_short, 1);
+                unlock_stats_sender(sender);
+            }
+            sended += ret;
+            /* Limit of retries is for queue without progress, not for whole send. */
+            retries = 0;
+            sender->m_backoff >>= 1;
+            continue;
+        }
+        if (ret == 0)
+            break;
+        if (errno == EINTR)
+            continue;
+        if (errno != ENOBUFS && errno != EAGAIN)
+            break;
+
+        lock_stats_sender(sender);
+        count_sender(&sender->m_stats.m_full, 1);
+        count_sender(&sender->m_stats.m_retries, retries < MAX_RETRIES_SENDER);
+        unlock_stats_sender(sender);
+        if (retries == MAX_RETRIES_SENDER)
+            break;
+        retries++;
+        backoff_sender(sender);
+    }
+
+    return sended ? (ssize_t)sended : -1;
+}
+
+/**
+ * @ingroup UdpSender
+ * @brief Function take TX timestamps of driver and record time from start of send.
+ *
+ * Timestamps not ready yet are taken after next send and are older than its
+ * start, such timestamps are skipped.
+ * @param[in,out] sender Sender with timestamping.
+ * @param[in] start Nanoseconds CLOCK_REALTIME before send.
+ * @note This function is private. Not used outside udp_lib/sender.c
+ */
+static void complete_sender(udp_sender_t sender, const uint64_t start) {
+    struct mmsghdr messages[MAX_BATCH_SENDER];
+    uint8_t controls[MAX_BATCH_SENDER][SIZE_CONTROL_SENDER];
+    int ret = 0;
+
+    do {
+        memset(messages, 0x00, sizeof(messages));
+        for (size_t i = 0; i < MAX_BATCH_SENDER; i++) {
+            messages[i].msg_hdr.msg_control = controls[i];
+            messages[i].msg_hdr.msg_controllen = SIZE_CONTROL_SENDER;
+        }
+
+        ret = recvmmsg(sender->m_fd, messages, MAX_BATCH_SENDER, \
+                MSG_ERRQUEUE | MSG_DONTWAIT, NULL);
+
+        for (int i = 0; i < ret; i++) {
+            struct msghdr * message = &messages[i].msg_hdr;
+
+            for (struct cmsghdr * control = CMSG_FIRSTHDR(message); control; \
+                    control = CMSG_NXTHDR(message, control)) {
+                struct scm_timestamping stamps;
+                uint64_t stamp = 0;
+
+                if (control->cmsg_level != SOL_SOCKET || \
+                        control->cmsg_type != SCM_TIMESTAMPING)
+                    continue;
+                memcpy(&stamps, CMSG_DATA(control), sizeof(stamps));
+                stamp = get_nsec_clock(&stamps.ts[0]);
+                if (stamp >= start)
+                    record_udp_stage(COMPLETION_STAGE, stamp - start);
+            }
+        }
+    } while (ret == MAX_BATCH_SENDER);
+}
+
+/**
+ * @ingroup UdpSender
+ * @brief Function give frames to backend of sender and count result.
+ * @param[in,out] sender Sender for work.
+ * @param[in] messages Frames as for sendmmsg.
+ * @param[in] count Count frames.
+ * @return Count sended frames or -1 on error, errno is kept.
+ * @note This function is private. Not used outside udp_lib/sender.c
+ */
+static ssize_t transmit_sender(udp_sender_t sender, struct mmsghdr * const messages, \
+        const size_t count) {
+    ssize_t ret = 0;
+    size_t sended = 0;
+    uint64_t bytes = 0;
+    uint64_t start = 0;
+    uint64_t begin = begin_udp_stage();
+    int error = 0;
+
+    FIRE2_PROBE(send_start, sender, count);
+    if (sender->m_is_timestamping) {
+        struct timespec ts;
+
+        clock_gettime(CLOCK_REALTIME, &ts);
+        start = get_nsec_clock(&ts);
+    }
+
+    if (sender->m_backend == BACKEND_PCAP_SENDER) {
+        ret = write_pcap_sender(sender, messages, count);
+    } else if (sender->m_backend == BACKEND_STORE_SENDER) {
+        for (; sended < count; sended++) {
+            if (add_frame_udp_store(sender->m_store, messages[sended].msg_hdr.msg_iov, \
+                    messages[sended].msg_hdr.msg_iovlen))
+                break;
+        }
+        sender->m_pending += sended;
+        ret = sended ? (ssize_t)sended : -1;
+    } else {
+        ret = send_socket_sender(sender, messages, count);
+    }
+    error = errno;
+    end_udp_stage(SYSCALL_STAGE, begin);
+
+    if (sender->m_is_timestamping && ret > 0)
+        complete_sender(sender, start);
+
+    sended = ret > 0 ? (size_t)ret : 0;
+    for (size_t i = 0; i < sended; i++) {
+        for (size_t j = 0; j < messages[i].msg_hdr.msg_iovlen; j++)
+            bytes += messages[i].msg_hdr.msg_iov[j].iov_len;
+    }
+    lock_stats_sender(sender);
+    count_sender(&sender->m_stats.m_packets, sended);
+    count_sender(&sender->m_stats.m_bytes, bytes);
+    if (sended < count) {
+        count_sender(&sender->m_stats.m_errors, count - sended);
+        count_sender(&sender->m_stats.m_errnos[error > 0 && error < COUNT_ERRNO_SENDER ? \
+                error : COUNT_ERRNO_SENDER - 1], count - sended);
+    }
+    unlock_stats_sender(sender);
+
+    FIRE4_PROBE(send_end, sender, count, ret, bytes);
+    if (sended < count)
+        FIRE3_PROBE(send_error, sender, error, count - sended);
+    errno = error;
+
+    return ret;
+}
+
+/**
+ * @ingroup UdpSender
+ * @brief Function send UDP package above MTU as IPv4 fragments.
+ *
+ * Checksum UDP is already calculated over whole datagram. Every fragment is two
+ * pieces: own copy ethernet and IP headers, and slice of UDP header and data
+ * straight from package, so data is never copied. Fragments go by sendmmsg in
+ * chunks of @ref MAX_FRAGMENTS_SENDER, small MTU gives up to 1365 fragments.
+ * @param[in,out] sender Sender for work.
+ * @param[in,out] pack UDP package with calculated checksum.
+ * @return 0 or -1 on error.
+ * @note This function is private. Not used outside udp_lib/sender.c
+ */
+static ssize_t send_fragments_sender(udp_sender_t sender, udp_pack_t pack) {
+    struct mmsghdr messages[MAX_FRAGMENTS_SENDER];
+    struct iovec vectors[MAX_FRAGMENTS_SENDER][2];
+    uint8_t * payload = (uint8_t *)pack->m_head;
+    size_t size = ntohs(pack->m_iphdr->tot_len) - HEAD_IP;
+    size_t slice = (sender->m_mtu - HEAD_IP) & ~(size_t)7;
+    size_t count = (size + slice - 1) / slice;
+    uint16_t id = htons(sender->m_id++);
+
+    for (size_t first = 0; first < count; first += MAX_FRAGMENTS_SENDER) {
+        size_t chunk = MIN(MAX_FRAGMENTS_SENDER, count - first);
+
+        memset(messages, 0x00, sizeof(*messages) * chunk);
+
+        for (size_t j = 0; j < chunk; j++) {
+            struct fragment_sender * fragment = &sender->m_fragments[j];
+            size_t offset = (first + j) * slice;
+            size_t length = MIN(slice, size - offset);
+            uint16_t flags = (first + j + 1 < count) ? IP_MF : 0;
+
+            fragment->m_ethhdr = *pack->m_ethhdr;
+            fragment->m_iphdr = *pack->m_iphdr;
+            fragment->m_iphdr.id = id;
+            fragment->m_iphdr.tot_len = htons(HEAD_IP + length);
+            fragment->m_iphdr.frag_off = htons(flags | (offset >> 3));
+            fragment->m_iphdr.check = NULL_CHECKSUM;
+            fragment->m_iphdr.check = checksum_compute( \
+                    sum_compute(&fragment->m_iphdr, HEAD_IP));
+
+            vectors[j][0].iov_base = fragment;
+            vectors[j][0].iov_len = sizeof(*fragment);
+            vectors[j][1].iov_base = payload + offset;
+            vectors[j][1].iov_len = length;
+
+            messages[j].msg_hdr.msg_iov = vectors[j];
+            messages[j].msg_hdr.msg_iovlen = 2;
+            messages[j].msg_hdr.msg_name = &sender->m_address;
+            messages[j].msg_hdr.msg_namelen = sizeof(sender->m_address);
+        }
+
+        /* Headers of chunk are reused by next chunk, backends copy frames. */
+        if (transmit_sender(sender, messages, chunk) != (ssize_t)chunk) {
+            perror("ERROR: send not fragments udp pack");
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+ssize_t send_udp_sender(udp_sender_t sender, udp_pack_t pack) {
+    ssize_t ret = 0;
+    struct iovec vector = {0};
+    struct mmsghdr message = {0};
+    uint64_t begin = begin_udp_stage();
+
+    if (!(pack->m_flags & FLAG_RESOLVED_UDP_PACK))
+        resolve_mac_address_udp_pack(pack);
+
+    vector.iov_base = get_pack_udp_pack(pack);
+    vector.iov_len = get_size_pack_udp_pack(pack);
+    message.msg_hdr.msg_iov = &vector;
+    message.msg_hdr.msg_iovlen = 1;
+    message.msg_hdr.msg_name = &sender->m_address;
+    message.msg_hdr.msg_namelen = sizeof(sender->m_address);
+    end_udp_stage(BUILD_STAGE, begin);
+
+    begin = begin_udp_stage();
+    calculate_checksum_udp_pack(pack);
+    end_udp_stage(CHECKSUM_STAGE, begin);
+
+    if (pack->m_encap != NULL) {
+        if (get_size_pack_udp_pack(pack) - HEAD_ETH + \
+                get_overhead_udp_encap(pack->m_encap) > sender->m_mtu) {
+            fputs("ERROR: encapsulated package is bigger than MTU\n", stderr);
+            return -1;
+        }
+    } else if (get_size_pack_udp_pack(pack) - HEAD_ETH > sender->m_mtu) {
+        if (pack->m_family == AF_INET)
+            return send_fragments_sender(sender, pack);
+        fputs("ERROR: IPv6 package is bigger than MTU\n", stderr);
+        return -1;
+    }
+
+    if (pack->m_encap != NULL)
+        vector.iov_base = wrap_udp_encap(pack, &vector.iov_len);
+    ret = transmit_sender(sender, &message, 1);
+    if (pack->m_encap != NULL)
+        unwrap_udp_encap(pack);
+
+    if (ret < 0) {
+        perror("ERROR: send not udp pack");
+        goto send_not_udp_pack;
+    }
+
+    return 0;
+send_not_udp_pack:
+    return ret;
+}
+
+ssize_t send_repeat_udp_sender(udp_sender_t sender, udp_pack_t pack, \
+        const uint64_t count) {
+    struct iovec frames[MAX_BATCH_SENDER];
+    struct iovec frame = {0};
+    uint64_t sended = 0;
+    uint64_t done = 1;
+
+    if (count == 0)
+        return 0;
+
+    if (send_udp_sender(sender, pack) == 0)
+        sended++;
+
+    /* Fragmented datagram is not one frame, it go by full path every time. */
+    if (get_size_pack_udp_pack(pack) - HEAD_ETH > sender->m_mtu) {
+        for (; done < count; done++) {
+            if (send_udp_sender(sender, pack) == 0)
+                sended++;
+        }
+        return sended;
+    }
+    /* Encapsulated package bigger than MTU is refused by first send. */
+    if (pack->m_encap != NULL && get_size_pack_udp_pack(pack) - HEAD_ETH + \
+            get_overhead_udp_encap(pack->m_encap) > sender->m_mtu)
+        return sended;
+
+    frame.iov_base = get_pack_udp_pack(pack);
+    frame.iov_len = get_size_pack_udp_pack(pack);
+    if (pack->m_encap != NULL)
+        frame.iov_base = wrap_udp_encap(pack, &frame.iov_len);
+    for (size_t i = 0; i < MAX_BATCH_SENDER; i++)
+        frames[i] = frame;
+
+    while (done < count) {
+        size_t batch = MIN(count - done, MAX_BATCH_SENDER);
+        ssize_t ret = send_batch_udp_sender(sender, frames, batch);
+
+        if (ret > 0)
+            sended += ret;
+        done += batch;
+    }
+
+    if (pack->m_encap != NULL)
+        unwrap_udp_encap(pack);
+
+    return sended;
+}
+
+ssize_t send_batch_udp_sender(udp_sender_t sender, \
+        const struct iovec * const frames, const size_t count) {
+    return send_scatter_udp_sender(sender, frames, 1, count);
+}
+
+ssize_t send_scatter_udp_sender(udp_sender_t sender, \
+        const struct iovec * const parts, const size_t parts_frame, \
+        const size_t count) {
+    struct mmsghdr messages[MAX_BATCH_SENDER];
+    size_t sended = 0;
+
+    while (sended < count) {
+        size_t batch = MIN(count - sended, MAX_BATCH_SENDER);
+        ssize_t ret = 0;
+
+        memset(messages, 0x00, sizeof(*messages) * batch);
+        for (size_t i = 0; i < batch; i++) {
+            messages[i].msg_hdr.msg_iov = \
+                    (struct iovec *)&parts[(sended + i) * parts_frame];
+            messages[i].msg_hdr.msg_iovlen = parts_frame;
+            messages[i].msg_hdr.msg_name = &sender->m_address;
+            messages[i].msg_hdr.msg_namelen = sizeof(sender->m_address);
+        }
+
+        ret = transmit_sender(sender, messages, batch);
+
+        if (ret < 0) {
+            if (sended)
+                break;
+            perror("ERROR: send not batch frames");
+            return ret;
+        }
+
+        sended += ret;
+
+        if ((size_t)ret < batch)
+            break;
+    }
+
+    return sended;
+}
+
+ssize_t set_batch_udp_sender(const size_t batch) {
+    if (batch == 0 || batch > MAX_BATCH_SENDER) {
+        fprintf(stderr, "ERROR: batch is out of range 1-%d\n", MAX_BATCH_SENDER);
+        return -1;
+    }
+    batch_sender = batch;
+
+    return 0;
+}
+
+uint16_t get_mtu_udp_sender(udp_sender_t sender) {
+    return sender->m_mtu;
+}
+
+const char * get_interface_udp_sender(udp_sender_t sender) {
+    return sender->m_interface;
+}
+
+void get_stats_udp_sender(udp_sender_t sender, struct udp_sender_stats * const stats) {
+    const uint64_t * from = (const uint64_t *)&sender->m_stats;
+    uint64_t * to = (uint64_t *)stats;
+    uint64_t sequence = 0;
+
+    /* Seqlock: copy is taken again if sender wrote counters meanwhile. */
+    do {
+        while ((sequence = __atomic_load_n(&sender->m_sequence, __ATOMIC_ACQUIRE)) & 1)
+            sched_yield();
+        for (size_t i = 0; i < sizeof(*stats) / sizeof(*to); i++)
+            to[i] = __atomic_load_n(&from[i], __ATOMIC_RELAXED);
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    } while (__atomic_load_n(&sender->m_sequence, __ATOMIC_RELAXED) != sequence);
+}
+
+void print_stats_udp_sender(udp_sender_t sender) {
+    struct udp_sender_stats stats;
+
+    get_stats_udp_sender(sender, &stats);
+
+    printf("sender packages: %lu bytes: %lu errors: %lu retries: %lu full: %lu " \
+            "short: %lu\n", stats.m_packets, stats.m_bytes, stats.m_errors, \
+            stats.m_retries, stats.m_full, stats.m_short);
+    for (size_t i = 0; i < COUNT_ERRNO_SENDER; i++) {
+        if (stats.m_errnos[i])
+            printf("  errno %zu (%s): %lu\n", i, \
+                    i + 1 < COUNT_ERRNO_SENDER ? strerror(i) : "other", stats.m_errnos[i]);
+    }
+}
+
+ssize_t finish_udp_sender(udp_sender_t sender) {
+    ssize_t ret = 0;
+    int error = 0;
+
+    if (sender->m_is_finished)
+        return ret;
+    sender->m_is_finished = true;
+
+    if (sender->m_backend == BACKEND_PCAP_SENDER)
+        ret = flush_pcap_sender(sender);
+    else if (sender->m_backend == BACKEND_STORE_SENDER)
+        ret = finish_udp_store(sender->m_store);
+    error = errno;
+
+    if (ret && sender->m_pending) {
+        /* Frames were counted as sended when taken in buffer, now they are lost. */
+        lock_stats_sender(sender);
+        count_sender(&sender->m_stats.m_errors, sender->m_pending);
+        count_sender(&sender->m_stats.m_errnos[error > 0 && error < COUNT_ERRNO_SENDER ? \
+                error : COUNT_ERRNO_SENDER - 1], sender->m_pending);
+        unlock_stats_sender(sender);
+    }
+    sender->m_pending = 0;
+
+    return ret;
+}
+
+void destroy_udp_sender(udp_sender_t sender) {
+    if (sender == NULL)
+        return;
+    remove_sender_udp_export(sender);
+    finish_udp_sender(sender);
+    if (sender->m_backend == BACKEND_STORE_SENDER) {
+        destroy_udp_store(sender->m_store);
+    } else {
+        close(sender->m_fd);
+    }
+    free(sender->m_buffer);
+    free(sender);
+}
@@ -0,0 +1,307 @@
+/**
+ * @file udp_lib/sender.h
+ * @author Vladsanin777
+ * @brief Header file for reusable sender UDP packages.
+ */
+
+#ifndef UDP_LIB_SENDER_H
+#define UDP_LIB_SENDER_H
+
+#include "udp_lib/udp.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#include <sys/uio.h>
+
+/**
+ * @defgroup UdpSender sender for udp
+ * @brief Group function for send UDP packages through one opened socket.
+ *
+ * When queue of interface is full (ENOBUFS or EAGAIN) sender waits and sends
+ * rest again. Wait is doubled on every full queue up to @ref MAX_BACKOFF_SENDER
+ * and halved on every good send, after @ref MAX_RETRIES_SENDER waits in a row
+ * frames are counted as errors. Every sender counts what really reached kernel
+ * or file, counters are written only by thread of sender under seqlock and read
+ * from any thread without blocking sender.
+ * @{
+ */
+
+/** Max frames in one call sendmmsg. */
+#define MAX_BATCH_SENDER 64
+
+/** Count errno values counted apart, bigger values are counted in last. */
+#define COUNT_ERRNO_SENDER 136
+
+/** Min wait after full queue in nanoseconds. */
+#define MIN_BACKOFF_SENDER 1000
+
+/** Max wait after full queue in nanoseconds. */
+#define MAX_BACKOFF_SENDER 1000000
+
+/** Max waits in a row before frames are errors. */
+#define MAX_RETRIES_SENDER 32
+
+/**
+ * @brief Struct is counters of sender.
+ */
+struct udp_sender_stats {
+    uint64_t m_packets; /**< Frames taken by kernel or file. */
+    uint64_t m_bytes; /**< Bytes of taken frames. */
+    uint64_t m_errors; /**< Frames not taken. */
+    uint64_t m_retries; /**< Sends repeated after full queue. */
+    uint64_t m_full; /**< Times queue was full (ENOBUFS or EAGAIN). */
+    uint64_t m_short; /**< Sends taken only part of frames. */
+    uint64_t m_errnos[COUNT_ERRNO_SENDER]; /**< Frames not taken by errno, sum is m_errors. */
+};
+
+/**
+ * @brief Private struct sender. (Hidden implementation)
+ */
+struct udp_sender;
+
+/**
+ * @brief Sender descriptor.
+ *
+ * Keep raw socket and address of interface between sends.
+ */
+typedef struct udp_sender * udp_sender_t;
+
+/**
+ * @brief Function for create sender on interface.
+ * @note You must call @ref destroy_udp_sender after this.
+ * @param[in] interface Interface to send UDP packages.
+ * @return pointer or null on error.
+ * Usage example.
+ * @code
+ * ssize_t ret = 0;
+ * udp_sender_t sender = init_udp_sender("lo");
+ * if (sender == NULL) {
+ *     ret = -1;
+ *     goto get_not_sender;
+ * }
+ * // other code whit using udp_sender_t
+ * destroy_udp_sender(sender);
+ * get_not_sender:
+ * @endcode
+ */
+udp_sender_t init_udp_sender(const char * const interface);
+
+/**
+ * @brief Function for create sender writing frames in pcap file.
+ *
+ * Frames are same as on interface with given MTU, with nanosecond timestamps.
+ * File is written by big sequential writes of buffer, root is not needed.
+ * @note You must call @ref finish_udp_sender after this, it write rest of buffer,
+ * and @ref destroy_udp_sender.
+ * @param[in] file Path to pcap file, it is truncated.
+ * @param[in] mtu MTU for fragmentation of big datagrams.
+ * @return pointer or null on error.
+ * Usage example.
+ * @code
+ * udp_sender_t sender = init_pcap_udp_sender("corpus.pcap", 1500);
+ * if (sender == NULL)
+ *     goto get_not_sender;
+ * // other code whit using udp_sender_t
+ * destroy_udp_sender(sender);
+ * get_not_sender:
+ * @endcode
+ */
+udp_sender_t init_pcap_udp_sender(const char * const file, const uint16_t mtu);
+
+/**
+ * @brief Function for create sender writing frames in store of ready frames.
+ * @note You must call @ref finish_udp_sender after this, it write index store,
+ * and @ref destroy_udp_sender.
+ * @param[in] file Path to store file, it is truncated.
+ * @param[in] mtu MTU for fragmentation of big datagrams.
+ * @return pointer or null on error.
+ * Usage example.
+ * @code
+ * udp_sender_t sender = init_store_udp_sender("corpus.store", 1500);
+ * if (sender == NULL)
+ *     goto get_not_sender;
+ * // other code whit using udp_sender_t
+ * destroy_udp_sender(sender);
+ * get_not_sender:
+ * @endcode
+ */
+udp_sender_t init_store_udp_sender(const char * const file, const uint16_t mtu);
+
+/**
+ * @brief Function for create sender for UDP package.
+ *
+ * File set by @ref set_pcap_udp_pack or @ref set_store_udp_pack is used,
+ * else interface UDP package.
+ * @note You must call @ref destroy_udp_sender after this.
+ * @param[in] pack UDP package.
+ * @return pointer or null on error.
+ * Usage example.
+ * @code
+ * udp_sender_t sender = init_pack_udp_sender(pack);
+ * if (sender == NULL)
+ *     goto get_not_sender;
+ * @endcode
+ */
+udp_sender_t init_pack_udp_sender(udp_pack_t pack);
+
+/**
+ * @brief Function calculate checksum and send UDP package.
+ * @note You must call @ref init_udp_sender before this.
+ * @note Package bigger than MTU interface is sended as IPv4 fragments.
+ * @note Mac addresses not set by user are resolved before first send, see @ref resolve_mac_address_udp_pack.
+ * @param[in,out] sender Sender for work.
+ * @param[in,out] pack UDP package to send.
+ * @return 0 or -1 on error.
+ * Usage example.
+ * @code
+ * ret = send_udp_sender(sender, pack);
+ * if (ret)
+ *     goto send_not_udp_pack;
+ * @endcode
+ */
+ssize_t send_udp_sender(udp_sender_t sender, udp_pack_t pack);
+
+/**
+ * @brief Function send same UDP package count times.
+ *
+ * First package go through @ref send_udp_sender, repeats are the same
+ * ready frame sent by batches without new checksum.
+ * @param[in,out] sender Sender for work.
+ * @param[in,out] pack UDP package to send.
+ * @param[in] count Count packages.
+ * @return Count sended packages.
+ * Usage example.
+ * @code
+ * if (send_repeat_udp_sender(sender, pack, 1000) != 1000)
+ *     puts("not all packages sended");
+ * @endcode
+ */
+ssize_t send_repeat_udp_sender(udp_sender_t sender, udp_pack_t pack, \
+        const uint64_t count);
+
+/**
+ * @brief Function send ready frames by one system call.
+ * @note Frames must start with ethernet header and have valid checksums.
+ * @param[in,out] sender Sender for work.
+ * @param[in] frames Array of frames.
+ * @param[in] count Count frames in array.
+ * @return Count sended frames or -1 on error.
+ * Usage example.
+ * @code
+ * struct iovec frames[2] = {{frame_0, size_0}, {frame_1, size_1}};
+ * ret = send_batch_udp_sender(sender, frames, 2);
+ * if (ret < 0)
+ *     goto send_not_frames;
+ * @endcode
+ */
+ssize_t send_batch_udp_sender(udp_sender_t sender, \
+        const struct iovec * const frames, const size_t count);
+
+/**
+ * @brief Function send ready frames gathered from several pieces by one system call.
+ *
+ * Every frame is parts_frame pieces going in a row, pieces are not copied
+ * before kernel, so headers can be rewritten apart from untouched data.
+ * @note Frames must start with ethernet header and have valid checksums.
+ * @param[in,out] sender Sender for work.
+ * @param[in] parts Array of pieces, count * parts_frame items.
+ * @param[in] parts_frame Count pieces in one frame.
+ * @param[in] count Count frames in array.
+ * @return Count sended frames or -1 on error.
+ * Usage example.
+ * @code
+ * struct iovec parts[2][2] = {
+ *     {{head_0, size_head_0}, {data_0, size_data_0}},
+ *     {{head_1, size_head_1}, {data_1, size_data_1}},
+ * };
+ * ret = send_scatter_udp_sender(sender, parts[0], 2, 2);
+ * if (ret < 0)
+ *     goto send_not_frames;
+ * @endcode
+ */
+ssize_t send_scatter_udp_sender(udp_sender_t sender, \
+        const struct iovec * const parts, const size_t parts_frame, \
+        const size_t count);
+
+/**
+ * @brief Function set max frames in one call sendmmsg for senders created after.
+ *
+ * Batches of send functions are split in calls of at most this count frames,
+ * by default @ref MAX_BATCH_SENDER.
+ * @param[in] batch Count frames from 1 to @ref MAX_BATCH_SENDER.
+ * @return 0 or -1 on error.
+ * Usage example.
+ * @code
+ * ret = set_batch_udp_sender(8);
+ * if (ret)
+ *     goto set_not_batch;
+ * @endcode
+ */
+ssize_t set_batch_udp_sender(const size_t batch);
+
+/**
+ * @brief Function for getting MTU interface sender.
+ * @param[in] sender Sender for work.
+ * @return MTU detected by SIOCGIFMTU.
+ */
+uint16_t get_mtu_udp_sender(udp_sender_t sender);
+
+/**
+ * @brief Function for getting interface of sender.
+ * @param[in] sender Sender for work.
+ * @return Name interface, empty for file.
+ */
+const char * get_interface_udp_sender(udp_sender_t sender);
+
+/**
+ * @brief Function read counters of sender.
+ * @note Can be called from any thread while sender works, all counters are
+ * taken at one moment, sender never waits reader.
+ * @param[in] sender Sender for work.
+ * @param[out] stats Counters.
+ * Usage example.
+ * @code
+ * struct udp_sender_stats stats;
+ * get_stats_udp_sender(sender, &stats);
+ * printf("on wire: %lu\n", stats.m_packets);
+ * @endcode
+ */
+void get_stats_udp_sender(udp_sender_t sender, struct udp_sender_stats * const stats);
+
+/**
+ * @brief Function print counters of sender, errno only not zero.
+ * @param[in] sender Sender for work.
+ * Usage example.
+ * @code
+ * print_stats_udp_sender(sender);
+ * @endcode
+ */
+void print_stats_udp_sender(udp_sender_t sender);
+
+/**
+ * @brief Function write rest of frames in file of sender: buffer of pcap file or
+ * index of store.
+ * @note Frames lost by failed write are added to errors of sender. Sender on
+ * interface has nothing to write. Called once, next calls return 0.
+ * @param[in,out] sender Sender for work.
+ * @return 0 or -1 on error, file is not whole then.
+ * Usage example.
+ * @code
+ * ret = finish_udp_sender(sender);
+ * print_stats_udp_sender(sender);
+ * destroy_udp_sender(sender);
+ * @endcode
+ */
+ssize_t finish_udp_sender(udp_sender_t sender);
+
+/**
+ * @brief Function close socket and free sender.
+ * @note Sender not finished by @ref finish_udp_sender is finished here, error is lost.
+ * @param[in,out] sender Sender for work.
+ */
+void destroy_udp_sender(udp_sender_t sender);
+
+/** @} */
+
+#endif /* UDP_LIB_SENDER_H */
@@ -0,0 +1,329 @@
+/**
+ * @file udp_lib/stage.c
+ * @author Vladsanin777
+ * @brief Code file for latency of stages of send path by TSC.
+ */
+
+#include "udp_lib/stage.h"
+#include "udp_lib/clock_private.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <errno.h>
+#include <time.h>
+#include <signal.h>
+#include <sched.h>
+#include <pthread.h>
+
+#include <sys/eventfd.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+/** Nanoseconds of calibration TSC. */
+#define CALIBRATION_STAGE 20000000ULL
+
+/**
+ * @ingroup UdpStage
+ * @brief Struct is histograms of one thread.
+ * @note This struct is private. Not used outside udp_lib/stage.c
+ */
+struct thread_stage {
+    udp_histogram_t m_histograms[COUNT_STAGE]; /**< Histogram of every stage. */
+    uint32_t m_sequence; /**< Seqlock of histograms, odd while thread records. */
+    size_t m_number; /**< Number of thread in output. */
+    struct thread_stage * m_next; /**< Next thread in list. */
+};
+
+/** Names stages in output. */
+static const char * const names_stage[COUNT_STAGE] = {
+    "build", "checksum", "queue", "syscall", "completion",
+};
+
+/** Instrumentation is on. */
+static bool is_enabled_stage = false;
+
+/** Nanoseconds in 2^32 counts of clock. */
+static uint64_t scale_stage = 1ULL << 32;
+
+/** eventfd for wake thread printing histograms. */
+static int fd_event_stage = -1;
+
+/** Histograms of all threads, new threads are added to head. */
+static struct thread_stage * threads_stage = NULL;
+
+/** Count threads in list. */
+static size_t count_threads_stage = 0;
+
+/** Lock of list threads and of output. */
+static pthread_mutex_t lock_stage = PTHREAD_MUTEX_INITIALIZER;
+
+/** Histograms of current thread. */
+static __thread struct thread_stage * local_stage = NULL;
+
+/** Snapshot of histogram of one thread for output, used under lock_stage. */
+static udp_histogram_t snapshot_stage = NULL;
+
+/**
+ * @ingroup UdpStage
+ * @brief Function read clock of stages.
+ * @return Counter TSC or nanoseconds CLOCK_MONOTONIC.
+ * @note This function is private. Not used outside udp_lib/stage.c
+ */
+static inline uint64_t now_stage(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return now_clock();
+#endif
+}
+
+/**
+ * @ingroup UdpStage
+ * @brief Function find scale of TSC to nanoseconds by CLOCK_MONOTONIC.
+ * @note This function is private. Not used outside udp_lib/stage.c
+ */
+static void calibrate_stage(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    struct timespec wait = {.tv_nsec = CALIBRATION_STAGE};
+    uint64_t start = now_clock();
+    uint64_t start_tsc = __rdtsc();
+    uint64_t finish = 0;
+    uint64_t finish_tsc = 0;
+
+    nanosleep(&wait, NULL);
+    finish = now_clock();
+    finish_tsc = __rdtsc();
+
+    if (finish_tsc > start_tsc)
+        scale_stage = ((unsigned __int128)(finish - start) << 32) / (finish_tsc - start_tsc);
+#endif
+}
+
+/**
+ * @ingroup UdpStage
+ * @brief Function getting histograms of current thread, taken on first call.
+ * @return Histograms or NULL on error.
+ * @note This function is private. Not used outside udp_lib/stage.c
+ */
+static struct thread_stage * get_thread_stage(void) {
+    struct thread_stage * thread = local_stage;
+
+    if (thread != NULL)
+        return thread;
+
+    thread = calloc(1, sizeof(*thread));
+    if (thread == NULL)
+        goto get_not_memory;
+
+    for (size_t i = 0; i < COUNT_STAGE; i++) {
+        thread->m_histograms[i] = init_udp_histogram();
+        if (thread->m_histograms[i] == NULL)
+            goto get_not_histogram;
+    }
+
+    pthread_mutex_lock(&lock_stage);
+    thread->m_number = count_threads_stage++;
+    thread->m_next = threads_stage;
+    threads_stage = thread;
+    pthread_mutex_unlock(&lock_stage);
+
+    local_stage = thread;
+
+    return thread;
+get_not_histogram:
+    for (size_t i = 0; i < COUNT_STAGE; i++)
+        destroy_udp_histogram(thread->m_histograms[i]);
+    free(thread);
+get_not_memory:
+    return NULL;
+}
+
+/**
+ * @ingroup UdpStage
+ * @brief Function copy histogram of other thread in @ref snapshot_stage.
+ *
+ * Copy is taken again if thread recorded while copy, so count, sum and
+ * buckets of snapshot always agree. Record path is never blocked.
+ * @note You must take lock_stage before this.
+ * @param[in] thread Thread.
+ * @param[in] stage Stage *_STAGE.
+ * @return Snapshot.
+ * @note This function is private. Not used outside udp_lib/stage.c
+ */
+static udp_histogram_t take_snapshot_stage(struct thread_stage * const thread, \
+        const uint8_t stage) {
+    uint32_t sequence = 0;
+
+    do {
+        while ((sequence = __atomic_load_n(&thread->m_sequence, __ATOMIC_ACQUIRE)) & 1)
+            sched_yield();
+        copy_udp_histogram(snapshot_stage, thread->m_histograms[stage]);
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    } while (__atomic_load_n(&thread->m_sequence, __ATOMIC_RELAXED) != sequence);
+
+    return snapshot_stage;
+}
+
+/**
+ * @ingroup UdpStage
+ * @brief Function handler @ref SIGNAL_STAGE, only wakes thread of output.
+ * @param[in] signal Signal.
+ * @note This function is private. Not used outside udp_lib/stage.c
+ */
+static void signal_stage(int signal) {
+    uint64_t one = 1;
+    int error = errno;
+    ssize_t ret = 0;
+
+    (void)signal;
+    ret = write(fd_event_stage, &one, sizeof(one));
+    (void)ret;
+    errno = error;
+}
+
+/**
+ * @ingroup UdpStage
+ * @brief Function of thread printing histograms after every signal.
+ * @param[in] argument Not used.
+ * @return NULL.
+ * @note This function is private. Not used outside udp_lib/stage.c
+ */
+static void * output_stage(void * argument) {
+    uint64_t value = 0;
+
+    (void)argument;
+    for (;;) {
+        if (read(fd_event_stage, &value, sizeof(value)) < 0) {
+            if (errno == EINTR)
+                continue;
+            break;
+        }
+        dump_udp_stage();
+    }
+
+    return NULL;
+}
+
+ssize_t enable_udp_stage(void) {
+    ssize_t ret = 0;
+    pthread_t thread;
+    pthread_attr_t attributes;
+    struct sigaction action = {.sa_handler = signal_stage, .sa_flags = SA_RESTART};
+
+    if (is_enabled_stage)
+        return ret;
+
+    snapshot_stage = init_udp_histogram();
+    if (snapshot_stage == NULL) {
+        ret = -1;
+        goto get_not_snapshot;
+    }
+
+    fd_event_stage = eventfd(0, EFD_CLOEXEC);
+    if (fd_event_stage < 0) {
+        ret = -1;
+        perror("ERROR: get not eventfd");
+        goto get_not_eventfd;
+    }
+
+    pthread_attr_init(&attributes);
+    pthread_attr_setdetachstate(&attributes, PTHREAD_CREATE_DETACHED);
+    if (pthread_create(&thread, &attributes, output_stage, NULL)) {
+        ret = -1;
+        fputs("ERROR: create not thread of stages\n", stderr);
+        goto create_not_thread;
+    }
+    pthread_attr_destroy(&attributes);
+
+    calibrate_stage();
+    sigaction(SIGNAL_STAGE, &action, NULL);
+    atexit(dump_udp_stage);
+    is_enabled_stage = true;
+
+    return ret;
+create_not_thread:
+    pthread_attr_destroy(&attributes);
+    close(fd_event_stage);
+    fd_event_stage = -1;
+get_not_eventfd:
+    destroy_udp_histogram(snapshot_stage);
+    snapshot_stage = NULL;
+get_not_snapshot:
+    return ret;
+}
+
+bool is_enabled_udp_stage(void) {
+    return is_enabled_stage;
+}
+
+uint64_t begin_udp_stage(void) {
+    if (!is_enabled_stage)
+        return 0;
+    return now_stage();
+}
+
+void end_udp_stage(const uint8_t stage, const uint64_t begin) {
+    uint64_t finish = 0;
+
+    if (begin == 0)
+        return;
+    finish = now_stage();
+    record_udp_stage(stage, finish > begin ? \
+            ((unsigned __int128)(finish - begin) * scale_stage) >> 32 : 0);
+}
+
+void record_udp_stage(const uint8_t stage, const uint64_t nanoseconds) {
+    struct thread_stage * thread = NULL;
+
+    if (!is_enabled_stage || stage >= COUNT_STAGE)
+        return;
+
+    thread = get_thread_stage();
+    if (thread == NULL)
+        return;
+    /* Only this thread writes sequence, readers retry while it is odd or changed. */
+    __atomic_store_n(&thread->m_sequence, thread->m_sequence + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    record_udp_histogram(thread->m_histograms[stage], nanoseconds);
+    __atomic_store_n(&thread->m_sequence, thread->m_sequence + 1, __ATOMIC_RELEASE);
+}
+
+void merge_udp_stage(const uint8_t stage, udp_histogram_t histogram) {
+    if (stage >= COUNT_STAGE)
+        return;
+
+    pthread_mutex_lock(&lock_stage);
+    for (struct thread_stage * thread = threads_stage; thread; thread = thread->m_next)
+        merge_udp_histogram(histogram, take_snapshot_stage(thread, stage));
+    pthread_mutex_unlock(&lock_stage);
+}
+
+const char * get_name_udp_stage(const uint8_t stage) {
+    return stage < COUNT_STAGE ? names_stage[stage] : "unknown";
+}
+
+void dump_udp_stage(void) {
+    char name[64];
+
+    /* Threads can record while output, histograms are printed from snapshots. */
+    pthread_mutex_lock(&lock_stage);
+    for (struct thread_stage * thread = threads_stage; thread; thread = thread->m_next) {
+        for (size_t i = 0; i < COUNT_STAGE; i++) {
+            udp_histogram_t snapshot = take_snapshot_stage(thread, i);
+
+            if (get_count_udp_histogram(snapshot) == 0)
+                continue;
+            snprintf(name, sizeof(name), "stage thread %zu %s", thread->m_number, \
+                    names_stage[i]);
+            print_udp_histogram(snapshot, name, "ns");
+        }
+    }
+    fflush(stdout);
+    pthread_mutex_unlock(&lock_stage);
+}
@@ -0,0 +1,139 @@
+/**
+ * @file udp_lib/stage.h
+ * @author Vladsanin777
+ * @brief Header file for latency of stages of send path by TSC.
+ */
+
+#ifndef UDP_LIB_STAGE_H
+#define UDP_LIB_STAGE_H
+
+#include "udp_lib/histogram.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <signal.h>
+
+/**
+ * @defgroup UdpStage stage for udp
+ * @brief Group function for measure time of every stage of send path.
+ *
+ * Instrumentation is off until @ref enable_udp_stage, then every stage is
+ * measured by rdtsc calibrated to nanoseconds (CLOCK_MONOTONIC on other
+ * processors) and recorded in log-linear histograms of own thread, so
+ * threads never write same memory. One record of build, checksum and
+ * syscall is one call: one package or one batch of frames, one record of
+ * queue and completion is one frame. Histograms are printed on exit and on
+ * SIGUSR1.
+ *
+ * Stages:
+ * - build is header setup and filling of frames before send;
+ * - checksum is @ref calculate_checksum_udp_pack;
+ * - queue is time of frame in queue of @ref UdpQueue from submit to take by sender thread;
+ * - syscall is sendmmsg or write of file;
+ * - completion is time from start of sendmmsg to software TX timestamp of driver,
+ *   only for senders on interface opened after @ref enable_udp_stage.
+ * @{
+ */
+
+/** Stage header setup and filling of frames. */
+#define BUILD_STAGE 0
+
+/** Stage checksums. */
+#define CHECKSUM_STAGE 1
+
+/** Stage wait in queue. */
+#define QUEUE_STAGE 2
+
+/** Stage system call. */
+#define SYSCALL_STAGE 3
+
+/** Stage send until driver took frame. */
+#define COMPLETION_STAGE 4
+
+/** Count stages. */
+#define COUNT_STAGE 5
+
+/** Signal for print histograms while program works. */
+#define SIGNAL_STAGE SIGUSR1
+
+/**
+ * @brief Function calibrate TSC and turn on instrumentation.
+ *
+ * Histograms are printed at exit and on @ref SIGNAL_STAGE by own thread.
+ * @return 0 or -1 on error.
+ * Usage example.
+ * @code
+ * ret = enable_udp_stage();
+ * if (ret)
+ *     goto enable_not_stage;
+ * @endcode
+ */
+ssize_t enable_udp_stage(void);
+
+/**
+ * @brief Function check if instrumentation is on.
+ * @return true if on.
+ */
+bool is_enabled_udp_stage(void);
+
+/**
+ * @brief Function take start of stage.
+ * @return Counter TSC or 0 if instrumentation is off.
+ * Usage example.
+ * @code
+ * uint64_t begin = begin_udp_stage();
+ * calculate_checksum_udp_pack(pack);
+ * end_udp_stage(CHECKSUM_STAGE, begin);
+ * @endcode
+ */
+uint64_t begin_udp_stage(void);
+
+/**
+ * @brief Function record time from start of stage in histogram of thread.
+ * @param[in] stage Stage *_STAGE.
+ * @param[in] begin Value of @ref begin_udp_stage, 0 is not recorded.
+ */
+void end_udp_stage(const uint8_t stage, const uint64_t begin);
+
+/**
+ * @brief Function record ready time of stage in histogram of thread.
+ * @param[in] stage Stage *_STAGE.
+ * @param[in] nanoseconds Time of stage.
+ */
+void record_udp_stage(const uint8_t stage, const uint64_t nanoseconds);
+
+/**
+ * @brief Function add values of stage from all threads in histogram.
+ * @note Histogram of every thread is read from seqlock snapshot, so result is
+ * consistent and threads recording now are not blocked.
+ * @param[in] stage Stage *_STAGE.
+ * @param[in,out] histogram Histogram for work.
+ * Usage example.
+ * @code
+ * reset_udp_histogram(histogram);
+ * merge_udp_stage(SYSCALL_STAGE, histogram);
+ * uint64_t p99 = get_percentile_udp_histogram(histogram, 99.0);
+ * @endcode
+ */
+void merge_udp_stage(const uint8_t stage, udp_histogram_t histogram);
+
+/**
+ * @brief Function for getting name of stage.
+ * @param[in] stage Stage *_STAGE.
+ * @return Name as in output.
+ */
+const char * get_name_udp_stage(const uint8_t stage);
+
+/**
+ * @brief Function print histograms of all threads.
+ * Usage example.
+ * @code
+ * dump_udp_stage();
+ * @endcode
+ */
+void dump_udp_stage(void);
+
+/** @} */
+
+#endif /* UDP_LIB_STAGE_H */
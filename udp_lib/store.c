@@ -0,0 +1,304 @@
+/**
+ * @file udp_lib/store.c
+ * @author Vladsanin777
+ * @brief Code file for store of ready frames and blast replay.
+ */
+
+#include "udp_lib/store.h"
+#include "udp_lib/udp_private.h"
+#include "udp_lib/sender.h"
+#include "udp_lib/clock_private.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+
+/** Size buffer of file, write is done by whole buffer. */
+#define SIZE_BUFFER_STORE (4 << 20)
+
+/** Start capacity index. */
+#define START_INDEX_STORE 1024
+
+/** Max frames in one call of sender. */
+#define BATCH_STORE 1024
+
+/**
+ * @ingroup UdpStore
+ * @brief Struct is writer store.
+ * @note This struct is private. Not used outside udp_lib/store.c
+ */
+struct udp_store {
+    FILE * m_file; /**< File opened for write. */
+    uint64_t m_offset; /**< Offset end of written data. */
+    uint64_t m_bytes; /**< Sum sizes frames. */
+    struct udp_store_entry * m_index; /**< Index frames. */
+    size_t m_count; /**< Count frames. */
+    size_t m_capacity; /**< Capacity index. */
+};
+
+/** Zeros for padding frames. */
+static const uint8_t padding_store[ALIGN_STORE];
+
+udp_store_t init_udp_store(const char * const file) {
+    struct udp_store_header header = {0};
+    udp_store_t store = calloc(1, sizeof(*store));
+
+    if (store == NULL)
+        goto get_not_memory;
+
+    store->m_capacity = START_INDEX_STORE;
+    store->m_index = malloc(sizeof(*store->m_index) * store->m_capacity);
+    if (store->m_index == NULL)
+        goto get_not_index;
+
+    store->m_file = fopen(file, "wbe");
+    if (store->m_file == NULL) {
+        perror("ERROR: open not store");
+        goto open_not_file;
+    }
+    setvbuf(store->m_file, NULL, _IOFBF, SIZE_BUFFER_STORE);
+
+    /* Header is written again by finish_udp_store, now it only keep place. */
+    if (fwrite(&header, sizeof(header), 1, store->m_file) != 1)
+        goto write_not_header;
+    store->m_offset = sizeof(header);
+
+    return store;
+write_not_header:
+    fclose(store->m_file);
+open_not_file:
+    free(store->m_index);
+get_not_index:
+    free(store);
+get_not_memory:
+    return NULL;
+}
+
+ssize_t add_frame_udp_store(udp_store_t store, const struct iovec * const parts, \
+        const size_t count) {
+    ssize_t ret = 0;
+    struct udp_store_entry * entry = NULL;
+    size_t size = 0;
+    size_t pad = 0;
+
+    if (store->m_count == store->m_capacity) {
+        struct udp_store_entry * index = realloc(store->m_index, \
+                sizeof(*index) * store->m_capacity * 2);
+
+        if (index == NULL) {
+            ret = -1;
+            goto get_not_memory;
+        }
+        store->m_index = index;
+        store->m_capacity *= 2;
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        if (parts[i].iov_len && \
+                fwrite(parts[i].iov_base, parts[i].iov_len, 1, store->m_file) != 1) {
+            ret = -1;
+            goto write_not_frame;
+        }
+        size += parts[i].iov_len;
+    }
+
+    pad = (ALIGN_STORE - size % ALIGN_STORE) % ALIGN_STORE;
+    if (pad && fwrite(padding_store, pad, 1, store->m_file) != 1) {
+        ret = -1;
+        goto write_not_frame;
+    }
+
+    entry = &store->m_index[store->m_count++];
+    entry->m_offset = store->m_offset;
+    entry->m_size = size;
+    entry->m_reserved = 0;
+    store->m_offset += size + pad;
+    store->m_bytes += size;
+
+    return ret;
+write_not_frame:
+    perror("ERROR: write not frame in store");
+get_not_memory:
+    return ret;
+}
+
+ssize_t finish_udp_store(udp_store_t store) {
+    ssize_t ret = 0;
+    int error = 0;
+    struct udp_store_header header = {
+        .m_version = VERSION_STORE,
+        .m_align = ALIGN_STORE,
+        .m_count = store->m_count,
+        .m_index = store->m_offset,
+        .m_bytes = store->m_bytes,
+    };
+
+    memcpy(header.m_magic, MAGIC_STORE, sizeof(header.m_magic));
+
+    if (store->m_count && fwrite(store->m_index, sizeof(*store->m_index), \
+            store->m_count, store->m_file) != store->m_count)
+        goto write_not_index;
+
+    if (fseek(store->m_file, 0, SEEK_SET) || \
+            fwrite(&header, sizeof(header), 1, store->m_file) != 1 || \
+            fflush(store->m_file))
+        goto write_not_header;
+
+    return ret;
+write_not_header:
+write_not_index:
+    ret = -1;
+    error = errno;
+    perror("ERROR: write not index store");
+    errno = error;
+    return ret;
+}
+
+void destroy_udp_store(udp_store_t store) {
+    if (store == NULL)
+        return;
+    fclose(store->m_file);
+    free(store->m_index);
+    free(store);
+}
+
+/**
+ * @ingroup UdpStore
+ * @brief Function check header and index mapped store.
+ * @param[in] map Mapped file.
+ * @param[in] size Size file.
+ * @return 0 or -1 if file is not store or broken.
+ * @note This function is private. Not used outside udp_lib/store.c
+ */
+static ssize_t check_store(const uint8_t * const map, const size_t size) {
+    const struct udp_store_header * header = (const struct udp_store_header *)map;
+    const struct udp_store_entry * index = NULL;
+
+    if (size < sizeof(*header) || \
+            memcmp(header->m_magic, MAGIC_STORE, sizeof(header->m_magic)) || \
+            header->m_version != VERSION_STORE || header->m_align != ALIGN_STORE)
+        return -1;
+
+    if (header->m_index > size || header->m_index % sizeof(uint64_t) || \
+            header->m_count > (size - header->m_index) / sizeof(*index))
+        return -1;
+
+    index = (const struct udp_store_entry *)(map + header->m_index);
+    for (uint64_t i = 0; i < header->m_count; i++) {
+        if (index[i].m_offset > header->m_index || \
+                index[i].m_size > header->m_index - index[i].m_offset)
+            return -1;
+    }
+
+    return 0;
+}
+
+ssize_t blast_udp_store(udp_pack_t pack, const char * const file, \
+        const uint64_t loops) {
+    ssize_t ret = 0;
+    int fd = -1;
+    struct stat info;
+    uint8_t * map = NULL;
+    const struct udp_store_header * header = NULL;
+    const struct udp_store_entry * index = NULL;
+    struct iovec * frames = NULL;
+    udp_sender_t sender = NULL;
+    uint64_t start = 0;
+    uint64_t sended = 0;
+    uint64_t errors = 0;
+    uint64_t bytes = 0;
+    double seconds = 0.0;
+
+    fd = open(file, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        ret = -1;
+        perror("ERROR: open not store");
+        goto open_not_file;
+    }
+
+    if (fstat(fd, &info) || info.st_size == 0) {
+        ret = -1;
+        fputs("ERROR: store is empty\n", stderr);
+        goto stat_not_file;
+    }
+
+    map = mmap(NULL, info.st_size, PROT_READ, MAP_SHARED | MAP_POPULATE, fd, 0);
+    if (map == MAP_FAILED) {
+        ret = -1;
+        perror("ERROR: map not store");
+        goto map_not_file;
+    }
+
+    ret = check_store(map, info.st_size);
+    if (ret) {
+        fputs("ERROR: file is not store or broken\n", stderr);
+        goto check_not_store;
+    }
+
+    header = (const struct udp_store_header *)map;
+    index = (const struct udp_store_entry *)(map + header->m_index);
+
+    frames = malloc(sizeof(*frames) * (header->m_count ? header->m_count : 1));
+    if (frames == NULL) {
+        ret = -1;
+        goto get_not_memory;
+    }
+
+    for (uint64_t i = 0; i < header->m_count; i++) {
+        frames[i].iov_base = map + index[i].m_offset;
+        frames[i].iov_len = index[i].m_size;
+    }
+
+    sender = init_pack_udp_sender(pack);
+    if (sender == NULL) {
+        ret = -1;
+        goto get_not_sender;
+    }
+
+    start = now_clock();
+
+    for (uint64_t loop = 0; loop < (loops ? loops : 1); loop++) {
+        for (uint64_t i = 0; i < header->m_count; i += BATCH_STORE) {
+            size_t batch = MIN(header->m_count - i, BATCH_STORE);
+            ssize_t count = send_batch_udp_sender(sender, frames + i, batch);
+
+            if (count < 0)
+                count = 0;
+            sended += count;
+            errors += batch - count;
+        }
+        bytes += header->m_bytes;
+    }
+
+    seconds = (now_clock() - start) / (double)NSEC_CLOCK;
+    if (finish_udp_sender(sender))
+        ret = -1;
+
+    printf("blast sended: %lu errors: %lu bytes: %lu seconds: %.3f " \
+            "rate: %.0f pps %.3f Gbit/s\n", sended, errors, bytes, seconds, \
+            seconds > 0.0 ? sended / seconds : 0.0, \
+            seconds > 0.0 ? bytes * 8 / seconds / 1e9 : 0.0);
+    print_stats_udp_sender(sender);
+
+    destroy_udp_sender(sender);
+get_not_sender:
+    free(frames);
+get_not_memory:
+check_not_store:
+    munmap(map, info.st_size);
+map_not_file:
+stat_not_file:
+    close(fd);
+open_not_file:
+    return ret;
+}
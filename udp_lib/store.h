@@ -0,0 +1,139 @@
+/**
+ * @file udp_lib/store.h
+ * @author Vladsanin777
+ * @brief Header file for store of ready frames and blast replay.
+ */
+
+#ifndef UDP_LIB_STORE_H
+#define UDP_LIB_STORE_H
+
+#include "udp_lib/udp.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#include <sys/uio.h>
+
+/**
+ * @defgroup UdpStore store of ready frames for udp
+ * @brief Group function for write frames once and send them many times without any work per frame.
+ *
+ * Layout file: header @ref udp_store_header, frames with valid checksums
+ * each on offset aligned to @ref ALIGN_STORE, index of @ref udp_store_entry
+ * after last frame. All numbers in byte order of host which wrote file.
+ * @{
+ */
+
+/** Magic in start file. */
+#define MAGIC_STORE "UDPSTORE"
+
+/** Version format. */
+#define VERSION_STORE 1
+
+/** Alignment of frames in file. */
+#define ALIGN_STORE 64
+
+/**
+ * @brief Header file store, takes one aligned block.
+ */
+struct udp_store_header {
+    char m_magic[8]; /**< @ref MAGIC_STORE without zero. */
+    uint32_t m_version; /**< @ref VERSION_STORE. */
+    uint32_t m_align; /**< @ref ALIGN_STORE. */
+    uint64_t m_count; /**< Count frames. */
+    uint64_t m_index; /**< Offset index in file. */
+    uint64_t m_bytes; /**< Sum sizes frames. */
+    uint8_t m_reserved[ALIGN_STORE - 40]; /**< Zeros. */
+};
+
+/**
+ * @brief Entry index file store.
+ */
+struct udp_store_entry {
+    uint64_t m_offset; /**< Offset frame in file. */
+    uint32_t m_size; /**< Size frame from ethernet header. */
+    uint32_t m_reserved; /**< Zero. */
+};
+
+/**
+ * @brief Private struct writer store. (Hidden implementation)
+ */
+struct udp_store;
+
+/**
+ * @brief Writer store descriptor.
+ */
+typedef struct udp_store * udp_store_t;
+
+/**
+ * @brief Function for create file store for write.
+ * @note You must call @ref destroy_udp_store after this.
+ * @param[in] file Path to file, it is truncated.
+ * @return pointer or null on error.
+ * Usage example.
+ * @code
+ * udp_store_t store = init_udp_store("corpus.store");
+ * if (store == NULL)
+ *     goto get_not_store;
+ * // other code whit using udp_store_t
+ * ret = finish_udp_store(store);
+ * destroy_udp_store(store);
+ * get_not_store:
+ * @endcode
+ */
+udp_store_t init_udp_store(const char * const file);
+
+/**
+ * @brief Function append frame in store.
+ * @param[in,out] store Writer for work.
+ * @param[in] parts Pieces of frame going in a row.
+ * @param[in] count Count pieces.
+ * @return 0 or -1 on error.
+ * Usage example.
+ * @code
+ * struct iovec frame = {buffer, size};
+ * ret = add_frame_udp_store(store, &frame, 1);
+ * if (ret)
+ *     goto add_not_frame;
+ * @endcode
+ */
+ssize_t add_frame_udp_store(udp_store_t store, const struct iovec * const parts, \
+        const size_t count);
+
+/**
+ * @brief Function write index and header, after this store is complete.
+ * @param[in,out] store Writer for work.
+ * @return 0 or -1 on error.
+ */
+ssize_t finish_udp_store(udp_store_t store);
+
+/**
+ * @brief Function close file and free writer.
+ * @note Store without @ref finish_udp_store is left invalid.
+ * @param[in,out] store Writer for work.
+ */
+void destroy_udp_store(udp_store_t store);
+
+/**
+ * @brief Function send all frames from store as fast as possible.
+ *
+ * File is mapped and pieces for sendmmsg are prepared once,
+ * every pass over file is only system calls.
+ * @note You must call @ref init_udp_pack and @ref set_interface_udp_pack before this.
+ * @param[in,out] pack UDP package used for interface or pcap file.
+ * @param[in] file Path to store.
+ * @param[in] loops Count passes over store, 0 is one pass.
+ * @return 0 or -1 on error.
+ * Usage example.
+ * @code
+ * ret = blast_udp_store(pack, "corpus.store", 100);
+ * if (ret)
+ *     goto blast_not_store;
+ * @endcode
+ */
+ssize_t blast_udp_store(udp_pack_t pack, const char * const file, \
+        const uint64_t loops);
+
+/** @} */
+
+#endif /* UDP_LIB_STORE_H */
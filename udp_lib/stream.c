@@ -0,0 +1,469 @@
+/**
+ * @file udp_lib/stream.c
+ * @author Vladsanin777
+ * @brief Code file for sequence/timestamp header and receiver analyzer.
+ */
+
+#include "udp_lib/stream.h"
+#include "udp_lib/udp_private.h"
+#include "udp_lib/sender.h"
+#include "udp_lib/histogram.h"
+#include "udp_lib/clock_private.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <errno.h>
+#include <time.h>
+#include <poll.h>
+#include <signal.h>
+#include <endian.h>
+
+#include <arpa/inet.h>
+
+#include <sys/socket.h>
+#include <sys/prctl.h>
+
+#include <netinet/in.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+/** Bits in sliding window of every stream. */
+#define BITS_WINDOW_STREAM 4096
+
+/** Words in sliding window of every stream. */
+#define WORDS_WINDOW_STREAM (BITS_WINDOW_STREAM / 64)
+
+/** Max streams in one analyzer. */
+#define MAX_STREAMS_ANALYZER 1024
+
+/** Max packages in one call recvmmsg. */
+#define BATCH_ANALYZER 64
+
+/** Max size one package. */
+#define SIZE_PACKAGE_ANALYZER 2048
+
+/**
+ * @ingroup UdpStream
+ * @brief Struct is state one stream on receiver.
+ * @note This struct is private. Not used outside udp_lib/stream.c
+ */
+struct state_stream {
+    bool m_used; /**< Slot is busy. */
+    uint16_t m_clock; /**< Source timestamp of stream. */
+    uint32_t m_stream; /**< ID stream. */
+    uint64_t m_first; /**< First sequence. */
+    uint64_t m_top; /**< Highest sequence. */
+    uint64_t m_received; /**< Unique packages. */
+    uint64_t m_lost; /**< Sequences gone out of window without package. */
+    uint64_t m_duplicates; /**< Packages with seen sequence. */
+    uint64_t m_reordered; /**< Packages below highest sequence. */
+    uint64_t m_late; /**< Packages came after window gone, counted in lost before. */
+    uint64_t m_skewed; /**< Packages with timestamp from future. */
+    udp_histogram_t m_reorder; /**< Distance reordering in sequences. */
+    udp_histogram_t m_delay; /**< One-way delay. */
+    uint64_t m_window[WORDS_WINDOW_STREAM]; /**< Bit for every received sequence in window. */
+};
+
+/**
+ * @ingroup UdpStream
+ * @brief Struct is analyzer.
+ * @note This struct is private. Not used outside udp_lib/stream.c
+ */
+struct udp_analyzer {
+    uint64_t m_invalid; /**< Packages without header stream. */
+    uint64_t m_untracked; /**< Packages from streams above limit. */
+    struct state_stream m_streams[MAX_STREAMS_ANALYZER]; /**< Open-addressing table streams. */
+};
+
+/**
+ * @ingroup UdpStream
+ * @brief Function getting timestamp in selected clock.
+ * @param[in] clock Source timestamp.
+ * @return Nanoseconds CLOCK_REALTIME or cycles TSC.
+ * @note This function is private. Not used outside udp_lib/stream.c
+ */
+static uint64_t timestamp_stream(const uint16_t clock) {
+    struct timespec ts;
+
+#if defined(__x86_64__) || defined(__i386__)
+    if (clock == CLOCK_TSC_STREAM)
+        return __rdtsc();
+#endif
+    (void)clock;
+
+    clock_gettime(CLOCK_REALTIME, &ts);
+
+    return get_nsec_clock(&ts);
+}
+
+ssize_t set_stream_header_udp_pack(udp_pack_t pack, const uint32_t stream, \
+        const uint64_t sequence, const uint16_t clock) {
+    struct udp_stream_header header = {
+        .m_magic = htons(MAGIC_STREAM),
+        .m_clock = htons(clock),
+        .m_stream = htonl(stream),
+        .m_sequence = htobe64(sequence),
+        .m_timestamp = htobe64(timestamp_stream(clock)),
+    };
+    uint16_t size = get_size_data_udp_pack(pack);
+
+    if (size < HEAD_STREAM) {
+        memset(pack->m_data + size, 0x00, HEAD_STREAM - size);
+        set_size_udp_pack(pack, HEAD_STREAM);
+    }
+
+    memcpy(pack->m_data, &header, HEAD_STREAM);
+
+    return 0;
+}
+
+ssize_t run_stream_udp_pack(udp_pack_t pack, \
+        const struct udp_stream_config * const config) {
+    ssize_t ret = 0;
+    uint64_t start = 0;
+    uint64_t errors = 0;
+    udp_sender_t sender = init_pack_udp_sender(pack);
+
+    if (sender == NULL) {
+        ret = -1;
+        goto get_not_sender;
+    }
+
+    prctl(PR_SET_TIMERSLACK, 1UL);
+    start = now_clock();
+
+    for (uint64_t sequence = 0; sequence < config->m_count; sequence++) {
+        if (config->m_rate)
+            sleep_until_clock(start + sequence * NSEC_CLOCK / config->m_rate);
+        set_stream_header_udp_pack(pack, config->m_stream, sequence, \
+                config->m_clock);
+        if (send_udp_sender(sender, pack))
+            errors++;
+    }
+
+    if (finish_udp_sender(sender))
+        ret = -1;
+
+    printf("stream %u sended: %lu errors: %lu\n", config->m_stream, \
+            config->m_count - errors, errors);
+    print_stats_udp_sender(sender);
+
+    destroy_udp_sender(sender);
+get_not_sender:
+    return ret;
+}
+
+udp_analyzer_t init_udp_analyzer(void) {
+    return calloc(1, sizeof(struct udp_analyzer));
+}
+
+/**
+ * @ingroup UdpStream
+ * @brief Function find or create state of stream.
+ * @param[in,out] analyzer Analyzer for work.
+ * @param[in] stream ID stream.
+ * @return State stream or NULL if table is full.
+ * @note This function is private. Not used outside udp_lib/stream.c
+ */
+static struct state_stream * find_stream(udp_analyzer_t analyzer, \
+        const uint32_t stream) {
+    size_t index = (stream * 0x9E3779B1U) % MAX_STREAMS_ANALYZER;
+
+    for (size_t i = 0; i < MAX_STREAMS_ANALYZER; i++) {
+        struct state_stream * state = &analyzer->m_streams[index];
+
+        if (state->m_used && state->m_stream == stream)
+            return state;
+        if (!state->m_used)
+            return state;
+        index = (index + 1) % MAX_STREAMS_ANALYZER;
+    }
+
+    return NULL;
+}
+
+/**
+ * @ingroup UdpStream
+ * @brief Function count sequences without package in window.
+ * @param[in] state State stream.
+ * @return Count missing sequences from max(first, top - window) to top.
+ * @note This function is private. Not used outside udp_lib/stream.c
+ */
+static uint64_t missing_stream(const struct state_stream * const state) {
+    uint64_t span = state->m_top - state->m_first + 1;
+    uint64_t seen = 0;
+
+    for (size_t i = 0; i < WORDS_WINDOW_STREAM; i++)
+        seen += __builtin_popcountll(state->m_window[i]);
+
+    if (span > BITS_WINDOW_STREAM)
+        span = BITS_WINDOW_STREAM;
+
+    return span - seen;
+}
+
+#define BIT_STREAM(sequence) (1ULL << ((sequence) % 64))
+
+#define WORD_STREAM(state, sequence) \
+    ((state)->m_window[((sequence) % BITS_WINDOW_STREAM) / 64])
+
+ssize_t process_udp_analyzer(udp_analyzer_t analyzer, const void * const data, \
+        const size_t size, const uint64_t received) {
+    struct udp_stream_header header;
+    struct state_stream * state = NULL;
+    uint64_t sequence = 0;
+    uint64_t timestamp = 0;
+    uint64_t now = received;
+
+    if (size < HEAD_STREAM)
+        goto invalid_header;
+
+    memcpy(&header, data, HEAD_STREAM);
+
+    if (ntohs(header.m_magic) != MAGIC_STREAM)
+        goto invalid_header;
+
+    state = find_stream(analyzer, ntohl(header.m_stream));
+
+    if (state == NULL) {
+        analyzer->m_untracked++;
+        return 0;
+    }
+
+    sequence = be64toh(header.m_sequence);
+    timestamp = be64toh(header.m_timestamp);
+
+    if (!state->m_used) {
+        state->m_reorder = init_udp_histogram();
+        state->m_delay = init_udp_histogram();
+        if (state->m_reorder == NULL || state->m_delay == NULL) {
+            destroy_udp_histogram(state->m_reorder);
+            destroy_udp_histogram(state->m_delay);
+            state->m_reorder = NULL;
+            state->m_delay = NULL;
+            analyzer->m_untracked++;
+            return 0;
+        }
+        state->m_used = true;
+        state->m_stream = ntohl(header.m_stream);
+        state->m_clock = ntohs(header.m_clock);
+        state->m_first = sequence;
+        state->m_top = sequence;
+        WORD_STREAM(state, sequence) |= BIT_STREAM(sequence);
+    } else if (sequence > state->m_top) {
+        uint64_t distance = sequence - state->m_top;
+
+        if (distance >= BITS_WINDOW_STREAM) {
+            state->m_lost += missing_stream(state);
+            state->m_lost += distance - BITS_WINDOW_STREAM;
+            memset(state->m_window, 0x00, sizeof(state->m_window));
+        } else {
+            for (uint64_t next = state->m_top + 1; next <= sequence; next++) {
+                if (next >= state->m_first + BITS_WINDOW_STREAM && \
+                        !(WORD_STREAM(state, next) & BIT_STREAM(next)))
+                    state->m_lost++;
+                WORD_STREAM(state, next) &= ~BIT_STREAM(next);
+            }
+        }
+        state->m_top = sequence;
+        WORD_STREAM(state, sequence) |= BIT_STREAM(sequence);
+    } else if (sequence < state->m_first || \
+            state->m_top - sequence >= BITS_WINDOW_STREAM) {
+        if (sequence >= state->m_first && state->m_lost)
+            state->m_lost--;
+        state->m_late++;
+        state->m_received++;
+        return 0;
+    } else if (WORD_STREAM(state, sequence) & BIT_STREAM(sequence)) {
+        state->m_duplicates++;
+        return 0;
+    } else {
+        WORD_STREAM(state, sequence) |= BIT_STREAM(sequence);
+        state->m_reordered++;
+        record_udp_histogram(state->m_reorder, state->m_top - sequence);
+    }
+
+    state->m_received++;
+
+    if (state->m_clock == CLOCK_TSC_STREAM)
+        now = timestamp_stream(CLOCK_TSC_STREAM);
+
+    if (now >= timestamp)
+        record_udp_histogram(state->m_delay, now - timestamp);
+    else
+        state->m_skewed++;
+
+    return 0;
+invalid_header:
+    analyzer->m_invalid++;
+    return -1;
+}
+
+#undef WORD_STREAM
+#undef BIT_STREAM
+
+void print_udp_analyzer(const udp_analyzer_t analyzer) {
+    for (size_t i = 0; i < MAX_STREAMS_ANALYZER; i++) {
+        const struct state_stream * state = &analyzer->m_streams[i];
+        uint64_t lost = 0;
+
+        if (!state->m_used)
+            continue;
+
+        lost = state->m_lost + missing_stream(state);
+
+        printf("stream %u: sequences %lu..%lu received %lu lost %lu " \
+                "duplicates %lu reordered %lu late %lu skewed %lu\n", \
+                state->m_stream, state->m_first, state->m_top, \
+                state->m_received, lost, state->m_duplicates, \
+                state->m_reordered, state->m_late, state->m_skewed);
+        print_udp_histogram(state->m_reorder, "  reorder distance", "");
+        print_udp_histogram(state->m_delay, "  one-way delay", \
+                state->m_clock == CLOCK_TSC_STREAM ? "cyc" : "ns");
+    }
+
+    printf("invalid: %lu untracked: %lu\n", analyzer->m_invalid, \
+            analyzer->m_untracked);
+}
+
+void destroy_udp_analyzer(udp_analyzer_t analyzer) {
+    if (analyzer == NULL)
+        return;
+    for (size_t i = 0; i < MAX_STREAMS_ANALYZER; i++) {
+        destroy_udp_histogram(analyzer->m_streams[i].m_reorder);
+        destroy_udp_histogram(analyzer->m_streams[i].m_delay);
+    }
+    free(analyzer);
+}
+
+/** Flag stop receive, set by SIGINT. */
+static volatile sig_atomic_t is_stop_analyzer = 0;
+
+/**
+ * @ingroup UdpStream
+ * @brief Handler SIGINT for stop receive.
+ * @param[in] signal Number signal.
+ * @note This function is private. Not used outside udp_lib/stream.c
+ */
+static void stop_analyzer(int signal) {
+    (void)signal;
+    is_stop_analyzer = 1;
+}
+
+ssize_t run_analyzer_udp(const char * const port, const uint64_t count, \
+        const uint64_t timeout) {
+    ssize_t ret = 0;
+    int fd = -1;
+    int enable = 1;
+    int size_buffer = 1 << 23;
+    uint64_t total = 0;
+    uint32_t dropped = 0;
+    int disable = 0;
+    struct sockaddr_in6 address = {0};
+    struct sigaction action = {0};
+    static uint8_t packages[BATCH_ANALYZER][SIZE_PACKAGE_ANALYZER];
+    static uint8_t controls[BATCH_ANALYZER][CMSG_SPACE(sizeof(struct timespec)) + \
+            CMSG_SPACE(sizeof(uint32_t))];
+    struct iovec vectors[BATCH_ANALYZER];
+    struct mmsghdr messages[BATCH_ANALYZER];
+    udp_analyzer_t analyzer = init_udp_analyzer();
+
+    if (analyzer == NULL) {
+        ret = -1;
+        goto get_not_analyzer;
+    }
+
+    fd = socket(AF_INET6, SOCK_DGRAM | SOCK_NONBLOCK, 0);
+
+    if (fd < 0) {
+        ret = -1;
+        perror("ERROR: get not fd sock for analyzer");
+        goto get_not_fd_socket;
+    }
+
+    setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &size_buffer, sizeof(size_buffer));
+    setsockopt(fd, SOL_SOCKET, SO_TIMESTAMPNS, &enable, sizeof(enable));
+    setsockopt(fd, SOL_SOCKET, SO_RXQ_OVFL, &enable, sizeof(enable));
+    setsockopt(fd, IPPROTO_IPV6, IPV6_V6ONLY, &disable, sizeof(disable));
+
+    address.sin6_family = AF_INET6;
+    address.sin6_addr = in6addr_any;
+    address.sin6_port = htons(atoi(port));
+
+    if (bind(fd, (struct sockaddr *)&address, sizeof(address))) {
+        ret = -1;
+        perror("ERROR: bind not socket for analyzer");
+        goto bind_not_socket;
+    }
+
+    for (size_t i = 0; i < BATCH_ANALYZER; i++) {
+        vectors[i].iov_base = packages[i];
+        vectors[i].iov_len = SIZE_PACKAGE_ANALYZER;
+    }
+
+    action.sa_handler = stop_analyzer;
+    sigaction(SIGINT, &action, NULL);
+
+    while (!is_stop_analyzer && (count == 0 || total < count)) {
+        struct pollfd pollfd = {.fd = fd, .events = POLLIN};
+        ssize_t received = 0;
+
+        /* Before first package sender may not run yet, so wait without limit. */
+        ret = poll(&pollfd, 1, total ? (int)(timeout / 1000000) : -1);
+        if (ret <= 0)
+            break;
+
+        for (size_t i = 0; i < BATCH_ANALYZER; i++) {
+            memset(&messages[i], 0x00, sizeof(messages[i]));
+            messages[i].msg_hdr.msg_iov = &vectors[i];
+            messages[i].msg_hdr.msg_iovlen = 1;
+            messages[i].msg_hdr.msg_control = controls[i];
+            messages[i].msg_hdr.msg_controllen = sizeof(controls[i]);
+        }
+
+        received = recvmmsg(fd, messages, BATCH_ANALYZER, MSG_DONTWAIT, NULL);
+
+        for (ssize_t i = 0; i < received; i++) {
+            uint64_t time = 0;
+
+            for (struct cmsghdr * cmsg = CMSG_FIRSTHDR(&messages[i].msg_hdr); \
+                    cmsg != NULL; cmsg = CMSG_NXTHDR(&messages[i].msg_hdr, cmsg)) {
+                if (cmsg->cmsg_level != SOL_SOCKET)
+                    continue;
+                if (cmsg->cmsg_type == SO_TIMESTAMPNS) {
+                    struct timespec ts;
+                    memcpy(&ts, CMSG_DATA(cmsg), sizeof(ts));
+                    time = get_nsec_clock(&ts);
+                } else if (cmsg->cmsg_type == SO_RXQ_OVFL) {
+                    memcpy(&dropped, CMSG_DATA(cmsg), sizeof(dropped));
+                }
+            }
+
+            if (time == 0)
+                time = timestamp_stream(CLOCK_REALTIME_STREAM);
+
+            process_udp_analyzer(analyzer, packages[i], messages[i].msg_len, time);
+        }
+
+        if (received > 0)
+            total += received;
+    }
+
+    ret = 0;
+
+    print_udp_analyzer(analyzer);
+    printf("received: %lu dropped in socket queue: %u\n", total, dropped);
+
+bind_not_socket:
+    close(fd);
+get_not_fd_socket:
+    destroy_udp_analyzer(analyzer);
+get_not_analyzer:
+    return ret;
+}
@@ -0,0 +1,174 @@
+/**
+ * @file udp_lib/stream.h
+ * @author Vladsanin777
+ * @brief Header file for sequence/timestamp header and receiver analyzer.
+ */
+
+#ifndef UDP_LIB_STREAM_H
+#define UDP_LIB_STREAM_H
+
+#include "udp_lib/udp.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+
+/**
+ * @defgroup UdpStream stream header for udp
+ * @brief Group function for mark packages with sequence and timestamp and analyze them on receiver.
+ *
+ * Header is placed at start data UDP package, all fields in big endian.
+ * Receiver keep sliding bitmap window for every stream and count loss,
+ * duplicates, reordering distance and one-way delay.
+ * @{
+ */
+
+/** Magic in start header. */
+#define MAGIC_STREAM 0x5553
+
+/** Timestamp from CLOCK_REALTIME in nanoseconds. */
+#define CLOCK_REALTIME_STREAM 0x0000
+
+/** Timestamp from rdtsc in cycles. Useful only when sender and receiver on one host. */
+#define CLOCK_TSC_STREAM 0x0001
+
+/** Default nanoseconds without packages before receive stops. */
+#define DEFAULT_IDLE_STREAM 1000000000ULL
+
+/**
+ * @brief Header stream in start data UDP package.
+ */
+struct udp_stream_header {
+    uint16_t m_magic; /**< Constant @ref MAGIC_STREAM. */
+    uint16_t m_clock; /**< Source timestamp, @ref CLOCK_REALTIME_STREAM or @ref CLOCK_TSC_STREAM. */
+    uint32_t m_stream; /**< ID stream. */
+    uint64_t m_sequence; /**< Number package in stream. */
+    uint64_t m_timestamp; /**< Time send. */
+} __attribute__((packed));
+
+/** Size header stream. */
+#define HEAD_STREAM sizeof(struct udp_stream_header)
+
+/**
+ * @brief Configuration sender stream.
+ */
+struct udp_stream_config {
+    uint32_t m_stream; /**< ID stream. */
+    uint16_t m_clock; /**< Source timestamp. */
+    uint64_t m_count; /**< Count packages to send. */
+    uint64_t m_rate; /**< Packages per second, 0 is as fast as possible. */
+};
+
+/**
+ * @brief Function write header stream in start data UDP package.
+ * @note You must call @ref init_udp_pack before this.
+ * @note Data shorter than header is extended by zeros.
+ * @param[in,out] pack UDP package for work.
+ * @param[in] stream ID stream.
+ * @param[in] sequence Number package in stream.
+ * @param[in] clock Source timestamp.
+ * @return 0 or -1 on error.
+ * Usage example.
+ * @code
+ * ret = set_stream_header_udp_pack(pack, 1, 0, CLOCK_REALTIME_STREAM);
+ * if (ret)
+ *     goto set_not_stream_header;
+ * @endcode
+ */
+ssize_t set_stream_header_udp_pack(udp_pack_t pack, const uint32_t stream, \
+        const uint64_t sequence, const uint16_t clock);
+
+/**
+ * @brief Function send count packages with header stream and growing sequence.
+ * @note You must call @ref init_udp_pack before this.
+ * @param[in,out] pack UDP package used as template.
+ * @param[in] config Configuration stream.
+ * @return 0 or -1 on error.
+ * Usage example.
+ * @code
+ * struct udp_stream_config config = {
+ *     .m_stream = 1,
+ *     .m_clock = CLOCK_REALTIME_STREAM,
+ *     .m_count = 1000000,
+ *     .m_rate = 100000,
+ * };
+ * ret = run_stream_udp_pack(pack, &config);
+ * if (ret)
+ *     goto run_not_stream;
+ * @endcode
+ */
+ssize_t run_stream_udp_pack(udp_pack_t pack, \
+        const struct udp_stream_config * const config);
+
+/**
+ * @brief Private struct analyzer. (Hidden implementation)
+ */
+struct udp_analyzer;
+
+/**
+ * @brief Analyzer descriptor.
+ */
+typedef struct udp_analyzer * udp_analyzer_t;
+
+/**
+ * @brief Function for create analyzer streams.
+ * @note You must call @ref destroy_udp_analyzer after this.
+ * @return pointer or null on error.
+ * Usage example.
+ * @code
+ * udp_analyzer_t analyzer = init_udp_analyzer();
+ * if (analyzer == NULL)
+ *     goto get_not_analyzer;
+ * // other code whit using udp_analyzer_t
+ * destroy_udp_analyzer(analyzer);
+ * get_not_analyzer:
+ * @endcode
+ */
+udp_analyzer_t init_udp_analyzer(void);
+
+/**
+ * @brief Function analyze one received data UDP package.
+ * @param[in,out] analyzer Analyzer for work.
+ * @param[in] data Data UDP package.
+ * @param[in] size Size data.
+ * @param[in] received Time receive, CLOCK_REALTIME in nanoseconds.
+ * @return 0 or -1 if data has not header stream.
+ */
+ssize_t process_udp_analyzer(udp_analyzer_t analyzer, const void * const data, \
+        const size_t size, const uint64_t received);
+
+/**
+ * @brief Function print report for every stream.
+ * @param[in] analyzer Analyzer for work.
+ */
+void print_udp_analyzer(const udp_analyzer_t analyzer);
+
+/**
+ * @brief Function free analyzer.
+ * @param[in,out] analyzer Analyzer for work.
+ */
+void destroy_udp_analyzer(udp_analyzer_t analyzer);
+
+/**
+ * @brief Function receive packages on UDP port and print report.
+ *
+ * Socket is dual stack, so IPv4 and IPv6 streams are received together.
+ * Receive stops after count packages or after timeout without packages,
+ * first package is waited without limit.
+ * Drops in socket queue (SO_RXQ_OVFL) are reported apart from loss on the way.
+ * @param[in] port Port to listen.
+ * @param[in] count Count packages, 0 is unlimited.
+ * @param[in] timeout Time wait next package in nanoseconds, @ref DEFAULT_IDLE_STREAM.
+ * @return 0 or -1 on error.
+ * Usage example.
+ * @code
+ * ret = run_analyzer_udp("8001", 0, 1000000000ULL);
+ * if (ret)
+ *     goto run_not_analyzer;
+ * @endcode
+ */
+ssize_t run_analyzer_udp(const char * const port, const uint64_t count, \
+        const uint64_t timeout);
+
+/** @} */
+
+#endif /* UDP_LIB_STREAM_H */
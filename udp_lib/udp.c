@@ -5,6 +5,12 @@
  */
 
 #include "udp_lib/udp.h"
+#include "udp_lib/udp_private.h"
+#include "udp_lib/sender.h"
+#include "udp_lib/probe.h"
+#include "udp_lib/encap.h"
+#include "udp_lib/hex.h"
+#include "udp_lib/neigh.h"
 
 #include <stdint.h>
 #include <string.h>
@@ -28,74 +34,114 @@
 #include <sys/socket.h>
 
 #include <netinet/ip.h>
+#include <netinet/ip6.h>
 
-#define PACKED __attribute__((packed))
-
-/** 
+/**
  * @ingroup UdpPack
- * @brief Struct is header UDP pack
- * @note This struct is private. Not used outside udp_lib/udp.c
+ * @brief Function recalculate partial sum addresses for pseudo header.
+ *
+ * Addresses change rarely, so their sum (8 bytes for IPv4 and 32 bytes for IPv6)
+ * is kept ready and checksum never read them again.
+ * @param[in,out] pack UDP package for work.
+ * @note This function is private. Not used outside udp_lib/udp.c
  */
-struct udp_head {
-    uint16_t m_port_source; /**< Port source */
-    uint16_t m_port_destantion; /**< Port destantion */
-    uint16_t m_length; /**< Length udp pack */
-    uint16_t m_checksum; /**< Calculated software checksum */
-} PACKED;
-
-#define HEAD_ETH sizeof(struct ethhdr)
-
-#define HEAD_UDP sizeof(struct udp_head)
-
-#define HEAD_IP sizeof(struct iphdr)
-
-#define HEAD_UDP_IP (HEAD_IP + HEAD_UDP)
-
-#define MAX_SIZE_DATA (0xFFFF - HEAD_UDP_IP)
-
-#define NULL_CHECKSUM 0x0000
-
-#define MIN(left, rigth) (((left) < ((typeof(left))rigth)) ? (left) : ((typeof(left))rigth))
+static void sum_address_udp_pack(udp_pack_t pack) {
+    if (pack->m_family == AF_INET6)
+        pack->m_sum_address = sum_compute(&pack->m_ip6hdr->ip6_src, \
+                2 * sizeof(struct in6_addr));
+    else
+        pack->m_sum_address = sum_compute(&pack->m_iphdr->saddr, \
+                2 * sizeof(in_addr_t));
+}
 
 /**
  * @ingroup UdpPack
- * @brief Struct is UDP package.
- * @note This struct is private. Not used outside udp_lib/udp.c
+ * @brief Function write IP header with default values for family.
+ * @param[in,out] pack UDP package for work.
+ * @param[in] family AF_INET or AF_INET6.
+ * @note This function is private. Not used outside udp_lib/udp.c
  */
-struct udp_pack {
-    char m_interface[IFNAMSIZ]; /**< Name ethrnet interface. */
-    struct ethhdr m_ethhdr; /**< Ethernet header start UDP package. */
-    struct iphdr m_iphdr; /**< IP header */
-    struct udp_head m_head; /**< UDP header */
-    uint8_t  m_data[MAX_SIZE_DATA]; /**< Data in UDP package. */
-} PACKED;
+static void init_ip_udp_pack(udp_pack_t pack, const uint8_t family) {
+    pack->m_family = family;
+    if (family == AF_INET6) {
+        pack->m_ethhdr->h_proto = htons(ETH_P_IPV6);
+        memset(pack->m_ip6hdr, 0x00, HEAD_IP6);
+        pack->m_ip6hdr->ip6_flow = htonl(6 << 28);
+        pack->m_ip6hdr->ip6_nxt = IPPROTO_UDP;
+        pack->m_ip6hdr->ip6_hlim = 64;
+        pack->m_ip6hdr->ip6_src = in6addr_loopback;
+        pack->m_ip6hdr->ip6_dst = in6addr_loopback;
+        pack->m_head = (struct udp_head *)(pack->m_l3 + HEAD_IP6);
+    } else {
+        pack->m_ethhdr->h_proto = htons(ETH_P_IP);
+        memset(pack->m_iphdr, 0x00, HEAD_IP);
+        pack->m_iphdr->version = 4;
+        pack->m_iphdr->ihl = 5;
+        pack->m_iphdr->protocol = IPPROTO_UDP;
+        pack->m_iphdr->saddr = inet_addr("171.0.0.1");
+        pack->m_iphdr->daddr = inet_addr("171.0.0.1");
+        pack->m_iphdr->ttl = 64;
+        pack->m_head = (struct udp_head *)(pack->m_l3 + HEAD_IP);
+    }
+    pack->m_data = (uint8_t *)(pack->m_head + 1);
+    sum_address_udp_pack(pack);
+}
 
 udp_pack_t init_udp_pack(void) {
     udp_pack_t pack = calloc(1, sizeof(*pack));
     if (pack == NULL)
         goto get_not_memory;
+    if (posix_memalign((void **)&pack->m_buffer, ALIGN_UDP_PACK, SIZE_BUFFER_UDP_PACK))
+        goto get_not_buffer;
+    memset(pack->m_buffer, 0x00, SIZE_BUFFER_UDP_PACK);
+    pack->m_l3 = pack->m_buffer + HEADROOM_UDP_PACK;
+    pack->m_ethhdr = (struct ethhdr *)(pack->m_l3 - HEAD_ETH);
     memset(pack->m_interface, 0x00, IFNAMSIZ);
-    memset(pack->m_ethhdr.h_dest, 0xff, ETH_ALEN);
-    memset(pack->m_ethhdr.h_source, 0x00, ETH_ALEN);
-    pack->m_ethhdr.h_proto = htons(ETH_P_IP);
-
-    pack->m_iphdr.version = 4;
-    pack->m_iphdr.ihl = 5;
-    pack->m_iphdr.protocol = IPPROTO_UDP;
-    pack->m_iphdr.saddr = inet_addr("171.0.0.1");
-    pack->m_iphdr.daddr = inet_addr("171.0.0.1");
-    pack->m_iphdr.tot_len = htons(HEAD_UDP_IP);
-    pack->m_iphdr.ttl = 64;
-
-    pack->m_head.m_port_source = htons(0x0000);
-    pack->m_head.m_port_destantion = htons(0x0000);
-    pack->m_head.m_length = htons(HEAD_UDP);
-    pack->m_head.m_checksum = htons(NULL_CHECKSUM);
+    memset(pack->m_ethhdr->h_dest, 0xff, ETH_ALEN);
+    memset(pack->m_ethhdr->h_source, 0x00, ETH_ALEN);
+
+    init_ip_udp_pack(pack, AF_INET);
+
+    pack->m_head->m_port_source = htons(0x0000);
+    pack->m_head->m_port_destantion = htons(0x0000);
+    pack->m_head->m_checksum = htons(NULL_CHECKSUM);
+    set_size_udp_pack(pack, 0);
+    FIRE1_PROBE(pack_init, pack);
     return pack;
+get_not_buffer:
+    free(pack);
 get_not_memory:
     return NULL;
 }
 
+ssize_t set_family_udp_pack(udp_pack_t pack, const int family) {
+    ssize_t ret = 0;
+    struct udp_head * head = pack->m_head;
+    uint16_t size = get_size_data_udp_pack(pack);
+
+    if (family != AF_INET && family != AF_INET6) {
+        ret = -1;
+        goto unknown_family;
+    }
+
+    if (family == pack->m_family)
+        return ret;
+
+    memmove(pack->m_l3 + (family == AF_INET6 ? HEAD_IP6 : HEAD_IP), \
+            head, HEAD_UDP + size);
+    init_ip_udp_pack(pack, family);
+    set_size_udp_pack(pack, size);
+    pack->m_flags &= ~FLAG_RESOLVED_UDP_PACK;
+
+    return ret;
+unknown_family:
+    return ret;
+}
+
+int get_family_udp_pack(udp_pack_t pack) {
+    return pack->m_family;
+}
+
 /**
  * @ingroup UdpPack
  * @brief Function support for parsing port.
@@ -127,7 +173,7 @@ ssize_t set_port_source_udp_pack(udp_pack_t pack, const char * const port) {
         ret = -1;
         goto error_in_inet_port;
     }
-    pack->m_head.m_port_source = hport;
+    pack->m_head->m_port_source = hport;
 
     return ret;
 error_in_inet_port:
@@ -141,7 +187,7 @@ ssize_t set_port_destantion_udp_pack(udp_pack_t pack, const char * const port) {
         ret = -1;
         goto error_in_inet_port;
     }
-    pack->m_head.m_port_destantion = hport;
+    pack->m_head->m_port_destantion = hport;
 
     return ret;
 error_in_inet_port:
@@ -150,44 +196,73 @@ error_in_inet_port:
 
 ssize_t set_ip_address_source_udp_pack(udp_pack_t pack, const char * const ip) {
     ssize_t ret = 0;
+    void * address = &pack->m_iphdr->saddr;
 
-    pack->m_iphdr.saddr = inet_addr(ip);
-    if (pack->m_iphdr.saddr == (in_addr_t)-1) {
+    if (pack->m_family == AF_INET6)
+        address = &pack->m_ip6hdr->ip6_src;
+
+    if (inet_pton(pack->m_family, ip, address) != 1) {
         ret = -1;
         goto error_in_inet_addr;
     }
+    pack->m_flags &= ~FLAG_RESOLVED_UDP_PACK;
+    sum_address_udp_pack(pack);
     return ret;
 error_in_inet_addr:
     return ret;
 }
 
+void set_raw_addresses_udp_pack(udp_pack_t pack, const void * const source, \
+        const void * const destantion) {
+    void * address_source = &pack->m_iphdr->saddr;
+    void * address_destantion = &pack->m_iphdr->daddr;
+    size_t size = sizeof(in_addr_t);
+
+    if (pack->m_family == AF_INET6) {
+        address_source = &pack->m_ip6hdr->ip6_src;
+        address_destantion = &pack->m_ip6hdr->ip6_dst;
+        size = sizeof(struct in6_addr);
+    }
+
+    if (memcmp(address_source, source, size) == 0 && \
+            memcmp(address_destantion, destantion, size) == 0)
+        return;
+
+    memcpy(address_source, source, size);
+    memcpy(address_destantion, destantion, size);
+    pack->m_flags &= ~FLAG_RESOLVED_UDP_PACK;
+    sum_address_udp_pack(pack);
+}
+
 ssize_t set_ip_address_destantion_udp_pack(udp_pack_t pack, const char * const ip) {
     ssize_t ret = 0;
-    pack->m_iphdr.daddr = inet_addr(ip);
-    if (pack->m_iphdr.daddr == (in_addr_t)-1) {
+    void * address = &pack->m_iphdr->daddr;
+
+    if (pack->m_family == AF_INET6)
+        address = &pack->m_ip6hdr->ip6_dst;
+
+    if (inet_pton(pack->m_family, ip, address) != 1) {
         ret = -1;
         goto error_in_inet_addr;
     }
+    pack->m_flags &= ~FLAG_RESOLVED_UDP_PACK;
+    sum_address_udp_pack(pack);
     return ret;
 error_in_inet_addr:
     return ret;
 }
 
-/**
- * @ingroup UdpPack
- * @brief Function raw write size UDP package.
- * @param[in,out] pack UDP package for work.
- * @param[in] size New size UDP package.
- * @note This function is private. Not used outside udp_lib/udp.c
- */
-static void set_size_udp_pack(udp_pack_t pack, \
+void set_size_udp_pack(udp_pack_t pack, \
         const uint16_t size) {
-    pack->m_head.m_length = htons(HEAD_UDP + size);
-    pack->m_iphdr.tot_len = htons(HEAD_UDP_IP + size);
+    pack->m_head->m_length = htons(HEAD_UDP + size);
+    if (pack->m_family == AF_INET6)
+        pack->m_ip6hdr->ip6_plen = htons(HEAD_UDP + size);
+    else
+        pack->m_iphdr->tot_len = htons(HEAD_UDP_IP + size);
 }
 
 uint16_t get_size_data_udp_pack(udp_pack_t pack) {
-    return ntohs(pack->m_head.m_length) - HEAD_UDP;
+    return ntohs(pack->m_head->m_length) - HEAD_UDP;
 }
 
 
@@ -208,6 +283,7 @@ ssize_t add_data_udp_pack(udp_pack_t pack, void * data, \
         goto add_not_data_udp_pack;
     }
     set_size_udp_pack(pack, new_size);
+    FIRE2_PROBE(payload_set, pack, new_size);
     return ret;
 add_not_data_udp_pack:
     return ret;
@@ -223,6 +299,7 @@ ssize_t set_data_udp_pack(udp_pack_t pack, void * data, uint16_t size) {
         goto set_not_data_udp_pack;
     }
     set_size_udp_pack(pack, size);
+    FIRE2_PROBE(payload_set, pack, size);
     return ret;
 set_not_data_udp_pack:
     return ret;
@@ -303,20 +380,64 @@ get_not_fd_set_file_data:
     return ret;
 }
 
-/**
- * @ingroup UdpPack
- * @brief Function calculate sum in big endian.
- * @param[in] ptr Buffer for calculating sum in big endian.
- * @param[in] nbytes Size buffer for calculating sum.
- * @return Sum buffer in big endian.
- * @note This function is private. Not used outside udp_lib/udp.c
- */
-static uint32_t sum_compute(void *ptr, \
+ssize_t set_data_hex_udp_pack(udp_pack_t pack, const char * const hex) {
+    ssize_t ret = 0;
+    size_t length = strlen(hex);
+    uint8_t * scratch = NULL;
+    ssize_t size = 0;
+
+    if (length % 2) {
+        ret = -1;
+        fputs("ERROR: data hex must be even count hex digits\n", stderr);
+        goto check_not_length;
+    }
+    if (length / 2 > MAX_SIZE_DATA) {
+        ret = -1;
+        fprintf(stderr, "ERROR: data hex is bigger max size data %zu\n", MAX_SIZE_DATA);
+        goto check_not_length;
+    }
+
+    /* Data of package is changed only if whole string is decoded. */
+    scratch = malloc(length / 2 + 1);
+    if (scratch == NULL) {
+        ret = -1;
+        goto get_not_memory;
+    }
+
+    size = decode_udp_hex(scratch, length / 2, hex, length);
+    if (size < 0) {
+        ret = -1;
+        fputs("ERROR: data hex has not hex digit\n", stderr);
+        goto decode_not_hex;
+    }
+
+    memcpy(pack->m_data, scratch, size);
+    set_size_udp_pack(pack, size);
+    FIRE2_PROBE(payload_set, pack, size);
+
+decode_not_hex:
+    free(scratch);
+get_not_memory:
+check_not_length:
+    return ret;
+}
+
+void set_print_hex_udp_pack(udp_pack_t pack, const int is_hex) {
+    if (is_hex)
+        pack->m_flags |= FLAG_PRINT_HEX_UDP_PACK;
+    else
+        pack->m_flags &= ~FLAG_PRINT_HEX_UDP_PACK;
+}
+
+uint32_t sum_compute(void *ptr, \
         uint16_t nbytes) {
     uint32_t sum = htonl(0x00000000);
 
-    for (; nbytes > 1; nbytes -= 2, ptr+=2)
-        sum += htons(*(uint16_t *)ptr);
+    for (; nbytes > 1; nbytes -= 2, ptr+=2) {
+        uint16_t word = 0;
+        memcpy(&word, ptr, sizeof(word));
+        sum += htons(word);
+    }
 
     if (nbytes == 1)
         sum += htons(*(uint8_t *)ptr);
@@ -324,14 +445,7 @@ static uint32_t sum_compute(void *ptr, \
     return sum;
 }
 
-/**
- * @ingroup UdpPack
- * @brief Function calculating from sum big endian to checksum big endian.
- * @param[in] sum Sum in big endian.
- * @return Checksum in big endian.
- * @note This function is private. Not used outside udp_lib/udp.c
- */
-static uint16_t checksum_compute(uint32_t sum) {
+uint16_t checksum_compute(uint32_t sum) {
     while (sum >> 16)
         sum = (sum & 0xFFFF) + (sum >> 16);
 
@@ -341,42 +455,20 @@ static uint16_t checksum_compute(uint32_t sum) {
     return htons(~sum);
 }
 
-/**
- * @ingroup UdpPack
- * @brief Struct pseudo_header for calculate checksum for UDP package.
- * @note This struct is private. Not used outside udp_lib/udp.c
- */
-struct pseudo_header {
-    uint32_t source_address; /**< Source ip addresses */
-    uint32_t dest_address; /**< Destination ip addresses */
-    uint8_t placeholder; /**< Placeholder is 0x00. */
-    uint8_t protocol; /**< Constant protocol. */
-    uint16_t udp_length; /**< Length UDP package. */
-} PACKED;
-
-#define HEAD_PSEUDO sizeof(struct pseudo_header)
-
-/**
- * @ingroup UdpPack
- * @brief Function calculate checksum for ip header and UDP package.
- * @param[in,out] pack UDP package for work.
- * @note This function is private. Not used outside udp_lib/udp.c
- */
-static void calculate_checksum_udp_pack(udp_pack_t pack) {
-    struct pseudo_header psh;
-
-    pack->m_iphdr.check = NULL_CHECKSUM;
-    pack->m_iphdr.check = checksum_compute(sum_compute(&pack->m_iphdr, HEAD_IP));
+void calculate_checksum_udp_pack(udp_pack_t pack) {
+    uint32_t sum = pack->m_sum_address + IPPROTO_UDP + \
+            ntohs(pack->m_head->m_length);
 
-    pack->m_head.m_checksum = NULL_CHECKSUM;
+    if (pack->m_family == AF_INET) {
+        pack->m_iphdr->check = NULL_CHECKSUM;
+        pack->m_iphdr->check = checksum_compute(sum_compute(pack->m_iphdr, HEAD_IP));
+    }
 
-    psh.source_address = pack->m_iphdr.saddr;
-    psh.dest_address = pack->m_iphdr.daddr;
-    psh.placeholder = 0x00;
-    psh.protocol = pack->m_iphdr.protocol;
-    psh.udp_length = pack->m_head.m_length;
-    pack->m_head.m_checksum = checksum_compute(sum_compute(&psh, HEAD_PSEUDO) + \
-            sum_compute(&pack->m_head, ntohs(pack->m_head.m_length)));
+    pack->m_head->m_checksum = NULL_CHECKSUM;
+    pack->m_head->m_checksum = checksum_compute(sum + \
+            sum_compute(pack->m_head, ntohs(pack->m_head->m_length)));
+    FIRE3_PROBE(checksum, pack, ntohs(pack->m_head->m_length), \
+            ntohs(pack->m_head->m_checksum));
 }
 
 ssize_t set_interface_udp_pack( \
@@ -384,58 +476,103 @@ ssize_t set_interface_udp_pack( \
     ssize_t ret = 0;
 
     strncpy(pack->m_interface, interface, IFNAMSIZ);
+    pack->m_flags &= ~FLAG_RESOLVED_UDP_PACK;
 
     return ret;
 }
 
 /**
  * @ingroup UdpPack
- * @brief Function raw get pointer on UDP package.
+ * @brief Function for set file instead of interface.
  * @param[in,out] pack UDP package for work.
- * @return Getting UDP package.
+ * @param[in] file Path to file or NULL.
+ * @param[in] type Format file OUTPUT_*_UDP_PACK.
+ * @return 0 or -1 on error.
  * @note This function is private. Not used outside udp_lib/udp.c
  */
-static void * get_pack_udp_pack(udp_pack_t pack) {
-    return &pack->m_ethhdr;
+static ssize_t set_output_udp_pack(udp_pack_t pack, const char * const file, \
+        const uint8_t type) {
+    ssize_t ret = 0;
+    char * path = NULL;
+
+    if (file != NULL) {
+        path = strdup(file);
+        if (path == NULL) {
+            ret = -1;
+            goto get_not_memory;
+        }
+    }
+
+    free(pack->m_output);
+    pack->m_output = path;
+    pack->m_output_type = type;
+
+get_not_memory:
+    return ret;
 }
 
-ssize_t send_udp_pack(udp_pack_t pack) {
-    struct ifreq ifr;
-    struct sockaddr_ll sockaddr_ll = {0};
-    ssize_t fd_sock = 0;
-    ssize_t ret = 0;
+ssize_t set_pcap_udp_pack(udp_pack_t pack, const char * const file) {
+    return set_output_udp_pack(pack, file, OUTPUT_PCAP_UDP_PACK);
+}
 
-    calculate_checksum_udp_pack(pack);
+ssize_t set_store_udp_pack(udp_pack_t pack, const char * const file) {
+    return set_output_udp_pack(pack, file, OUTPUT_STORE_UDP_PACK);
+}
+
+void * get_pack_udp_pack(udp_pack_t pack) {
+    return pack->m_ethhdr;
+}
 
-    fd_sock = socket(AF_PACKET, SOCK_RAW, htons(ETH_P_ALL));
+size_t get_size_ip_udp_pack(udp_pack_t pack) {
+    return pack->m_family == AF_INET6 ? HEAD_IP6 : HEAD_IP;
+}
 
-    if (fd_sock < 0) {
-        ret = fd_sock;
-        perror("ERROR: get not fd sock, please lauhce with root");
-        goto give_not_fd_socket;
+size_t get_size_pack_udp_pack(udp_pack_t pack) {
+    return HEAD_ETH + get_size_ip_udp_pack(pack) + \
+            ntohs(pack->m_head->m_length);
+}
+
+size_t get_frame_udp_pack(udp_pack_t pack, struct udp_frame * const template) {
+    size_t size_ip = get_size_ip_udp_pack(pack);
+    struct udp_head * head = (struct udp_head *)(template->m_l3 + size_ip);
+
+    if (!(pack->m_flags & FLAG_RESOLVED_UDP_PACK))
+        resolve_mac_address_udp_pack(pack);
+
+    memset(template, 0x00, sizeof(*template));
+    memcpy(template, pack->m_ethhdr, HEAD_ETH + size_ip + HEAD_UDP);
+    if (pack->m_family == AF_INET6) {
+        template->m_ip6hdr.ip6_plen = 0;
+    } else {
+        template->m_iphdr.tot_len = 0;
+        template->m_iphdr.check = NULL_CHECKSUM;
     }
+    head->m_length = 0;
+    head->m_checksum = NULL_CHECKSUM;
 
-    strncpy(ifr.ifr_name, pack->m_interface, IFNAMSIZ);
-    ret = ioctl(fd_sock, SIOCGIFINDEX, &ifr);
+    return HEAD_ETH + size_ip + HEAD_UDP;
+}
 
-    if (ret) {
-        perror("ERROR: get not siocgifindex");
-        goto give_not_siocgifindex;
+ssize_t send_udp_pack(udp_pack_t pack) {
+    ssize_t ret = 0;
+    udp_sender_t sender = init_pack_udp_sender(pack);
+
+    if (sender == NULL) {
+        ret = -1;
+        goto get_not_sender;
     }
 
-    sockaddr_ll.sll_family = AF_PACKET;
-    sockaddr_ll.sll_ifindex = ifr.ifr_ifindex;
-    sockaddr_ll.sll_halen = ETH_ALEN;
-    memset(sockaddr_ll.sll_addr, 0xff, ETH_ALEN);
+    ret = send_udp_sender(sender, pack);
+    if (ret == 0)
+        ret = finish_udp_sender(sender);
 
-    sendto(fd_sock, get_pack_udp_pack(pack), ETH_HLEN + ntohs(pack->m_iphdr.tot_len), \
-           0, (struct sockaddr *)&sockaddr_ll, sizeof(sockaddr_ll));
+    if (ret)
+        goto send_not_udp_pack;
 
     puts("\nPacked sended!!!");
-    close(fd_sock);
-    return ret;
-give_not_fd_socket:
-give_not_siocgifindex:
+send_not_udp_pack:
+    destroy_udp_sender(sender);
+get_not_sender:
     return ret;
 }
 
@@ -477,11 +614,12 @@ ssize_t set_mac_address_source_udp_pack( \
         goto get_not_mac_address;
     }
     mac = ptr;
-    ptr = memcpy(&pack->m_ethhdr.h_source, mac, ETH_ALEN);
+    ptr = memcpy(&pack->m_ethhdr->h_source, mac, ETH_ALEN);
     if (ptr == NULL) {
         ret = -1;
         goto write_not_mac_address;
     }
+    pack->m_flags |= FLAG_MAC_SOURCE_UDP_PACK;
     free(mac);
     return ret;
 write_not_mac_address:
@@ -501,11 +639,12 @@ ssize_t set_mac_address_destantion_udp_pack( \
         goto get_not_mac_address;
     }
     mac = ptr;
-    ptr = memcpy(&pack->m_ethhdr.h_dest, mac, ETH_ALEN);
+    ptr = memcpy(&pack->m_ethhdr->h_dest, mac, ETH_ALEN);
     if (ptr == NULL) {
         ret = -1;
         goto write_not_mac_address;
     }
+    pack->m_flags |= FLAG_MAC_DESTANTION_UDP_PACK;
     free(mac);
     return ret;
 write_not_mac_address:
@@ -516,14 +655,17 @@ get_not_mac_address:
 
 char * get_ip_address_source_udp_pack(udp_pack_t pack) {
     char * buffer = NULL;
-    struct in_addr addr = {.s_addr = pack->m_iphdr.saddr};
+    void * addr = &pack->m_iphdr->saddr;
+
+    if (pack->m_family == AF_INET6)
+        addr = &pack->m_ip6hdr->ip6_src;
 
-    buffer = calloc(INET_ADDRSTRLEN, 1);
+    buffer = calloc(INET6_ADDRSTRLEN, 1);
 
     if (buffer == NULL)
         goto get_not_buffer;
 
-    if (inet_ntop(AF_INET, &addr, buffer, INET_ADDRSTRLEN) == NULL)
+    if (inet_ntop(pack->m_family, addr, buffer, INET6_ADDRSTRLEN) == NULL)
         goto convert_not_ip_address;
 
     return buffer;
@@ -535,14 +677,17 @@ get_not_buffer:
 
 char * get_ip_address_destantion_udp_pack(udp_pack_t pack) {
     char * buffer = NULL;
-    struct in_addr addr = {.s_addr = pack->m_iphdr.daddr};
+    void * addr = &pack->m_iphdr->daddr;
 
-    buffer = calloc(INET_ADDRSTRLEN, 1);
+    if (pack->m_family == AF_INET6)
+        addr = &pack->m_ip6hdr->ip6_dst;
+
+    buffer = calloc(INET6_ADDRSTRLEN, 1);
 
     if (buffer == NULL)
         goto get_not_buffer;
 
-    if (inet_ntop(AF_INET, &addr, buffer, INET_ADDRSTRLEN) == NULL)
+    if (inet_ntop(pack->m_family, addr, buffer, INET6_ADDRSTRLEN) == NULL)
         goto convert_not_ip_address;
 
     return buffer;
@@ -559,7 +704,7 @@ char * get_interface_udp_pack(udp_pack_t pack) {
 char * get_mac_address_source_udp_pack(udp_pack_t pack) {
     ssize_t ret = 0;
     char * mac_address = NULL;
-    uint8_t * mac_buffer = pack->m_ethhdr.h_source;
+    uint8_t * mac_buffer = pack->m_ethhdr->h_source;
     ret = asprintf(&mac_address, \
             "%02hhx:%02hhx:%02hhx:%02hhx:%02hhx:%02hhx", \
             *mac_buffer, mac_buffer[1], mac_buffer[2], \
@@ -580,7 +725,7 @@ get_not_buffer:
 char * get_mac_address_destantion_udp_pack(udp_pack_t pack) {
     ssize_t ret = 0;
     char * mac_address = NULL;
-    uint8_t * mac_buffer = pack->m_ethhdr.h_dest;
+    uint8_t * mac_buffer = pack->m_ethhdr->h_dest;
     ret = asprintf(&mac_address, \
             "%02hhx:%02hhx:%02hhx:%02hhx:%02hhx:%02hhx", \
             *mac_buffer, mac_buffer[1], mac_buffer[2], \
@@ -602,7 +747,7 @@ char * get_port_destantion_udp_pack(udp_pack_t pack) {
     int ret = 0;
     char * port = NULL;
     ret = asprintf(&port, "%hd", \
-            ntohs(pack->m_head.m_port_destantion));
+            ntohs(pack->m_head->m_port_destantion));
     if (port == NULL)
         goto get_not_buffer;
     if (ret == 0)
@@ -618,7 +763,7 @@ char * get_port_source_udp_pack(udp_pack_t pack) {
     int ret = 0;
     char * port = NULL;
     ret = asprintf(&port, "%hd", \
-            ntohs(pack->m_head.m_port_source));
+            ntohs(pack->m_head->m_port_source));
     if (port == NULL)
         goto get_not_buffer;
     if (ret == 0)
@@ -725,6 +870,23 @@ ssize_t print_udp_pack(udp_pack_t pack) {
 
     free(buffer);
 
+    if (pack->m_flags & FLAG_PRINT_HEX_UDP_PACK) {
+        buffer = get_data_hex_udp_pack(pack);
+
+        if (buffer == NULL) {
+            ret = -1;
+            goto get_not_data;
+        }
+
+        puts("data hex:");
+
+        puts(buffer);
+
+        free(buffer);
+
+        return ret;
+    }
+
     buffer = get_data_udp_pack(pack);
 
     if (buffer == NULL) {
@@ -771,6 +933,25 @@ get_not_buffer:
     return NULL;
 }
 
+char * get_data_hex_udp_pack(udp_pack_t pack) {
+    uint16_t size_data = get_size_data_udp_pack(pack);
+    char * buffer = malloc(size_data * 2 + 1);
+
+    if (buffer == NULL)
+        goto get_not_buffer;
+
+    buffer[encode_udp_hex(buffer, pack->m_data, size_data)] = '\0';
+
+    return buffer;
+get_not_buffer:
+    return NULL;
+}
+
 void destroy_udp_pack(udp_pack_t pack) {
+    if (pack == NULL)
+        return;
+    free(pack->m_output);
+    destroy_udp_encap(pack->m_encap);
+    free(pack->m_buffer);
     free(pack);
 }
@@ -4,6 +4,9 @@
  * @brief Header file for work udp package.
  */
 
+#ifndef UDP_LIB_UDP_H
+#define UDP_LIB_UDP_H
+
 #include <stdint.h>
 #include <stdlib.h>
 
@@ -44,6 +47,41 @@ typedef struct udp_pack * udp_pack_t;
  */
 udp_pack_t init_udp_pack(void);
 
+/**
+ * @brief Function for setting IP family UDP package.
+ * @note You must call @ref init_udp_pack before this.
+ * @note Addresses are reset to defaults of family, ports and data are kept.
+ * @param[in,out] pack UDP package for work.
+ * @param[in] family AF_INET (default) or AF_INET6.
+ * @return 0 or -1 on error.
+ * Usage example.
+ * @code
+ * ssize_t ret = 0;
+ * udp_pack_t pack = init_udp_pack();
+ * if (pack == NULL) {
+ *     ret = -1;
+ *     goto get_not_udp_pack;
+ * }
+ * ret = set_family_udp_pack(pack, AF_INET6);
+ * if (ret == -1)
+ *     goto set_not_family;
+ * ret = set_ip_address_source_udp_pack(pack, "fe80::1");
+ * // other code whit udp_pack_t
+ * set_not_family:
+ * get_not_udp_pack:
+ * destroy_udp_pack(pack);
+ * @endcode
+ */
+ssize_t set_family_udp_pack(udp_pack_t pack, const int family);
+
+/**
+ * @brief Function for getting IP family UDP package.
+ * @note You must call @ref init_udp_pack before this.
+ * @param[in,out] pack UDP package for work.
+ * @return AF_INET or AF_INET6.
+ */
+int get_family_udp_pack(udp_pack_t pack);
+
 /**
  * @brief Function for setting source port in UDP package.
  * @note You must call @ref init_udp_pack before this.
@@ -89,6 +127,7 @@ ssize_t set_port_destantion_udp_pack(udp_pack_t pack, const char * const port);
 /**
  * @brief Function for setting source ip address in UDP package.
  * @note You must call @ref init_udp_pack before this.
+ * @note Address is parsed for family set by @ref set_family_udp_pack.
  * @param[in,out] pack UDP package for work.
  * @param[in] ip Source ip to send.
  * @return 0 or -1 on error.
@@ -115,6 +154,7 @@ ssize_t set_ip_address_source_udp_pack( \
 /**
  * @brief Function for setting destantion ip address in UDP package.
  * @note You must call @ref init_udp_pack before this.
+ * @note Address is parsed for family set by @ref set_family_udp_pack.
  * @param[in,out] pack UDP package for work.
  * @param[in] ip Destination ip address to send.
  * @return 0 or -1 on error.
@@ -257,6 +297,43 @@ ssize_t set_input_data_udp_pack(udp_pack_t pack);
 ssize_t set_file_data_udp_pack( \
         udp_pack_t pack, const char * const file_name);
 
+/**
+ * @brief Function overriding data in UDP package by bytes of hex text.
+ * @note You must call @ref init_udp_pack before this.
+ * @param[in,out] pack UDP package for work.
+ * @param[in] hex Hex text, even count digits in any case.
+ * @return 0 or -1 on error, data is not changed on error.
+ * Usage example.
+ * @code
+ * ssize_t ret = 0;
+ * udp_pack_t pack = init_udp_pack();
+ * if (pack == NULL) {
+ *     ret = -1;
+ *     goto get_not_udp_pack;
+ * }
+ * ret = set_data_hex_udp_pack(pack, "deadbeef");
+ * if (ret)
+ *     goto set_not_data_hex;
+ * set_not_data_hex:
+ * get_not_udp_pack:
+ * destroy_udp_pack(pack);
+ * @endcode
+ */
+ssize_t set_data_hex_udp_pack(udp_pack_t pack, const char * const hex);
+
+/**
+ * @brief Function choose print of data by @ref print_udp_pack.
+ * @note You must call @ref init_udp_pack before this.
+ * @param[in,out] pack UDP package for work.
+ * @param[in] is_hex Not 0 print data as hex text, 0 print raw bytes.
+ * Usage example.
+ * @code
+ * set_print_hex_udp_pack(pack, 1);
+ * print_udp_pack(pack);
+ * @endcode
+ */
+void set_print_hex_udp_pack(udp_pack_t pack, const int is_hex);
+
 /**
  * @brief Function for pick interface to send UDP package.
  * @note You must call @ref init_udp_pack before this.
@@ -279,6 +356,48 @@ ssize_t set_file_data_udp_pack( \
 ssize_t set_interface_udp_pack( \
         udp_pack_t pack, const char * const interface);
 
+/**
+ * @brief Function for write frames UDP package in pcap file instead of interface.
+ * @note You must call @ref init_udp_pack before this.
+ * @note Root is not needed. If interface is set too, its MTU and mac addresses are used.
+ * @param[in,out] pack UDP package for work.
+ * @param[in] file Path to pcap file, NULL send on interface again.
+ * @return 0 or -1 on error.
+ * Usage example.
+ * @code
+ * ssize_t ret = 0;
+ * udp_pack_t pack = init_udp_pack();
+ * if (pack == NULL) {
+ *     ret = -1;
+ *     goto get_not_udp_pack;
+ * }
+ * ret = set_pcap_udp_pack(pack, "corpus.pcap");
+ * if (ret)
+ *     goto set_not_pcap;
+ * send_udp_pack(pack);
+ * set_not_pcap:
+ * get_not_udp_pack:
+ * destroy_udp_pack(pack);
+ * @endcode
+ */
+ssize_t set_pcap_udp_pack(udp_pack_t pack, const char * const file);
+
+/**
+ * @brief Function for write frames UDP package in store of ready frames instead of interface.
+ * @note You must call @ref init_udp_pack before this.
+ * @note Store is sended later by @ref blast_udp_store without any work per frame.
+ * @param[in,out] pack UDP package for work.
+ * @param[in] file Path to store file, NULL send on interface again.
+ * @return 0 or -1 on error.
+ * Usage example.
+ * @code
+ * ret = set_store_udp_pack(pack, "corpus.store");
+ * if (ret)
+ *     goto set_not_store;
+ * @endcode
+ */
+ssize_t set_store_udp_pack(udp_pack_t pack, const char * const file);
+
 /**
  * @brief Function to send UDP package.
  * @note You must call @ref init_udp_pack before this.
@@ -701,3 +820,5 @@ ssize_t print_udp_pack(udp_pack_t pack);
 void destroy_udp_pack(udp_pack_t pack);
 
 /** @} */
+
+#endif /* UDP_LIB_UDP_H */
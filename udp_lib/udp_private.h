@@ -0,0 +1,239 @@
+/**
+ * @file udp_lib/udp_private.h
+ * @author Vladsanin777
+ * @brief Private layout UDP package shared between files udp_lib.
+ * @note This header is private. Not used outside udp_lib.
+ */
+
+#ifndef UDP_LIB_UDP_PRIVATE_H
+#define UDP_LIB_UDP_PRIVATE_H
+
+#include "udp_lib/udp.h"
+
+#include <stdint.h>
+
+#include <net/if.h>
+
+#include <net/ethernet.h>
+
+#include <netinet/ip.h>
+#include <netinet/ip6.h>
+
+#include <linux/if_ether.h>
+
+#include <arpa/inet.h>
+
+#define PACKED __attribute__((packed))
+
+/**
+ * @ingroup UdpPack
+ * @brief Struct is header UDP pack
+ * @note This struct is private. Not used outside udp_lib.
+ */
+struct udp_head {
+    uint16_t m_port_source; /**< Port source */
+    uint16_t m_port_destantion; /**< Port destantion */
+    uint16_t m_length; /**< Length udp pack */
+    uint16_t m_checksum; /**< Calculated software checksum */
+} PACKED;
+
+#define HEAD_ETH sizeof(struct ethhdr)
+
+#define HEAD_UDP sizeof(struct udp_head)
+
+#define HEAD_IP sizeof(struct iphdr)
+
+#define HEAD_UDP_IP (HEAD_IP + HEAD_UDP)
+
+#define HEAD_IP6 sizeof(struct ip6_hdr)
+
+#define HEAD_UDP_IP6 (HEAD_IP6 + HEAD_UDP)
+
+#define MAX_SIZE_DATA (0xFFFF - HEAD_UDP_IP)
+
+#define NULL_CHECKSUM 0x0000
+
+#define MIN(left, rigth) (((left) < ((typeof(left))rigth)) ? (left) : ((typeof(left))rigth))
+
+/** Mac source set by user, not taken from interface. */
+#define FLAG_MAC_SOURCE_UDP_PACK 0x01
+
+/** Mac destantion set by user, not taken from neighbor table. */
+#define FLAG_MAC_DESTANTION_UDP_PACK 0x02
+
+/** Mac addresses already resolved for current interface and destantion. */
+#define FLAG_RESOLVED_UDP_PACK 0x04
+
+/** Data is printed by print_udp_pack as hex text. */
+#define FLAG_PRINT_HEX_UDP_PACK 0x08
+
+/** Frames are written in pcap file. */
+#define OUTPUT_PCAP_UDP_PACK 0x01
+
+/** Frames are written in store of ready frames. */
+#define OUTPUT_STORE_UDP_PACK 0x02
+
+/** Alignment of buffer of frame. */
+#define ALIGN_UDP_PACK 64
+
+/**
+ * Bytes from start of buffer to IP header, multiple of @ref ALIGN_UDP_PACK so
+ * IP header, UDP header and data are aligned. Before ethernet header are
+ * HEADROOM_UDP_PACK - HEAD_ETH free bytes for outer headers of encapsulation,
+ * they are written in place without copy of data.
+ */
+#define HEADROOM_UDP_PACK 128
+
+/** Size of buffer of frame with headroom. */
+#define SIZE_BUFFER_UDP_PACK (HEADROOM_UDP_PACK + HEAD_UDP_IP6 + MAX_SIZE_DATA)
+
+/**
+ * @ingroup UdpPack
+ * @brief Struct is UDP package.
+ *
+ * Frame lives in own buffer aligned to @ref ALIGN_UDP_PACK, headers are pointers
+ * in it: ethernet header at HEADROOM_UDP_PACK - HEAD_ETH, IP header at
+ * @ref HEADROOM_UDP_PACK.
+ * @note This struct is private. Not used outside udp_lib.
+ */
+struct udp_pack {
+    char m_interface[IFNAMSIZ]; /**< Name ethrnet interface. */
+    char * m_output; /**< Path to file instead of interface or NULL. */
+    uint8_t m_output_type; /**< Format file OUTPUT_*_UDP_PACK. */
+    struct udp_head * m_head; /**< UDP header, after IP header of current family. */
+    uint8_t * m_data; /**< Data in UDP package, after UDP header. */
+    uint32_t m_sum_address; /**< Partial sum source and destination addresses for pseudo header. */
+    uint8_t m_family; /**< AF_INET or AF_INET6. */
+    uint8_t m_flags; /**< Flags FLAG_*_UDP_PACK. */
+    struct udp_encap * m_encap; /**< Tunnel or NULL. */
+    struct ethhdr m_saved_ethhdr; /**< Ethernet header kept while frame is wrapped in tunnel. */
+    uint8_t * m_buffer; /**< Buffer of frame with headroom. */
+    struct ethhdr * m_ethhdr; /**< Ethernet header start UDP package. */
+    union {
+        struct iphdr * m_iphdr; /**< IP header for AF_INET. */
+        struct ip6_hdr * m_ip6hdr; /**< IP header for AF_INET6. */
+        uint8_t * m_l3; /**< Place for headers and data. */
+    };
+};
+
+/**
+ * @ingroup UdpPack
+ * @brief Struct is ethernet, IP and UDP headers of package, template of batch of frames.
+ * @note This struct is private. Not used outside udp_lib.
+ */
+struct udp_frame {
+    struct ethhdr m_ethhdr; /**< Ethernet header. */
+    union {
+        struct iphdr m_iphdr; /**< IP header for AF_INET. */
+        struct ip6_hdr m_ip6hdr; /**< IP header for AF_INET6. */
+        uint8_t m_l3[HEAD_UDP_IP6]; /**< Place for IP and UDP headers. */
+    } PACKED;
+} PACKED;
+
+/**
+ * @ingroup UdpPack
+ * @brief Function calculate sum in big endian.
+ * @param[in] ptr Buffer for calculating sum in big endian.
+ * @param[in] nbytes Size buffer for calculating sum.
+ * @return Sum buffer in big endian.
+ */
+uint32_t sum_compute(void *ptr, uint16_t nbytes);
+
+/**
+ * @ingroup UdpPack
+ * @brief Function calculating from sum big endian to checksum big endian.
+ * @param[in] sum Sum in big endian.
+ * @return Checksum in big endian.
+ */
+uint16_t checksum_compute(uint32_t sum);
+
+/**
+ * @ingroup UdpPack
+ * @brief Function calculate checksum for ip header and UDP package.
+ * @param[in,out] pack UDP package for work.
+ */
+void calculate_checksum_udp_pack(udp_pack_t pack);
+
+/**
+ * @ingroup UdpPack
+ * @brief Function raw get size IP header current family.
+ * @param[in] pack UDP package for work.
+ * @return HEAD_IP or HEAD_IP6.
+ */
+size_t get_size_ip_udp_pack(udp_pack_t pack);
+
+/**
+ * @ingroup UdpPack
+ * @brief Function raw write size UDP package.
+ * @param[in,out] pack UDP package for work.
+ * @param[in] size New size data UDP package.
+ */
+void set_size_udp_pack(udp_pack_t pack, const uint16_t size);
+
+/**
+ * @ingroup UdpPack
+ * @brief Function raw write IP addresses of current family.
+ * @note Mac addresses are resolved again only if addresses are changed.
+ * @param[in,out] pack UDP package for work.
+ * @param[in] source Source address in network order.
+ * @param[in] destantion Destantion address in network order.
+ */
+void set_raw_addresses_udp_pack(udp_pack_t pack, const void * const source, \
+        const void * const destantion);
+
+/**
+ * @ingroup UdpPack
+ * @brief Function raw get pointer on start frame UDP package.
+ * @param[in,out] pack UDP package for work.
+ * @return Pointer on ethernet header.
+ */
+void * get_pack_udp_pack(udp_pack_t pack);
+
+/**
+ * @ingroup UdpPack
+ * @brief Function raw get size frame UDP package.
+ * @param[in,out] pack UDP package for work.
+ * @return Size frame from ethernet header to end data.
+ */
+size_t get_size_pack_udp_pack(udp_pack_t pack);
+
+/**
+ * @ingroup UdpPack
+ * @brief Function copy headers of UDP package in template of frames.
+ * @note Mac addresses are resolved first if they are not yet. Lengths and
+ * checksums in template are zero, they are written by @ref wrap_frame_udp_pack.
+ * @param[in,out] pack UDP package for work.
+ * @param[out] template Template of frames.
+ * @return Size headers from ethernet header to end UDP header.
+ */
+size_t get_frame_udp_pack(udp_pack_t pack, struct udp_frame * const template);
+
+/**
+ * @ingroup UdpPack
+ * @brief Function write headers of one frame from template.
+ * @note Checksums stay zero, they are written by caller.
+ * @param[out] frame Headers of frame.
+ * @param[in] template Template from @ref get_frame_udp_pack.
+ * @param[in] family AF_INET or AF_INET6 of template.
+ * @param[in] length Length UDP package with UDP header.
+ * @return UDP header in frame.
+ */
+static inline struct udp_head * wrap_frame_udp_pack(struct udp_frame * const frame, \
+        const struct udp_frame * const template, const uint8_t family, \
+        const uint16_t length) {
+    struct udp_head * head = NULL;
+
+    *frame = *template;
+    if (family == AF_INET6) {
+        frame->m_ip6hdr.ip6_plen = htons(length);
+        head = (struct udp_head *)(frame->m_l3 + HEAD_IP6);
+    } else {
+        frame->m_iphdr.tot_len = htons(HEAD_IP + length);
+        head = (struct udp_head *)(frame->m_l3 + HEAD_IP);
+    }
+    head->m_length = htons(length);
+
+    return head;
+}
+
+#endif /* UDP_LIB_UDP_PRIVATE_H */